@@ -65,17 +65,20 @@ if ($opt eq '-d') {
 
   // Access sizes.
   const Indices& get_sizes() const { return _sizes; }
-  void set_sizes(const Indices& sizes) { _sizes = sizes; }
+  virtual void set_sizes(const Indices& sizes) { _sizes = sizes; }
   idx_t get_size(int i) const {
     assert(i >= 0);
     assert(i < _sizes.getNumDims());
     return _sizes[i]; 
   }
-  void set_size(int i, idx_t size) {
+  virtual void set_size(int i, idx_t size) {
     assert(i >= 0);
     assert(i < _sizes.getNumDims());
     _sizes[i] = size; 
   }
+
+  // Set sizes of tiles; ignored by untiled layouts.
+  virtual void set_tile_sizes(const Indices& tile_sizes) { }
   virtual int get_num_sizes() const {
     return _sizes.getNumDims(); 
   }
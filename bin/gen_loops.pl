@@ -49,6 +49,10 @@ my $bSerp = 0x1;                # serpentine path
 my $bSquare = 0x2;              # square_wave path
 my $bGroup = 0x4;               # group path
 my $bSimd = 0x8;                # simd prefix
+my $bSteal = 0x10;              # work-stealing scheduler
+my $bMorton = 0x20;             # morton (Z-order) path
+my $bHilbert = 0x40;            # hilbert path
+my $bCurve = $bMorton | $bHilbert; # space-filling-curve paths
 
 ##########
 # Function to make names of variables based on dimension string(s).
@@ -109,6 +113,18 @@ sub alignBeginVar {
 sub numItersVar {
     return join('_', 'num_iters', @_);
 }
+sub stealVar {
+    return join('_', 'steal_sched', @_);
+}
+sub mortonBitsVar {
+    return join('_', 'morton_bits', @_);
+}
+sub hilbertBitsVar {
+    return join('_', 'hilbert_bits', @_);
+}
+sub numCurveItersVar {
+    return join('_', 'num_curve_iters', @_);
+}
 sub numGroupsVar {
     return join('_', 'num_full_groups', @_);
 }
@@ -262,6 +278,42 @@ sub addIndexVars1($$$) {
             }
         }
     }
+
+    # For morton loops, the linear index covers the power-of-2
+    # sizes that hold the number of iterations in each dim.
+    if ($features & $bMorton) {
+        my @bvars;
+        for my $dim (@$loopDims) {
+            my $mbvar = mortonBitsVar($dim);
+            my $nvar = numItersVar($dim);
+            push @$code,
+                " // Number of bits in the index for dimension $dim on the 'morton' path.",
+                " int $mbvar = 0;",
+                " while ((idx_t(1) << $mbvar) < $nvar) $mbvar++;";
+            push @bvars, $mbvar;
+        }
+        my $mnvar = numCurveItersVar(@$loopDims);
+        push @$code,
+            " // Number of iterations in ".dimStr(@$loopDims)." on the 'morton' path,".
+            " including those outside the scan, which are skipped.",
+            " const $itype $mnvar = idx_t(1) << (".join(' + ', @bvars).");";
+    }
+
+    # For hilbert loops, the linear index covers the power-of-2
+    # cube that holds the number of iterations in every dim.
+    if ($features & $bHilbert) {
+        my $hbvar = hilbertBitsVar(@$loopDims);
+        my $nmax = join(', ', map { numItersVar($_) } @$loopDims);
+        $nmax = "std::max({ $nmax })" if @$loopDims > 1;
+        my $hnvar = numCurveItersVar(@$loopDims);
+        push @$code,
+            " // Number of bits in the index for each of ".dimStr(@$loopDims)." on the 'hilbert' path.",
+            " int $hbvar = 0;",
+            " while ((idx_t(1) << $hbvar) < $nmax) $hbvar++;",
+            " // Number of iterations in ".dimStr(@$loopDims)." on the 'hilbert' path,".
+            " including those outside the scan, which are skipped.",
+            " const $itype $hnvar = idx_t(1) << ($hbvar * ".scalar(@$loopDims).");";
+    }
 }
 
 # Add index variables *inside* the loop.
@@ -283,6 +335,8 @@ sub addIndexVars2($$$$) {
             if $features & $bSerp;
         die "error: square-wave not compatible with grouping.\n"
             if $features & $bSquare;
+        die "error: morton and hilbert not compatible with grouping.\n"
+            if $features & $bCurve;
 
         my $ndims = scalar @$loopDims;
 
@@ -391,6 +445,48 @@ sub addIndexVars2($$$$) {
         }
     }
 
+    # Hilbert path.
+    elsif ($features & $bHilbert) {
+
+        die "error: serpentine and square-wave not compatible with hilbert.\n"
+            if $features & ($bSerp | $bSquare);
+        die "error: morton not compatible with hilbert.\n"
+            if $features & $bMorton;
+
+        my $ndims = scalar @$loopDims;
+        push @$code,
+            " // Zero-based, unit-stride indices for ".dimStr(@$loopDims)." on the 'hilbert' path.",
+            " idx_t hcoords[$ndims];",
+            " yask::getHilbertCoords($civar, ".hilbertBitsVar(@$loopDims).", $ndims, hcoords);",
+            (map { " idx_t ".indexVar($loopDims->[$_])." = hcoords[$_];" } 0 .. $ndims-1),
+            " // Skip indices outside the scan.",
+            " if (".join(' || ', map { indexVar($_)." >= ".numItersVar($_) } @$loopDims).")",
+            "  continue;";
+    }
+
+    # Morton path.
+    elsif ($features & $bMorton) {
+
+        die "error: serpentine and square-wave not compatible with morton.\n"
+            if $features & ($bSerp | $bSquare);
+
+        # Deal out the bits of the linear index, lowest first,
+        # starting with the inner dim and skipping dims whose
+        # indices have no more bits.
+        my @rdims = reverse @$loopDims;
+        push @$code,
+            " // Zero-based, unit-stride indices for ".dimStr(@$loopDims)." on the 'morton' path.",
+            map { " idx_t ".indexVar($_)." = 0;" } @$loopDims;
+        push @$code,
+            " for (idx_t mbits = $civar, mbit = 0; mbits; mbit++) {",
+            (map { "  if (mbit < ".mortonBitsVar($_).") { ".
+                       indexVar($_)." |= (mbits & 1) << mbit; mbits >>= 1; }" } @rdims),
+            " }",
+            " // Skip indices outside the scan.",
+            " if (".join(' || ', map { indexVar($_)." >= ".numItersVar($_) } @$loopDims).")",
+            "  continue;";
+    }
+
     # No grouping.
     else {
 
@@ -505,10 +601,25 @@ sub beginLoop($$$$$$$) {
     my $loopStack = shift;      # whole stack, including enclosing dims.
 
     $endVal = numItersVar(@$loopDims) if !defined $endVal;
+    $endVal = numCurveItersVar(@$loopDims) if $features & $bCurve;
     my $itype = indexType(@$loopDims);
     my $ivar = loopIndexVar(@$loopDims);
-    push @$code, @$prefix if defined $prefix;
-    push @$code, " for ($itype $ivar = $beginVal; $ivar < $endVal; $ivar++) {";
+
+    # Work-stealing loop: each OpenMP thread gets its next index from a
+    # scheduler shared by the team instead of from an OpenMP schedule.
+    if ($features & $bSteal) {
+        die "error: work-stealing loop must begin at zero.\n" if $beginVal ne '0';
+        my $svar = stealVar(@$loopDims);
+        push @$code,
+            " // Scheduler for iterations shared by all threads.",
+            " StealScheduler $svar($endVal, omp_get_max_threads());";
+        push @$code, @$prefix if defined $prefix;
+        push @$code, " for ($itype $ivar = 0; $svar.next(omp_get_thread_num(), $ivar); ) {";
+    }
+    else {
+        push @$code, @$prefix if defined $prefix;
+        push @$code, " for ($itype $ivar = $beginVal; $ivar < $endVal; $ivar++) {";
+    }
 
     # add inner index vars.
     addIndexVars2($code, $loopDims, $features, $loopStack);
@@ -707,6 +818,9 @@ sub processCode($) {
         "#ifndef OMP_PRAGMA_PREFIX",
         "#define OMP_PRAGMA_PREFIX $OPT{ompConstruct}",
         "#endif",
+        "#ifndef OMP_STEAL_PRAGMA_PREFIX",
+        "#define OMP_STEAL_PRAGMA_PREFIX $OPT{ompStealConstruct}",
+        "#endif",
         "#ifndef OMP_PRAGMA_SUFFIX",
         "#define OMP_PRAGMA_SUFFIX",
         "#endif",
@@ -732,6 +846,19 @@ sub processCode($) {
             print "info: using OpenMP on following loop.\n";
         }
 
+        # use OpenMP with work-stealing on next loop.
+        elsif (lc $tok eq 'steal') {
+
+            # make local copies of scan index vars.
+            my $priv = "firstprivate(".join(',',@scanVars).")";
+            
+            push @loopPrefix,
+                " // Distribute iterations among OpenMP threads with work-stealing.", 
+                "#pragma OMP_STEAL_PRAGMA_PREFIX $priv OMP_PRAGMA_SUFFIX";
+            $features |= $bSteal;
+            print "info: using OpenMP with work-stealing on following loop.\n";
+        }
+
         # generate simd in next loop.
         elsif (lc $tok eq 'simd') {
 
@@ -754,6 +881,16 @@ sub processCode($) {
         elsif (lc $tok eq 'square_wave') {
             $features |= $bSquare;
         }
+
+        # use morton path in next loop if possible.
+        elsif (lc $tok eq 'morton') {
+            $features |= $bMorton;
+        }
+
+        # use hilbert path in next loop if possible.
+        elsif (lc $tok eq 'hilbert') {
+            $features |= $bHilbert;
+        }
         
         # beginning of a loop.
         # also eats the args in parens and the following '{'.
@@ -907,6 +1044,7 @@ sub processCode($) {
     push @code,
         "}",
         "#undef OMP_PRAGMA_PREFIX",
+        "#undef OMP_STEAL_PRAGMA_PREFIX",
         "#undef OMP_PRAGMA_SUFFIX",
         "// End of generated code.";
     
@@ -961,6 +1099,7 @@ sub main() {
         [ "comArgs=s", "Common arguments to all calls.", ''],
         [ "callPrefix=s", "Common prefix for function call(s).", ''],
         [ "ompConstruct=s", "Pragma to use before 'omp' loop(s).", "omp parallel for"],
+        [ "ompStealConstruct=s", "Pragma to use before 'steal' loop(s).", "omp parallel"],
         [ "innerMod=s", "Code to insert before inner loops.", ''],
         [ "output=s", "Name of output file.", 'loops.h'],
         );
@@ -979,9 +1118,13 @@ sub main() {
             "A loop statement with more than one argument will generate a single collapsed loop.\n",
             "Optional loop modifiers:\n",
             "  omp:             generate an OpenMP for loop (distribute work across SW threads).\n",
+            "  steal:           generate an OpenMP parallel region that gets iterations from a\n",
+            "                     work-stealing scheduler (alternative to 'omp').\n",
             "  grouped:         generate grouped scan within a collapsed loop.\n",
             "  serpentine:      generate reverse scan when enclosing loop dimension is odd.\n",
             "  square_wave:     generate 2D square-wave scan for two innermost dimensions of a collapsed loop.\n",
+            "  morton:          generate Z-order scan by interleaving the index bits of a collapsed loop.\n",
+            "  hilbert:         generate Hilbert-curve scan of a collapsed loop.\n",
             "A 'ScanIndices' var must be defined in C++ code prior to including the generated code.\n",
             "  This struct contains the following 'Indices' elements:\n",
             "  'begin':       [in] first index to scan in each dim.\n",
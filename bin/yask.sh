@@ -255,6 +255,11 @@ else
     envs="$envs LD_LIBRARY_PATH=./lib:$LD_LIBRARY_PATH$libpath"
 fi
 
+# Bind the threads of each block to one core when sharing a core.
+if [[ " $opts $@ " == *" -smt_share "* && ! "$envs" =~ OMP_PLACES= ]]; then
+    envs="$envs OMP_PLACES=cores"
+fi
+
 # Command sequence to be run in a shell.
 cmds="cd $dir; uname -a; sed '/^$/q' /proc/cpuinfo; lscpu; numactl -H; ldd $exe; date; $pre_cmd; env $envs $mpi_cmd $exe_prefix $exe $opts $@; $post_cmd; date"
 
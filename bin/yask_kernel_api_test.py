@@ -94,6 +94,33 @@ def read_grid(grid, timestep) :
     print("Raw data: " + repr(fp_ptr[0]) + ", ..., " + repr(fp_ptr[num_elems-1]))
     #ndarray2 = np.fromiter(fp_ptr, dtype, num_elems); print(ndarray2)
 
+    # Same slice via the NumPy copy helper.
+    ndarray2 = grid.get_ndarray(first_indices, last_indices).reshape(shape)
+    assert np.array_equal(ndarray1, ndarray2)
+
+    # Zero-copy view of the whole allocation if it is strided.
+    strided = True
+    for dname in grid.get_dim_names() :
+        if grid.get_raw_storage_stride(dname) == 0 :
+            strided = False
+    if strided :
+        view = np.asarray(grid)
+        print("Zero-copy view with shape " + repr(view.shape) + " and strides " +
+              repr(view.strides))
+
+        # Check first point in slice.
+        vpt = ()
+        for dname, idx in zip(grid.get_dim_names(), first_indices) :
+            if dname == soln.get_step_dim_name() :
+                vpt += (idx % grid.get_alloc_size(dname),)
+            elif dname in soln.get_domain_dim_names() :
+                vpt += (idx - grid.get_first_rank_alloc_index(dname),)
+            else :
+                vpt += (idx - grid.get_first_misc_index(dname),)
+        assert view[vpt] == grid.get_element(first_indices)
+    else :
+        print("Raw storage is not strided; no zero-copy view.")
+
 # Init grid using NumPy ndarray.
 def init_grid(grid, timestep) :
     print("Initializing grid '" + grid.get_name() + "' at time " + repr(timestep) + "...")
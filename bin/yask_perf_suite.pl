@@ -0,0 +1,296 @@
+#!/usr/bin/env perl
+
+##############################################################################
+## YASK: Yet Another Stencil Kernel
+## Copyright (c) 2014-2018, Intel Corporation
+## 
+## Permission is hereby granted, free of charge, to any person obtaining a copy
+## of this software and associated documentation files (the "Software"), to
+## deal in the Software without restriction, including without limitation the
+## rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+## sell copies of the Software, and to permit persons to whom the Software is
+## furnished to do so, subject to the following conditions:
+## 
+## * The above copyright notice and this permission notice shall be included in
+##   all copies or substantial portions of the Software.
+## 
+## THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+## IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+## FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+## AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+## LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+## FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+## IN THE SOFTWARE.
+##############################################################################
+
+# Purpose: Build and run several stencils with several folds and clusters,
+# append the performance of each to a history file, and compare it to a
+# baseline stored for this machine.
+
+use strict;
+use File::Basename;
+use File::Path;
+use Sys::Hostname;
+use POSIX;
+
+# command-line options.
+my $outDir = 'logs';            # dir for output.
+my $arch;                       # target architecture.
+my @stencils = qw(iso3dfd awp awp_elastic ssg fsg2 tti 3axis 9axis 3plane cube);
+my @folds = ('');               # folds to build; '' is the default for the arch.
+my @clusters = ('');            # clusters to build; '' is the default.
+my $runArgs = '-d 256 -dt 10 -t 3 -sleep 0'; # args for bin/yask.sh.
+my $makeArgs = '';              # extra make arguments.
+my $makePrefix = '';            # prefix for make.
+my $doBuild = 1;                # do compiles.
+my $tolerance = 5;              # pct below the baseline that is a regression.
+my $saveBaseline = 0;           # write results as the new baseline.
+my $machine = hostname();       # name of this machine for the files.
+
+sub usage {
+  my $msg = shift;              # error message or undef.
+
+  warn "error: $msg\n" if defined $msg;
+  warn
+      "usage: $0 [options]\n".
+      "\nOptions:\n".
+      " -arch=<ARCH>         Specify target architecture: knl, skx, hsw, ... (required).\n".
+      " -stencils=<LIST>     Comma-separated stencils (default is '".join(',', @stencils)."').\n".
+      " -folds=<LIST>        Semicolon-separated folds, e.g., 'x=4,y=4;z=16' (default is the arch default).\n".
+      " -clusters=<LIST>     Semicolon-separated clusters, e.g., ';x=2' (default is no clustering).\n".
+      " -runArgs=<ARGS>      Args for bin/yask.sh (default is '$runArgs').\n".
+      "                      The sizes and steps should be fixed, so runs are comparable.\n".
+      " -makePrefix=<CMD>    Prefix make command with <CMD>.\n".
+      " -makeArgs=<ARGS>     Pass additional <ARGS> to make command.\n".
+      " -noBuild             Do not compile; only valid with one fold and cluster per stencil.\n".
+      " -outDir=<DIR>        Directory for logs, history, and baseline (default is '$outDir').\n".
+      " -machine=<NAME>      Machine name used in the file names (default is '$machine').\n".
+      " -tolerance=<PCT>     Flag results more than <PCT>% below the baseline (default is $tolerance).\n".
+      " -saveBaseline        Save the results as the baseline for this machine.\n".
+      "\nFiles in <DIR>:\n".
+      " perf_history.<MACHINE>.csv   One line per run is appended.\n".
+      " perf_baseline.<MACHINE>.csv  Results compared against; written by -saveBaseline.\n".
+      "\nThe exit status is 1 if any result is a regression or fails.\n".
+      "\nexamples:\n".
+      " $0 -arch=skx -saveBaseline\n".
+      " $0 -arch=skx -stencils=iso3dfd,awp -folds='x=4,y=4;x=2,y=8' -clusters=';z=2'\n";
+
+  exit(defined $msg ? 1 : 0);
+}
+
+# process args.
+print "Invocation: $0 @ARGV\n";
+for my $origOpt (@ARGV) {
+  my $opt = lc $origOpt;
+
+  if ($opt eq '-h' || $opt eq '-help') {
+    usage();
+  }
+  elsif ($opt =~ '^-arch=(\S+)$') {
+    $arch = $1;
+  }
+  elsif ($opt =~ '^-stencils=(\S+)$') {
+    @stencils = split(/,/, $1);
+  }
+  elsif ($origOpt =~ /^-folds=(.*)$/i) {
+    @folds = split(/;/, $1, -1);
+  }
+  elsif ($origOpt =~ /^-clusters=(.*)$/i) {
+    @clusters = split(/;/, $1, -1);
+  }
+  elsif ($origOpt =~ /^-runargs=(.*)$/i) {
+    $runArgs = $1;
+  }
+  elsif ($origOpt =~ /^-makeargs=(.*)$/i) {
+    $makeArgs = $1;
+  }
+  elsif ($origOpt =~ /^-makeprefix=(.*)$/i) {
+    $makePrefix = $1;
+  }
+  elsif ($opt eq '-nobuild') {
+    $doBuild = 0;
+  }
+  elsif ($origOpt =~ /^-outdir=(.*)$/i) {
+    $outDir = $1;
+  }
+  elsif ($origOpt =~ /^-machine=(\S+)$/i) {
+    $machine = $1;
+  }
+  elsif ($opt =~ '^-tolerance=([.\d]+)$') {
+    $tolerance = $1;
+  }
+  elsif ($opt eq '-savebaseline') {
+    $saveBaseline = 1;
+  }
+  else {
+    usage("unknown option '$origOpt'");
+  }
+}
+usage("arch not specified") if !defined $arch;
+@folds = ('') if !@folds;
+@clusters = ('') if !@clusters;
+usage("-noBuild requires one fold and one cluster")
+  if !$doBuild && (@folds > 1 || @clusters > 1);
+
+mkpath($outDir);
+my $histFile = "$outDir/perf_history.$machine.csv";
+my $baseFile = "$outDir/perf_baseline.$machine.csv";
+my @cols = qw(date machine arch stencil fold cluster status
+              gflops gpts_per_sec gbytes_per_sec block_size);
+
+# Read the baseline, keyed by stencil, fold, and cluster.
+my %baseline;
+if (open my $fh, '<', $baseFile) {
+  my $hdr = <$fh>;
+  chomp $hdr;
+  my @hcols = split(/,/, $hdr, -1);
+  while (my $line = <$fh>) {
+    chomp $line;
+    my %r;
+    @r{@hcols} = split(/,/, $line, -1);
+    $baseline{"$r{stencil}|$r{fold}|$r{cluster}"} = \%r;
+  }
+  close $fh;
+  print "Read baseline from '$baseFile'.\n";
+}
+else {
+  print "No baseline in '$baseFile'; run with -saveBaseline to create one.\n";
+}
+
+# CSV fields may not contain commas.
+sub csvField {
+  my $val = shift;
+  $val = '' if !defined $val;
+  $val =~ s/,/ /g;
+  return $val;
+}
+
+# Convert a number with an SI suffix from makeNumStr(), e.g., '1.2G'.
+sub siVal {
+  my $str = shift;
+  return undef if !defined $str;
+  my %mult = (K => 1e3, M => 1e6, G => 1e9, T => 1e12, P => 1e15);
+  if ($str =~ /^([-+.\deE]+)([KMGTP]?)/) {
+    return $1 * ($2 ? $mult{$2} : 1);
+  }
+  return undef;
+}
+
+# Get the results from a kernel log.
+sub parseLog {
+  my $logFile = shift;
+  my %r;
+  open my $fh, '<', $logFile or return \%r;
+  my $bytesPerPt;
+  while (my $line = <$fh>) {
+    if ($line =~ /^best-throughput \(est-FLOPS\):\s+(\S+)/) {
+      $r{gflops} = siVal($1) / 1e9;
+    }
+    elsif ($line =~ /^best-throughput \(num-points\/sec\):\s+(\S+)/) {
+      $r{gpts_per_sec} = siVal($1) / 1e9;
+    }
+    elsif ($line =~ /^best-est-mem-bw \(bytes\/sec\):\s+(\S+)/) {
+      $r{gbytes_per_sec} = siVal($1) / 1e9;
+    }
+    elsif ($line =~ /est-mem-bytes per point with reuse in blocks:\s+(\S+)/) {
+      $bytesPerPt = $1;
+    }
+    elsif ($line =~ /^best-block-size:\s+(.*)$/) {
+      $r{block_size} = $1;
+    }
+    elsif ($line =~ /^\s*block-size:\s+(.*)$/ && !defined $r{block_size}) {
+      $r{block_size} = $1;
+    }
+  }
+  close $fh;
+
+  # Without hardware counts, estimate the BW from the bytes per point.
+  $r{gbytes_per_sec} = $r{gpts_per_sec} * $bytesPerPt
+    if !defined $r{gbytes_per_sec} && defined $r{gpts_per_sec} && defined $bytesPerPt;
+  return \%r;
+}
+
+# Open the history file, adding the header if new.
+my $newHist = ! -e $histFile;
+open my $histFh, '>>', $histFile or die "error: cannot append to '$histFile'\n";
+print $histFh join(',', @cols)."\n" if $newHist;
+
+my $date = strftime("%Y-%m-%dT%H:%M:%S", localtime);
+my @results;
+my $nbad = 0;
+my $run = 0;
+for my $stencil (@stencils) {
+  for my $fold (@folds) {
+    for my $cluster (@clusters) {
+      $run++;
+      my $name = "$stencil fold='$fold' cluster='$cluster'";
+      print "\n=== $name ===\n";
+      my %r = (date => $date, machine => $machine, arch => $arch,
+               stencil => $stencil, fold => $fold, cluster => $cluster);
+
+      # Build.
+      my $ok = 1;
+      if ($doBuild) {
+        my $makeCmd = "$makePrefix make clean; ".
+          "$makePrefix make -j stencil=$stencil arch=$arch";
+        $makeCmd .= " fold='$fold'" if length $fold;
+        $makeCmd .= " cluster='$cluster'" if length $cluster;
+        $makeCmd .= " $makeArgs";
+        my $makeLog = "$outDir/yask_perf_suite.$stencil.$arch.make".sprintf("%03d", $run).".log";
+        print "$makeCmd\n";
+        $ok = system("($makeCmd) > $makeLog 2>&1") == 0;
+        print "build failed; see '$makeLog'.\n" if !$ok;
+      }
+
+      # Run.
+      if ($ok) {
+        my $runLog = "$outDir/yask_perf_suite.$stencil.$arch.run".sprintf("%03d", $run).".log";
+        my $runCmd = "bin/yask.sh -stencil $stencil -arch $arch -log $runLog $runArgs";
+        print "$runCmd\n";
+        system("$runCmd > /dev/null 2>&1");
+        my $pr = parseLog($runLog);
+        %r = (%r, %$pr);
+        $ok = defined $r{gpts_per_sec};
+        print "run failed; see '$runLog'.\n" if !$ok;
+      }
+
+      # Compare to baseline.
+      my $status = $ok ? 'ok' : 'failed';
+      my $base = $baseline{"$stencil|$fold|$cluster"};
+      if ($ok && defined $base && $base->{gpts_per_sec} > 0) {
+        my $pct = 100 * ($r{gpts_per_sec} / $base->{gpts_per_sec} - 1);
+        printf "throughput is %.2f%% vs. baseline of %g GPts/s on %s.\n",
+          $pct, $base->{gpts_per_sec}, $base->{date};
+        $status = 'regression' if $pct < -$tolerance;
+      }
+      elsif ($ok) {
+        $status = 'new';
+      }
+      $nbad++ if $status eq 'regression' || $status eq 'failed';
+      $r{status} = $status;
+      printf "status: %s, GFLOPS: %s, GPts/s: %s, GB/s: %s, block-size: %s\n",
+        $status, map { defined $r{$_} ? $r{$_} : 'n/a' }
+        qw(gflops gpts_per_sec gbytes_per_sec block_size);
+
+      my $line = join(',', map { csvField($r{$_}) } @cols)."\n";
+      print $histFh $line;
+      push @results, $line if $ok;
+    }
+  }
+}
+close $histFh;
+print "\nAppended results to '$histFile'.\n";
+
+if ($saveBaseline) {
+  open my $fh, '>', $baseFile or die "error: cannot write '$baseFile'\n";
+  print $fh join(',', @cols)."\n", @results;
+  close $fh;
+  print "Saved ".scalar(@results)." result(s) as baseline in '$baseFile'.\n";
+}
+
+if ($nbad) {
+  print "$nbad regression(s) or failure(s) found.\n";
+  exit 1;
+}
+print "No regressions found.\n";
+exit 0;
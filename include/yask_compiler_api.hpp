@@ -251,6 +251,25 @@ namespace yask {
         virtual yc_grid_ptr
         get_grid(const std::string& name /**< [in] Name of the grid. */ ) =0;
         
+        /// **[Advanced]** Batch independent problems along a new domain dimension.
+        /**
+           When format() is called, `dim` is added to each non-scratch
+           grid that is updated by an equation and to each scratch grid
+           that depends on one, and every point in those grids is indexed
+           by `dim` at offset zero. Grids that are only read, e.g.,
+           model parameters, do not get `dim`, so one copy is shared by
+           all the problems in the batch, and each value read is reused
+           across the batch.
+           The size of the batch is the domain size in `dim`, which is
+           set in the kernel like any other domain size.
+           To vectorize across the batch, apply a fold only in `dim`
+           via set_fold_len(); then the shared values are broadcast.
+           @note `dim` must not already be used by any grid. */
+        virtual void
+        set_batch_dim(const yc_index_node_ptr dim
+                      /**< [in] Batch dimension, e.g., "shot".
+                         This must be an index created by new_domain_index(). */ ) =0;
+
         /// Set the vectorization length in given dimension.
         /** For YASK-code generation, the product of the fold lengths should
             be equal to the number of elements in a HW SIMD register.
@@ -317,6 +336,9 @@ namespace yask {
             avx2    | YASK stencil classes for CORE AVX2 ISA.
             avx512  | YASK stencil classes for CORE AVX-512 & MIC AVX-512 ISAs.
             knc     | YASK stencil classes for Knights Corner ISA. 
+            omp-target | YASK stencil classes with OpenMP target offload of sub-blocks.
+            sve     | YASK stencil classes for ARM SVE ISA.
+            neon    | YASK stencil classes for ARM NEON ISA.
             dot     | DOT-language description.
             dot-lite| DOT-language description of grid accesses only.
             pseudo  | Human-readable pseudo-code (for debug).
@@ -324,6 +346,8 @@ namespace yask {
             Progress text will be written to the output stream set via set_debug_output().
 
             @note "avx512f" is allowed as an alias for "avx512".
+            @note The "sve" vector length is 512 bits unless changed
+            with the `-sve-bits` option of the stencil compiler.
             @warning *Side effect:* Applies optimizations to the equation(s), so some pointers
             to nodes in the original equations may refer to modified nodes or nodes
             that have been optimized away after calling format().
@@ -438,6 +462,33 @@ namespace yask {
          */
         virtual void
         clear_dependencies() =0;
+
+        /// **[Advanced]** Add a reduction of the values written by an equation.
+        /**
+           The generated kernel combines the values written to the LHS grid of
+           `equation` in each step over the whole problem domain, as each part
+           of the domain is calculated, so no extra pass over the grid is needed.
+           The results are available after each step via
+           yk_solution::get_reduction().
+
+           Currently supported operations:
+           Name    | Result
+           --------|--------
+           sum     | Sum of the values.
+           sum_sq  | Sum of the squares of the values, e.g., for an L2 norm.
+           max_abs | Maximum absolute value.
+
+           The equation must not update a scratch grid.
+         */
+        virtual void
+        add_reduction(const std::string& name
+                      /**< [in] Name used to get the results from the kernel.
+                         May be used for several equations with the same
+                         `op`, e.g., for updates under different conditions. */,
+                      yc_equation_node_ptr equation
+                      /**< [in] Equation whose output is reduced. */,
+                      const std::string& op
+                      /**< [in] Name of operation from the above table. */) =0;
     };
 
     /// A compile-time grid.
@@ -468,6 +519,62 @@ namespace yask {
         virtual std::vector<std::string>
         get_dim_names() const =0;
 
+        /// Set the precision used to store the grid's elements.
+        /**
+           Reduced-precision storage halves the memory used by the grid
+           and the bandwidth needed to read it. Values are converted to
+           the kernel's `real_t` type when loaded, so all arithmetic is
+           done at full precision.
+
+           Only grids that are not updated by any equation and that
+           contain all the vector-folded dimensions can use reduced
+           precision; it is ignored for other grids that are read only.
+           Values set via the kernel APIs are rounded to the storage precision.
+
+           Lookup-table storage keeps each distinct value of the grid once
+           in a table and stores a one- or two-byte index per element, so
+           values are exact. It suits parameter grids with few distinct
+           values, e.g., layered material models. Storing more distinct
+           values than the index can address throws an exception in the kernel.
+        */
+        virtual void
+        set_storage_precision(const std::string& precision
+                              /**< [in] "real" for the kernel `real_t` type (default),
+                                 "bf16" for bfloat16, "fp16" for IEEE half precision,
+                                 "lut8" for a table of up to 256 values, or
+                                 "lut16" for a table of up to 65536 values. */ ) =0;
+
+        /// Get the precision used to store the grid's elements.
+        /** @returns String set via set_storage_precision() or "real". */
+        virtual const std::string&
+        get_storage_precision() const =0;
+
+        /// Store the grid interleaved with others in a group.
+        /**
+           The kernel allocates the grids in a group together and stores
+           their vectors interleaved, so the vectors of all the grids at
+           a point are adjacent in memory. Grids that are always read
+           together, e.g., the stress components of an elastic model,
+           then use one memory stream instead of one per grid.
+
+           Only vector-folded grids with full-precision storage and the
+           same dimensions, step allocation, and misc indices as the other
+           grids in the group are interleaved; others are stored
+           separately with a notice from the compiler.
+           Raw storage of an interleaved grid is not contiguous, so
+           yk_grid::get_raw_storage_buffer() and yk_grid::save_storage()
+           should not be used with it.
+        */
+        virtual void
+        set_interleave_group(const std::string& name
+                             /**< [in] Name of the group, or an empty
+                                string to store the grid separately (default). */ ) =0;
+
+        /// Get the interleave group of the grid.
+        /** @returns String set via set_interleave_group() or an empty string. */
+        virtual const std::string&
+        get_interleave_group() const =0;
+
         /// Create a reference to a point in a grid.
         /**
            Each expression in `index_exprs` describes how to access
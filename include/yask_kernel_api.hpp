@@ -34,6 +34,7 @@ IN THE SOFTWARE.
 
 #include "yask_common_api.hpp"
 #include <vector>
+#include <functional>
 #include <cinttypes>
 
 namespace yask {
@@ -62,6 +63,15 @@ namespace yask {
     /// Shared pointer to \ref yk_stats.
     typedef std::shared_ptr<yk_stats> yk_stats_ptr;
 
+    class yk_run_handle;
+    /// Shared pointer to \ref yk_run_handle.
+    typedef std::shared_ptr<yk_run_handle> yk_run_handle_ptr;
+
+    /// Function called by the kernel at each step; see yk_solution::add_step_callback().
+    typedef std::function<void (idx_t step_index,
+                                const std::vector<idx_t>& first_indices,
+                                const std::vector<idx_t>& last_indices)> yk_step_callback;
+
     /** @}*/
 } // namespace yask.
 
@@ -120,6 +130,61 @@ namespace yask {
                      const yk_solution_ptr source
                      /**< [in] Pointer to existing \ref yk_solution from which
                         the settings will be copied. */ ) const;
+
+        /// **[Advanced]** Create a stencil solution from code generated at run time.
+        /**
+           Builds a kernel library from a file written by yc_solution::format()
+           unless one built from the same code and settings is already in
+           `cache_dir`, loads it, and creates a solution from it.
+           This allows a stencil to be specialized to values known only at
+           run time without rebuilding the application.
+           The library is built with the same YASK source tree, architecture,
+           MPI setting, and compiler as this one, so the kernel source
+           directory used to build this library must still exist.
+           With MPI, rank zero builds the library, so `cache_dir` must be
+           visible to all ranks.
+           @returns Pointer to new solution object.
+        */
+        virtual yk_solution_ptr
+        new_jit_solution(yk_env_ptr env /**< [in] Pointer to env info. */,
+                         const std::string& code_file
+                         /**< [in] Name of file containing the output of
+                            yc_solution::format() for the YASK target of this kernel. */,
+                         const std::string& cache_dir = ""
+                         /**< [in] Directory for built libraries. If empty,
+                            `$YASK_JIT_DIR` or `$TMPDIR/yask_jit` is used,
+                            with `/tmp` if `$TMPDIR` is not set. */,
+                         const std::string& make_args = ""
+                         /**< [in] Additional arguments for the kernel `make` command. */ ) const;
+
+        /// **[Advanced]** Create a stencil solution from the best kernel variant for its settings.
+        /**
+           Variants of a kernel are built from the same stencil with other
+           architecture, fold, and cluster settings via the `variants` make
+           variable, e.g., `make stencil=iso3dfd arch=hsw variants="skx/x=4,y=4/x=1 hsw/z=8/x=1"`.
+           Each one is built into its own library next to this one.
+           Candidates are the source solution and each variant that has been built
+           and whose architecture is supported by the CPUs of all ranks.
+           - If `bench_steps` is zero, the candidate whose clusters leave the fewest
+           unused points in the rank domains is chosen, preferring larger clusters
+           when equal.
+           - If `bench_steps` is positive, each candidate is prepared and run for
+           that many steps, and the fastest one is chosen.
+           The settings from the `yk_solution::set_*()` functions that take a
+           dimension name are copied from the source to the chosen solution.
+           The same variant is chosen on all ranks, so this must be called on all ranks.
+           Use yk_solution::get_target(), yk_solution::get_fold_size(), and
+           yk_solution::get_cluster_size() to see which one was chosen.
+           @returns Pointer to the source or a new solution object.
+        */
+        virtual yk_solution_ptr
+        new_variant_solution(yk_env_ptr env /**< [in] Pointer to env info. */,
+                             const yk_solution_ptr source
+                             /**< [in] Pointer to a solution from this library whose
+                                settings are used. It should not be prepared yet. */,
+                             int bench_steps = 0
+                             /**< [in] Number of steps to time each candidate
+                                or zero to choose without running. */ ) const;
     };
 
     /// Kernel environment.
@@ -146,6 +211,19 @@ namespace yask {
          */
         virtual void
         global_barrier() const =0;
+
+        /// Free the memory kept for reuse across solutions.
+        /**
+           When the `-alloc_pool` option is set, the memory of a solution
+           is kept in a process-wide pool when it is released, e.g., by
+           yk_solution::end_solution(), so that it can be reused by later
+           solutions that need the same sizes.
+           This frees all the memory currently in the pool; memory still in
+           use by any solution is not affected.
+           @returns Number of bytes freed.
+         */
+        virtual idx_t
+        clear_alloc_pool() =0;
     };
 
     /** @}*/
@@ -598,7 +598,79 @@ namespace yask {
                               /**< [in] List of initial indices, one for each grid dimension. */,
                               const std::vector<idx_t>& last_indices
                               /**< [in] List of final indices, one for each grid dimension. */ ) =0;
-        
+
+        /// Initialize all grid elements from a 1-D profile.
+        /**
+           Sets all allocated elements, including those in the padding area,
+           so that the element at index `i` in dimension `dim` gets
+           `values[i - first_index]`, regardless of its indices in the other
+           dimensions.
+           Indices before or after the profile get its first or last value,
+           respectively.
+           This is much faster than setting slices when a model only varies
+           in one dimension, e.g., a velocity that depends only on depth.
+           If storage has not been allocated for this grid, this will have no effect.
+           @returns Number of elements set.
+        */
+        virtual idx_t
+        set_elements_from_profile(const std::string& dim
+                                  /**< [in] Name of dimension in which the values vary.
+                                     Must be a domain or misc dimension of this grid. */,
+                                  idx_t first_index
+                                  /**< [in] Index in `dim` of the first value. */,
+                                  const std::vector<double>& values
+                                  /**< [in] Values at consecutive indices in `dim`. */ ) =0;
+
+        /// Initialize all grid elements from a layered model.
+        /**
+           Sets all allocated elements, including those in the padding area,
+           so that the element at index `i` in dimension `dim` gets
+           `values[k]`, where `k` is the number of entries in `boundaries`
+           that are less than or equal to `i`.
+           Thus, `values[0]` is used before `boundaries[0]`, and the last value
+           is used at and after the last boundary.
+           If storage has not been allocated for this grid, this will have no effect.
+           @returns Number of elements set.
+        */
+        virtual idx_t
+        set_elements_from_layers(const std::string& dim
+                                 /**< [in] Name of dimension across the layers.
+                                    Must be a domain or misc dimension of this grid. */,
+                                 const std::vector<idx_t>& boundaries
+                                 /**< [in] Index in `dim` of the first element in each layer
+                                    after the first one, in increasing order. */,
+                                 const std::vector<double>& values
+                                 /**< [in] Value in each layer. Must have one more entry
+                                    than `boundaries`. */ ) =0;
+
+        /// Initialize all grid elements from a coarse grid.
+        /**
+           The coarse grid has a point every `spacings[j]` elements in the
+           `j`th domain dimension of this grid, starting at index zero, i.e., at the
+           first index of the *overall* problem domain.
+           Its values are given in row-major order over the domain
+           dimensions in the order returned by get_dim_names(), so the
+           last domain dimension is unit-stride in `values`.
+           Sets all allocated elements, including those in the padding area,
+           by nearest-neighbor or multi-linear interpolation between the coarse
+           points; elements outside the coarse grid get the value at the
+           nearest coarse point in each dimension.
+           The values do not depend on the step or misc indices.
+           If storage has not been allocated for this grid, this will have no effect.
+           @returns Number of elements set.
+        */
+        virtual idx_t
+        set_elements_from_coarse_grid(const std::vector<double>& values
+                                      /**< [in] Values at the coarse points. */,
+                                      const std::vector<idx_t>& coarse_sizes
+                                      /**< [in] Number of coarse points in each domain dimension. */,
+                                      const std::vector<idx_t>& spacings
+                                      /**< [in] Distance between coarse points in each domain
+                                         dimension, in elements. */,
+                                      bool linear = true
+                                      /**< [in] If true, use multi-linear interpolation;
+                                         if false, use the nearest coarse point. */ ) =0;
+
         /// Format the indices for pretty-printing.
         /**
            Provide indices in a list in the same order returned by get_dim_names().
@@ -906,6 +978,9 @@ namespace yask {
            and some other grid, any given element index applied to both grids
            will refer to an element at the same offset into their respective
            data buffers. 
+           - None of the above hold for a grid whose storage is interleaved
+           with that of other grids in the same group,
+           as set by yc_grid::set_interleave_group().
 
            Thus,
            - You can perform element-wise unary mathematical operations on
@@ -919,7 +994,9 @@ namespace yask {
            The following assumptions are not safe:
            - Any expectations regarding the relationship between an element
            index and that element's offset from the beginning of the buffer
-           such as row-major or column-major layout.
+           such as row-major or column-major layout,
+           unless get_raw_storage_stride() returns a non-zero value for
+           every dimension.
            - All elements in the buffer are part of the rank domain or halo.
 
            Thus,
@@ -932,6 +1009,150 @@ namespace yask {
         */
         virtual void* get_raw_storage_buffer() =0;
 
+        /// **[Advanced]** Get the distance between elements in the raw storage buffer along the specified dimension.
+        /**
+           If this returns a non-zero value for every dimension in the grid,
+           the buffer from get_raw_storage_buffer() can be accessed as a
+           strided array: the element at get_first_rank_alloc_index() in
+           each domain dimension, get_first_misc_index() in each misc
+           dimension and index zero in the step dimension is at the
+           beginning of the buffer, and each increment of an index moves
+           the given number of elements through the buffer.
+           This allows zero-copy views of the storage, e.g., NumPy arrays
+           from the Python API.
+           Indices in the step dimension wrap around the allocation, so
+           position `i` along that dimension holds the steps that are equal
+           to `i` modulo get_alloc_size().
+           Zero is returned when the elements in the dimension are not at
+           a const stride, e.g., when the dimension is vector-folded.
+           Use get_elements_in_slice() to copy the elements in that case.
+           @returns Number of elements between consecutive indices in the
+           dimension or zero.
+        */
+        virtual idx_t
+        get_raw_storage_stride(const std::string& dim
+                               /**< [in] Name of dimension to get.
+                                  Must be one of the names from get_dim_names(). */ ) const =0;
+
+        /// **[Advanced]** Get the number of bytes in each element of the raw storage buffer.
+        /**
+           @returns Same value as yk_solution::get_element_bytes().
+        */
+        virtual int
+        get_element_bytes() const =0;
+
+        /// **[Advanced]** Register a set of points to be sampled by get_samples().
+        /**
+           Each sample is a weighted sum of the values at `points_per_sample`
+           points, e.g., 1 point with weight 1 for the nearest grid point,
+           8 points for trilinear interpolation or more for windowed-sinc
+           interpolation.
+           Each point is given by one index for each dimension returned by
+           get_dim_names() except the step dimension, in the same order.
+           Indices are relative to the *overall* problem domain and
+           must fall within the allocated space of this grid in this rank.
+           The positions of the points are found once, when get_samples() is
+           first called after storage is allocated, so sampling does not
+           need to check indices for each point.
+           @returns Index of the new set, to be passed to get_samples().
+        */
+        virtual int
+        add_sample_set(const std::vector<idx_t>& indices
+                       /**< [in] Indices of all the points of all the samples, one
+                          point after another. */,
+                       const std::vector<double>& weights
+                       /**< [in] Weight of each point, or empty to use 1.0
+                          for all points. */,
+                       idx_t points_per_sample
+                       /**< [in] Number of points summed for each sample. */ ) =0;
+
+        /// **[Advanced]** Get the values of a set of samples.
+        /**
+           Writes one value for each sample in the set registered by
+           add_sample_set() to consecutive memory locations,
+           starting at `buffer_ptr`.
+           The buffer pointed to must contain either 4 or 8 byte FP values per
+           sample, depending on the FP precision of the solution.
+           @returns Number of samples written.
+        */
+        virtual idx_t
+        get_samples(void* buffer_ptr
+                    /**< [out] Pointer to buffer where values will be written. */,
+                    int set_index
+                    /**< [in] Value returned by add_sample_set(). */,
+                    idx_t step_index
+                    /**< [in] Index in the step dimension; ignored if this grid
+                       does not use the step dimension. */ ) =0;
+
+        /// **[Advanced]** Register a set of sources to be injected into this grid.
+        /**
+           Each source adds its value at each step, multiplied by the weight
+           of each point, to the values at `points_per_source` points, e.g.,
+           the 8 points around an off-grid location.
+           The points are given as in add_sample_set().
+           The values are added by yk_solution::run_solution() right after
+           the stencils compute the step where they appear, inside the same step
+           loop, so a range of steps may be run in one call, including with
+           wave-front tiling.
+           Values for step `first_step_index + k` are
+           `values[k * ns]` through `values[k * ns + ns - 1]`,
+           where `ns` is the number of sources, so the length of
+           `values` must be a multiple of `ns`.
+           Nothing is added at steps outside of the series.
+           Points are updated only where this rank calculates the grid,
+           so, when using MPI, a source near a rank boundary should be
+           registered in each rank whose allocated space contains it.
+           Temporal blocking is not used while any sources are registered.
+           @returns Index of the new set.
+        */
+        virtual int
+        add_source_set(const std::vector<idx_t>& indices
+                       /**< [in] Indices of all the points of all the sources, one
+                          point after another. */,
+                       const std::vector<double>& weights
+                       /**< [in] Weight of each point, or empty to use 1.0
+                          for all points. */,
+                       idx_t points_per_source
+                       /**< [in] Number of points updated by each source. */,
+                       const std::vector<double>& values
+                       /**< [in] Value of each source at each step,
+                          one step after another. */,
+                       idx_t first_step_index
+                       /**< [in] Index in the step dimension of the first values. */ ) =0;
+
+        /// **[Advanced]** Remove all sources registered by add_source_set().
+        virtual void
+        clear_source_sets() =0;
+
+        /// **[Advanced]** Write the raw data storage and its layout to a file.
+        /**
+           The file contains a description of the storage layout followed
+           by a copy of the buffer from get_raw_storage_buffer().
+           It may be used later by set_storage_file(), e.g., to restart a
+           simulation without reading the file element by element.
+         */
+        virtual void
+        save_storage(const std::string& filename
+                     /**< [in] Name of file to write in this rank. */ ) const =0;
+
+        /// **[Advanced]** Use a file written by save_storage() as the data storage.
+        /**
+           After this call, allocation of this grid via alloc_storage() or
+           yk_solution::prepare_solution() maps the file into memory instead
+           of allocating and initializing new storage.
+           Pages are read from the file as they are first accessed, and
+           changes to the grid are not written back to the file.
+           If storage is already allocated, it is replaced by the file now.
+           The file must have been written from a grid with the same name,
+           type and storage layout, including domain, padding and
+           step-dimension allocation sizes in each dimension, as this grid
+           has when the file is mapped; otherwise an exception is thrown.
+           Use an empty string to go back to allocating the storage.
+        */
+        virtual void
+        set_storage_file(const std::string& filename
+                         /**< [in] Name of file to map in this rank. */ ) =0;
+
         /* Deprecated APIs for yk_grid found below should be avoided.
            Use the more explicit form found in the documentation. */
         
@@ -93,6 +93,36 @@ namespace yask {
         */
         virtual int 
         get_element_bytes() const =0;
+
+        /// Get the architecture this solution's kernel was built for.
+        /**
+           @returns String containing the `arch` setting used to build the
+           kernel library, e.g., "hsw" or "skx".
+        */
+        virtual std::string
+        get_target() const =0;
+
+        /// Get the number of points in each SIMD vector in the specified dimension.
+        /**
+           This is the vector fold set when the kernel was built.
+           @returns Number of points in the fold in `dim`.
+        */
+        virtual idx_t
+        get_fold_size(const std::string& dim
+                      /**< [in] Name of dimension to get.  Must be one of
+                         the names from get_domain_dim_names(). */) const =0;
+
+        /// Get the number of points in each cluster of vectors in the specified dimension.
+        /**
+           This is the fold size multiplied by the cluster multiple set when the
+           kernel was built.
+           Block sizes are rounded up to a multiple of this value.
+           @returns Number of points in the cluster in `dim`.
+        */
+        virtual idx_t
+        get_cluster_size(const std::string& dim
+                         /**< [in] Name of dimension to get.  Must be one of
+                            the names from get_domain_dim_names(). */) const =0;
         
         /// Get the solution step dimension.
         /**
@@ -277,6 +307,10 @@ namespace yask {
            Since this function initiates MPI communication, it must be called
            on all MPI ranks, and it will block until all ranks have completed.
            Must be called before applying any stencils.
+           May be called again after changing settings. Grids keep their
+           storage and data unless their allocation sizes change, and the
+           rank positions and bounding-boxes are only found again if the
+           rank layout or sizes changed.
         */
         virtual void
         prepare_solution() =0;
@@ -399,6 +433,29 @@ namespace yask {
         virtual void
         run_solution(idx_t step_index /**< [in] Index in the step dimension */ ) =0;
 
+        /// **[Advanced]** Start running the stencil solution without waiting for it to finish.
+        /**
+           Runs `run_solution(first_step_index, last_step_index)` on a
+           separate host thread, which starts its own OpenMP thread teams,
+           and returns immediately.
+           Use the returned handle to check for or wait for completion and to
+           pause the run at a safe point between steps.
+
+           While the run is active:
+           - Do not call any other function of this solution, its grids or its
+           environment except through the handle, because the kernel's
+           MPI calls must not overlap others.
+           - Do not read or write any grid elements unless the run is paused
+           via yk_run_handle::pause_after_step() or has finished.
+
+           Only one asynchronous run may be active at a time per solution.
+           Calling end_solution() waits for any active run to finish.
+           @returns Handle to the new run.
+        */
+        virtual yk_run_handle_ptr
+        run_solution_async(idx_t first_step_index /**< [in] First index in the step dimension */,
+                           idx_t last_step_index /**< [in] Last index in the step dimension */ ) =0;
+
         /// Finish using a solution.
         /**
            Performs a final MPI halo exchange.
@@ -750,6 +807,178 @@ namespace yask {
         virtual int
         get_default_numa_preferred() const =0;
 
+        /// **[Advanced]** Use precomputed bounding-boxes from a file.
+        /**
+           Finding the points where each stencil bundle is valid requires
+           evaluating its sub-domain condition at every point in the rank,
+           which can take a long time for large domains.
+           After this call, prepare_solution() will read the bounding-boxes
+           from the given file instead, which must have been written by
+           save_bounding_boxes() for the same stencil, domain sizes, and
+           rank indices. If not, prepare_solution() will throw an exception.
+           Use an empty string to go back to finding the bounding-boxes
+           in prepare_solution().
+           The `-bb_cache_dir` command-line option may be used instead to
+           save and reload the bounding-boxes automatically.
+        */
+        virtual void
+        load_bounding_boxes(const std::string& filename
+                            /**< [in] Name of file to read in this rank. */ ) =0;
+
+        /// **[Advanced]** Save the bounding-boxes found by prepare_solution() to a file.
+        /**
+           This function should be called only *after* calling prepare_solution().
+           The file may be used in a later call to load_bounding_boxes().
+        */
+        virtual void
+        save_bounding_boxes(const std::string& filename
+                            /**< [in] Name of file to write in this rank. */ ) =0;
+
+        /// **[Advanced]** Set the minimum finite-difference order needed in a box.
+        /**
+           For stencils that provide equations of several orders with
+           `min_order()` conditions, e.g., "iso3dfd_var", each point is
+           updated by the lowest-order equation allowed by the boxes
+           that contain it. Where boxes overlap, the last one set is used.
+           Outside of all boxes, the highest order is used.
+           The indices are relative to the overall problem, and the last
+           ones are inclusive.
+           Takes effect in the next call to prepare_solution().
+           The `-order_file` command-line option may be used instead.
+        */
+        virtual void
+        set_min_order(const std::vector<idx_t>& first_indices
+                      /**< [in] First index in each domain dimension. */,
+                      const std::vector<idx_t>& last_indices
+                      /**< [in] Last index in each domain dimension. */,
+                      idx_t order
+                      /**< [in] Minimum order needed in the box. */ ) =0;
+
+        /// **[Advanced]** Remove the boxes set by set_min_order().
+        /**
+           Takes effect in the next call to prepare_solution().
+        */
+        virtual void
+        clear_min_orders() =0;
+
+        /// **[Advanced]** Write a snapshot of grids to a file in the background.
+        /**
+           Copies the elements of the given grids into a staging buffer
+           and returns while a background thread writes the buffer to
+           `filename`, so the application can continue, e.g., by calling
+           run_solution().
+           For each grid, the elements in the rank domain of each domain
+           dimension and all indices in each misc dimension are written.
+           Grids that use the step dimension are written at `step_index`,
+           which must still be held in their allocation.
+           Two staging buffers are used, so a snapshot may be taken while the
+           previous one is still being written. If a snapshot is requested
+           while both are in use, this call waits for the earlier write
+           to finish first.
+           Each rank writes its own file, so `filename` should be unique
+           to each rank, e.g., by including get_rank_index().
+
+           The file starts with text lines giving the format version,
+           stencil name, step index, element size and, for each grid, its
+           name, number of elements and index range in each dimension, followed by
+           a line "data". The elements of each grid follow in binary in the
+           same order, each grid laid out as from yk_grid::get_elements_in_slice().
+
+           This function should be called only *after* calling prepare_solution().
+           Errors from writing are reported by the next call to this function
+           or to wait_for_snapshots().
+        */
+        virtual void
+        write_snapshot(const std::string& filename
+                       /**< [in] Name of file to write in this rank. */,
+                       idx_t step_index
+                       /**< [in] Index in the step dimension to write. */,
+                       const std::vector<std::string>& grid_names
+                       /**< [in] Names of grids to write.
+                          If empty, all grids that use the step dimension are written. */ ) =0;
+
+        /// **[Advanced]** Wait for snapshots being written in the background.
+        /**
+           Blocks until all files from earlier calls to write_snapshot()
+           have been written.
+           This is also done by end_solution().
+        */
+        virtual void
+        wait_for_snapshots() =0;
+
+        /// **[Advanced]** Register a function to be called within the step loop.
+        /**
+           The callback is called with the index of each step computed by
+           run_solution() right after the stencils and any sources
+           from yk_grid::add_source_set() have updated that step, and with the
+           first and last indices of a span of points in each domain
+           dimension, in the order returned by get_domain_dim_names().
+           This allows per-step work, e.g., boundary updates or norms, to be
+           done without calling run_solution() for one step at a time.
+
+           The footprint of the callback is declared by `read_grids`,
+           `write_grids` and `reach`:
+           - If `reach` is zero, the callback may only access the
+             elements of these grids at `step_index` and earlier steps
+             within the span given. It is called once for each span of each
+             region, so wave-front tiling is still used, and the spans may
+             include points outside of the rank domain that are computed
+             redundantly by the tiling. Calls for different spans and steps
+             may come in any order that respects the stencil dependencies.
+           - If `reach` is greater than zero, the callback may also read the
+             elements within `reach` points outside of the span, which is the
+             whole rank domain. It is called once per step after the
+             halos of `read_grids` are exchanged, so `reach` must not exceed
+             their halo sizes. This requires the region size in the step
+             dimension to be one, i.e., no wave-front tiling.
+
+           Grids in `write_grids` are marked as modified at `step_index`, so
+           their halos are exchanged before they are next read by the stencils.
+           Callbacks are called from one thread at a time, in the order they
+           were added. They are also called by the reference code used for
+           validation.
+           @returns Index of the new callback.
+        */
+        virtual int
+        add_step_callback(yk_step_callback callback
+                          /**< [in] Function to call. */,
+                          const std::vector<yk_grid_ptr>& read_grids
+                          /**< [in] Grids read by the callback. */,
+                          const std::vector<yk_grid_ptr>& write_grids
+                          /**< [in] Grids written by the callback. */,
+                          idx_t reach
+                          /**< [in] Number of points outside of the span that may be read. */ ) =0;
+
+        /// **[Advanced]** Remove all callbacks added by add_step_callback().
+        virtual void
+        clear_step_callbacks() =0;
+
+        /// Get the names of the reductions in the solution.
+        /**
+           Reductions are declared in the stencil compiler with
+           yc_solution::add_reduction() and are computed while the
+           equations are evaluated by run_solution().
+           @returns List of reduction names.
+        */
+        virtual std::vector<std::string>
+        get_reduction_names() const =0;
+
+        /// Get the value of a reduction at a step.
+        /**
+           The value covers the points written at `step_index` in the
+           domains of all ranks.  Only values for the steps written by
+           the most recent call to run_solution() are available.
+           Points in the extra pads and halos and points outside any
+           sub-domain of the equation are not included.
+           @returns Value of the reduction, e.g., the sum of the squares
+           for a "sum_sq" reduction.
+        */
+        virtual double
+        get_reduction(const std::string& name
+                      /**< [in] Name of the reduction. */,
+                      idx_t step_index
+                      /**< [in] Step index of the values reduced. */ ) const =0;
+
         /// **[Advanced]** Set performance parameters from an option string.
         /**
            Parses the string for options as if from a command-line.
@@ -776,6 +1005,62 @@ namespace yask {
                            /**< [in] Solution from which grid storage will be shared. */) =0;
     };
 
+    /// Handle to a run started by yk_solution::run_solution_async().
+    /**
+       Safe points occur after each group of steps is finished on this rank,
+       i.e., after each step or, with temporal wave-front tiling, after the
+       steps in each region.
+       All functions must be called from one host thread.
+    */
+    class yk_run_handle {
+    public:
+        virtual ~yk_run_handle() {}
+
+        /// Check whether the run has finished.
+        /**
+           Does not block.
+           If the run failed, throws a \ref yask_exception with its message
+           once the run has finished.
+           @returns `true` if the run has finished, `false` otherwise.
+        */
+        virtual bool
+        test() =0;
+
+        /// Wait for the run to finish.
+        /**
+           Resumes the run if it is paused.
+           If the run failed, throws a \ref yask_exception with its message.
+        */
+        virtual void
+        wait() =0;
+
+        /// Pause the run at a safe point.
+        /**
+           Blocks until the run is paused at the first safe point at or after
+           `step_index` has been calculated or until the run finishes.
+           While paused, grid elements at the steps done may be read or
+           written, e.g., via yk_grid::get_element().
+           If the run is already paused at an earlier step, it is resumed
+           until the new safe point.
+           @returns `true` if the run is paused, `false` if it has finished.
+        */
+        virtual bool
+        pause_after_step(idx_t step_index
+                         /**< [in] Step index that must be done before pausing. */ ) =0;
+
+        /// Continue a run paused by pause_after_step().
+        virtual void
+        resume() =0;
+
+        /// Get the last step index calculated by the run.
+        /**
+           @returns Last step index finished on this rank, or one step before the
+           first step index if no steps have been finished.
+        */
+        virtual idx_t
+        get_last_step_done() =0;
+    };
+
     /// Statistics from calls to run_solution().
     /**
        A throughput rate may be calculated by multiplying an
@@ -825,6 +1110,94 @@ namespace yask {
         */
         virtual double
         get_elapsed_run_secs() =0;
+
+        /// Get the efficiency of overlapping halo exchange with computation.
+        /**
+           Only meaningful when MPI halo exchanges are overlapped with
+           computation, i.e., when the "-overlap_comms" option is used.
+           @returns Fraction in [0, 1] of the time overlapped exchanges were
+           in flight that was not spent waiting for them to complete,
+           or zero if no exchanges were overlapped.
+        */
+        virtual double
+        get_halo_overlap_efficiency() =0;
+
+        /// Get the names of the timers in the timer tree.
+        /**
+           Timers are named by their path in the tree, with '/' between
+           the levels, and are listed with each parent before its children:
+           Name                                  | Time in
+           --------------------------------------|--------
+           run                                   | yk_solution::run_solution().
+           run/compute                           | All stencil packs.
+           run/compute/<pack>                    | One pack.
+           run/compute/<pack>/<bundle>           | One bundle, including its scratch bundles.
+           run/compute/<pack>/<bundle>/scratch   | The scratch bundles needed by the bundle.
+           run/halo                              | MPI halo exchanges.
+           run/halo/pack                         | Copying halos into send buffers.
+           run/halo/wait                         | Waiting for halo messages.
+           run/halo/unpack                       | Copying halos from receive buffers.
+
+           The compute times are measured by each thread that evaluates
+           blocks and averaged over those threads, so they are comparable
+           to the elapsed time of run_solution().
+           The halo times are empty if MPI is not enabled.
+           @returns List of timer names.
+        */
+        virtual std::vector<std::string>
+        get_timer_names() =0;
+
+        /// Get the time in one timer of the timer tree.
+        /**
+           @returns Number of seconds in the timer named `name`, which
+           must be one of the names from get_timer_names().
+        */
+        virtual double
+        get_timer_secs(const std::string& name
+                       /**< [in] Path of the timer in the tree. */ ) =0;
+
+        /// Get the timer tree in JSON format.
+        /**
+           Each node is an object with "name", "secs", and, if it has
+           any, "children", which is a list of nodes.
+           @returns JSON object for the "run" timer.
+        */
+        virtual std::string
+        get_timers_json() =0;
+
+        /// Get the names of the available hardware event counts.
+        /**
+           Counts are only collected if the kernel was built with
+           `perf_events=1` and the OS allows user-mode hardware events
+           via `perf_event_open()`.
+           Name         | Count of
+           -------------|---------
+           cycles       | Core clock cycles.
+           instructions | Instructions retired.
+           l2_misses    | Last-level-cache references, i.e., L2 misses.
+           dram_bytes   | Last-level-cache misses times the cache-line size.
+
+           The counts come from the generic Linux events, so their exact
+           meaning depends on the CPU.
+           @returns List of event names or an empty list if no counts
+           were collected.
+        */
+        virtual std::vector<std::string>
+        get_counter_names() =0;
+
+        /// Get the hardware event count in one compute timer.
+        /**
+           Counts are summed over all threads and ranks.
+           @returns Count of `event`, which must be one of the names from
+           get_counter_names(), in the timer named `timer_name`, which
+           must be "run/compute" or one of the pack or bundle timers
+           under it from get_timer_names().
+        */
+        virtual idx_t
+        get_counter(const std::string& event
+                    /**< [in] Name of the event. */,
+                    const std::string& timer_name
+                    /**< [in] Path of the timer in the tree. */ ) =0;
     };
     
     /** @}*/
@@ -49,7 +49,6 @@ void fd_coeff(float *coeff, const float eval_point, const int order, float *poin
 {
     float c1, c2, c3;
     float x_0=eval_point;
-    float center=0;
 
     
 
@@ -88,12 +87,12 @@ void fd_coeff(float *coeff, const float eval_point, const int order, float *poin
             c3 = points[n] - points[v];
             c2 = c2*c3;
             for(int m=0; m<=MIN(n, order); ++m){
-		d[m*m_idx+n*n_idx + v] = (points[n]-x_0)*d[m*m_idx + (n-1)*n_idx + v] - m*d[(m-1)*m_idx + (n-1)*n_idx + v];
+		d[m*m_idx+n*n_idx + v] = (points[n]-x_0)*d[m*m_idx + (n-1)*n_idx + v] - (m ? m*d[(m-1)*m_idx + (n-1)*n_idx + v] : 0.f);
 		d[m*m_idx + n*n_idx + v] *= 1.f/c3;
             }
 	}
 	for(int m=0; m<= MIN(n, order); ++m){
-            d[m*m_idx+n*n_idx+n] = m*d[(m-1)*m_idx+(n-1)*n_idx+(n-1)] - (points[n-1]-x_0)*d[m*m_idx+(n-1)*n_idx+n-1];
+            d[m*m_idx+n*n_idx+n] = (m ? m*d[(m-1)*m_idx+(n-1)*n_idx+(n-1)] : 0.f) - (points[n-1]-x_0)*d[m*m_idx+(n-1)*n_idx+n-1];
             d[m*m_idx+n*n_idx+n] *= c1/c2;
 	}
         c1=c2;
@@ -63,7 +63,12 @@ namespace yask {
         // Look up names in the pool.
         static const std::string* _getPoolPtr(const std::string& name) {
 
-            // Get existing entry or add.
+            // Get existing entry without making a new node.
+            auto j = _allNames.find(name);
+            if (j != _allNames.end())
+                return &j->second;
+
+            // Add.
             // Add the value to be the same as the key because
             // addr of key might change, but addr of value won't.
             auto i = _allNames.emplace(name, name); // returns iterator + bool pair.
@@ -84,8 +84,10 @@ namespace yask {
             vMap = &_vec2elemMap;
         
         // Determine type to avoid virtual call.
+        // Use the name of the class template common to all
+        // storage types of folded grids.
         bool folded = gp.isGridFoldable();
-        string gtype = folded ? "YkVecGrid" : "YkElemGrid";
+        string gtype = folded ? "YkVecGridT" : "YkElemGrid";
 
         // Get/set local vars.
         string gridPtr = getLocalVar(os, gp.getGridPtr(), "auto");
@@ -311,12 +313,136 @@ namespace yask {
                     // Continue loop.
                     os << "; ofs++)\n" <<
                         _linePrefix << "  prefetch<L" << level << "_HINT>(&" << ptr <<
-                        "[" << idim << " + ofs])" << _lineSuffix;
+                        "[" << makePtrIndex(ptr, idim + " + ofs") << "], __LINE__)" << _lineSuffix;
                 }
                 os << _linePrefix << "#endif // L" << level << " prefetch.\n";
         }
     }
     
+    // Print code to set pointers to the next rows and planes of
+    // the outermost read-only vectors.
+    // The sub-block loops visit the domain dims in order with the inner
+    // dim last, so the dim just outside the inner one is the row dim, and
+    // the one outside that is the plane dim.
+    // At the end of a row, the only reads of a grid that are not already
+    // in cache are those just beyond the highest offset in the row dim.
+    void CppVecPrintHelper::printAheadPtrs(ostream& os) {
+        _aheadPtrs.clear();
+        const string& idim = _dims->_innerDim;
+        vector<string> odims;
+        for (auto& dim : _dims->_domainDims.getDims())
+            if (dim.getName() != idim)
+                odims.push_back(dim.getName());
+
+        // Pointers also used for writes aren't read-only.
+        set<string> wptrs;
+        for (auto& gp : _vv._vecWrites) {
+            auto bgp = makeBasePoint(gp);
+            auto* p = lookupPointPtr(*bgp);
+            if (p)
+                wptrs.insert(*p);
+        }
+
+        // Row dim, then plane dim.
+        for (size_t i = 0; i < 2 && i < odims.size(); i++) {
+            auto& odim = odims[odims.size() - 1 - i];
+            bool isPlane = i > 0;
+            auto* fp = _dims->_fold.lookup(odim);
+            int flen = fp ? *fp : 1;
+            auto* cp = _dims->_clusterMults.lookup(odim);
+            int cmult = cp ? *cp : 1;
+
+            // Find the highest offset in 'odim' among the read ptrs
+            // that differ only in 'odim'.
+            map<string, pair<int, const GridPoint*>> outers;
+            for (auto& vp : _vecPtrs) {
+                auto& bgp = vp.first;
+                if (!_ptrOfsHi.count(vp.second) || wptrs.count(vp.second))
+                    continue;
+                auto* ofs = bgp.getArgOffsets().lookup(odim);
+                if (!ofs)
+                    continue;
+                auto kgp = bgp.cloneGridPoint();
+                kgp->setArgOffset(IntScalar(odim, 0));
+                string key = kgp->makeStr();
+                if (!outers.count(key) || outers[key].first < *ofs)
+                    outers[key] = make_pair(*ofs, &bgp);
+            }
+
+            // Make ptrs to the vectors that the next iteration in 'odim'
+            // will read for the first time.
+            for (auto& j : outers) {
+                auto* bgp = j.second.second;
+                for (int k = 1; k <= cmult; k++) {
+                    auto agp = bgp->cloneGridPoint();
+                    agp->setArgOffset(IntScalar(odim, j.second.first + k * flen));
+                    printPointComment(os, *agp, isPlane ?
+                                      "Calculate next-plane pointer to" :
+                                      "Calculate next-row pointer to");
+                    auto vp = printVecPointCall(os, *agp, "getVecPtrNorm", "", "false", true);
+                    string aptr = makeVarName();
+                    os << _linePrefix << "auto* " << aptr << " = " << vp << _lineSuffix;
+                    _ptrGrids[aptr] = bgp->getGrid();
+                    _aheadPtrs.push_back({ _vecPtrs.at(*bgp), aptr, isPlane });
+                }
+            }
+        }
+    }
+
+    // Print prefetches for the last iterations of the inner loop.
+    // Prefetches that would go past the end of the row start over
+    // at the beginning of the next row or plane, so they continue
+    // the same distance ahead across the row boundary.
+    // Next rows are prefetched to L1 and L2; next planes are
+    // needed much later, so they are only prefetched to L2.
+    void CppVecPrintHelper::printAheadPrefetches(ostream& os) {
+        if (_aheadPtrs.size() == 0)
+            return;
+        const string& idim = _dims->_innerDim;
+        string istart = "start_" + idim;
+        string istop = "stop_" + idim;
+        string istep = "step_" + idim;
+        string pfidx = "pf_" + idim;
+
+        for (int level = 1; level <= 2; level++) {
+            string dist = "(PFD_L" + to_string(level) + "*" + istep + ")";
+
+            os << "\n // Prefetch next rows";
+            if (level > 1)
+                os << " and planes";
+            os << " to L" << level << " cache near end of row if enabled.\n" <<
+                _linePrefix << "#if PFD_L" << level << " > 0\n" <<
+                " if (" << idim << " + " << dist << " >= " << istop << ") {\n" <<
+                "  idx_t " << pfidx << " = " << istart << " + " << idim << " + " <<
+                dist << " - " << istop << ";\n";
+            for (auto& ap : _aheadPtrs) {
+                if (ap._isPlane && level < 2)
+                    continue;
+                string left = _dims->makeNormStr(_ptrOfsLo[ap._ptr], idim);
+                if (left.length() == 0) left = "0";
+                string right = _dims->makeNormStr(_ptrOfsHi[ap._ptr], idim);
+
+                // Vectors behind the leading edge, once per row.
+                if (_ptrOfsLo[ap._ptr] < _ptrOfsHi[ap._ptr])
+                    os << "  if (" << pfidx << " - " << istart << " < " << istep << ") {\n" <<
+                        "#pragma unroll\n" <<
+                        _linePrefix << "  for (int ofs = " << left << "; ofs < 0" << right << "; ofs++)\n" <<
+                        _linePrefix << "   prefetch<L" << level << "_HINT>(&" << ap._aheadPtr <<
+                        "[" << makePtrIndex(ap._aheadPtr, pfidx + " + ofs") << "], __LINE__)" << _lineSuffix <<
+                        "  }\n";
+
+                // Leading edge, as in the rest of the row.
+                os << "#pragma unroll\n" <<
+                    _linePrefix << " for (int ofs = 0" << right << "; ofs < " << istep << right <<
+                    "; ofs++)\n" <<
+                    _linePrefix << "  prefetch<L" << level << "_HINT>(&" << ap._aheadPtr <<
+                    "[" << makePtrIndex(ap._aheadPtr, pfidx + " + ofs") << "], __LINE__)" << _lineSuffix;
+            }
+            os << " }\n" <<
+                _linePrefix << "#endif // L" << level << " prefetch.\n";
+        }
+    }
+
     // Print code to set ptrName to gp.
     void CppVecPrintHelper::printPointPtr(ostream& os, const string& ptrName,
                                           const GridPoint& gp) {
@@ -325,10 +451,152 @@ namespace yask {
         // Get pointer to vector using normalized indices.
         // Ignore out-of-range errors because we might get a base pointer to an
         // element before the allocated range.
+        // Reduced-precision grids have their own vector type, which
+        // converts to the var type when read.
         auto vp = printVecPointCall(os, gp, "getVecPtrNorm", "", "false", true);
-        os << _linePrefix << getVarType() << "* " << ptrName << " = " << vp << _lineSuffix;
+        string ptype = gp.getGrid()->isReducedPrecision() ?
+            gp.getGrid()->getVecStorageType() : getVarType();
+        os << _linePrefix << ptype << "* " << ptrName << " = " << vp << _lineSuffix;
+        _ptrGrids[ptrName] = gp.getGrid();
+
+        // Lookup-table grids also need their table to decode the vectors.
+        if (gp.getGrid()->usesLookupTable()) {
+            string gridPtr = getLocalVar(os, gp.getGridPtr(), "auto");
+            os << _linePrefix << "const auto& " << ptrName << "_codec = " <<
+                gridPtr << "->get_codec()" << _lineSuffix;
+        }
     }
     
+    // Return code for the offset of vector 'idx' from pointer 'ptrName'.
+    string CppVecPrintHelper::makePtrIndex(const string& ptrName, const string& idx) const {
+        auto* gp = _ptrGrids.count(ptrName) ? _ptrGrids.at(ptrName) : 0;
+        if (!gp || gp->getInterleaveFactor() <= 1)
+            return idx;
+        return "(" + idx + ") * " + to_string(gp->getInterleaveFactor());
+    }
+
+    // Return code to read vector 'idx' through pointer 'ptrName'.
+    string CppVecPrintHelper::makePtrRead(const string& ptrName, const string& idx) {
+        string rd = "read_ptr(&" + ptrName + "[" + makePtrIndex(ptrName, idx) + "], __LINE__)";
+
+        // Lookup-table grids need their table to decode the vectors.
+        auto* gp = _ptrGrids.count(ptrName) ? _ptrGrids.at(ptrName) : 0;
+        if (gp && gp->usesLookupTable())
+            rd = ptrName + "_codec.decode(" + rd + ")";
+        return rd;
+    }
+
+    // Print declarations of the sliding-window vars and the loads
+    // needed before the first iteration.
+    // A window holds every vector in the inner-dim range read via a
+    // pointer, so the vectors at the lowest offsets in one iteration
+    // are the ones that were at offsets higher by the step in the
+    // previous iteration.
+    void CppVecPrintHelper::printInnerWindowInit(ostream& os) {
+        _ptrWindows.clear();
+        if (_innerReuseStep <= 0)
+            return;
+        const string& idim = _dims->_innerDim;
+        auto* fp = _dims->_fold.lookup(idim);
+        int flen = fp ? *fp : 1;
+
+        // Pointers used for writes can't be reused because reads
+        // could see old values.
+        set<string> wptrs;
+        for (auto& gp : _vv._vecWrites) {
+            auto bgp = makeBasePoint(gp);
+            auto* p = lookupPointPtr(*bgp);
+            if (p)
+                wptrs.insert(*p);
+        }
+
+        // Normalized inner-dim offsets of reads via each pointer.
+        // These must match the reads done in readFromPoint().
+        map<string, set<int>> rofs;
+        set<string> badPtrs;
+        for (auto& gp : _vv._alignedVecs) {
+            if (gp.getVecType() != GridPoint::VEC_FULL ||
+                gp.getLoopType() != GridPoint::LOOP_OFFSET)
+                continue;
+            auto bgp = makeBasePoint(gp);
+            auto* p = lookupPointPtr(*bgp);
+            if (!p || wptrs.count(*p))
+                continue;
+            auto* ofs = gp.getArgOffsets().lookup(idim);
+            if (!ofs || *ofs % flen) {
+                badPtrs.insert(*p);
+                continue;
+            }
+            rofs[*p].insert(*ofs / flen);
+        }
+
+        // Make windows where some reads can be reused.
+        for (auto& i : rofs) {
+            auto& ptr = i.first;
+            auto& ofss = i.second;
+            if (badPtrs.count(ptr))
+                continue;
+            int lo = *ofss.begin();
+            int hi = *ofss.rbegin();
+            int nreused = 0;
+            for (int k : ofss)
+                if (k + _innerReuseStep <= hi)
+                    nreused++;
+            if (!nreused)
+                continue;
+
+            os << "\n // Vectors at " << idim << " offsets " << lo << " to " << hi <<
+                " via " << ptr << ", reused across iterations.\n";
+            auto& win = _ptrWindows[ptr];
+            for (int k = lo; k <= hi; k++) {
+                string vname = makeVarName();
+                win[k] = vname;
+                os << _linePrefix << getVarType() << " " << vname;
+                if (k + _innerReuseStep <= hi)
+                    os << " = " << makePtrRead(ptr, idim + _dims->makeNormStr(k * flen, idim));
+                os << _lineSuffix;
+            }
+        }
+    }
+
+    // Print loads of the vectors that enter the windows.
+    void CppVecPrintHelper::printInnerWindowLoads(ostream& os) {
+        const string& idim = _dims->_innerDim;
+        auto* fp = _dims->_fold.lookup(idim);
+        int flen = fp ? *fp : 1;
+        for (auto& i : _ptrWindows) {
+            auto& ptr = i.first;
+            auto& win = i.second;
+            int hi = win.rbegin()->first;
+            os << "\n // Load new vectors via " << ptr << ".\n";
+            for (auto& j : win) {
+                int k = j.first;
+                if (k + _innerReuseStep > hi)
+                    os << _linePrefix << j.second << " = " <<
+                        makePtrRead(ptr, idim + _dims->makeNormStr(k * flen, idim)) <<
+                        _lineSuffix;
+            }
+        }
+    }
+
+    // Print the window shifts for the next iteration.
+    void CppVecPrintHelper::printInnerWindowShifts(ostream& os) {
+        for (auto& i : _ptrWindows) {
+            auto& ptr = i.first;
+            auto& win = i.second;
+            int hi = win.rbegin()->first;
+            os << "\n // Shift vectors via " << ptr << " for next iteration.\n";
+
+            // Ascending order, so each source is moved before it is replaced.
+            for (auto& j : win) {
+                int k = j.first;
+                if (k + _innerReuseStep <= hi)
+                    os << _linePrefix << j.second << " = " <<
+                        win.at(k + _innerReuseStep) << _lineSuffix;
+            }
+        }
+    }
+
     // Print any needed memory reads and/or constructions to 'os'.
     // Return code containing a vector of grid points.
     string CppVecPrintHelper::readFromPoint(ostream& os, const GridPoint& gp) {
@@ -356,11 +624,20 @@ namespace yask {
                 string idim = _dims->_innerDim;
                 string ofsStr = gp.makeNormArgStr(idim, *_dims);
                 
+                // Already loaded into a sliding window?
+                auto* ofs = gp.getArgOffsets().lookup(idim);
+                auto* flen = _dims->_fold.lookup(idim);
+                if (ofs && _ptrWindows.count(*p) &&
+                    _ptrWindows[*p].count(*ofs / (flen ? *flen : 1)))
+                    codeStr = _ptrWindows[*p][*ofs / (flen ? *flen : 1)];
+
                 // Output read using base addr.
-                printPointComment(os, gp, "Read aligned");
-                codeStr = makeVarName();
-                os << _linePrefix << getVarType() << " " << codeStr << " = " <<
-                    *p << "[" << ofsStr << "]" << _lineSuffix;
+                else {
+                    printPointComment(os, gp, "Read aligned");
+                    codeStr = makeVarName();
+                    os << _linePrefix << getVarType() << " " << codeStr << " = " <<
+                        makePtrRead(*p, ofsStr) << _lineSuffix;
+                }
             }
         }
 
@@ -397,7 +674,12 @@ namespace yask {
                 // Output write using base addr.
                 printPointComment(os, gp, "Write aligned");
 
-                os << _linePrefix << val << ".storeTo_masked(" << *p << "+" << ofs << ", write_mask)" << _lineSuffix;
+                if (_ntGrids.count(gp.getGrid()))
+                    os << _linePrefix << val << ".storeTo_masked_nt(write_ptr(" << *p << " + " << makePtrIndex(*p, ofs) <<
+                        ", _use_nt_stores, __LINE__), write_mask, _use_nt_stores)" << _lineSuffix;
+                else
+                    os << _linePrefix << val << ".storeTo_masked(write_ptr(" << *p << " + " << makePtrIndex(*p, ofs) <<
+                        ", false, __LINE__), write_mask)" << _lineSuffix;
                 // without mask: os << _linePrefix << *p << "[" << ofs << "] = " << val << _lineSuffix;
 
                 return "";
@@ -99,6 +99,24 @@ namespace yask {
         map<GridPoint, string> _vecPtrs; // pointers to grid vecs. value: ptr-var name.
         map<string, int> _ptrOfsLo; // lowest read offset from _vecPtrs in inner dim.
         map<string, int> _ptrOfsHi; // highest read offset from _vecPtrs in inner dim.
+        map<string, const Grid*> _ptrGrids; // grid of each ptr-var name.
+
+        // Sliding windows of vectors reused across inner-loop iterations.
+        int _innerReuseStep = 0; // vectors per inner-loop iteration; 0 => no reuse.
+        map<string, map<int, string>> _ptrWindows; // ptr-var name -> normalized
+                                                    // inner-dim offset -> vec-var name.
+
+        // Pointers to the next rows and planes of read-only vectors
+        // for prefetching near the end of a row.
+        struct AheadPtr {
+            string _ptr;        // ptr-var name of the current row or plane.
+            string _aheadPtr;   // ptr-var name of the next one.
+            bool _isPlane;      // next plane instead of next row.
+        };
+        vector<AheadPtr> _aheadPtrs;
+
+        // Grids written w/streaming stores when enabled at run-time.
+        set<const Grid*> _ntGrids;
 
         // Element indices.
         string _elemSuffix = "_elem";
@@ -132,6 +150,14 @@ namespace yask {
                                          const string& lastArg,
                                          bool isNorm);
     
+        // Return code for the offset of vector 'idx' from pointer 'ptrName'.
+        // The vectors of interleaved grids are spread out by the
+        // number of grids in the group.
+        virtual string makePtrIndex(const string& ptrName, const string& idx) const;
+
+        // Return code to read vector 'idx' through pointer 'ptrName'.
+        virtual string makePtrRead(const string& ptrName, const string& idx);
+
         // Print aligned memory read.
         virtual string printAlignedVecRead(ostream& os, const GridPoint& gp);
 
@@ -186,6 +212,37 @@ namespace yask {
         // Print only 'ptrVar' if provided.
         virtual void printPrefetches(ostream& os, bool ahead, string ptrVar = "");
 
+        // Print code to set pointers to the next rows and planes of
+        // the outermost read-only vectors. Call after printBasePtrs().
+        virtual void printAheadPtrs(ostream& os);
+
+        // Print prefetches for the last iterations of the inner loop
+        // using the pointers from printAheadPtrs().
+        virtual void printAheadPrefetches(ostream& os);
+
+        // Set grids to write w/streaming stores when enabled at run-time.
+        virtual void setNtGrids(const set<const Grid*>& grids) {
+            _ntGrids = grids;
+        }
+
+        // Rotate vectors through vars across inner-loop iterations
+        // that each step 'step' vectors, so each vector read via a base
+        // pointer is loaded only once per loop.
+        virtual void setInnerReuse(int step) {
+            _innerReuseStep = step;
+        }
+
+        // Print declarations of the sliding-window vars and the loads
+        // needed before the first iteration. Call after printBasePtrs().
+        virtual void printInnerWindowInit(ostream& os);
+
+        // Print loads of the vectors that enter the windows at the
+        // beginning of an iteration.
+        virtual void printInnerWindowLoads(ostream& os);
+
+        // Print the window shifts at the end of an iteration.
+        virtual void printInnerWindowShifts(ostream& os);
+
         // Print any needed memory reads and/or constructions to 'os'.
         // Return code containing a vector of grid points.
         virtual string readFromPoint(ostream& os, const GridPoint& gp);
@@ -246,6 +303,10 @@ namespace yask {
         // Print an expression as a one-line C++ comment.
         void addComment(ostream& os, EqBundle& eq);
 
+        // Find the output grids of 'eq' that it never reads at the
+        // same step index, so they can use streaming stores.
+        set<const Grid*> findWriteOnlyGrids(EqBundle& eq) const;
+
         // A factory method to create a new PrintHelper.
         // This can be overridden in derived classes to provide
         // alternative PrintHelpers.
@@ -263,6 +324,11 @@ namespace yask {
         virtual void printData(ostream& os);
         virtual void printEqBundles(ostream& os);
         virtual void printContext(ostream& os);
+
+        // Print any target-specific methods of a bundle: declarations
+        // inside the class to 'os' and definitions to 'dos'.
+        virtual void printBundleExtras(ostream& os, ostream& dos,
+                                       EqBundle& eq, const string& egsName) { }
         
         
     public:
@@ -286,6 +352,24 @@ namespace yask {
         virtual void print(ostream& os);
     };
 
+    // Print scalar C++ code for YASK whose sub-block calculations can be
+    // offloaded to a device, e.g., a GPU, via OpenMP target directives.
+    // Each device thread calculates one cluster.
+    class YASKOmpTargetPrinter : public YASKCppPrinter {
+    protected:
+        virtual void printEqBundles(ostream& os);
+        virtual void printBundleExtras(ostream& os, ostream& dos,
+                                       EqBundle& eq, const string& egsName);
+
+    public:
+        YASKOmpTargetPrinter(StencilSolution& stencil,
+                             EqBundles& eqBundles,
+                             EqBundlePacks& eqBundlePacks,
+                             EqBundles& clusterEqBundles,
+                             const Dimensions* dims) :
+            YASKCppPrinter(stencil, eqBundles, eqBundlePacks, clusterEqBundles, dims) { }
+    };
+
 } // namespace yask.
 
 #endif
@@ -167,6 +167,9 @@ void CppIntrinPrintHelper::tryAlign(ostream& os,
                         os << ")" << _lineSuffix;
                     }
 
+                    // One shuffle.
+                    _ctorCounts.add(1, 0, 1);
+
                     // Done w/the found elems.
                     for (auto fei = foundElems.begin(); fei != foundElems.end(); fei++) {
                         size_t fe = *fei;
@@ -265,6 +268,9 @@ void CppIntrinPrintHelper::tryPerm1(ostream& os,
                 printMask(os, mask);
             os << ")" << _lineSuffix;
 
+            // One shuffle w/the control from memory.
+            _ctorCounts.add(1, 1, 1);
+
             // Done w/the found elems.
             for (auto fei = foundElems.begin(); fei != foundElems.end(); fei++) {
                 size_t fe = *fei;
@@ -392,6 +398,9 @@ void CppIntrinPrintHelper::tryPerm2(ostream& os,
                     os << mv2Name << ", " << mv1Name;
                 os << ")" << _lineSuffix;
 
+                // One shuffle w/the control from memory.
+                _ctorCounts.add(1, 1, 1);
+
                 // Done w/the found elems.
                 for (auto fei = foundElems.begin(); fei != foundElems.end(); fei++) {
                     size_t fe = *fei;
@@ -408,6 +417,199 @@ void CppIntrinPrintHelper::tryPerm2(ostream& os,
 }
     
     
+// Throughput resources of known targets.
+// Each shuffle-capable port is counted as one, and FP ops that share
+// those ports are modeled by 'fpShuffleShare'. Unaligned loads of full
+// cache-line vectors always split across two lines.
+static const VecCostModel costModels[] = {
+    // name, shuffle ports, load ports, issue width, unaligned-load uops,
+    //  FP share on shuffle port(s), {shuffles, loads, uops} per element insert.
+    { "knc", 1, 1, 2, 2, 1.0, { 0, 1, 2 } },
+    { "knl", 1, 2, 2, 2, 0.5, { 0, 1, 2 } },
+    { "skx", 1, 2, 4, 2, 0.5, { 0, 1, 2 } },
+    { "icx", 1, 2, 5, 2, 0.5, { 0, 1, 2 } },
+    { "spr", 1, 3, 6, 2, 0.5, { 0, 1, 2 } },
+    { "hsw", 1, 2, 4, 1.5, 0.0, { 0, 1, 2 } },
+    { "a64fx", 1, 2, 4, 2, 0.5, { 0, 1, 2 } },
+    { "neoverse-v1", 2, 3, 8, 1.5, 0.5, { 0, 1, 2 } },
+    { "neoverse-n1", 2, 2, 4, 1, 1.0, { 0, 1, 2 } },
+};
+
+// Find a model by name.
+const VecCostModel* VecCostModel::lookup(const string& name) {
+    for (auto& m : costModels)
+        if (m.name == name)
+            return &m;
+    return 0;
+}
+
+// List of model names.
+string VecCostModel::getNames() {
+    string names;
+    for (auto& m : costModels) {
+        if (names.length())
+            names += ", ";
+        names += m.name;
+    }
+    return names;
+}
+
+// Set the cost model by name.
+void CppIntrinPrintHelper::setCostModel(const string& name) {
+    string mname = name.length() ? name : getDefaultCostModel();
+    _costModel = VecCostModel::lookup(mname);
+    if (!_costModel)
+        THROW_YASK_EXCEPTION("Error: unknown cost model '" + mname +
+                             "'; use one of " + VecCostModel::getNames());
+}
+
+// Try the strategies in the given order.
+void CppIntrinPrintHelper::tryStrategies(ostream& os,
+                                         const string& pvName,
+                                         size_t nelemsTarget, 
+                                         const VecElemList& elems, 
+                                         set<size_t>& doneElems,
+                                         const GridPointSet& alignedVecs,
+                                         const vector<VecCtorStrategy>& order) {
+    for (auto st : order) {
+        switch (st) {
+        case CTOR_ALIGN:
+            tryAlign(os, pvName, nelemsTarget, elems, doneElems, alignedVecs, false);
+            break;
+        case CTOR_ALIGN_MASKED:
+            tryAlign(os, pvName, nelemsTarget, elems, doneElems, alignedVecs, true);
+            break;
+        case CTOR_PERM1:
+            tryPerm1(os, pvName, nelemsTarget, elems, doneElems, alignedVecs);
+            break;
+        case CTOR_PERM2:
+            tryPerm2(os, pvName, nelemsTarget, elems, doneElems, alignedVecs);
+            break;
+        }
+    }
+}
+
+// Find the cheapest construction of pvName at gp.
+void CppIntrinPrintHelper::findCtor(const GridPoint& gp,
+                                    const string& pvName,
+                                    string& code,
+                                    set<size_t>& doneElems,
+                                    VecCtorCounts& counts) {
+    assert(_costModel);
+
+    // List of elements for this vec block.
+    auto& elems = _vv._vblk2elemLists[gp];
+    size_t nelems = elems.size();
+
+    // Set of aligned vec blocks that overlap with this unaligned vec block.
+    const auto& alignedVecs = _vv._vblk2avblks[gp];
+
+    // State changed by the try*() methods.
+    auto ctrls0 = definedCtrls;
+    bool na0 = _definedNA;
+    set<string> bestCtrls;
+    bool bestNA = na0;
+    double bestCycles = 0.;
+    bool found = false;
+
+    // Try each order of the strategies, starting with the default.
+    // In each, use a greedy algorithm: try to get as many elements at
+    // once as possible.
+    auto order = getStrategies();
+    vector<size_t> perm(order.size());
+    for (size_t i = 0; i < perm.size(); i++)
+        perm[i] = i;
+    do {
+        vector<VecCtorStrategy> porder;
+        for (auto i : perm)
+            porder.push_back(order[i]);
+
+        ostringstream oss;
+        set<size_t> done;
+        definedCtrls = ctrls0;
+        _definedNA = na0;
+        _ctorCounts = VecCtorCounts();
+
+        // Loop through decreasing numbers of elements.
+        for (size_t nelemsTarget = nelems;
+             done.size() < nelems && nelemsTarget > 0; 
+             nelemsTarget--)
+            tryStrategies(oss, pvName, nelemsTarget, elems, done, alignedVecs, porder);
+
+        // Any missing elements are inserted individually.
+        for (size_t i = done.size(); i < nelems; i++)
+            _ctorCounts.add(_costModel->elemCounts);
+
+        // Keep if cheaper; ties go to the earlier order.
+        double cycles = getBodyCycles(_ctorCounts);
+        if (!found || cycles < bestCycles) {
+            found = true;
+            bestCycles = cycles;
+            code = oss.str();
+            doneElems = done;
+            counts = _ctorCounts;
+            bestCtrls = definedCtrls;
+            bestNA = _definedNA;
+        }
+    } while (next_permutation(perm.begin(), perm.end()));
+
+    // Leave state as it would be after printing the best one.
+    definedCtrls = bestCtrls;
+    _definedNA = bestNA;
+}
+
+// Whether an unaligned load is estimated to be cheaper than
+// constructing the vector.
+bool CppIntrinPrintHelper::useUnalignedLoad(const GridPoint& gp) {
+    if (!_costModel || !_vv._vblk2elemLists.count(gp))
+        return true;
+
+    // Aligned vecs not yet read would also need to be loaded.
+    // Give them temporary names for the trial.
+    VecCtorCounts ctorCounts;
+    vector<GridPoint> tmpVars;
+    for (auto& av : _vv._vblk2avblks[gp]) {
+        if (!_vecVars.count(av)) {
+            _vecVars[av] = "tmp_aligned";
+            tmpVars.push_back(av);
+            ctorCounts.add(0, 1, 1);
+        }
+    }
+
+    // Trial construction w/o changing state.
+    auto ctrls0 = definedCtrls;
+    bool na0 = _definedNA;
+    string code;
+    set<size_t> doneElems;
+    VecCtorCounts counts;
+    findCtor(gp, "tmp", code, doneElems, counts);
+    ctorCounts.add(counts);
+    definedCtrls = ctrls0;
+    _definedNA = na0;
+    for (auto& av : tmpVars)
+        _vecVars.erase(av);
+
+    // Compare to an unaligned load; ties go to the load.
+    VecCtorCounts loadCounts;
+    loadCounts.loads = ceil(_costModel->unalignedLoads);
+    loadCounts.uops = 1;
+    double loadCycles = getBodyCycles(loadCounts);
+    bool useLoad = loadCycles <= getBodyCycles(ctorCounts);
+    if (useLoad)
+        _bodyCounts.add(loadCounts);
+    return useLoad;
+}
+
+// Print any needed memory reads and/or constructions to 'os'.
+// Counts new aligned loads for the cost model.
+string CppIntrinPrintHelper::readFromPoint(ostream& os, const GridPoint& gp) {
+    bool isNew = !_vecVars.count(gp);
+    string codeStr = CppVecPrintHelper::readFromPoint(os, gp);
+    if (isNew && gp.getVecType() == GridPoint::VEC_FULL && _vv._alignedVecs.count(gp))
+        _bodyCounts.add(0, 1, 1);
+    return codeStr;
+}
+
 // Print construction for one unaligned vector pvName at gp.
 void CppIntrinPrintHelper::printUnalignedVecCtor(ostream& os,
                                                  const GridPoint& gp,
@@ -421,26 +623,17 @@ void CppIntrinPrintHelper::printUnalignedVecCtor(ostream& os,
     auto& elems = _vv._vblk2elemLists[gp];
     size_t nelems = elems.size();
 
-    // Set of elements in gp that have been constructed.
+    // Want to construct this vector as efficiently as possible
+    // as estimated by the cost model.
+    string code;
     set<size_t> doneElems;
-
-    // Set of aligned vec blocks that overlap with this unaligned vec block.
-    const auto& alignedVecs = _vv._vblk2avblks[gp];
-
-    // Brute-force, greedy algorithm:
-    // Want to construct this vector as efficiently as possible.
-    // Try to get as many elements at once as possible.
-    // For each target number of elements (most to least), try various strategies.
-
-    // Loop through decreasing numbers of elements.
-    for (size_t nelemsTarget = nelems;
-         doneElems.size() < nelems && nelemsTarget > 0; 
-         nelemsTarget--) {
-
-        tryStrategies(os, pvName,
-                      nelemsTarget, elems, doneElems, alignedVecs);
-
-    } // decreasing number of target elements for next attempt.
+    VecCtorCounts counts;
+    findCtor(gp, pvName, code, doneElems, counts);
+    _bodyCounts.add(counts);
+    os << " // Estimated for '" << _costModel->name << "': " <<
+        counts.shuffles << " shuffle(s), " << counts.loads << " load(s), " <<
+        counts.uops << " uop(s)." << endl;
+    os << code;
 
     // Check that all elements are done and add any missing ones.
     size_t ndone = doneElems.size();
@@ -34,11 +34,73 @@ IN THE SOFTWARE.
 
 namespace yask {
 
+    // Instruction types that can construct an unaligned vector.
+    enum VecCtorStrategy {
+        CTOR_ALIGN,             // align w/o masking.
+        CTOR_ALIGN_MASKED,      // align w/masking.
+        CTOR_PERM1,             // 1-var permute.
+        CTOR_PERM2              // 2-var permute.
+    };
+
+    // Counts of operations used to make a vector.
+    struct VecCtorCounts {
+        int shuffles;           // uops on shuffle port(s).
+        int loads;              // uops on load port(s), including permute controls.
+        int uops;               // all fused-domain uops.
+
+        VecCtorCounts(int nshuffles = 0, int nloads = 0, int nuops = 0) :
+            shuffles(nshuffles), loads(nloads), uops(nuops) { }
+
+        void add(int nshuffles, int nloads, int nuops) {
+            shuffles += nshuffles;
+            loads += nloads;
+            uops += nuops;
+        }
+        void add(const VecCtorCounts& rhs) {
+            add(rhs.shuffles, rhs.loads, rhs.uops);
+        }
+    };
+
+    // Throughput resources of a target CPU, used to compare ways to make
+    // a vector. Only the relative costs matter.
+    struct VecCostModel {
+        string name;
+        double shufflePorts;    // ports that execute full-width shuffles.
+        double loadPorts;       // ports that execute loads.
+        double issueWidth;      // fused-domain uops issued per cycle.
+        double unalignedLoads;  // load uops for a vector load that isn't aligned.
+        double fpShuffleShare;  // fraction of FP ops issued to the shuffle port(s).
+        VecCtorCounts elemCounts; // ops to insert one element.
+
+        // Estimated cycles of the throughput bottleneck for the ops in
+        // 'c' and 'nfp' FP ops.
+        double getCycles(const VecCtorCounts& c, int nfp) const {
+            return max(max((c.shuffles + nfp * fpShuffleShare) / shufflePorts,
+                           c.loads / loadPorts),
+                       (c.uops + nfp) / issueWidth);
+        }
+
+        // Known models by name, e.g., "skx".
+        // Returns null if not found.
+        static const VecCostModel* lookup(const string& name);
+        static string getNames();
+    };
+
     // Add specialization for 256 and 512-bit intrinsics.
     class CppIntrinPrintHelper : public CppVecPrintHelper {
 
     protected:
         set<string> definedCtrls; // control vars already defined.
+        const VecCostModel* _costModel = 0; // model for selecting instructions.
+        VecCtorCounts _ctorCounts; // ops printed by try*() methods.
+        VecCtorCounts _bodyCounts; // ops selected so far in the loop body.
+
+        // Cycles to run the loop body with 'extra' ops added.
+        double getBodyCycles(const VecCtorCounts& extra) const {
+            VecCtorCounts c = _bodyCounts;
+            c.add(extra);
+            return _costModel->getCycles(c, _cv ? _cv->getNumOps() : 0);
+        }
 
         // Ctor.
         CppIntrinPrintHelper(VecInfoVisitor& vv,
@@ -60,7 +122,13 @@ namespace yask {
             os << ", 0x" << hex << mask << dec;
         }
 
-        // Try all applicable strategies to create nelemsTarget elements.
+        // Strategies available on the target in their default order.
+        virtual vector<VecCtorStrategy> getStrategies() const =0;
+
+        // Name of the cost model to use when none is given.
+        virtual string getDefaultCostModel() const =0;
+
+        // Try the strategies in 'order' to create nelemsTarget elements.
         // Elements needed are those from elems but not in doneElems.
         // Elements can be taken from alignedVecs.
         // Update doneElems.
@@ -69,7 +137,8 @@ namespace yask {
                                    size_t nelemsTarget, 
                                    const VecElemList& elems, 
                                    set<size_t>& doneElems,
-                                   const GridPointSet& alignedVecs) =0;
+                                   const GridPointSet& alignedVecs,
+                                   const vector<VecCtorStrategy>& order);
 
         // Try to use align instruction(s) to construct nelemsTarget elements
         // per instruction.
@@ -99,7 +168,29 @@ namespace yask {
                               set<size_t>& doneElems,
                               const GridPointSet& alignedVecs);
 
+        // Find the cheapest construction of pvName at gp over all orders
+        // of the available strategies. Prints nothing, but returns the code
+        // in 'code', the elements made in 'doneElems', and the ops
+        // including any per-element inserts in 'counts'. All aligned vecs
+        // must have vars.
+        virtual void findCtor(const GridPoint& gp,
+                              const string& pvName,
+                              string& code,
+                              set<size_t>& doneElems,
+                              VecCtorCounts& counts);
+
+        // Whether an unaligned load is estimated to be cheaper than
+        // constructing the vector.
+        virtual bool useUnalignedLoad(const GridPoint& gp);
+
     public:
+        // Print any needed memory reads and/or constructions to 'os'.
+        // Counts new aligned loads for the cost model.
+        virtual string readFromPoint(ostream& os, const GridPoint& gp);
+
+        // Set the cost model by name, or use the default if empty.
+        virtual void setCostModel(const string& name);
+
         // Print construction for one unaligned vector pvName at gp.
         virtual void printUnalignedVecCtor(ostream& os,
                                            const GridPoint& gp,
@@ -111,16 +202,11 @@ namespace yask {
     class CppKncPrintHelper : public CppIntrinPrintHelper {
     protected:
 
-        // Try all applicable strategies.
-        virtual void tryStrategies(ostream& os,
-                                   const string& pvName,
-                                   size_t nelemsTarget, 
-                                   const VecElemList& elems, 
-                                   set<size_t>& doneElems,
-                                   const GridPointSet& alignedVecs) {
-            tryAlign(os, pvName, nelemsTarget, elems, doneElems, alignedVecs, true);
-            tryPerm1(os, pvName, nelemsTarget, elems, doneElems, alignedVecs);
+        // Available strategies.
+        virtual vector<VecCtorStrategy> getStrategies() const {
+            return { CTOR_ALIGN_MASKED, CTOR_PERM1 };
         }
+        virtual string getDefaultCostModel() const { return "knc"; }
     
     public:
         CppKncPrintHelper(VecInfoVisitor& vv,
@@ -139,17 +225,11 @@ namespace yask {
     class CppAvx512PrintHelper : public CppIntrinPrintHelper {
     protected:
 
-        // Try all applicable strategies.
-        virtual void tryStrategies(ostream& os,
-                                   const string& pvName,
-                                   size_t nelemsTarget, 
-                                   const VecElemList& elems, 
-                                   set<size_t>& doneElems,
-                                   const GridPointSet& alignedVecs) {
-            tryAlign(os, pvName, nelemsTarget, elems, doneElems, alignedVecs, true);
-            tryPerm2(os, pvName, nelemsTarget, elems, doneElems, alignedVecs);
-            tryPerm1(os, pvName, nelemsTarget, elems, doneElems, alignedVecs);
+        // Available strategies.
+        virtual vector<VecCtorStrategy> getStrategies() const {
+            return { CTOR_ALIGN_MASKED, CTOR_PERM2, CTOR_PERM1 };
         }
+        virtual string getDefaultCostModel() const { return "skx"; }
     
     public:
         CppAvx512PrintHelper(VecInfoVisitor& vv,
@@ -168,15 +248,11 @@ namespace yask {
     class CppAvx256PrintHelper : public CppIntrinPrintHelper {
     protected:
 
-        // Try all applicable strategies.
-        virtual void tryStrategies(ostream& os,
-                                   const string& pvName,
-                                   size_t nelemsTarget, 
-                                   const VecElemList& elems, 
-                                   set<size_t>& doneElems,
-                                   const GridPointSet& alignedVecs) {
-            tryAlign(os, pvName, nelemsTarget, elems, doneElems, alignedVecs, false);
+        // Available strategies.
+        virtual vector<VecCtorStrategy> getStrategies() const {
+            return { CTOR_ALIGN };
         }
+        virtual string getDefaultCostModel() const { return "hsw"; }
     
     public:
         CppAvx256PrintHelper(VecInfoVisitor& vv,
@@ -191,13 +267,62 @@ namespace yask {
                                  varPrefix, varType, linePrefix, lineSuffix) { }
     };
 
+    // Specialization for ARM SVE intrinsics.
+    class CppSvePrintHelper : public CppIntrinPrintHelper {
+    protected:
+
+        // Available strategies.
+        // There is no 2-var table lookup before SVE2.
+        virtual vector<VecCtorStrategy> getStrategies() const {
+            return { CTOR_ALIGN_MASKED, CTOR_PERM1 };
+        }
+        virtual string getDefaultCostModel() const { return "a64fx"; }
+    
+    public:
+        CppSvePrintHelper(VecInfoVisitor& vv,
+                          bool allowUnalignedLoads,
+                          const Dimensions* dims,
+                          const CounterVisitor* cv,
+                          const string& varPrefix,
+                          const string& varType,
+                          const string& linePrefix,
+                          const string& lineSuffix) :
+            CppIntrinPrintHelper(vv, allowUnalignedLoads, dims, cv,
+                                 varPrefix, varType, linePrefix, lineSuffix) { }
+    };
+
+    // Specialization for ARM NEON intrinsics.
+    class CppNeonPrintHelper : public CppIntrinPrintHelper {
+    protected:
+
+        // Available strategies.
+        virtual vector<VecCtorStrategy> getStrategies() const {
+            return { CTOR_ALIGN };
+        }
+        virtual string getDefaultCostModel() const { return "neoverse-n1"; }
+    
+    public:
+        CppNeonPrintHelper(VecInfoVisitor& vv,
+                           bool allowUnalignedLoads,
+                           const Dimensions* dims,
+                           const CounterVisitor* cv,
+                           const string& varPrefix,
+                           const string& varType,
+                           const string& linePrefix,
+                           const string& lineSuffix) :
+            CppIntrinPrintHelper(vv, allowUnalignedLoads, dims, cv,
+                                 varPrefix, varType, linePrefix, lineSuffix) { }
+    };
+
     // Print KNC intrinsic code.
     class YASKKncPrinter : public YASKCppPrinter {
     protected:
         virtual CppVecPrintHelper* newCppVecPrintHelper(VecInfoVisitor& vv,
                                                         CounterVisitor& cv) {
-            return new CppKncPrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
-                                         "temp", "real_vec_t", " ", ";\n");
+            auto* vp = new CppKncPrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
+                                             "temp", "real_vec_t", " ", ";\n");
+            vp->setCostModel(_settings._costModel);
+            return vp;
         }
 
     public:
@@ -220,8 +345,10 @@ namespace yask {
     protected:
         virtual CppVecPrintHelper* newCppVecPrintHelper(VecInfoVisitor& vv,
                                                         CounterVisitor& cv) {
-            return new CppAvx256PrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
-                                            "temp", "real_vec_t", " ", ";\n");
+            auto* vp = new CppAvx256PrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
+                                                "temp", "real_vec_t", " ", ";\n");
+            vp->setCostModel(_settings._costModel);
+            return vp;
         }
 
     public:
@@ -240,8 +367,10 @@ namespace yask {
     protected:
         virtual CppVecPrintHelper* newCppVecPrintHelper(VecInfoVisitor& vv,
                                                         CounterVisitor& cv) {
-            return new CppAvx512PrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
-                                            "temp", "real_vec_t", " ", ";\n");
+            auto* vp = new CppAvx512PrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
+                                                "temp", "real_vec_t", " ", ";\n");
+            vp->setCostModel(_settings._costModel);
+            return vp;
         }
 
     public:
@@ -259,6 +388,67 @@ namespace yask {
         virtual bool is_folding_efficient() const { return true; }
     };
 
+    // Print ARM SVE intrinsic code.
+    // The generated code uses a fixed vector length of '_sveBits',
+    // which must match the kernel's SVE_BITS.
+    class YASKSvePrinter : public YASKCppPrinter {
+    protected:
+        virtual CppVecPrintHelper* newCppVecPrintHelper(VecInfoVisitor& vv,
+                                                        CounterVisitor& cv) {
+            auto* vp = new CppSvePrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
+                                             "temp", "real_vec_t", " ", ";\n");
+            vp->setCostModel(_settings._costModel);
+            return vp;
+        }
+
+    public:
+        YASKSvePrinter(StencilSolution& stencil,
+                       EqBundles& eqBundles,
+                       EqBundlePacks& eqBundlePacks,
+                       EqBundles& clusterEqBundles,
+                       const Dimensions* dims) :
+            YASKCppPrinter(stencil, eqBundles, eqBundlePacks, clusterEqBundles,
+                           dims) { }
+
+        // Lengths are limited to powers of 2 for -msve-vector-bits
+        // and to 16 elements to keep the masks the same size as for AVX-512.
+        virtual int num_vec_elems() const {
+            int bits = _settings._sveBits;
+            int nelems = bits / 8 / _settings._elem_bytes;
+            if ((bits != 128 && bits != 256 && bits != 512 && bits != 1024) ||
+                nelems > 16)
+                THROW_YASK_EXCEPTION("Error: SVE vector length of " + to_string(bits) +
+                                     " bits is not supported for " +
+                                     to_string(_settings._elem_bytes) + "-byte elements");
+            return nelems;
+        }
+
+        // Whether multi-dim folding is efficient.
+        virtual bool is_folding_efficient() const { return true; }
+    };
+
+    // Print 128-bit ARM NEON intrinsic code.
+    class YASKNeonPrinter : public YASKCppPrinter {
+    protected:
+        virtual CppVecPrintHelper* newCppVecPrintHelper(VecInfoVisitor& vv,
+                                                        CounterVisitor& cv) {
+            auto* vp = new CppNeonPrintHelper(vv, _settings._allowUnalignedLoads, _dims, &cv,
+                                              "temp", "real_vec_t", " ", ";\n");
+            vp->setCostModel(_settings._costModel);
+            return vp;
+        }
+
+    public:
+        YASKNeonPrinter(StencilSolution& stencil,
+                        EqBundles& eqBundles,
+                        EqBundlePacks& eqBundlePacks,
+                        EqBundles& clusterEqBundles,
+                        const Dimensions* dims) :
+            YASKCppPrinter(stencil, eqBundles, eqBundlePacks, clusterEqBundles, dims) { }
+
+        virtual int num_vec_elems() const { return 16 / _settings._elem_bytes; }
+    };
+
 } // namespace yask.
 
 #endif
@@ -287,7 +287,18 @@ namespace yask {
             // TODO: check to make sure cond1 depends only on indices.
         } // for all eqs.
 
-        // 2. Check each pair of eqs.
+        // Index eqs by the grids they write and read, so that each eq
+        // only needs to be checked against eqs that read its output
+        // instead of against all eqs.
+        map<Grid*, vector<EqualsExprPtr>> writers, readers;
+        for (auto eq : getAll()) {
+            auto* eqp = eq.get();
+            writers[outGrids.at(eqp)].push_back(eq);
+            for (auto* g : inGrids.at(eqp))
+                readers[g].push_back(eq);
+        }
+
+        // 2. Check each pair of eqs that could be related.
         os << "Analyzing for dependencies...\n";
         for (auto eq1 : getAll()) {
             auto* eq1p = eq1.get();
@@ -300,31 +311,16 @@ namespace yask {
             //auto& ip1 = inPts.at(eq1p);
             auto cond1 = eq1p->getCond();
 
-            // Check each 'eq2' to see if it depends on 'eq1'.
-            for (auto eq2 : getAll()) {
+            // If two different eqs have the same condition, they
+            // cannot update the same grid.
+            for (auto eq2 : writers[og1]) {
                 auto* eq2p = eq2.get();
-                auto& og2 = outGrids.at(eq2p);
-                assert(og2 == eq2->getGrid());
                 auto& op2 = outPts.at(eq2p);
-                auto& ig2 = inGrids.at(eq2p);
-                auto& ip2 = inPts.at(eq2p);
                 auto cond2 = eq2p->getCond();
 
-#ifdef DEBUG_DEP
-                cout << " Checking eq " <<
-                    eq1->makeQuotedStr() << " vs " <<
-                    eq2->makeQuotedStr() << "...\n";
-#endif
-                
-                bool same_eq = eq1 == eq2;
-                bool same_cond = areExprsSame(cond1, cond2);
-
                 // A separate grid is defined by its name and any const indices.
-                bool same_og = op1->isSameLogicalGrid(*op2);
-
-                // If two different eqs have the same condition, they
-                // cannot update the same grid.
-                if (!same_eq && same_cond && same_og) {
+                if (eq1 != eq2 && areExprsSame(cond1, cond2) &&
+                    op1->isSameLogicalGrid(*op2)) {
                     string cdesc = cond1 ? "with condition " + cond1->makeQuotedStr() :
                         "without conditions";
                     THROW_YASK_EXCEPTION("Error: two equations " + cdesc +
@@ -333,6 +329,24 @@ namespace yask {
                                          eq1->makeQuotedStr() + " and " +
                                          eq2->makeQuotedStr());
                 }
+            }
+
+            // Check each 'eq2' that reads the grid written by 'eq1' to
+            // see if it depends on 'eq1'.
+            for (auto eq2 : readers[og1]) {
+                auto* eq2p = eq2.get();
+                assert(outGrids.at(eq2p) == eq2->getGrid());
+                auto& ip2 = inPts.at(eq2p);
+                auto cond2 = eq2p->getCond();
+
+#ifdef DEBUG_DEP
+                cout << " Checking eq " <<
+                    eq1->makeQuotedStr() << " vs " <<
+                    eq2->makeQuotedStr() << "...\n";
+#endif
+                
+                bool same_eq = eq1 == eq2;
+                bool same_cond = areExprsSame(cond1, cond2);
 
                 // First dep check: exact matches on LHS of eq1 to RHS of eq2.
                 // eq2 dep on eq1 => some output of eq1 is an input to eq2.
@@ -387,8 +401,7 @@ namespace yask {
                 //
                 // TODO: be much smarter about this and find only real
                 // dependencies--use a polyhedral library?
-                if (ig2.count(og1)) {
-
+                {
                     // detailed check of g1 input points on RHS of eq2.
                     for (auto* i2 : ip2) {
 
@@ -688,6 +701,63 @@ namespace yask {
                     });
             }
         }
+
+        // Find the grids that can be updated in place: all writes must be
+        // at one end of the step-offset range, and every read of the value
+        // at the other (oldest) end must be in an eq that writes the grid
+        // at the same point, so no other read of the old value can follow
+        // the write to the same memory.
+        map<Grid*, int> writeOfs;
+        map<Grid*, bool> inPlaceOk;
+        for (auto& eq1 : getAll()) {
+            auto* outPt1 = pv.getOutputPts().at(eq1.get());
+            auto* og1 = outPt1->getGrid();
+            int first_ofs = 0, last_ofs = 0;
+            if (!og1->getStepOffsetRange(first_ofs, last_ofs) || first_ofs == last_ofs)
+                continue;
+            auto* ofs = outPt1->getArgOffsets().lookup(og1->getStepDim()->getName());
+            bool ok = ofs && (*ofs == first_ofs || *ofs == last_ofs);
+            if (ok && writeOfs.count(og1) && writeOfs[og1] != *ofs)
+                ok = false;
+            if (ok)
+                writeOfs[og1] = *ofs;
+            if (!inPlaceOk.count(og1))
+                inPlaceOk[og1] = true;
+            if (!ok)
+                inPlaceOk[og1] = false;
+        }
+        for (auto& eq1 : getAll()) {
+            auto* outPt1 = pv.getOutputPts().at(eq1.get());
+            auto& inPts1 = pv.getInputPts().at(eq1.get());
+            for (auto ip : inPts1) {
+                auto* g = ip->getGrid();
+                if (!inPlaceOk.count(g) || !inPlaceOk[g])
+                    continue;
+                int first_ofs = 0, last_ofs = 0;
+                g->getStepOffsetRange(first_ofs, last_ofs);
+                int old_ofs = (writeOfs[g] == last_ofs) ? first_ofs : last_ofs;
+                auto sdim = g->getStepDim();
+                auto* ofs = ip->getArgOffsets().lookup(sdim->getName());
+
+                // Only reads of the oldest value matter.
+                if (ofs && *ofs != old_ofs)
+                    continue;
+                bool ok = ofs && outPt1->getGrid() == g &&
+                    g->getStepHaloSize(old_ofs) == 0;
+                if (ok) {
+                    auto& args = ip->getArgs();
+                    auto& oargs = outPt1->getArgs();
+                    for (size_t i = 0; ok && i < args.size(); i++)
+                        if (g->getDims()[i]->getName() != sdim->getName() &&
+                            args[i]->makeStr() != oargs[i]->makeStr())
+                            ok = false;
+                }
+                if (!ok)
+                    inPlaceOk[g] = false;
+            }
+        }
+        for (auto& i : inPlaceOk)
+            i.first->setInPlaceOk(i.second);
     }
    
    
@@ -777,6 +847,326 @@ namespace yask {
         }
     };
 
+    // Makes copies of exprs w/each grid point shifted by an offset, like
+    // a clone followed by an OffsetVisitor, except that sub-exprs w/o
+    // grid points are shared w/the original, and a sub-expr that
+    // appears more than once, e.g., after CSE, is copied only once.
+    class OffsetCopier {
+        IntTuple _ofs;
+        map<Expr*, NumExprPtr> _copies; // original -> copy.
+
+        // Make a new node like 'ep' w/operands 'ops'.
+        // Returns null if the type of 'ep' isn't known.
+        static NumExprPtr remake(NumExprPtr ep, const NumExprPtrVec& ops) {
+            if (dynamic_pointer_cast<NegExpr>(ep))
+                return make_shared<NegExpr>(ops[0]);
+            if (dynamic_pointer_cast<SubExpr>(ep))
+                return make_shared<SubExpr>(ops[0], ops[1]);
+            if (dynamic_pointer_cast<DivExpr>(ep))
+                return make_shared<DivExpr>(ops[0], ops[1]);
+            shared_ptr<CommutativeExpr> ce;
+            if (dynamic_pointer_cast<AddExpr>(ep))
+                ce = make_shared<AddExpr>();
+            else if (dynamic_pointer_cast<MultExpr>(ep))
+                ce = make_shared<MultExpr>();
+            if (ce)
+                ce->getOps() = ops;
+            return ce;
+        }
+        
+    public:
+        OffsetCopier(const IntTuple& ofs) :
+            _ofs(ofs) {}
+
+        NumExprPtr copy(NumExprPtr ep) {
+            auto it = _copies.find(ep.get());
+            if (it != _copies.end())
+                return it->second;
+            NumExprPtr np = ep; // share by default.
+
+            // Shift grid point.
+            if (auto gp = dynamic_pointer_cast<GridPoint>(ep)) {
+                auto ngp = gp->cloneGridPoint();
+                ngp->setArgOffsets(gp->getArgOffsets().addElements(_ofs, false));
+                np = ngp;
+            }
+
+            // Copy operands and make a new node if any changed.
+            else {
+                NumExprPtrVec ops, nops;
+                if (auto be = dynamic_pointer_cast<BinaryNumExpr>(ep)) {
+                    ops.push_back(be->getLhs());
+                    ops.push_back(be->getRhs());
+                }
+                else if (auto ue = dynamic_pointer_cast<UnaryNumExpr>(ep))
+                    ops.push_back(ue->getRhs());
+                else if (auto ce = dynamic_pointer_cast<CommutativeExpr>(ep))
+                    ops = ce->getOps();
+                bool changed = false;
+                for (auto& op : ops) {
+                    nops.push_back(copy(op));
+                    if (nops.back().get() != op.get())
+                        changed = true;
+                }
+                if (changed) {
+                    np = remake(ep, nops);
+
+                    // Unknown type: fall back to a deep copy.
+                    if (!np) {
+                        np = ep->clone();
+                        OffsetVisitor ov(_ofs);
+                        np->accept(&ov);
+                    }
+                }
+            }
+            _copies[ep.get()] = np;
+            return np;
+        }
+
+        EqualsExprPtr copy(EqualsExprPtr eq) {
+            auto lhs = eq->getLhs()->cloneGridPoint();
+            lhs->setArgOffsets(lhs->getArgOffsets().addElements(_ofs, false));
+            BoolExprPtr cond;
+            if (eq->getCond()) {
+                cond = eq->getCond()->clone();
+                OffsetVisitor ov(_ofs);
+                cond->accept(&ov);
+            }
+            return make_shared<EqualsExpr>(lhs, copy(eq->getRhs()), cond);
+        }
+    };
+
+    // Visitor that replaces each read of a scratch grid with the
+    // expression that defines it, shifted to the offsets of the read.
+    class ScratchInlineVisitor : public RewriteVisitor {
+        Grid* _grid;
+        NumExprPtr _rhs;
+
+    public:
+        ScratchInlineVisitor(Grid* grid, NumExprPtr rhs) :
+            RewriteVisitor("scratch-grid inlining"),
+            _grid(grid), _rhs(rhs) {}
+
+        virtual NumExprPtr rewrite(NumExprPtr ep) {
+            auto gp = dynamic_pointer_cast<GridPoint>(ep);
+            if (!gp || gp->getGrid() != _grid)
+                return ep;
+
+            // Make a copy of the RHS at the offsets of 'gp'.
+            auto ne = _rhs->clone();
+            OffsetVisitor ov(gp->getArgOffsets());
+            ne->accept(&ov);
+            _numChanges++;
+            return ne;
+        }
+    };
+
+    // Visitor that adds an index to each point in the given grids
+    // after the dim was added to the grids.
+    class BatchDimVisitor : public ExprVisitor {
+        const map<Grid*, size_t>& _posns; // grid -> posn of new dim.
+        IndexExprPtr _dim;
+        set<GridPoint*> _done; // points may be shared.
+
+    public:
+        BatchDimVisitor(const map<Grid*, size_t>& posns, IndexExprPtr dim) :
+            _posns(posns), _dim(dim) {}
+
+        virtual void visit(GridPoint* gp) {
+            auto i = _posns.find(gp->getGrid());
+            if (i == _posns.end() || _done.count(gp))
+                return;
+            gp->insertArg(i->second, _dim->clone());
+            _done.insert(gp);
+        }
+    };
+
+    // Add the domain dim named in 'settings._batchDim' to the grids that
+    // hold the state of each independent problem in a batch, i.e., all
+    // non-scratch grids that are updated and the scratch grids that
+    // depend on them. Read-only grids are shared by the whole batch.
+    void Eqs::addBatchDim(CompilerSettings& settings,
+                          Grids& grids,
+                          ostream& os) {
+        auto& bname = settings._batchDim;
+        if (!bname.length())
+            return;
+        for (auto* g : grids)
+            for (auto& d : g->getDims())
+                if (d->getName() == bname)
+                    THROW_YASK_EXCEPTION("Error: batch dimension '" + bname +
+                                         "' is already used in grid '" +
+                                         g->getName() + "'");
+
+        // Updated non-scratch grids, then scratch grids that read any
+        // batched grid until there are no more.
+        PointVisitor pv;
+        visitEqs(&pv);
+        set<Grid*> batched;
+        for (auto eq : _all) {
+            auto* g = eq->getGrid();
+            if (!g->isScratch())
+                batched.insert(g);
+        }
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (auto eq : _all) {
+                auto* g = eq->getGrid();
+                if (batched.count(g))
+                    continue;
+                for (auto* ig : pv.getInputGrids().at(eq.get()))
+                    if (batched.count(ig)) {
+                        batched.insert(g);
+                        progress = true;
+                        break;
+                    }
+            }
+        }
+
+        // Add the dim to the grids, then to their points.
+        auto dim = make_shared<IndexExpr>(bname, DOMAIN_INDEX);
+        map<Grid*, size_t> posns;
+        for (auto* g : grids)
+            if (batched.count(g))
+                posns[g] = g->insertDim(dim);
+        BatchDimVisitor bdv(posns, dim);
+        visitEqs(&bdv);
+        os << "\nAdded batch dimension '" << bname << "' to " << posns.size() <<
+            " updated grid(s); " << (grids.size() - posns.size()) <<
+            " other grid(s) are shared by the batch.\n";
+    }
+
+    // Replace reads of scratch grids with their defining expressions
+    // when the recomputation is cheaper than the store and reloads, or
+    // when requested via 'settings'. Inlined scratch grids and their
+    // eqs are removed from 'grids' and this object.
+    void Eqs::inlineScratchEqs(CompilerSettings& settings,
+                               Grids& grids,
+                               ostream& os) {
+        regex inlinex(settings._inlineScratchRegex);
+        regex keepx(settings._keepScratchRegex);
+        bool doInline = settings._inlineScratchRegex.length() > 0;
+        bool doKeep = settings._keepScratchRegex.length() > 0;
+
+        // Count eqs that define each scratch grid.
+        map<Grid*, int> numDefs;
+        for (auto eq : _all) {
+            auto* g = eq->getGrid();
+            if (g->isScratch())
+                numDefs[g]++;
+        }
+        if (!numDefs.size())
+            return;
+        os << "\nChecking " << numDefs.size() << " scratch grid(s) for inlining...\n";
+
+        // Scratch grids already inlined or kept.
+        set<Grid*> done;
+
+        // Visit producers before consumers, so that a scratch grid is
+        // only considered after all the scratch grids it reads.
+        bool progress = true;
+        while (progress) {
+            progress = false;
+
+            PointVisitor pv;
+            visitEqs(&pv);
+            for (auto eq : _all) {
+                auto* g = eq->getGrid();
+                if (!g->isScratch() || done.count(g))
+                    continue;
+                bool ready = true;
+                for (auto* ig : pv.getInputGrids().at(eq.get()))
+                    if (ig->isScratch() && ig != g && !done.count(ig))
+                        ready = false;
+                if (!ready)
+                    continue;
+                done.insert(g);
+                progress = true;
+                auto& gname = g->getName();
+
+                // Check whether inlining is possible.
+                // The LHS must be at the origin in all dims, and every
+                // read of 'g' must be at simple offsets in all dims.
+                string why;
+                auto* lhs = eq->getLhs().get();
+                if (numDefs.at(g) > 1)
+                    why = "it is defined by more than one equation";
+                else if (eq->getCond())
+                    why = "its equation has a condition";
+                else if (lhs->getArgOffsets().getNumDims() != g->get_num_dims() ||
+                         lhs->getArgOffsets().max() != 0 ||
+                         lhs->getArgOffsets().min() != 0)
+                    why = "its LHS is not at the origin";
+                else if (pv.getInputGrids().at(eq.get()).count(g))
+                    why = "its equation reads its own values";
+
+                // Count unique reads of 'g' in other eqs.
+                int numReads = 0;
+                for (auto eq2 : _all) {
+                    if (eq2 == eq)
+                        continue;
+                    set<GridPoint> pts;
+                    for (auto* ip : pv.getInputPts().at(eq2.get())) {
+                        if (ip->getGrid() != g)
+                            continue;
+                        if (ip->getArgOffsets().getNumDims() != g->get_num_dims())
+                            why = "it is read at a non-simple index";
+                        pts.insert(*ip);
+                    }
+                    numReads += pts.size();
+                }
+
+                // Recomputing costs the producer's ops at every read
+                // but the first.
+                CounterVisitor cv;
+                eq->getRhs()->accept(&cv);
+                int numOps = cv.getNumOps();
+                int extraOps = numOps * max(numReads - 1, 0);
+
+                // Decide.
+                bool inlineIt = extraOps <= settings._maxScratchInlineOps;
+                if (doKeep && regex_search(gname, keepx))
+                    inlineIt = false;
+                else if (doInline && regex_search(gname, inlinex))
+                    inlineIt = true;
+                if (inlineIt && why.length()) {
+                    os << " Cannot inline scratch grid '" << gname <<
+                        "' because " << why << ".\n";
+                    inlineIt = false;
+                }
+                if (!inlineIt) {
+                    os << " Keeping scratch grid '" << gname << "': " << numReads <<
+                        " unique read(s) of " << numOps << " FP op(s) each.\n";
+                    continue;
+                }
+                os << " Inlining scratch grid '" << gname << "' into " << numReads <<
+                    " unique read(s), adding " << extraOps << " FP op(s).\n";
+
+                // Replace reads in all other eqs.
+                ScratchInlineVisitor siv(g, eq->getRhs());
+                EqList newAll;
+                for (auto eq2 : _all) {
+                    if (eq2 == eq)
+                        continue;
+                    eq2->accept(&siv);
+                    newAll.insert(eq2);
+                }
+                _all = newAll;
+
+                // Remove grid.
+                Grids newGrids;
+                for (auto* g2 : grids)
+                    if (g2 != g)
+                        newGrids.insert(g2);
+                grids = newGrids;
+
+                // Start over because the eqs have changed.
+                break;
+            }
+        }
+    }
+
     // Replicate each equation at the non-zero offsets for
     // each vector in a cluster.
     void EqBundle::replicateEqsInCluster(Dimensions& dims)
@@ -799,15 +1189,13 @@ namespace yask {
                     auto clusterOffset = clusterIndex.multElements(dims._fold);
 
                     // Loop thru eqs.
+                    // Sub-exprs are copied once for all eqs at this offset.
+                    OffsetCopier oc(clusterOffset);
                     for (auto eq : eqs) {
                         assert(eq.get());
             
-                        // Make a copy.
-                        auto eq2 = eq->clone();
-
-                        // Add offsets to each grid point.
-                        OffsetVisitor ov(clusterOffset);
-                        eq2->accept(&ov);
+                        // Make a copy w/offsets added to each grid point.
+                        auto eq2 = oc.copy(eq);
 
                         // Put new equation into bundle.
                         addEq(eq2);
@@ -918,14 +1306,164 @@ namespace yask {
         return newBundle;
     }
 
+    // Estimate the bytes moved per point when evaluating 'eb'.
+    double EqBundles::estimateBytesPerPoint(EqBundle& eb,
+                                            const CompilerSettings& settings) const {
+        double elemBytes = settings._elem_bytes;
+
+        // Memory traffic: each input grid is streamed in and each output
+        // grid is streamed out once per pass over the bundle, so a grid
+        // shared by eqs in the same bundle is only counted once.
+        double bytes = elemBytes *
+            (eb.getInputGrids().size() + eb.getOutputGrids().size());
+
+        // Register pressure: eqs are evaluated one after another, so the
+        // live vectors are those of the largest eq plus those read by
+        // more than one eq, which are kept for reuse. Each one beyond the
+        // register budget is assumed to be spilled and reloaded, i.e., two
+        // elements moved per point.
+        map<GridPoint, int> vecUses;
+        int maxEqVecs = 0;
+        for (auto& eq : eb.getEqs()) {
+            VecInfoVisitor vv(*_dims);
+            eq->accept(&vv);
+            CounterVisitor cv;
+            eq->accept(&cv);
+            int numEqVecs = vv.getNumAlignedVecs() + vv._scalarPoints.size() +
+                vv._nonVecPoints.size() + cv.getNumWrites();
+            maxEqVecs = max(maxEqVecs, numEqVecs);
+            for (auto& av : vv._alignedVecs)
+                vecUses[av]++;
+        }
+        int numShared = 0;
+        for (auto& i : vecUses)
+            if (i.second > 1)
+                numShared++;
+        int numSpills = max(0, maxEqVecs + numShared - settings._bundleRegs);
+        bytes += 2.0 * elemBytes * numSpills;
+
+        return bytes;
+    }
+
+    // Search for a low-cost bundling of 'eqs' and add the resulting
+    // bundles with the default base-name.
+    // Simple, greedy algorithm: start with one bundle per eq, then
+    // repeatedly merge the legal pair that saves the most bytes per
+    // point. Merges that save nothing are still taken to reduce the
+    // number of passes, but not ones that add spills.
+    void EqBundles::searchEqBundles(Eqs& allEqs,
+                                    const EqList& eqs,
+                                    const CompilerSettings& settings,
+                                    ostream& os) {
+        if (!eqs.size())
+            return;
+        os << "Searching for bundling of " << eqs.size() << " equation(s)...\n";
+        auto& eq_deps = allEqs.getDeps();
+
+        // Candidate bundles and their costs.
+        vector<shared_ptr<EqBundle>> cands;
+        vector<double> costs;
+        for (auto eq : eqs) {
+            assert(!eq->isScratch());
+            auto eb = make_shared<EqBundle>(*_dims, false);
+            eb->cond = eq->getCond();
+            eb->addEq(eq);
+            cands.push_back(eb);
+            costs.push_back(estimateBytesPerPoint(*eb, settings));
+        }
+        double startCost = 0.0;
+        for (auto c : costs)
+            startCost += c;
+
+        while (cands.size() > 1) {
+
+            // Find best pair to merge.
+            size_t iBest = 0, jBest = 0;
+            double bestGain = -1.0, bestCost = 0.0;
+            shared_ptr<EqBundle> best;
+            for (size_t i = 0; i < cands.size(); i++) {
+                for (size_t j = i + 1; j < cands.size(); j++) {
+                    auto& ci = cands[i];
+                    auto& cj = cands[j];
+
+                    // Must have same condition.
+                    if (!areExprsSame(ci->cond, cj->cond))
+                        continue;
+
+                    // Must not have any dependency between them.
+                    // Deps are transitive, so this also rules out
+                    // paths through other bundles.
+                    bool is_ok = true;
+                    for (auto& eq1 : ci->getEqs()) {
+                        for (auto& eq2 : cj->getEqs()) {
+                            if (eq_deps.is_dep(eq1, eq2)) {
+                                is_ok = false;
+                                break;
+                            }
+                        }
+                        if (!is_ok)
+                            break;
+                    }
+                    if (!is_ok)
+                        continue;
+
+                    // Score merged bundle.
+                    auto merged = make_shared<EqBundle>(*ci);
+                    for (auto& eq2 : cj->getEqs())
+                        merged->addEq(eq2);
+                    double cost = estimateBytesPerPoint(*merged, settings);
+                    double gain = costs[i] + costs[j] - cost;
+                    if (gain >= 0.0 && gain > bestGain) {
+                        iBest = i;
+                        jBest = j;
+                        bestGain = gain;
+                        bestCost = cost;
+                        best = merged;
+                    }
+                }
+            }
+            if (!best)
+                break;
+#if DEBUG_ADD_EXPRS
+            cout << "searchEqBundles: merging candidates " << iBest <<
+                " and " << jBest << " saves " << bestGain << " byte(s) per point\n";
+#endif
+
+            // Replace first and remove second.
+            cands[iBest] = best;
+            costs[iBest] = bestCost;
+            cands.erase(cands.begin() + jBest);
+            costs.erase(costs.begin() + jBest);
+        }
+
+        // Add resulting bundles.
+        double endCost = 0.0;
+        for (size_t i = 0; i < cands.size(); i++) {
+            auto& eb = cands[i];
+            eb->baseName = _basename_default;
+            eb->index = _indices[_basename_default]++;
+            addItem(eb);
+            for (auto& eq : eb->getEqs()) {
+                _eqs_in_bundles.insert(eq);
+                _outGrids.insert(eq->getGrid());
+            }
+            endCost += costs[i];
+            os << " " << eb->getDescr() << ": estimated " <<
+                costs[i] << " byte(s) per point.\n";
+        }
+        os << "Estimated " << endCost << " byte(s) per point in " << cands.size() <<
+            " bundle(s) vs. " << startCost << " in " << eqs.size() << " unfused bundle(s).\n";
+    }
+
     // Divide all equations into eqBundles.
-    // Only process updates to grids in 'gridRegex'.
-    // 'targets': string provided by user to specify bundleing.
+    // Only process updates to grids in the grid regex.
+    // The eq-bundle targets are provided by user to specify bundling.
     void EqBundles::makeEqBundles(Eqs& allEqs,
-                                  const string& gridRegex,
-                                  const string& targets,
+                                  const CompilerSettings& settings,
                                   ostream& os)
     {
+        auto& gridRegex = settings._gridRegex;
+        auto& targets = settings._eqBundleTargets;
         os << "\nPartitioning " << allEqs.getNum() << " equation(s) into bundles...\n";
         //auto& stepDim = _dims->_stepDim;
 
@@ -976,6 +1514,7 @@ namespace yask {
             });
 
         // Add all remaining equations.
+        EqList remEqs;
         for (auto eq : allEqs.getAll()) {
 
             // Get name of updated grid.
@@ -987,9 +1526,14 @@ namespace yask {
             if (!regex_search(gname, gridx))
                 continue;
 
-            // Add equation.
-            addEqToBundle(allEqs, eq, _basename_default);
+            // Add equation now or save for search.
+            if (!settings._autoBundle)
+                addEqToBundle(allEqs, eq, _basename_default);
+            else if (!_eqs_in_bundles.count(eq))
+                remEqs.insert(eq);
         }
+        if (settings._autoBundle)
+            searchEqBundles(allEqs, remEqs, settings, os);
 
         os << "Finding transitive closure...\n";
         inherit_deps_from(allEqs);
@@ -1047,11 +1591,30 @@ namespace yask {
                 opts.push_back(new CseVisitor);
         }
 
+        // Factoring of common multiplicands.
+        if (settings._doFactor) {
+            opts.push_back(new FactorVisitor);
+
+            // Do CSE again to share new sums.
+            if (settings._doCse)
+                opts.push_back(new CseVisitor);
+        }
+
+        // Multiply-add chains.
+        // Must be last because combination would undo it.
+        if (settings._maxFmaChain > 1)
+            opts.push_back(new FmaChainVisitor(settings._maxFmaChain));
+
         // Apply opts.
+        // Any hashes cached by a previous opt are invalid if it
+        // changed the exprs.
+        Expr::clearHashes();
         for (auto optimizer : opts) {
 
             visitEqs(optimizer);
             int numChanges = optimizer->getNumChanges();
+            if (numChanges)
+                Expr::clearHashes();
             string odescr = "after applying " + optimizer->getName() + " to " +
                 descr + " equation-bundle(s)";
 
@@ -352,6 +352,16 @@ namespace yask {
             }
         }
 
+        // Add the batch dim to the grids that are updated.
+        virtual void addBatchDim(CompilerSettings& settings,
+                                 Grids& grids,
+                                 std::ostream& os);
+
+        // Replace reads of cheap scratch grids with their defining exprs.
+        virtual void inlineScratchEqs(CompilerSettings& settings,
+                                      Grids& grids,
+                                      std::ostream& os);
+
         // Find dependencies based on all eqs. 
         virtual void analyzeEqs(CompilerSettings& settings,
                                 Dimensions& dims,
@@ -507,6 +517,17 @@ namespace yask {
                                    EqualsExprPtr eq,
                                    const string& baseName);
 
+        // Estimate the bytes moved per point when evaluating 'eb'.
+        virtual double estimateBytesPerPoint(EqBundle& eb,
+                                             const CompilerSettings& settings) const;
+
+        // Search for a low-cost bundling of 'eqs' and add the
+        // resulting bundles with the default base-name.
+        virtual void searchEqBundles(Eqs& allEqs,
+                                     const EqList& eqs,
+                                     const CompilerSettings& settings,
+                                     ostream& os);
+
     public:
         EqBundles() {}
         EqBundles(const string& basename_default, Dimensions& dims) :
@@ -528,9 +549,11 @@ namespace yask {
         // In this example, all eqs updating grid names containing 'foo' go in eqBundle1,
         // all eqs updating grid names containing 'bar' go in eqBundle2, and
         // each remaining eq goes into a separate eqBundle.
+        // Only updates to grids matching the grid regex are processed.
+        // If auto-bundling is enabled, the remaining eqs are bundled by
+        // a search instead.
         void makeEqBundles(Eqs& eqs,
-                           const string& gridRegex,
-                           const string& targets,
+                           const CompilerSettings& settings,
                            std::ostream& os);
         
         virtual const Grids& getOutputGrids() const {
@@ -313,6 +313,9 @@ namespace yask {
     BIN_NUM2BOOL_OP(IsGreaterExpr, >)
     BIN_NUM2BOOL_OP(NotGreaterExpr, <=)
     
+    // Start w/all cached hashes invalid.
+    unsigned Expr::_curHashGen = 1;
+
     // Compare 2 expr pointers and return whether the expressions are
     // equivalent.
     // TODO: Be much smarter about matching symbolically-equivalent exprs.
@@ -348,6 +351,13 @@ namespace yask {
         return make_shared<IndexExpr>(dim->getName(), LAST_INDEX);
     }
 
+    // Free function to get the min FD order set at run-time for the
+    // current point. The kernel evaluates it from the indices passed to
+    // the sub-domain condition.
+    NumExprPtr min_order() {
+        return make_shared<CodeExpr>("MIN_ORDER(idxs)");
+    }
+
     // Commutative.
     // If one side is nothing, just return other side;
     // This allows us to start with an uninitialized GridValue
@@ -536,6 +546,12 @@ namespace yask {
             _rhs->isSame(p->_rhs.get()) &&
             areExprsSame(_cond, p->_cond); // might be null.
     }
+    size_t EqualsExpr::makeHash() const {
+        size_t h = combineHashes(_lhs->getHash(), _rhs->getHash());
+        if (_cond)
+            h = combineHashes(h, _cond->getHash());
+        return h;
+    }
 
     // Commutative methods.
     bool CommutativeExpr::isSame(const Expr* other) const {
@@ -571,6 +587,14 @@ namespace yask {
         // Do all match?
         return matches.size() == _ops.size();
     }
+    size_t CommutativeExpr::makeHash() const {
+
+        // Operands may be in any order, so just add their hashes.
+        size_t h = 0;
+        for (auto& op : _ops)
+            h += op->getHash();
+        return combineHashes(hash<string>{}(_opStr), h);
+    }
 
     // GridPoint methods.
     GridPoint::GridPoint(Grid* grid, const NumExprPtrVec& args) :
@@ -634,7 +658,11 @@ namespace yask {
         return _grid == rhs._grid &&
             _offsets == rhs._offsets &&
             _consts == rhs._consts &&
-            makeStr() == rhs.makeStr(); // TODO: make more efficient.
+            getArgStr() == rhs.getArgStr();
+    }
+    size_t GridPoint::makeHash() const {
+        return combineHashes(hash<const Grid*>{}(_grid),
+                             hash<string>{}(getArgStr()));
     }
     bool GridPoint::operator<(const GridPoint& rhs) const {
         return (_grid < rhs._grid) ? true :
@@ -643,7 +671,7 @@ namespace yask {
             (_offsets > rhs._offsets) ? false :
             (_consts < rhs._consts) ? true :
             (_consts > rhs._consts) ? false :
-            makeStr() < rhs.makeStr(); // TODO: make more efficient.
+            getArgStr() < rhs.getArgStr();
     }
     string GridPoint::makeArgStr(const VarMap* varMap) const {
         string str;
@@ -758,6 +786,7 @@ namespace yask {
 
                 // Replace in args.
                 _args[i] = nep;
+                argsChanged();
 
                 // Set offset.
                 _offsets.addDimBack(dname, ofs);
@@ -770,6 +799,23 @@ namespace yask {
         }
     }
     
+    // Insert arg for a dim just added to the grid.
+    void GridPoint::insertArg(size_t posn, NumExprPtr arg) {
+        auto gdims = _grid->getDims();
+        assert(gdims.size() == _args.size() + 1);
+        assert(posn < gdims.size());
+        auto dname = gdims[posn]->getName();
+        _args.insert(_args.begin() + posn, arg);
+        argsChanged();
+
+        // Eval arg as in ctor.
+        int offset = 0;
+        if (arg->isConstVal())
+            _consts.addDimBack(dname, arg->getIntVal());
+        else if (arg->isOffsetFrom(dname, offset))
+            _offsets.addDimBack(dname, offset);
+    }
+
     // Set given arg to given const;
     void GridPoint::setArgConst(const IntScalar& val) {
 
@@ -787,6 +833,7 @@ namespace yask {
 
                 // Replace in args.
                 _args[i] = vp;
+                argsChanged();
 
                 // Set const
                 _consts.addDimBack(dname, v);
@@ -129,6 +129,11 @@ namespace yask {
     struct Dimensions;
 
     typedef map<string, string> VarMap; // map used when substituting vars.
+
+    // Mix 'h2' into hash 'h1'.
+    inline size_t combineHashes(size_t h1, size_t h2) {
+        return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+    }
     
     //// Classes to implement parts of expressions.
     // The expressions are constructed at run-time when the
@@ -140,6 +145,15 @@ namespace yask {
     // NumExpr, BoolExpr, and EqualsExpr.
     class Expr : public virtual yc_expr_node {
 
+    protected:
+        // Cached value of makeHash().
+        mutable size_t _hash = 0;
+        mutable unsigned _hashGen = 0; // valid if same as '_curHashGen'.
+        static unsigned _curHashGen;
+
+        // Compute a hash of the structure of this expr.
+        virtual size_t makeHash() const =0;
+
     public:
         Expr() { }
         virtual ~Expr() { }
@@ -156,6 +170,21 @@ namespace yask {
             return isSame(other.get());
         }
 
+        // Get a hash of the structure of this expr.
+        // Exprs that are the same via isSame() have the same hash.
+        // The hash is cached in each node, so clearHashes() must be
+        // called after modifying any expr that may have been hashed.
+        virtual size_t getHash() const {
+            if (_hashGen != _curHashGen) {
+                _hash = makeHash();
+                _hashGen = _curHashGen;
+            }
+            return _hash;
+        }
+        static void clearHashes() {
+            _curHashGen++;
+        }
+
         // Return a simple string expr.
         virtual string makeStr(const VarMap* varMap = 0) const;
         virtual string makeQuotedStr(string quote = "'",
@@ -310,6 +339,9 @@ namespace yask {
             auto p = dynamic_cast<const IndexExpr*>(other);
             return p && _dimName == p->_dimName && _type == p->_type;
         }
+        virtual size_t makeHash() const {
+            return combineHashes(hash<string>{}(_dimName), _type);
+        }
    
         // Create a deep copy of this expression.
         virtual NumExprPtr clone() const { return make_shared<IndexExpr>(*this); }
@@ -328,6 +360,12 @@ namespace yask {
     NumExprPtr first_index(IndexExprPtr dim);
     NumExprPtr last_index(IndexExprPtr dim);
 
+    // Free function to get the minimum finite-difference order needed
+    // at the current point, which is set per region of the domain at
+    // run-time. Only valid in a sub-domain condition, e.g.,
+    // 'IF min_order() <= 4'.
+    NumExprPtr min_order();
+
     // A simple wrapper to provide automatic construction
     // of a NumExpr ptr from other types.
     class NumExprArg : public NumExprPtr {
@@ -391,6 +429,9 @@ namespace yask {
             auto p = dynamic_cast<const ConstExpr*>(other);
             return p && _f == p->_f;
         }
+        virtual size_t makeHash() const {
+            return hash<double>{}(_f == 0.0 ? 0.0 : _f); // -0 == +0.
+        }
    
         // Create a deep copy of this expression.
         virtual NumExprPtr clone() const { return make_shared<ConstExpr>(*this); }
@@ -424,6 +465,9 @@ namespace yask {
             auto p = dynamic_cast<const CodeExpr*>(other);
             return p && _code == p->_code;
         }
+        virtual size_t makeHash() const {
+            return hash<string>{}(_code);
+        }
 
         // Create a deep copy of this expression.
         virtual NumExprPtr clone() const { return make_shared<CodeExpr>(*this); }
@@ -459,6 +503,9 @@ namespace yask {
             return p && _opStr == p->_opStr &&
                 _rhs && _rhs->isSame(p->_rhs.get());
         }
+        virtual size_t makeHash() const {
+            return combineHashes(hash<string>{}(_opStr), _rhs->getHash());
+        }
     };
 
     // Various types of unary operators depending on input and output types.
@@ -543,6 +590,10 @@ namespace yask {
                 _lhs->isSame(p->_lhs.get()) &&
                 BaseT::_rhs->isSame(p->_rhs.get());
         }
+        virtual size_t makeHash() const {
+            return combineHashes(combineHashes(BaseT::makeHash(), 2),
+                                 _lhs->getHash());
+        }
 
         // APIs.
         virtual ArgApiT get_lhs() {
@@ -712,6 +763,7 @@ namespace yask {
 
         // Check for equivalency.
         virtual bool isSame(const Expr* other) const;
+        virtual size_t makeHash() const;
 
         // APIs.
         virtual int get_num_operands() {
@@ -809,6 +861,19 @@ namespace yask {
 
         VecType _vecType = VEC_UNSET; // allowed vectorization.
         LoopType _loopType = LOOP_UNSET; // analysis for looping.
+
+        // Cached makeArgStr() w/o substitutions for comparisons and
+        // hashing. Cleared when args are changed.
+        mutable string _argStr;
+        virtual const string& getArgStr() const {
+            if (_argStr.empty())
+                _argStr = makeArgStr();
+            return _argStr;
+        }
+        virtual void argsChanged() {
+            _argStr.clear();
+            _hashGen = 0;
+        }
         
     public:
         
@@ -856,6 +921,10 @@ namespace yask {
         // Set given arg to given const.
         virtual void setArgConst(const IntScalar& val);
 
+        // Insert 'arg' at 'posn' after the same dim was
+        // inserted into the grid via Grid::insertDim().
+        virtual void insertArg(size_t posn, NumExprPtr arg);
+
         // Some comparisons.
         bool operator==(const GridPoint& rhs) const;
         bool operator<(const GridPoint& rhs) const;
@@ -868,6 +937,7 @@ namespace yask {
             auto p = dynamic_cast<const GridPoint*>(other);
             return p && *this == *p;
         }
+        virtual size_t makeHash() const;
 
         // Check for same logical grid.
         // A logical grid is defined by the grid itself
@@ -916,13 +986,12 @@ namespace yask {
 } // namespace yask.
 
 // Define hash function for GridPoint for unordered_{set,map}.
-// TODO: make this more efficient.
 namespace std {
     using namespace yask;
     
     template <> struct hash<GridPoint> {
         size_t operator()(const GridPoint& k) const {
-            return hash<string>{}(k.makeStr());
+            return k.getHash();
         }
     };
 }
@@ -975,6 +1044,7 @@ namespace yask {
         
         // Check for equivalency.
         virtual bool isSame(const Expr* other) const;
+        virtual size_t makeHash() const;
 
         // Create a deep copy of this expression.
         virtual EqualsExprPtr clone() const { return make_shared<EqualsExpr>(*this); }
@@ -78,15 +78,18 @@ namespace yask {
 #endif
         
         // Already visited this node?
-        if (_seen.count(ep)) {
+        if (_seen.count(ep.get())) {
 #if DEBUG_CSE >= 2
             cout << "  //** already seen '" << ep->makeStr() << "'@" << ep << endl;
 #endif
             return true;
         }
         
-        // Loop through nodes already seen.
-        for (auto& oep : _seen) {
+        // Loop through nodes already seen w/the same hash.
+        size_t h = ep->getHash();
+        auto range = _seenByHash.equal_range(h);
+        for (auto it = range.first; it != range.second; it++) {
+            auto& oep = it->second;
 #if DEBUG_CSE >= 3
             cout << "  //** comparing '" << ep->makeStr() << "'@" << ep <<
                 " to '" << oep->makeStr() << "'@" << oep << endl;
@@ -110,7 +113,167 @@ namespace yask {
 #if DEBUG_CSE >= 2
         cout << "  //** no match to " << ep->makeStr() << endl;
 #endif
-        _seen.insert(ep);
+        _seen.insert(ep.get());
+        _seenByHash.insert({h, ep});
         return false;
     }
+
+    // Rewrite children of 'ep', then 'ep' itself.
+    void RewriteVisitor::rewriteChild(NumExprPtr& ep) {
+
+        // Already rewritten this node?
+        auto it = _newExprs.find(ep.get());
+        if (it != _newExprs.end()) {
+            ep = it->second;
+            return;
+        }
+        auto oep = ep;
+
+        // Depth-first.
+        ep->accept(this);
+        ep = rewrite(ep);
+
+        _oldExprs.push_back(oep);
+        _newExprs[oep.get()] = ep;
+        _newExprs[ep.get()] = ep;
+    }
+
+    // Return product 'ep' if it contains 'factor', else null.
+    static CommutativeExpr* findFactor(NumExprPtr ep, NumExprPtr factor) {
+        auto pe = dynamic_cast<CommutativeExpr*>(ep.get());
+        if (pe && pe->getOpStr() == MultExpr::opStr()) {
+            for (auto& op : pe->getOps())
+                if (op->isSame(factor.get()))
+                    return pe;
+        }
+        return 0;
+    }
+
+    // Factor common multiplicands out of a sum.
+    NumExprPtr FactorVisitor::rewrite(NumExprPtr ep) {
+        auto se = dynamic_cast<CommutativeExpr*>(ep.get());
+        if (!se || se->getOpStr() != AddExpr::opStr())
+            return ep;
+        NumExprPtrVec ops = se->getOps(); // copy.
+        bool changed = false;
+
+        // Simple, greedy algorithm:
+        // Select the factor that appears in the most products.
+        // Repeat until no factor appears in more than one product.
+        while (true) {
+            NumExprPtr best;
+            size_t bestCount = 1;
+            for (auto& op : ops) {
+                auto pe = dynamic_cast<CommutativeExpr*>(op.get());
+                if (!pe || pe->getOpStr() != MultExpr::opStr())
+                    continue;
+                for (auto& f : pe->getOps()) {
+                    size_t count = 0;
+                    for (auto& op2 : ops)
+                        if (findFactor(op2, f))
+                            count++;
+                    if (count > bestCount ||
+                        (count > 1 && count == bestCount &&
+                         f->isConstVal() && !best->isConstVal())) {
+                        best = f;
+                        bestCount = count;
+                    }
+                }
+            }
+            if (!best)
+                break;
+
+            // Make a sum of the products w/o the factor.
+            auto rems = make_shared<AddExpr>();
+            NumExprPtrVec nops;
+            size_t pos = 0;
+            for (auto& op : ops) {
+                auto pe = findFactor(op, best);
+                if (!pe) {
+                    nops.push_back(op);
+                    continue;
+                }
+                if (rems->getOps().size() == 0)
+                    pos = nops.size();
+
+                // Remove only one instance of the factor.
+                NumExprPtrVec rops;
+                bool found = false;
+                for (auto& f : pe->getOps()) {
+                    if (!found && f->isSame(best.get()))
+                        found = true;
+                    else
+                        rops.push_back(f);
+                }
+                if (rops.size() == 1)
+                    rems->getOps().push_back(rops[0]);
+                else {
+                    auto rem = make_shared<MultExpr>();
+                    rem->getOps() = rops;
+                    rems->getOps().push_back(rem);
+                }
+            }
+
+            // Factor the remainders, too, e.g., for
+            // c*d*a + c*d*b.
+            auto prod = make_shared<MultExpr>();
+            prod->getOps().push_back(best);
+            prod->getOps().push_back(rewrite(rems));
+
+            // Replace the products w/the new one.
+            nops.insert(nops.begin() + pos, prod);
+            ops.swap(nops);
+            changed = true;
+            _numChanges++;
+        }
+
+        if (!changed)
+            return ep;
+        if (ops.size() == 1)
+            return ops[0];
+        auto nse = make_shared<AddExpr>();
+        nse->getOps() = ops;
+        return nse;
+    }
+
+    // Split a long sum into nested sums.
+    NumExprPtr FmaChainVisitor::rewrite(NumExprPtr ep) {
+        auto se = dynamic_cast<CommutativeExpr*>(ep.get());
+        if (_maxChain < 2 || !se || se->getOpStr() != AddExpr::opStr() ||
+            se->getOps().size() <= size_t(_maxChain))
+            return ep;
+
+        // Put non-products first.
+        NumExprPtrVec ops = se->getOps(); // copy.
+        stable_partition(ops.begin(), ops.end(),
+                         [&](NumExprPtr op) {
+                             auto ce = dynamic_cast<CommutativeExpr*>(op.get());
+                             return !ce || ce->getOpStr() != MultExpr::opStr();
+                         });
+
+        // Make groups of nearly equal size
+        // until the top-level sum is short enough.
+        while (ops.size() > size_t(_maxChain)) {
+            size_t nops = ops.size();
+            size_t ngroups = (nops + _maxChain - 1) / _maxChain;
+            NumExprPtrVec groups;
+            for (size_t g = 0; g < ngroups; g++) {
+                size_t begin = g * nops / ngroups;
+                size_t end = (g + 1) * nops / ngroups;
+                if (end - begin == 1)
+                    groups.push_back(ops[begin]);
+                else {
+                    auto ge = make_shared<AddExpr>();
+                    ge->getOps().assign(ops.begin() + begin, ops.begin() + end);
+                    groups.push_back(ge);
+                }
+            }
+            ops.swap(groups);
+            _numChanges++;
+        }
+
+        auto nse = make_shared<AddExpr>();
+        nse->getOps() = ops;
+        return nse;
+    }
 } // namespace yask.
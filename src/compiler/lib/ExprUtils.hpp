@@ -75,9 +75,12 @@ namespace yask {
     // A visitor that eliminates common numerical subexprs.
     // TODO: find matches to subsets of commutative operations;
     // example: a+b+c * b+d+a => c+(a+b) * d+(a+b) w/expr a+b combined.
+    // Candidate matches are found by their cached structural hashes, so
+    // each node is compared only to the few seen nodes w/the same hash.
     class CseVisitor : public OptVisitor {
     protected:
-        set<NumExprPtr> _seen;
+        unordered_set<Expr*> _seen;
+        unordered_multimap<size_t, NumExprPtr> _seenByHash; // key: hash.
     
         // If 'ep' has already been seen, just return true.
         // Else if 'ep' has a match, change pointer to that match, return true.
@@ -124,6 +127,83 @@ namespace yask {
         }
     };
 
+    // Base class for a visitor that replaces numerical subexprs
+    // bottom-up via the pointers held by their parents.
+    // New nodes are created instead of modifying existing ones, so
+    // nodes shared via CSE stay valid for their other parents.
+    // Each node is rewritten only once, and its replacement is
+    // reused wherever the original node appears.
+    class RewriteVisitor : public OptVisitor {
+    protected:
+        map<Expr*, NumExprPtr> _newExprs; // original -> replacement.
+        NumExprPtrVec _oldExprs; // keeps originals alive while in '_newExprs'.
+
+        // Rewrite children of 'ep', then 'ep' itself.
+        virtual void rewriteChild(NumExprPtr& ep);
+
+        // Return the replacement for 'ep' after its children
+        // have been rewritten, or 'ep' itself if no change.
+        virtual NumExprPtr rewrite(NumExprPtr ep) =0;
+
+    public:
+        RewriteVisitor(const string& name) :
+            OptVisitor(name) {}
+        virtual ~RewriteVisitor() {}
+
+        virtual void visit(UnaryNumExpr* ue) {
+            rewriteChild(ue->getRhs());
+        }
+        virtual void visit(BinaryNumExpr* be) {
+            rewriteChild(be->getLhs());
+            rewriteChild(be->getRhs());
+        }
+        virtual void visit(CommutativeExpr* ce) {
+            for (auto& ep : ce->getOps())
+                rewriteChild(ep);
+        }
+        virtual void visit(EqualsExpr* ee) {
+
+            // Only process RHS.
+            rewriteChild(ee->getRhs());
+        }
+    };
+
+    // A visitor that factors common multiplicands out of sums.
+    // Example: c*a + c*b + d => c*(a + b) + d.
+    // This is typical of symmetric stencils, where neighbors at the
+    // same distance share a coefficient.
+    // Constant factors are preferred when there is a tie.
+    class FactorVisitor : public RewriteVisitor {
+    protected:
+        virtual NumExprPtr rewrite(NumExprPtr ep);
+
+    public:
+        FactorVisitor() :
+            RewriteVisitor("common-factor extraction") {}
+        virtual ~FactorVisitor() {}
+    };
+
+    // A visitor that splits long sums into nested sums of at most
+    // '_maxChain' terms each.
+    // Example w/max chain of 2: a*b + c*d + e*f + g*h =>
+    // (a*b + c*d) + (e*f + g*h).
+    // Each inner sum can be evaluated as a chain of fused multiply-adds,
+    // and the chains are independent, which bounds the dependency depth.
+    // Non-product terms are put first so they can start a chain.
+    // Must be applied after CombineVisitor, which would undo it.
+    class FmaChainVisitor : public RewriteVisitor {
+    protected:
+        int _maxChain;
+
+        virtual NumExprPtr rewrite(NumExprPtr ep);
+
+    public:
+        FmaChainVisitor(int maxChain) :
+            RewriteVisitor("multiply-add chain splitting"),
+            _maxChain(maxChain) {}
+        virtual ~FmaChainVisitor() {}
+    };
+
     // A visitor that can keep track of what's been visted.
     class TrackingVisitor : public ExprVisitor {
     protected:
@@ -103,6 +103,90 @@ namespace yask {
             ret.push_back(dn->getName());
         return ret;
     }
+    void Grid::set_storage_precision(const std::string& precision) {
+        if (precision != "real" && precision != "bf16" && precision != "fp16" &&
+            precision != "lut8" && precision != "lut16")
+            THROW_YASK_EXCEPTION("Error: unknown storage precision '" + precision +
+                                 "' for grid '" + _name +
+                                 "'; use 'real', 'bf16', 'fp16', 'lut8', or 'lut16'");
+        if (_isScratch && precision != "real")
+            THROW_YASK_EXCEPTION("Error: scratch grid '" + _name +
+                                 "' cannot use reduced-precision storage");
+        _storagePrec = precision;
+    }
+    void Grid::set_interleave_group(const std::string& name) {
+        if (_isScratch && name.length())
+            THROW_YASK_EXCEPTION("Error: scratch grid '" + _name +
+                                 "' cannot be in an interleave group");
+        _interleaveGroup = name;
+    }
+
+    // Set the interleave factor of the grids in each interleave group.
+    // Groups are given via the grid APIs and/or the settings, e.g.,
+    // "s=stress_,v=vel_" puts the grids whose names contain 'stress_'
+    // in group 's' and those containing 'vel_' in group 'v'.
+    // Every grid in a group must have the same layout in the kernel, so
+    // grids that don't match the first one are stored separately.
+    void Grids::setInterleaving(const CompilerSettings& settings,
+                                ostream& os) {
+        if (settings._interleaveTargets.length()) {
+            ArgParser ap;
+            ap.parseKeyValuePairs
+                (settings._interleaveTargets, [&](const string& key, const string& value) {
+                    regex patx(value);
+                    for (auto gp : *this)
+                        if (!gp->isScratch() && regex_search(gp->getName(), patx))
+                            gp->set_interleave_group(key);
+                });
+        }
+
+        // Members of each group in grid order.
+        map<string, vector<Grid*>> groups;
+        for (auto gp : *this) {
+            gp->setInterleaveFactor(1);
+            auto& gname = gp->get_interleave_group();
+            if (gname.length())
+                groups[gname].push_back(gp);
+        }
+
+        for (auto& i : groups) {
+            auto& gname = i.first;
+            vector<Grid*> members;
+            for (auto gp : i.second) {
+                string why;
+                if (!gp->isFoldable())
+                    why = "it is not vector-folded";
+                else if (gp->isReducedPrecision())
+                    why = "it uses reduced-precision storage";
+                else if (members.size()) {
+                    auto* g0 = members[0];
+                    if (!gp->areDimsSame(*g0))
+                        why = "its dims differ from those of '" + g0->getName() + "'";
+                    else if (gp->getStepDimSize() != g0->getStepDimSize())
+                        why = "its step allocation differs from that of '" + g0->getName() + "'";
+                    else if (gp->getMinIndices() != g0->getMinIndices() ||
+                             gp->getMaxIndices() != g0->getMaxIndices())
+                        why = "its misc indices differ from those of '" + g0->getName() + "'";
+                }
+                if (why.length())
+                    os << "Notice: grid '" << gp->getName() << "' is not interleaved in group '" <<
+                        gname << "' because " << why << ".\n";
+                else
+                    members.push_back(gp);
+            }
+            if (members.size() < 2) {
+                os << "Notice: interleave group '" << gname << "' has fewer than two grids, "
+                    "so it is not used.\n";
+                continue;
+            }
+            os << "Interleaving " << members.size() << " grid(s) in group '" << gname << "':";
+            for (auto gp : members) {
+                gp->setInterleaveFactor(int(members.size()));
+                os << " '" << gp->getName() << "'";
+            }
+            os << ".\n";
+        }
+    }
 
     // yask_compiler_factory API methods.
     // See yask_compiler_api.hpp.
@@ -170,6 +254,16 @@ namespace yask {
         _dims = dims;
     }
 
+    // Add 'dim' after the existing step and domain dims.
+    size_t Grid::insertDim(IndexExprPtr dim) {
+        size_t posn = 0;
+        for (size_t i = 0; i < _dims.size(); i++)
+            if (_dims[i]->getType() != MISC_INDEX)
+                posn = i + 1;
+        _dims.insert(_dims.begin() + posn, dim);
+        return posn;
+    }
+
     // Determine whether grid can be folded.
     void Grid::setFolding(const Dimensions& dims) {
 
@@ -274,20 +368,12 @@ namespace yask {
         }
     }
 
-    // Determine how many values in step-dim are needed.
-    int Grid::getStepDimSize() const
+    // Get the lowest and highest step-dim offsets used to access this grid.
+    bool Grid::getStepOffsetRange(int& first_ofs, int& last_ofs) const
     {
-        // Only need one value if no step-dim index used.
-        auto stepDim = getStepDim();
-        if (!stepDim)
-            return 1;
-
-        // No info stored?
-        if (_halos.size() == 0)
-            return 1;
-
-        // First and last step-dim.
-        int first_ofs = 0, last_ofs = 0;
+        first_ofs = last_ofs = 0;
+        if (!getStepDim() || _halos.size() == 0)
+            return false;
 
         // left and right.
         for (auto& i : _halos) {
@@ -304,26 +390,45 @@ namespace yask {
                 last_ofs = max(last_ofs, ofs);
             }
         }
+        return true;
+    }
 
-        // First and last largest halos.
-        int first_max_halo = 0, last_max_halo = 0;
+    // Get the max halo at the given step-dim offset.
+    int Grid::getStepHaloSize(int step_ofs) const
+    {
+        int h = 0;
         for (auto& i : _halos) {
             //auto left = i.first;
             auto& h2 = i.second; // map of step-dims to halos.
 
-            if (h2.count(first_ofs))
-                first_max_halo = max(first_max_halo, h2.at(first_ofs).max());
-            if (h2.count(last_ofs))
-                last_max_halo = max(last_max_halo, h2.at(last_ofs).max());
+            if (h2.count(step_ofs))
+                h = max(h, h2.at(step_ofs).max());
         }
-        
+        return h;
+    }
+
+    // Determine how many values in step-dim are needed.
+    int Grid::getStepDimSize() const
+    {
+        // Only need one value if no step-dim index used
+        // or no info stored.
+        int first_ofs = 0, last_ofs = 0;
+        if (!getStepOffsetRange(first_ofs, last_ofs))
+            return 1;
+
         // Default step-dim size is range of offsets.
         assert(last_ofs >= first_ofs);
         int sz = last_ofs - first_ofs + 1;
     
         // If first and last halos are zero, we can further optimize storage by
         // immediately reusing memory location.
-        if (sz > 1 && first_max_halo == 0 && last_max_halo == 0)
+        // We can also do this when the oldest values are only read by the
+        // updates of the newest ones at the same points, i.e., update in
+        // place. Reads of the newest values at other points are done in
+        // later bundles or steps, before the next update of the location,
+        // because the wave-front angles cover every halo.
+        if (sz > 1 && ((getStepHaloSize(first_ofs) == 0 &&
+                        getStepHaloSize(last_ofs) == 0) || _isInPlaceOk))
             sz--;
 
         // TODO: recognize that reading in one eq-bundle and then writing in
@@ -36,6 +36,7 @@ namespace yask {
 
     // Fwd decl.
     struct Dimensions;
+    class CompilerSettings;
     
     // A class for a Grid.
     // This is a generic container for all variables to be accessed
@@ -47,6 +48,9 @@ namespace yask {
         string _name;           // name of this grid.
         IndexExprPtrVec _dims;  // dimensions of this grid.
         bool _isScratch = false; // true if a temp grid.
+        string _storagePrec = "real"; // "real", "bf16", "fp16", "lut8", or "lut16".
+        string _interleaveGroup; // name of group to store interleaved with; empty => none.
+        int _interleaveFactor = 1; // number of grids in the group after checking.
 
         // Ptr to solution that this grid belongs to (its parent).
         StencilSolution* _soln = 0;
@@ -62,6 +66,12 @@ namespace yask {
         // Min and max const indices that are used to access each dim.
         IntTuple _minIndices, _maxIndices;
         
+        // Whether the oldest step value is only read by the eqs that
+        // update this grid at the same point in the newest one. If so,
+        // each update can overwrite the value it reads.
+        // "Oldest" and "newest" follow the step direction.
+        bool _isInPlaceOk = false;
+
         // Max abs-value of domain-index halos required by all eqs at
         // various step-index values.
         // bool key: true=left, false=right.
@@ -106,7 +116,24 @@ namespace yask {
 
         // Temp grid?
         virtual bool isScratch() const { return _isScratch; }
+
+        // Stored at less than full precision?
+        virtual bool isReducedPrecision() const { return _storagePrec != "real"; }
+
+        // Stored as indices into a lookup table?
+        virtual bool usesLookupTable() const { return _storagePrec.compare(0, 3, "lut") == 0; }
+
+        // Kernel type of one vector of storage.
+        virtual string getVecStorageType() const {
+            return isReducedPrecision() ? "real_vec_" + _storagePrec + "_t" : "real_vec_t";
+        }
         
+        // Number of grids whose vectors are interleaved with this one's.
+        // Each vector of this grid is this many vectors from the next
+        // one in the inner dim.
+        virtual int getInterleaveFactor() const { return _interleaveFactor; }
+        virtual void setInterleaveFactor(int n) { _interleaveFactor = n; }
+
         // Access to solution.
         virtual StencilSolution* getSoln() { return _soln; }
         virtual void setSoln(StencilSolution* soln) { _soln = soln; }
@@ -189,6 +216,22 @@ namespace yask {
             return true;
         }
 
+        // Add 'dim' after the existing step and domain dims.
+        // Returns its position. Existing points in this grid must be
+        // updated separately via GridPoint::insertArg().
+        virtual size_t insertDim(IndexExprPtr dim);
+
+        // Get the lowest and highest step-dim offsets used to access
+        // this grid. Returns 'false' if it isn't accessed via the step dim.
+        virtual bool getStepOffsetRange(int& first_ofs, int& last_ofs) const;
+
+        // Get the max halo at the given step-dim offset.
+        virtual int getStepHaloSize(int step_ofs) const;
+
+        // Access whether updates can overwrite the oldest step value.
+        virtual bool isInPlaceOk() const { return _isInPlaceOk; }
+        virtual void setInPlaceOk(bool ok) { _isInPlaceOk = ok; }
+
         // Determine how many values in step-dim are needed.
         virtual int getStepDimSize() const;
 
@@ -294,6 +337,14 @@ namespace yask {
             return dp->getName();
         }
         virtual std::vector<std::string> get_dim_names() const;
+        virtual void set_storage_precision(const std::string& precision);
+        virtual const std::string& get_storage_precision() const {
+            return _storagePrec;
+        }
+        virtual void set_interleave_group(const std::string& name);
+        virtual const std::string& get_interleave_group() const {
+            return _interleaveGroup;
+        }
         virtual yc_grid_point_node_ptr
         new_grid_point(const std::vector<yc_number_node_ptr>& index_exprs);
         virtual yc_grid_point_node_ptr
@@ -327,7 +378,12 @@ namespace yask {
             for (auto gp : *this)
                 gp->setFolding(dims);
         }
-        
+
+        // Set the interleave factor of the grids in each interleave
+        // group after checking that they can share one layout.
+        // Call after setFolding() and after the halos are known.
+        virtual void setInterleaving(const CompilerSettings& settings,
+                                     ostream& os);
     };
 
     // Settings for the compiler.
@@ -346,9 +402,24 @@ namespace yask {
         int _minExprSize = 2;
         bool _doCse = true;      // do common-subexpr elim.
         bool _doComb = true;    // combine commutative operations.
+        bool _doFactor = true;  // factor common multiplicands out of sums.
+        int _maxFmaChain = 4;   // max terms in a sum; 0 => no limit.
         bool _doOptCluster = true; // apply optimizations also to cluster.
+        int _maxScratchInlineOps = 8; // max FP ops added by inlining a scratch grid; <0 => none.
+        string _inlineScratchRegex; // scratch grids to always inline.
+        string _keepScratchRegex;   // scratch grids to never inline.
+        bool _doInnerReuse = false; // reuse vectors across inner-loop iterations.
+        bool _doAheadPrefetch = true; // prefetch next rows and planes near end of row.
+        bool _doNtStores = true; // allow streaming stores for write-only outputs.
+        string _costModel;      // CPU model for selecting vector ctors; empty => default for target.
+        int _sveBits = 512;     // SVE vector length for the 'sve' target.
         string _eqBundleTargets;  // how to bundle equations.
+        bool _autoBundle = false; // search for bundling of remaining equations.
+        int _bundleRegs = 32;     // vector registers assumed by bundle search.
         string _gridRegex;       // grids to update.
+        string _reductionOpts;   // reductions to add, e.g., "e=sum_sq:pressure".
+        string _batchDim;        // domain dim added to updated grids, e.g., "shot".
+        string _interleaveTargets; // grids to store interleaved, e.g., "s=stress_".
         bool _findDeps = true;
     };
     
@@ -27,6 +27,7 @@ IN THE SOFTWARE.
 
 #include "Print.hpp"
 #include "CppIntrin.hpp"
+#include "Parse.hpp"
 
 using namespace std;
 
@@ -68,6 +69,44 @@ namespace yask {
         cluster.addDimBack(dim->get_name(), mult);
     }
 
+    void StencilSolution::set_batch_dim(const yc_index_node_ptr dim) {
+        auto ie = dynamic_pointer_cast<IndexExpr>(dim);
+        if (!ie || ie->getType() != DOMAIN_INDEX)
+            THROW_YASK_EXCEPTION("Error: set_batch_dim(): not a domain index");
+        _settings._batchDim = ie->getName();
+    }
+
+    void StencilSolution::add_reduction(const string& name,
+                                        yc_equation_node_ptr equation,
+                                        const string& op) {
+        auto ep = dynamic_pointer_cast<EqualsExpr>(equation);
+        if (!ep)
+            THROW_YASK_EXCEPTION("Error: add_reduction(): null equation");
+        if (op != "sum" && op != "sum_sq" && op != "max_abs")
+            THROW_YASK_EXCEPTION("Error: add_reduction(): unknown operation '" + op +
+                                 "' for reduction '" + name + "'");
+        if (ep->getLhs()->getGrid()->isScratch())
+            THROW_YASK_EXCEPTION("Error: add_reduction(): equation " + ep->makeQuotedStr() +
+                                 " updates a scratch grid");
+        Reduction r;
+        r.name = name;
+        r.op = op;
+        r.lhs = ep->getLhs()->makeStr();
+        r.cond = ep->getCond() ? ep->getCond()->makeStr() : "";
+        for (auto& r2 : _reductions) {
+            if (r2.name != name)
+                continue;
+            if (r2.op != op)
+                THROW_YASK_EXCEPTION("Error: add_reduction(): reduction '" + name +
+                                     "' already uses operation '" + r2.op + "'");
+
+            // Already added, e.g., from a previous define().
+            if (r2.lhs == r.lhs && r2.cond == r.cond)
+                return;
+        }
+        _reductions.push_back(r);
+    }
+
     // Create the intermediate data for printing.
     void StencilSolution::analyze_solution(int vlen,
                                            bool is_folding_efficient) {
@@ -76,6 +115,54 @@ namespace yask {
         // ASTs and grids can also be created via the APIs.
         define();
 
+        // Add the batch dim to the updated grids. Reductions already
+        // added refer to their eqs by strings, so update them.
+        if (_settings._batchDim.length()) {
+            map<EqualsExpr*, pair<string, string>> oldStrs; // LHS, cond.
+            for (auto& eq : _eqs.getAll())
+                oldStrs[eq.get()] = { eq->getLhs()->makeStr(),
+                                      eq->getCond() ? eq->getCond()->makeStr() : "" };
+            _eqs.addBatchDim(_settings, _grids, *_dos);
+            for (auto& r : _reductions) {
+                for (auto& eq : _eqs.getAll()) {
+                    auto& old = oldStrs.at(eq.get());
+                    if (old.first == r.lhs && old.second == r.cond) {
+                        r.lhs = eq->getLhs()->makeStr();
+                        r.cond = eq->getCond() ? eq->getCond()->makeStr() : "";
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Add reductions from the cmd-line to all eqs that update each grid.
+        // Example: "e=sum_sq:pressure,m=max_abs:vel".
+        if (_settings._reductionOpts.length()) {
+            ArgParser ap;
+            ap.parseKeyValuePairs
+                (_settings._reductionOpts, [&](const string& key, const string& value) {
+                    auto cp = value.find(':');
+                    if (cp == string::npos)
+                        THROW_YASK_EXCEPTION("Error: reduction '" + key + "=" + value +
+                                             "' is not in the form <name>=<op>:<grid>");
+                    auto op = value.substr(0, cp);
+                    auto gname = value.substr(cp + 1);
+                    bool found = false;
+                    for (auto& eq : _eqs.getAll()) {
+                        if (eq->getLhs()->getGridName() == gname) {
+                            add_reduction(key, eq, op);
+                            found = true;
+                        }
+                    }
+                    if (!found)
+                        THROW_YASK_EXCEPTION("Error: no equation updates grid '" + gname +
+                                             "' for reduction '" + key + "'");
+                });
+        }
+
+        // Replace cheap scratch grids with their defining expressions.
+        _eqs.inlineScratchEqs(_settings, _grids, *_dos);
+
         // Find all the stencil dimensions from the grids.
         // Create the final folds and clusters from the cmd-line options.
         _dims.setDims(_grids, _settings, vlen, is_folding_efficient, *_dos);
@@ -92,12 +179,14 @@ namespace yask {
 
         // Update access stats for the grids.
         _eqs.updateGridStats();
+
+        // Check the interleave groups now that the halos are known.
+        _grids.setInterleaving(_settings, *_dos);
         
         // Create equation bundles based on dependencies and/or target strings.
         _eqBundles.set_basename_default(_settings._eq_bundle_basename_default);
         _eqBundles.set_dims(_dims);
-        _eqBundles.makeEqBundles(_eqs, _settings._gridRegex,
-                                 _settings._eqBundleTargets, *_dos);
+        _eqBundles.makeEqBundles(_eqs, _settings, *_dos);
         _eqBundles.optimizeEqBundles(_settings, "scalar & vector", false, *_dos);
 
         // Separate bundles into packs.
@@ -127,6 +216,9 @@ namespace yask {
         if (format_type == "cpp")
             printer = new YASKCppPrinter(*this, _eqBundles, _eqBundlePacks,
                                          _clusterEqBundles, &_dims);
+        else if (format_type == "omp-target")
+            printer = new YASKOmpTargetPrinter(*this, _eqBundles, _eqBundlePacks,
+                                               _clusterEqBundles, &_dims);
         else if (format_type == "knc")
             printer = new YASKKncPrinter(*this, _eqBundles, _eqBundlePacks,
                                          _clusterEqBundles, &_dims);
@@ -136,6 +228,12 @@ namespace yask {
         else if (format_type == "avx512" || format_type == "avx512f")
             printer = new YASKAvx512Printer(*this, _eqBundles, _eqBundlePacks,
                                             _clusterEqBundles, &_dims);
+        else if (format_type == "sve")
+            printer = new YASKSvePrinter(*this, _eqBundles, _eqBundlePacks,
+                                         _clusterEqBundles, &_dims);
+        else if (format_type == "neon")
+            printer = new YASKNeonPrinter(*this, _eqBundles, _eqBundlePacks,
+                                          _clusterEqBundles, &_dims);
         else if (format_type == "dot")
             printer = new DOTPrinter(*this, _clusterEqBundles, false);
         else if (format_type == "dot-lite")
@@ -75,6 +75,14 @@ namespace yask {
         // generated code for this solution.
         ExtensionsList _extensions;
 
+        // Reductions from add_reduction(). The equation is identified by
+        // its LHS and condition because bundles hold copies of the eqs.
+        struct Reduction {
+            string name, op;
+            string lhs, cond;
+        };
+        vector<Reduction> _reductions;
+
     private:
 
         // Intermediate data needed to format output.
@@ -102,6 +110,7 @@ namespace yask {
         virtual Grids& getGrids() { return _grids; }
         virtual Eqs& getEqs() { return _eqs; }
         virtual CompilerSettings& getSettings() { return _settings; }
+        virtual const vector<Reduction>& getReductions() const { return _reductions; }
 
         // Get user-provided code for the given section.
         CodeList * getExtensionCode(YASKSection section)
@@ -189,7 +198,11 @@ namespace yask {
         virtual void clear_dependencies() {
             _eqs.getDeps().clear_deps();
         }
+        virtual void add_reduction(const std::string& name,
+                                   yc_equation_node_ptr equation,
+                                   const std::string& op);
 
+        virtual void set_batch_dim(const yc_index_node_ptr dim);
         virtual void set_fold_len(const yc_index_node_ptr, int len);
         virtual void clear_folding() { _settings._foldOptions.clear(); }
         virtual void set_cluster_mult(const yc_index_node_ptr, int mult);
@@ -167,7 +167,12 @@ namespace yask {
         }
         
         // Unaligned loads allowed?
-        else if (_allowUnalignedLoads) {
+        // Not for reduced-precision grids, which have no real_t elements
+        // to load from, or interleaved grids, whose neighboring vectors
+        // are in other grids.
+        else if (_allowUnalignedLoads && !gp.getGrid()->isReducedPrecision() &&
+                 gp.getGrid()->getInterleaveFactor() <= 1 &&
+                 useUnalignedLoad(gp)) {
 #ifdef DEBUG_GP
             cout << " //** reading from point " << gp.makeStr() << " as fully vectorized and unaligned.\n";
 #endif
@@ -226,7 +231,18 @@ namespace yask {
         // Repeat until done.
         // TODO: sort based on all reused exprs, not just grid reads.
 
-        GridPointSet alignedVecs; // aligned vecs needed so far.
+        // Aligned vecs needed so far.  Vecs already in '_vv' are
+        // needed regardless of the order, so they are not counted.
+        GridPointSet alignedVecs = _vv._alignedVecs;
+
+        // Get aligned vecs needed for each expr once.
+        vector<GridPointSet> exprAlignedVecs;
+        for (auto& expr : oev) {
+            VecInfoVisitor tmpvv(_vv.getDims());
+            expr->accept(&tmpvv);
+            exprAlignedVecs.push_back(tmpvv._alignedVecs);
+        }
+        
         set<size_t> usedExprs; // expressions used.
         for (size_t i = 0; i < oev.size(); i++) {
 
@@ -237,17 +253,11 @@ namespace yask {
             // Scan unused exprs.
             size_t jBest = 0;
             size_t jBestCost = size_t(-1);
-            GridPointSet jBestAlignedVecs;
             for (size_t j = 0; j < oev.size(); j++) {
                 if (usedExprs.count(j) == 0) {
 
-                    // This unused expr.
-                    auto& expr = oev[j];
-
-                    // Get aligned vecs needed for this expr.
-                    VecInfoVisitor tmpvv(_vv);
-                    expr->accept(&tmpvv);
-                    auto& tmpAlignedVecs = tmpvv._alignedVecs;
+                    // Aligned vecs needed for this unused expr.
+                    auto& tmpAlignedVecs = exprAlignedVecs[j];
 
                     // Calculate cost.
                     size_t cost = 0;
@@ -269,9 +279,8 @@ namespace yask {
                     if (cost < jBestCost) {
                         jBestCost = cost;
                         jBest = j;
-                        jBestAlignedVecs = tmpAlignedVecs;
 #ifdef DEBUG_SORT
-                        cout << "  Best so far has " << jBestAlignedVecs.size() << " aligned vecs" << endl;
+                        cout << "  Best so far has " << tmpAlignedVecs.size() << " aligned vecs" << endl;
 #endif
                     }
                 }
@@ -285,6 +294,7 @@ namespace yask {
             usedExprs.insert(jBest);
 
             // Remember used vectors.
+            auto& jBestAlignedVecs = exprAlignedVecs[jBest];
             for (auto k = jBestAlignedVecs.begin(); k != jBestAlignedVecs.end(); k++) {
                 alignedVecs.insert(*k);
             }
@@ -98,6 +98,9 @@ namespace yask {
             _vlen = dims._fold.product();
         }
 
+        virtual const Dimensions& getDims() const {
+            return _dims;
+        }
         virtual const IntTuple& getFold() const {
             return _dims._fold;
         }
@@ -237,6 +240,12 @@ namespace yask {
         // Read from multiple points that are not vectorizable.
         // Return var name.
         virtual string printNonVecRead(ostream& os, const GridPoint& gp) =0;
+
+        // Whether to use an unaligned load for gp when allowed instead
+        // of constructing it from aligned vectors.
+        virtual bool useUnalignedLoad(const GridPoint& gp) {
+            return true;
+        }
         
     public:
         VecPrintHelper(VecInfoVisitor& vv,
@@ -174,6 +174,7 @@ namespace yask {
         // Save data for ctor and new-grid method.
         string ctorCode, ctorList, newGridCode, scratchCode;
         set<string> newGridDims;
+        map<string, vector<string>> interleaveGroups;
 
         // Grids.
         os << "\n ///// Grid(s)." << endl;
@@ -209,9 +210,35 @@ namespace yask {
             bool folded = gp->isFoldable();
             string gtype = folded ? "YkVecGrid" : "YkElemGrid";
 
-            // Type-name in kernel is 'GRID_TYPE<LAYOUT, WRAP_1ST_IDX, VEC_LENGTHS...>'.
+            // Reduced-precision storage is only used for read-only
+            // folded grids.
+            bool lowp = false;
+            if (gp->isReducedPrecision()) {
+                if (_eqBundles.getOutputGrids().count(gp))
+                    THROW_YASK_EXCEPTION("Error: grid '" + grid + "' is updated by an equation, "
+                                         "so it cannot use '" + gp->get_storage_precision() +
+                                         "' storage");
+                if (folded) {
+                    lowp = true;
+                    os << " // Stored as " << gp->get_storage_precision() << ".\n";
+                } else
+                    cout << "Notice: grid '" << grid << "' is not vector-folded, so it is "
+                        "stored at full precision instead of " << gp->get_storage_precision() << ".\n";
+            }
+            if (gp->getInterleaveFactor() > 1) {
+                os << " // Stored interleaved with the other grid(s) in group '" <<
+                    gp->get_interleave_group() << "'.\n";
+                interleaveGroups[gp->get_interleave_group()].push_back(grid);
+            }
+
+            // Type-name in kernel is 'GRID_TYPE<LAYOUT, WRAP_1ST_IDX, VEC_LENGTHS...>'
+            // or 'YkVecGridT<VEC_TYPE, LAYOUT, WRAP_1ST_IDX, VEC_LENGTHS...>'.
             ostringstream oss;
-            oss << gtype << "<Layout_";
+            if (lowp)
+                oss << "YkVecGridT<" << gp->getVecStorageType() << ", ";
+            else
+                oss << gtype << "<";
+            oss << "Layout_";
             int step_posn = 0;
             int inner_posn = 0;
             vector<int> vlens;
@@ -395,8 +422,9 @@ namespace yask {
             }
 
             // Make new grids via API.
+            // Don't use a reduced-precision type for them.
             string newGridKey = gdims.makeDimStr();
-            if (!newGridDims.count(newGridKey)) {
+            if (!lowp && !newGridDims.count(newGridKey)) {
                 newGridDims.insert(newGridKey);
                 bool firstGrid = newGridCode.length() == 0;
                 if (gdims.getNumDims())
@@ -411,6 +439,16 @@ namespace yask {
                 
         } // grids.
 
+        // Groups of grids to be stored interleaved.
+        // The generated pointer code assumes the kernel does this.
+        for (auto& i : interleaveGroups) {
+            ctorCode += "\n // Interleave group '" + i.first + "'.\n"
+                " addInterleaveGroup({";
+            for (size_t j = 0; j < i.second.size(); j++)
+                ctorCode += string(j ? ", " : " ") + i.second[j] + "_ptr";
+            ctorCode += " });\n";
+        }
+
         // Ctor.
         {
             os << "\n // Constructor.\n" <<
@@ -446,9 +484,83 @@ namespace yask {
         os << "}; // " << _context_base << endl;
     }
 
+    // Collects the step indices of grid reads and writes.
+    class StepIndexVisitor : public ExprVisitor {
+    public:
+        map<const Grid*, set<int>> _reads, _writes;
+        set<const Grid*> _noStep; // grids accessed w/o a step index.
+
+        void add(GridPoint* gp, map<const Grid*, set<int>>& accesses) {
+            auto* g = gp->getGrid();
+            auto sdim = g->getStepDim();
+            auto* ofs = sdim ? gp->getArgOffsets().lookup(sdim->getName()) : 0;
+            if (ofs)
+                accesses[g].insert(*ofs);
+            else
+                _noStep.insert(g);
+        }
+        virtual void visit(GridPoint* gp) {
+            add(gp, _reads);
+        }
+        virtual void visit(EqualsExpr* ee) {
+            add(ee->getLhs().get(), _writes);
+            ee->getRhs()->accept(this);
+        }
+    };
+
+    // Find the output grids of 'eq' that it never reads at the
+    // same step index. With a step allocation of 'n', indices that
+    // differ by a multiple of 'n' use the same memory.
+    set<const Grid*> YASKCppPrinter::findWriteOnlyGrids(EqBundle& eq) const {
+        set<const Grid*> wogrids;
+        if (eq.isScratch())
+            return wogrids;
+        StepIndexVisitor siv;
+        eq.visitEqs(&siv);
+
+        for (auto* g : eq.getOutputGrids()) {
+            if (g->isScratch() || g->isReducedPrecision())
+                continue;
+
+            // Not read at all?
+            if (!eq.getInputGrids().count(g)) {
+                wogrids.insert(g);
+                continue;
+            }
+            if (siv._noStep.count(g))
+                continue;
+
+            int alloc = _settings._stepAlloc > 0 ?
+                _settings._stepAlloc : g->getStepDimSize();
+            bool wo = alloc > 0;
+            for (int w : siv._writes[g])
+                for (int r : siv._reads[g])
+                    if ((w - r) % alloc == 0)
+                        wo = false;
+            if (wo)
+                wogrids.insert(g);
+        }
+        return wogrids;
+    }
+
     // Print YASK equation bundles.
     void YASKCppPrinter::printEqBundles(ostream& os) {
-        
+
+        // The calculation code of each bundle is defined outside of its
+        // class, so it can be compiled in its own translation unit
+        // to allow parallel builds of large stencils.
+        os << "\n // Whether the calculation code of bundle 'i' is defined here.\n"
+            " // Define DEFINE_BUNDLE_CODE as -1 for all bundles or as 'n' for those\n"
+            " // with index 'n' modulo NUM_BUNDLE_FILES.\n"
+            "#if !defined(DEFINE_BUNDLE_CODE)\n"
+            "#define YASK_BUNDLE_CODE_HERE(i) 0\n"
+            "#elif DEFINE_BUNDLE_CODE < 0\n"
+            "#define YASK_BUNDLE_CODE_HERE(i) 1\n"
+            "#else\n"
+            "#define YASK_BUNDLE_CODE_HERE(i) ((i) % NUM_BUNDLE_FILES == DEFINE_BUNDLE_CODE)\n"
+            "#endif\n";
+
+        set<size_t> redsDone; // reductions that matched an eq.
         for (int ei = 0; ei < _eqBundles.getNum(); ei++) {
 
             // Scalar eqBundle.
@@ -464,6 +576,9 @@ namespace yask {
                 " _context_type* _context = 0;\n"
                 " public:\n";
 
+            // Out-of-class calculation code.
+            ostringstream dos;
+
             // Stats for this eqBundle.
             CounterVisitor stats;
             eq->visitEqs(&stats);
@@ -482,6 +597,8 @@ namespace yask {
                     " _scalar_points_read = " << stats.getNumReads() << ";\n"
                     " _scalar_points_written = " << stats.getNumWrites() << ";\n"
                     " _is_scratch = " << (eq->isScratch() ? "true" : "false") << ";\n";
+                if (_settings._doNtStores)
+                    os << " _num_nt_store_grids = " << findWriteOnlyGrids(*eq).size() << ";\n";
 
                 // I/O grids.
                 os << "\n // The following grids are read by " << egsName << endl;
@@ -498,6 +615,40 @@ namespace yask {
                     else
                         os << "  outputGridPtrs.push_back(_context->" << gp->getName() << "_ptr);\n";
                 }
+
+                // Reductions of the values written. The indices give the
+                // step offset and misc indices of the LHS; indices in the
+                // domain dims are not used.
+                bool hdr = false;
+                auto& reds = _stencil.getReductions();
+                for (size_t ri = 0; ri < reds.size(); ri++) {
+                    auto& r = reds[ri];
+                    for (auto& ee : eq->getItems()) {
+                        auto lhs = ee->getLhs();
+                        string cond = ee->getCond() ? ee->getCond()->makeStr() : "";
+                        if (lhs->makeStr() != r.lhs || cond != r.cond)
+                            continue;
+                        if (!hdr)
+                            os << "\n // Reductions of the values written by " << egsName << endl;
+                        hdr = true;
+                        redsDone.insert(ri);
+                        os << "  add_reduction(\"" << r.name << "\", \"" << r.op << "\", _context->" <<
+                            lhs->getGridName() << "_ptr, {";
+                        int di = 0;
+                        for (auto& dim : lhs->getGrid()->getDims()) {
+                            auto& dname = dim->getName();
+                            auto* ofs = lhs->getArgOffsets().lookup(dname);
+                            auto* cv = lhs->getArgConsts().lookup(dname);
+                            idx_t v = 0;
+                            if (dim->getType() == STEP_INDEX && ofs)
+                                v = *ofs;
+                            else if (dim->getType() == MISC_INDEX && cv)
+                                v = *cv;
+                            os << (di++ ? ", " : "") << v;
+                        }
+                        os << "});\n";
+                    }
+                }
                 os << " } // Ctor." << endl;
             }
 
@@ -523,8 +674,9 @@ namespace yask {
                     _dims->_stencilDims.makeDimStr() << ".\n"
                     " // There are approximately " << stats.getNumOps() <<
                     " FP operation(s) per invocation.\n"
-                    " virtual void calc_scalar(int thread_idx, const Indices& idxs) {\n";
-                printIndices(os);
+                    " virtual void calc_scalar(int thread_idx, const Indices& idxs);\n";
+                dos << "\n void " << egsName << "::calc_scalar(int thread_idx, const Indices& idxs) {\n";
+                printIndices(dos);
 
                 // C++ scalar print assistant.
                 CounterVisitor cv;
@@ -532,11 +684,11 @@ namespace yask {
                 CppPrintHelper* sp = new CppPrintHelper(_dims, &cv, "temp", "real_t", " ", ";\n");
             
                 // Generate the code.
-                PrintVisitorBottomUp pcv(os, *sp, _settings);
+                PrintVisitorBottomUp pcv(dos, *sp, _settings);
                 eq->visitEqs(&pcv);
 
                 // End of function.
-                os << "} // calc_scalar." << endl;
+                dos << "} // calc_scalar." << endl;
 
                 delete sp;
             }
@@ -598,65 +750,151 @@ namespace yask {
                     " vector block(s) created from " << vv.getNumAlignedVecs() <<
                     " aligned vector-block(s).\n"
                     " // There are approximately " << (stats.getNumOps() * numResults) <<
-                    " FP operation(s) per iteration.\n" <<
-                    " void " << funcstr << "(int thread_idx, const Indices& idxs, idx_t " << istop;
+                    " FP operation(s) per iteration.\n";
+                string args = "(int thread_idx, const Indices& idxs, idx_t " + istop;
                 if (!do_cluster)
-                    os << ", idx_t write_mask";
-                os << ") {\n";
-                printIndices(os);
-                os << " idx_t " << istart << " = " << idim << ";\n";
-                os << " idx_t " << istep << " = " << nvecs << "; // number of vectors per iter.\n";
-                os << " idx_t " << iestep << " = " << nelems << "; // number of elements per iter.\n";
+                    args += ", idx_t write_mask";
+                args += ")";
+                os << " void " << funcstr << args << ";\n";
+                dos << "\n void " << egsName << "::" << funcstr << args << " {\n";
+                printIndices(dos);
+                dos << " idx_t " << istart << " = " << idim << ";\n";
+                dos << " idx_t " << istep << " = " << nvecs << "; // number of vectors per iter.\n";
+                dos << " idx_t " << iestep << " = " << nelems << "; // number of elements per iter.\n";
                 if (do_cluster)
-                    os << " idx_t write_mask = idx_t(-1); // no masking for clusters.\n";
+                    dos << " idx_t write_mask = idx_t(-1); // no masking for clusters.\n";
 
                 // C++ vector print assistant.
                 CppVecPrintHelper* vp = newCppVecPrintHelper(vv, cv);
-                vp->printElemIndices(os);
+                if (_settings._doNtStores)
+                    vp->setNtGrids(findWriteOnlyGrids(*vceq));
+                vp->printElemIndices(dos);
 
                 // Start forced-inline code.
-                os << "\n // Force inlining if possible.\n"
+                dos << "\n // Force inlining if possible.\n"
                     "#if !defined(DEBUG) && defined(__INTEL_COMPILER)\n"
                     "#pragma forceinline recursive\n"
                     "#endif\n"
                     " {\n";
                     
                 // Print loop-invariants.
-                CppLoopVarPrintVisitor lvv(os, *vp, _settings);
+                CppLoopVarPrintVisitor lvv(dos, *vp, _settings);
                 vceq->visitEqs(&lvv);
 
                 // Print pointers and prefetches.
-                vp->printBasePtrs(os);
+                vp->printBasePtrs(dos);
+                if (_settings._doAheadPrefetch)
+                    vp->printAheadPtrs(dos);
+
+                // Print vars to carry vectors between iterations.
+                if (_settings._doInnerReuse) {
+                    vp->setInnerReuse(do_cluster ? _dims->_clusterMults[idim] : 1);
+                    vp->printInnerWindowInit(dos);
+                }
 
                 // Actual Loop.
-                os << "\n // Inner loop.\n"
+                dos << "\n // Inner loop.\n"
                     " for (idx_t " << idim << " = " << istart << "; " <<
                     idim << " < " << istop << "; " <<
                     idim << " += " << istep << ", " <<
                     vp->getElemIndex(idim) << " += " << iestep << ") {\n";
+                vp->printInnerWindowLoads(dos);
 
                 // Generate loop body using vars stored in print helper.
                 // Visit all expressions to cover the whole vector/cluster.
-                PrintVisitorBottomUp pcv(os, *vp, _settings);
+                PrintVisitorBottomUp pcv(dos, *vp, _settings);
                 vceq->visitEqs(&pcv);
 
                 // Insert prefetches using vars stored in print helper for next iteration.
-                vp->printPrefetches(os, true);
+                vp->printPrefetches(dos, true);
+                vp->printAheadPrefetches(dos);
+
+                // Move vectors for reuse in next iteration.
+                vp->printInnerWindowShifts(dos);
 
                 // End of loop.
-                os << " } // '" << idim << "' loop.\n";
+                dos << " } // '" << idim << "' loop.\n";
 
                 // End forced-inline code.
-                os << " } // Forced-inline block.\n";
+                dos << " } // Forced-inline block.\n";
                     
                 // End of function.
-                os << "} // " << funcstr << ".\n";
+                dos << "} // " << funcstr << ".\n";
                 delete vp;
             }
 
+            printBundleExtras(os, dos, *eq, egsName);
             os << "}; // " << egsName << ".\n"; // end of class.
+
+            // Calculation code.
+            os << "\n#if YASK_BUNDLE_CODE_HERE(" << ei << ")\n" <<
+                dos.str() <<
+                "#endif // YASK_BUNDLE_CODE_HERE(" << ei << ").\n";
             
         } // stencil eqBundles.
+
+        for (size_t ri = 0; ri < _stencil.getReductions().size(); ri++) {
+            auto& r = _stencil.getReductions()[ri];
+            if (!redsDone.count(ri))
+                THROW_YASK_EXCEPTION("Error: equation for " + r.lhs +
+                                     " in reduction '" + r.name + "' not found in any bundle");
+        }
+    }
+
+    // Print the bundles after checking that their code can run on
+    // the device. Scratch grids are kept per host thread, and the
+    // device threads have no host-thread index to select them with.
+    void YASKOmpTargetPrinter::printEqBundles(ostream& os) {
+        for (auto gp : _grids)
+            if (gp->isScratch())
+                THROW_YASK_EXCEPTION("Error: scratch grid '" + gp->getName() +
+                                     "' is not supported by the 'omp-target' format");
+        YASKCppPrinter::printEqBundles(os);
+    }
+
+    // Print the device code of a bundle.
+    void YASKOmpTargetPrinter::printBundleExtras(ostream& os, ostream& dos,
+                                                 EqBundle& eq, const string& egsName) {
+        string idim = _dims->_innerDim;
+        os << endl << " // Calculate all clusters in the sub-block in 'idxs' on the offload device.\n"
+            " // Indices must be rank-relative and normalized, as for calc_loop_of_clusters().\n"
+            " // The device uses 'this' and the grids at their host addresses, so the\n"
+            " // region only runs on the device with 'YASK_OFFLOAD_IF' from yask.hpp,\n"
+            " // i.e., when unified shared memory is required. 'thread_idx' only selects\n"
+            " // scratch grids, which this format does not allow.\n"
+            " virtual void calc_sub_block_offload(int thread_idx, const ScanIndices& idxs);\n";
+        dos << "\n void " << egsName << "::calc_sub_block_offload(int thread_idx, const ScanIndices& idxs) {\n"
+            " auto* self = this;\n";
+
+        // Copy the bounds to scalars so they can be mapped to the device.
+        int i = 0, nsdims = 0;
+        for (auto& dim : _dims->_stencilDims.getDims()) {
+            auto& dname = dim.getName();
+            if (dname == _dims->_stepDim)
+                dos << " idx_t " << dname << " = idxs.begin[" << i << "];\n";
+            else {
+                dos << " idx_t begin_" << dname << " = idxs.begin[" << i << "];\n"
+                    " idx_t end_" << dname << " = idxs.end[" << i << "];\n";
+                nsdims++;
+            }
+            i++;
+        }
+
+        // One device thread per cluster.
+        dos << "\n#pragma omp target teams distribute parallel for collapse(" << nsdims <<
+            ") YASK_OFFLOAD_IF\n";
+        for (auto& dim : _dims->_domainDims.getDims()) {
+            auto& dname = dim.getName();
+            dos << " for (idx_t " << dname << " = begin_" << dname << "; " <<
+                dname << " < end_" << dname << "; " <<
+                dname << " += CMULT_" << allCaps(dname) << ")\n";
+        }
+        dos << " {\n"
+            " Indices pt = { " << _dims->_stencilDims.makeDimStr() << " };\n"
+            " self->" << egsName << "::calc_loop_of_clusters(thread_idx, pt, " <<
+            idim << " + CMULT_" << allCaps(idim) << ");\n"
+            " }\n"
+            "} // calc_sub_block_offload.\n";
     }
 
     // Print final YASK context.
@@ -98,6 +98,39 @@ void usage(const string& cmd) {
         "      Example: \"-eq-bundles 'g_$&=b[aeiou]r'\" with grids 'bar_x', 'bar_y', 'ber_x', and 'ber_y'\n"
         "        would create eq-bundle 'g_bar_0' for grids 'bar_x' and 'bar_y' and eq-bundle 'g_ber_0' for\n"
         "        grids 'ber_x' and 'ber_y' because '$&' is substituted by the string that matches the regex.\n"
+        " -max-scratch-inline-ops <num-ops>\n"
+        "    Inline a scratch grid into the equations that read it when doing so adds\n"
+        "      at most <num-ops> FP operations per point (default=" << settings._maxScratchInlineOps << ").\n"
+        "      The defining expression is recomputed at each unique offset read instead of\n"
+        "        being stored to and loaded from the scratch grid.\n"
+        "      Use -1 to inline only scratch grids matching -inline-scratch.\n"
+        " -inline-scratch <regex>\n"
+        "    Always inline scratch grids whose names match <regex> if possible.\n"
+        " -keep-scratch <regex>\n"
+        "    Never inline scratch grids whose names match <regex>.\n"
+        " [-no]-auto-bundle\n"
+        "    Do [not] search for the bundling of equations not matched by -eq-bundles (default=" <<
+        settings._autoBundle << ").\n"
+        "      Independent equations are merged greedily while the estimated bytes moved per point,\n"
+        "        which include input and output grid streams and register spills, do not increase.\n"
+        " -bundle-regs <n>\n"
+        "    Set number of vector registers assumed by the bundle search (default=" <<
+        settings._bundleRegs << ").\n"
+        " -reductions <name>=<op>:<grid>,...\n"
+        "    Reduce the values written to <grid> in each step by all the equations that update it.\n"
+        "      <op> may be 'sum', 'sum_sq' or 'max_abs'.\n"
+        "      The results are available from yk_solution::get_reduction() in the kernel.\n"
+        "      Example: \"-reductions e=sum_sq:pressure,m=max_abs:pressure\".\n"
+        " -batch-dim <name>\n"
+        "    Add domain dimension <name> to the grids that are updated and the scratch grids\n"
+        "      that depend on them, so that independent problems, e.g., shots, run as one batch.\n"
+        "      Grids that are only read are shared by the whole batch.\n"
+        "      Use \"-fold <name>=<size>\" to vectorize across the batch.\n"
+        " -interleave <name>=<regex>,...\n"
+        "    Store the vectors of the grids matching <regex> interleaved in group <name>,\n"
+        "      so grids that are read together use one memory stream.\n"
+        "      Grids in a group must be vector-folded and have the same dims.\n"
+        "      Example: \"-interleave s=stress_,v=vel_\".\n"
         " -step-alloc <size>\n"
         "    Specify the size of the step-dimension memory allocation.\n"
         "      By default, allocations are calculated automatically for each grid.\n"
@@ -119,8 +152,39 @@ void usage(const string& cmd) {
         "    Do [not] combine commutative operations (default=" << settings._doComb << ").\n"
         " [-no]-opt-cse\n"
         "    Do [not] eliminate common subexpressions (default=" << settings._doCse << ").\n"
+        " [-no]-opt-factor\n"
+        "    Do [not] factor common multiplicands out of sums (default=" << settings._doFactor << ").\n"
+        "      Example: c*a + c*b => c*(a + b).\n"
+        " -max-fma-chain <num-terms>\n"
+        "    Split sums into independent sums of at most <num-terms> terms (default=" <<
+        settings._maxFmaChain << ").\n"
+        "      Each one can be evaluated as a chain of fused multiply-adds.\n"
+        "      Use 0 to disable.\n"
         " [-no]-opt-cluster\n"
         "    Do [not] apply optimizations across the cluster (default=" << settings._doOptCluster << ").\n"
+        " [-no]-opt-inner-reuse\n"
+        "    Do [not] keep vectors in vars across inner-loop iterations (default=" <<
+        settings._doInnerReuse << ").\n"
+        "      Each aligned vector read via a base pointer is loaded once per loop,\n"
+        "        which reduces loads for high-order stencils at the cost of more registers.\n"
+        " [-no]-pf-ahead\n"
+        "    Do [not] prefetch the next rows and planes of read-only vectors near the end of a row (default=" <<
+        settings._doAheadPrefetch << ").\n"
+        "      Only new vectors, i.e., those beyond the highest offset read in each dim, are prefetched.\n"
+        "      Active when the kernel is built with pfd_l1 or pfd_l2 > 0.\n"
+        "      To measure, build the kernel with EXTRA_MACROS='MODEL_CACHE=L1_HINT' or 'MODEL_CACHE=L2_HINT'.\n"
+        " [-no]-nt-stores\n"
+        "    Do [not] allow streaming stores for grids that are written but not read at the same step\n"
+        "      index in an equation bundle (default=" << settings._doNtStores << ").\n"
+        "      They are used at run-time when the output in a region is larger than a threshold;\n"
+        "        see the kernel '-nt_stores' and '-nt_store_mib' options.\n"
+        " -cost-model <name>\n"
+        "    Select vector-construction instructions using the throughput model of the named CPU.\n"
+        "      Known models: " << VecCostModel::getNames() << ".\n"
+        "      By default, the model matching the target is used.\n"
+        " -sve-bits <n>\n"
+        "    Set SVE vector length in bits for the 'sve' format (default=" << settings._sveBits << ").\n"
+        "      Must match the SVE_BITS setting of the kernel, e.g., 512 for A64FX or 256 for Neoverse V1.\n"
         " -max-es <num-nodes>\n"
         "    Set heuristic for max single expression-size (default=" << settings._maxExprSize << ").\n"
         " -min-es <num-nodes>\n"
@@ -136,6 +200,9 @@ void usage(const string& cmd) {
         "      avx2      YASK stencil classes for CORE AVX2 ISA (256-bit HW SIMD vectors).\n"
         "      avx512    YASK stencil classes for CORE AVX-512 & MIC AVX-512 ISAs (512-bit HW SIMD vectors).\n"
         "      knc       YASK stencil classes for KNC ISA (512-bit HW SIMD vectors).\n"
+        "      omp-target  YASK stencil classes with sub-blocks offloaded via OpenMP target directives.\n"
+        "      sve       YASK stencil classes for ARM SVE ISA (HW SIMD vectors of -sve-bits).\n"
+        "      neon      YASK stencil classes for ARM NEON ISA (128-bit HW SIMD vectors).\n"
         "      pseudo    Human-readable scalar pseudo-code for one point.\n"
         "      dot       DOT-language description.\n"
         "      dot-lite  DOT-language description of grid accesses only.\n"
@@ -181,10 +248,30 @@ void parseOpts(int argc, const char* argv[])
                 settings._doCse = true;
             else if (opt == "-no-opt-cse")
                 settings._doCse = false;
+            else if (opt == "-opt-factor")
+                settings._doFactor = true;
+            else if (opt == "-no-opt-factor")
+                settings._doFactor = false;
+            else if (opt == "-pf-ahead")
+                settings._doAheadPrefetch = true;
+            else if (opt == "-no-pf-ahead")
+                settings._doAheadPrefetch = false;
+            else if (opt == "-nt-stores")
+                settings._doNtStores = true;
+            else if (opt == "-no-nt-stores")
+                settings._doNtStores = false;
+            else if (opt == "-auto-bundle")
+                settings._autoBundle = true;
+            else if (opt == "-no-auto-bundle")
+                settings._autoBundle = false;
             else if (opt == "-opt-cluster")
                 settings._doOptCluster = true;
             else if (opt == "-no-opt-cluster")
                 settings._doOptCluster = false;
+            else if (opt == "-opt-inner-reuse")
+                settings._doInnerReuse = true;
+            else if (opt == "-no-opt-inner-reuse")
+                settings._doInnerReuse = false;
             else if (opt == "-find-deps")
                 settings._findDeps = true;
             else if (opt == "-no-find-deps")
@@ -209,6 +296,18 @@ void parseOpts(int argc, const char* argv[])
                     settings._gridRegex = argop;
                 else if (opt == "-eq-bundles")
                     settings._eqBundleTargets = argop;
+                else if (opt == "-inline-scratch")
+                    settings._inlineScratchRegex = argop;
+                else if (opt == "-keep-scratch")
+                    settings._keepScratchRegex = argop;
+                else if (opt == "-cost-model")
+                    settings._costModel = argop;
+                else if (opt == "-reductions")
+                    settings._reductionOpts = argop;
+                else if (opt == "-batch-dim")
+                    settings._batchDim = argop;
+                else if (opt == "-interleave")
+                    settings._interleaveTargets = argop;
                 else if (opt == "-fold" || opt == "-cluster") {
 
                     // example: x=4,y=2
@@ -249,11 +348,19 @@ void parseOpts(int argc, const char* argv[])
                         settings._maxExprSize = val;
                     else if (opt == "-min-es")
                         settings._minExprSize = val;
+                    else if (opt == "-max-fma-chain")
+                        settings._maxFmaChain = val;
+                    else if (opt == "-max-scratch-inline-ops")
+                        settings._maxScratchInlineOps = val;
+                    else if (opt == "-bundle-regs")
+                        settings._bundleRegs = val;
 
                     else if (opt == "-radius")
                         radius = val;
                     else if (opt == "-elem-bytes")
                         settings._elem_bytes = val;
+                    else if (opt == "-sve-bits")
+                        settings._sveBits = val;
 
                     else if (opt == "-ps")
                         vlenForStats = val;
@@ -23,187 +23,234 @@ IN THE SOFTWARE.
 
 *****************************************************************************/
 
-// Purpose: implement a simple,infinite-size cache model to check
-// prefetch and/or eviction coverage.
+// Purpose: implement a sampled, set-associative model of the L1, L2, and
+// L3 data caches driven by the prefetch, read, and write hooks used by
+// the generated code. It predicts the miss rates of each stencil bundle
+// for the current block and sub-block sizes.
 
 #include <map>
+#include <vector>
 
 namespace yask {
 
-    // key is CL addr; value is line num.
-    class Cache : public std::map<uintptr_t, int> {
-        int myLevel;
-        size_t numReads, numPFs, numEvicts, numLowPFs;
-        size_t numReadsNotPFed, numExtraPFs, numBadEvicts, numLowPFsNotPFed;
-        size_t numSizes, sumSizes, maxSize;
-        static const int maxMsgs = 20;
-        bool enabled;
-        uintptr_t prevReadLine;
-        std::map<intptr_t, size_t> strideCounts;
-        static const float minStridePct = 0.1f;
+    // One level of a set-associative cache with LRU replacement.
+    // Only the sets of sampled lines are kept.
+    class CacheLevel {
+        size_t _nbytes = 0, _nsets = 0, _nways = 0;
+        std::vector<uintptr_t> _tags; // '_nways' per set; line addr + 1, or 0 if empty.
+        std::vector<uint64_t> _ages;  // time of last access of each way.
+        uint64_t _time = 0;
 
     public:
-        Cache(int l): myLevel(l), numReads(0), numPFs(0), numEvicts(0),
-                      numReadsNotPFed(0), numExtraPFs(0), numBadEvicts(0),
-                      numSizes(0), sumSizes(0), maxSize(0), enabled(true),
-                      prevReadLine(0)
-        {
-            printf("modeling cache L%i (a max of %i warnings of each type will be printed)...\n",
-                   myLevel, maxMsgs);
-        }
-
-        void disable() { enabled = false; }
-        void enable() { enabled = true; }
-        bool isEnabled() const { return enabled; }
 
-        static float lines2MB(size_t l) {
-            return (float)l * CACHELINE_BYTES / (1024*1024);
+        // Model a cache of 'nbytes' and 'nways' that sees only one
+        // in 'sample_rate' lines.
+        void init(size_t nbytes, size_t nways, size_t sample_rate) {
+            _nbytes = nbytes;
+            _nways = std::max(nways, size_t(1));
+            size_t nsets = nbytes / (_nways * CACHELINE_BYTES);
+            _nsets = std::max(nsets / sample_rate, size_t(1));
+            _tags.assign(_nsets * _nways, 0);
+            _ages.assign(_nsets * _nways, 0);
+            _time = 0;
         }
+        size_t get_bytes() const { return _nbytes; }
+        size_t get_ways() const { return _nways; }
 
-        void dumpStats() const {
-            int np = 0, nr = 0;
-            for (auto const& i : *this) {
-                void *p = (void*)(i.first * CACHELINE_BYTES);
-                int line = i.second;
-                if (line >= 0 && ++np < maxMsgs)
-                    printf("cache L%i: prefetch of %p from line %i without any read.\n", myLevel,
-                           p, line);
-                if (line < 0 && ++nr < maxMsgs)
-                    printf("cache L%i: read of %p from line %i without any eviction.\n", myLevel,
-                           p, -line);
-            }
-            if (numSizes)
-                printf("cache L%i stats:\n"
-                       " cur num elements = %lli lines (%.4f MB).\n"
-                       " max num elements = %lli lines (%.4f MB).\n"
-                       " ave num elements = %lli lines (%.4f MB).\n", myLevel,
-                       size(), lines2MB(size()),
-                       maxSize, lines2MB(maxSize), 
-                       sumSizes / numSizes, lines2MB(sumSizes) / numSizes);
-            printf(" num reads = %lli.\n", numReads);
-            printf("  num reads of missing lines = %lli.%s\n", numReadsNotPFed,
-                   numReadsNotPFed? " <<<<< WARNING" : "");
-            printf("  num lines read but never evicted = %i.\n", nr);
-            printf(" num prefetches = %lli.\n", numPFs);
-            printf("  num prefetches of lines never subsequently read = %i.\n", np);
-            printf("  num prefetches of lines already in cache = %lli.\n", numExtraPFs);
-            printf(" num evictitions = %lli.\n", numEvicts);
-            printf("  num evictions to non-existant lines = %lli.\n", numBadEvicts);
-            if (myLevel > 1) {
-                printf(" num prefetches into L%i = %lli.\n", myLevel-1, numLowPFs);
-                printf("  num prefetches into L%i of missing lines = %lli.%s\n", myLevel-1, numLowPFsNotPFed,
-                       numLowPFsNotPFed? " <<<<< WARNING!" : "");
-            }
-            if (numReads > 1 && strideCounts.size()) {
-                printf(" stride counts (>= %f%% of num reads):\n", minStridePct);
-                for (auto& i : strideCounts) {
-                    float p = 100.f * (float)i.second / (float)numReads;
-                    if (p >= minStridePct)
-                        printf("  %lli: %llu (%f%%)\n", i.first, i.second, p);
+        // Access line 'k', which has already been divided by the sample
+        // rate. Return whether it was present. If not, it replaces the
+        // least-recently-used line in its set.
+        bool access(uintptr_t k) {
+            size_t base = (k % _nsets) * _nways;
+            size_t lru = base;
+            _time++;
+            for (size_t i = base; i < base + _nways; i++) {
+                if (_tags[i] == k + 1) {
+                    _ages[i] = _time;
+                    return true;
                 }
+                if (_ages[i] < _ages[lru])
+                    lru = i;
             }
+            _tags[lru] = k + 1;
+            _ages[lru] = _time;
+            return false;
         }
+    };
+
+    // Model of the caches seen by one thread.
+    // Only the accesses by the first thread at each OpenMP nesting level
+    // are modeled, and the last level is scaled by the number of threads
+    // sharing it.  A line is sampled if its address is a multiple of the
+    // sample rate, which models the same fraction of the sets at every
+    // level when the sample rate is a power of 2.
+    class CacheModel {
+    public:
+        static const int num_levels = 3;
 
-        void updateSize() {
-            size_t s = size();
-            if (s > maxSize) 
-                maxSize = s;
+        // Counts for one bundle.
+        struct Counts {
+            idx_t num_pts = 0;  // points in sub-blocks.
+            uint64_t num_reads = 0, num_writes = 0, num_nt_writes = 0;
+            uint64_t num_pfs = 0, num_extra_pfs = 0;
+            uint64_t num_misses[num_levels] = {};
+        };
 
-            // keep stats for calculating ave.
-            sumSizes += s;
-            numSizes++;
+    protected:
+        CacheLevel _levels[num_levels];
+        size_t _sample_rate = 1;
+        bool _enabled = false;
+        std::map<std::string, Counts> _counts;
+        Counts* _cur = 0;
+
+        static bool is_modeled_thread() {
+            for (int l = 1; l <= omp_get_level(); l++)
+                if (omp_get_ancestor_thread_num(l) != 0)
+                    return false;
+            return true;
         }
 
-        void evict(const void* p, int hint, int line) {
-            if (!enabled) return;
+        // Access starting at 'first_level' and return the level
+        // that had the line, or 'num_levels' if none.
+        int access(uintptr_t k, int first_level) {
+            int i = first_level;
+            for (; i < num_levels; i++)
+                if (_levels[i].access(k))
+                    break;
+            return i;
+        }
 
-            // eviction from lower caches ignored. 
-            // NB: this code assumes hint corresponds 1:1 to level.
-            if (hint < myLevel) return;
-            uintptr_t k = (uintptr_t)p / CACHELINE_BYTES;
+        // Return whether the line at 'p' is modeled and set 'k' to its
+        // sampled index.
+        bool get_line(const void* p, uintptr_t& k) const {
+            if (!_enabled || !_cur || !is_modeled_thread())
+                return false;
+            uintptr_t l = uintptr_t(p) / CACHELINE_BYTES;
+            if (l % _sample_rate)
+                return false;
+            k = l / _sample_rate;
+            return true;
+        }
 
-#pragma omp critical
-            {
-                // only report bad evicts if level matches.
-                if (hint == myLevel && count(k) == 0) {
-                    if (++numBadEvicts < maxMsgs)
-                        printf("cache L%i: eviction of non-existant %p at line %i\n", myLevel, p, line);
-                }
+    public:
 
-                erase(k);
-                numEvicts++;
-                updateSize();
+        // Start modeling with sizes of the current CPU's caches,
+        // using defaults for any that are unknown.
+        // 'sample_rate' is rounded down to a power of 2.
+        void init(size_t sample_rate, int nthreads) {
+            const size_t def_bytes[num_levels] { 32 * 1024, 1024 * 1024, 32 * 1024 * 1024 };
+            const size_t def_ways[num_levels] { 8, 16, 16 };
+            _sample_rate = 1;
+            while (_sample_rate * 2 <= sample_rate)
+                _sample_rate *= 2;
+            for (int i = 0; i < num_levels; i++) {
+                size_t nbytes = 0, nways = 0;
+                if (!getCacheGeom(i + 1, nbytes, nways)) {
+                    nbytes = def_bytes[i];
+                    nways = def_ways[i];
+                }
+                if (i == num_levels - 1)
+                    nbytes /= std::max(nthreads, 1);
+                _levels[i].init(nbytes, nways, _sample_rate);
             }
+            _counts.clear();
+            _cur = 0;
+            _enabled = true;
         }
 
-        void prefetch(const void* p, int hint, int line) {
-            if (!enabled) return;
-            uintptr_t k = (uintptr_t)p / CACHELINE_BYTES;
-
-            // prefetch higher cache.
-            if (hint > myLevel) return;
-
-#pragma omp critical
-            {
-                // prefetch this cache.
-                // NB: this code assumes hint corresponds 1:1 to level.
-                if (hint == myLevel) {
-                    if (count(k) > 0) {
-                        if (++numExtraPFs < maxMsgs) {
-                            printf("cache L%i: redundant prefetch of %p at line %i", myLevel, p, line);
-                            int oldLine = operator[](k);
-                            if (oldLine < 0)
-                                printf(" after a read at line %i.\n", -oldLine);
-                            else
-                                printf(" after a prefetch at line %i.\n", oldLine);
-                        }
-                    }
-                }
+        void disable() { _enabled = false; }
+        bool isEnabled() const { return _enabled; }
 
-                // prefetch closer cache.
-                else {
-                    if (count(k) == 0) {
-                        if (++numLowPFsNotPFed < maxMsgs)
-                            printf("cache L%i: L%i prefetch of non-existant %p at line %i\n", myLevel, hint, p, line);
-                    }
-                    numLowPFs++;
-                }
+        // Attribute subsequent accesses to bundle 'name', which is
+        // evaluating a sub-block of 'npts' points.
+        void set_bundle(const std::string& name, idx_t npts) {
+            if (!_enabled || !is_modeled_thread())
+                return;
+            _cur = &_counts[name];
+            _cur->num_pts += npts;
+        }
 
-                // mark lines prefetched whether they were from this cache or a closer one.
-                operator[](k) = line; // remember lines for later report.
-                numPFs++;
-                updateSize();
-            }
+        // Prefetch into 'level' (1 or 2) and farther caches.
+        void prefetch(const void* p, int level, int line) {
+            uintptr_t k;
+            if (!get_line(p, k))
+                return;
+            _cur->num_pfs++;
+            if (access(k, level - 1) == level - 1)
+                _cur->num_extra_pfs++;
         }
 
         void read(const void* p, int line) {
-            if (!enabled) return;
-            uintptr_t k = (uintptr_t)p / CACHELINE_BYTES;
-
-#pragma omp critical
-            {
-                if (count(k) == 0) {
-                    if (++numReadsNotPFed < maxMsgs)
-                        printf("cache L%i: read of non-existant %p at line %i\n", myLevel, p, line);
-                }
-                operator[](k) = -line; // neg line indicates read.
-
-#ifdef TRACK_STRIDES
-                // track stride.
-                if (prevReadLine) {
-                    intptr_t stride = (intptr_t)k - (intptr_t)prevReadLine;
-                    strideCounts[stride]++;
-                }
-#endif
+            uintptr_t k;
+            if (!get_line(p, k))
+                return;
+            _cur->num_reads++;
+            int lvl = access(k, 0);
+            for (int i = 0; i < lvl; i++)
+                _cur->num_misses[i]++;
+        }
 
-                prevReadLine = k;
-                numReads++;
-                updateSize();
+        // Writes allocate lines unless 'nt' is set.
+        void write(const void* p, bool nt, int line) {
+            uintptr_t k;
+            if (!get_line(p, k))
+                return;
+            if (nt) {
+                _cur->num_nt_writes++;
+                return;
             }
+            _cur->num_writes++;
+            int lvl = access(k, 0);
+            for (int i = 0; i < lvl; i++)
+                _cur->num_misses[i]++;
         }
 
-        // Currently not monitoring writes.
-        void write(const void* p, int line) {
+        // Predicted misses at 'level' (1-3) per read and write of 'bundle',
+        // or zero if it had no accesses.
+        double get_miss_rate(const std::string& bundle, int level) const {
+            auto i = _counts.find(bundle);
+            if (i == _counts.end())
+                return 0.;
+            auto& c = i->second;
+            uint64_t n = c.num_reads + c.num_writes;
+            return n ? double(c.num_misses[level - 1]) / n : 0.;
+        }
+
+        // Predicted bytes moved into 'level' (1-3) per point of 'bundle'.
+        double get_miss_bytes_per_point(const std::string& bundle, int level) const {
+            auto i = _counts.find(bundle);
+            if (i == _counts.end() || !i->second.num_pts)
+                return 0.;
+            auto& c = i->second;
+            return double(c.num_misses[level - 1]) * _sample_rate * CACHELINE_BYTES / c.num_pts;
+        }
+
+        const std::map<std::string, Counts>& get_counts() const {
+            return _counts;
+        }
+
+        void dumpStats(std::ostream& os) const {
+            os << "Cache model of one thread, sampling 1 in " << _sample_rate << " lines:\n";
+            for (int i = 0; i < num_levels; i++)
+                os << " L" << (i + 1) << ": " << makeByteStr(_levels[i].get_bytes()) <<
+                    ", " << _levels[i].get_ways() << "-way.\n";
+            for (auto& i : _counts) {
+                auto& name = i.first;
+                auto& c = i.second;
+                os << " bundle '" << name << "':\n"
+                    "  num points in sub-blocks: " << makeNumStr(c.num_pts) << "\n"
+                    "  num sampled reads: " << c.num_reads << "\n"
+                    "  num sampled writes: " << c.num_writes << "\n";
+                if (c.num_nt_writes)
+                    os << "  num sampled streaming writes: " << c.num_nt_writes << "\n";
+                if (c.num_pfs)
+                    os << "  num sampled prefetches: " << c.num_pfs <<
+                        " (" << c.num_extra_pfs << " of lines already in the target cache)\n";
+                for (int j = 1; j <= num_levels; j++)
+                    os << "  L" << j << " miss rate: " <<
+                        (100. * get_miss_rate(name, j)) << "%, " <<
+                        get_miss_bytes_per_point(name, j) << " bytes per point\n";
+            }
         }
     };
 
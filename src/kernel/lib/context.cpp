@@ -51,6 +51,8 @@ namespace yask {
     GET_SOLN_API(get_last_rank_domain_index, rank_bb.bb_end[dim] - 1, false, true, false, true)
     GET_SOLN_API(get_overall_domain_size, overall_domain_sizes[dim], false, true, false, true)
     GET_SOLN_API(get_rank_index, _opts->_rank_indices[dim], false, true, false, true)
+    GET_SOLN_API(get_fold_size, _dims->_fold_pts[dim], false, true, false, false)
+    GET_SOLN_API(get_cluster_size, _dims->_cluster_pts[dim], false, true, false, false)
 #undef GET_SOLN_API
 
     // The grid sizes updated any time these settings are changed.
@@ -192,6 +194,7 @@ namespace yask {
 
         // Use only one set of scratch grids.
         int scratch_grid_idx = 0;
+        find_source_grids();
         
         // Indices to loop through.
         // Init from begin & end tuples.
@@ -280,6 +283,10 @@ namespace yask {
                 
             } // all bundles.
 
+            // Add sources and call callbacks for the step just calculated.
+            do_span_work(start_t + step_t, rank_idxs.begin, rank_idxs.end);
+            do_step_work(start_t + step_t);
+
         } // iterations.
 
         // Final halo exchange.
@@ -311,7 +318,14 @@ namespace yask {
     void StencilContext::run_solution(idx_t first_step_index,
                                       idx_t last_step_index)
     {
+        if (_run_handle && !_run_handle->is_run_thread() && !_run_handle->is_done())
+            THROW_YASK_EXCEPTION("Error: run_solution() called while an asynchronous run is active");
         run_time.start();
+
+        // Start recording the timeline on the first run.
+        if (_opts->_trace_file.length() && !EventTrace::is_enabled())
+            EventTrace::enable(_opts->_trace_buf_events);
+        static const int step_trace_id = EventTrace::get_id("step");
         
         auto& step_dim = _dims->_step_dim;
         auto step_posn = Indices::step_posn;
@@ -350,12 +364,32 @@ namespace yask {
             return;
         }
         
+        // Use streaming stores only when the output in a region
+        // is too big to stay in the cache until it is read.
+        {
+            idx_t rpts = 1;
+            for (auto& dim : _dims->_domain_dims.getDims())
+                rpts *= _opts->_region_sizes[dim.getName()];
+            idx_t min_bytes = _opts->_nt_store_mib * 1024 * 1024;
+            if (min_bytes <= 0)
+                min_bytes = getLastCacheSize();
+            for (auto* sg : stBundles) {
+                idx_t nbytes = rpts * REAL_BYTES * sg->get_num_nt_store_grids();
+                sg->set_using_nt_stores(_opts->_nt_stores && nbytes > min_bytes);
+            }
+        }
+
 #ifdef MODEL_CACHE
+        // Model the caches only on the message rank and only for the
+        // first call.
         ostream& os = get_ostr();
-        if (context.my_rank != context.msg_rank)
-            cache_model.disable();
-        if (cache_model.isEnabled())
-            os << "Modeling cache...\n";
+        static bool cache_modeled = false;
+        if (!cache_modeled && _env->my_rank == _opts->msg_rank) {
+            cache_model.init(_opts->_cache_model_sample,
+                             max(_opts->max_threads / _opts->thread_divisor, 1));
+            os << "Modeling caches...\n";
+        }
+        cache_modeled = true;
 #endif
         
         // Extend end points for overlapping regions due to wavefront angle.
@@ -382,13 +416,12 @@ namespace yask {
         // XXXXXX|  <- areas outside of outer ranks not calculated ->  |XXXXXXX
         //
         if (abs(step_t) > 1) {
-            for (auto& dim : _dims->_domain_dims.getDims()) {
-                auto& dname = dim.getName();
+            for (int j = 0; j < _dims->_domain_dims.getNumDims(); j++) {
 
                 // The end should be adjusted if there is not
                 // already an extension.
-                if (right_wf_exts[dname] == 0)
-                    end[dname] += wf_shifts[dname];
+                if (right_wf_exts[j] == 0)
+                    end[Dims::get_domain_dim_id(j)] += wf_shifts[j];
             }
             TRACE_MSG("after adjustment for " << num_wf_shifts <<
                       " wave-front shift(s): " <<
@@ -404,6 +437,31 @@ namespace yask {
 
         // Make sure threads are set properly for a region.
         set_region_threads();
+        find_source_grids();
+
+        // Callbacks that read outside their spans need whole steps.
+        bool need_step_work = false;
+        for (auto& cb : _step_callbacks)
+            if (cb.reach && !_timing_run)
+                need_step_work = true;
+        if (need_step_work && abs(step_t) > 1)
+            THROW_YASK_EXCEPTION("Error: run_solution(): a step callback with non-zero"
+                                 " reach requires the region size in the step dimension to be one");
+
+        // Only keep the reductions from this run.
+        if (!_timing_run) {
+            for (auto& r : _reductions) {
+                r.partials.clear();
+                r.results.clear();
+            }
+        }
+
+        // Overlap comms with computation? Only possible when not doing
+        // wave-fronts, and when there is an interior to calculate.
+        bool do_overlap = _opts->overlap_comms && step_t == 1 &&
+            mpi_exterior.size() > 0;
+        TRACE_MSG("run_solution: " << (do_overlap ? "" : "NOT ") <<
+                  "overlapping halo exchange with computation");
 
         // Initial halo exchange.
         exchange_halos_all();
@@ -415,6 +473,7 @@ namespace yask {
         {
             YaskTimer rtime;   // just for these step_t steps.
             rtime.start();
+            EventTrace::Scope step_scope(step_trace_id);
             
             // This value of index_t steps from start_t to stop_t-1.
             const idx_t start_t = begin_t + (index_t * step_t);
@@ -429,10 +488,47 @@ namespace yask {
             rank_idxs.stop[step_posn] = stop_t;
             rank_idxs.step[step_posn] = step_t;
             
+            // If no wave-fronts and no neighbor ranks, the packs may be
+            // evaluated together as a graph of block tasks, which needs
+            // no halo exchange or barrier between packs.
+            if (step_t == 1 && _opts->_async_packs &&
+                stPacks.size() > 1 && _env->num_ranks == 1) {
+
+                exchange_halos_all();
+                TRACE_MSG("run_solution: step " << start_t << " in all bundle-packs");
+                calc_packs_async(start_t);
+                if (have_span_work())
+                    do_span_work(start_t + step_t, rank_idxs.begin, rank_idxs.end);
+            }
+
+            // If no wave-fronts, the rank may be split into NUMA parts,
+            // each calculated by its own thread team. The packs are
+            // still done one at a time across all the parts.
+            else if (step_t == 1 && _opts->_numa_parts > 1 && !do_overlap) {
+
+                for (auto& bp : stPacks) {
+                    exchange_halos_all();
+                    TRACE_MSG("run_solution: step " << start_t <<
+                              " in bundle-pack '" << bp->get_name() << "' in " <<
+                              _opts->_numa_parts << " NUMA parts");
+                    run_numa_parts(rank_idxs, [&](ScanIndices& rank_idxs) {
+#include "yask_rank_loops.hpp"
+                        });
+
+                    // Grids are marked here instead of in calc_region()
+                    // because calc_region() runs in each part.
+                    mark_grids_dirty(bp, start_t + step_t, start_t + 2 * step_t);
+                }
+
+                // Done here for the same reason.
+                if (have_span_work())
+                    do_span_work(start_t + step_t, rank_idxs.begin, rank_idxs.end);
+            }
+
             // If no wave-fronts (default), loop through packs here, and do
             // only one pack at a time in calc_region(). This is similar to
             // loop in calc_rank_ref(), but with packs instead of bundles.
-            if (step_t == 1) {
+            else if (step_t == 1) {
 
                 for (auto& bp : stPacks) {
 
@@ -444,14 +540,34 @@ namespace yask {
                     exchange_halos(bp, start_t, stop_t);
 #else
                     // Exchange all dirty halos.
+                    // This completes any exchange left in progress.
                     exchange_halos_all();
 #endif
-                    
-                    // Include automatically-generated loop code that calls
-                    // calc_region() for each region.
-                    TRACE_MSG("run_solution: step " << start_t <<
-                              " in bundle-pack '" << bp->get_name() << "'");
+
+                    // When overlapping, calculate each exterior slab
+                    // first, then start the halo exchange, then
+                    // calculate the interior while the messages are in
+                    // flight. Otherwise, calculate the whole rank in one
+                    // phase.
+                    int num_phases = do_overlap ? int(mpi_exterior.size()) + 1 : 1;
+                    for (int phase = 0; phase < num_phases; phase++) {
+                        if (do_overlap) {
+                            if (phase < int(mpi_exterior.size()))
+                                sub_bb = &mpi_exterior[phase];
+                            else {
+                                exchange_halos_all(true);
+                                sub_bb = &mpi_interior;
+                            }
+                        }
+
+                        // Include automatically-generated loop code that calls
+                        // calc_region() for each region.
+                        TRACE_MSG("run_solution: step " << start_t <<
+                                  " in bundle-pack '" << bp->get_name() << "'" <<
+                                  (do_overlap ? " in phase " + to_string(phase) : string()));
 #include "yask_rank_loops.hpp"
+                    }
+                    sub_bb = 0;
                 }
             }
 
@@ -471,6 +587,17 @@ namespace yask {
 #include "yask_rank_loops.hpp"
             }
 
+            // Callbacks that need the whole step.
+            if (need_step_work)
+                do_step_work(start_t + step_t);
+
+            // Reductions of the steps just written.
+            finish_reductions(start_t, stop_t);
+
+            // Make sure nothing is left in flight after the last step.
+            if (index_t == num_t - 1)
+                complete_halo_exchange();
+
             steps_done += this_num_t;
             rtime.stop();   // for these steps.
 
@@ -478,6 +605,10 @@ namespace yask {
             // TODO: remove MPI time from consideration by auto-tuner.
             auto elapsed_time = rtime.get_elapsed_secs();
             _at.eval(this_num_t, elapsed_time);
+
+            // Let an async run pause here.
+            if (_run_handle && _run_handle->is_run_thread())
+                _run_handle->safe_point(stop_t - step_dir);
             
         } // step loop.
 
@@ -485,14 +616,119 @@ namespace yask {
         // Print cache stats, then disable.
         // Thus, cache is only modeled for first call.
         if (cache_model.isEnabled()) {
-            os << "Done modeling cache...\n";
-            cache_model.dumpStats();
+            os << "Done modeling caches with block-size " <<
+                _opts->_block_sizes.makeDimValStr(" * ") << " and sub-block-size " <<
+                _opts->_sub_block_sizes.makeDimValStr(" * ") << ".\n";
+            cache_model.dumpStats(os);
             cache_model.disable();
         }
 #endif
         run_time.stop();
     }
 
+    // Start run_solution() on a new thread.
+    yk_run_handle_ptr StencilContext::run_solution_async(idx_t first_step_index,
+                                                         idx_t last_step_index) {
+        if (_run_handle) {
+            if (!_run_handle->is_done())
+                THROW_YASK_EXCEPTION("Error: run_solution_async() called while "
+                                     "another asynchronous run is active");
+            _run_handle->join();
+        }
+        auto rh = make_shared<RunHandle>(first_step_index, _dims->_step_dir);
+        _run_handle = rh;
+        TRACE_MSG("run_solution_async: steps " << first_step_index <<
+                  " ... " << last_step_index);
+        rh->start([this, first_step_index, last_step_index]() {
+                run_solution(first_step_index, last_step_index);
+            });
+        return rh;
+    }
+
+    void RunHandle::start(std::function<void ()> fn) {
+
+        // Hold the lock until '_thread' is set, so the new thread
+        // can use is_run_thread().
+        lock_guard<mutex> start_lock(_mutex);
+        _thread = thread([this, fn]() {
+                {
+                    lock_guard<mutex> lock(_mutex);
+                }
+                string err;
+                try {
+                    fn();
+                } catch (yask_exception& e) {
+                    err = e.get_message();
+                } catch (std::exception& e) {
+                    err = e.what();
+                }
+                {
+                    lock_guard<mutex> lock(_mutex);
+                    _err = err;
+                    _done = true;
+                    _paused = false;
+                }
+                _cv.notify_all();
+            });
+    }
+
+    void RunHandle::safe_point(idx_t last_step) {
+        unique_lock<mutex> lock(_mutex);
+        _last_step = last_step;
+        if (!_pause_req || !is_past_pause_step())
+            return;
+        _paused = true;
+        _cv.notify_all();
+        _cv.wait(lock, [this]{ return !_paused; });
+    }
+
+    void RunHandle::join() {
+        resume();
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    bool RunHandle::test() {
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (!_done)
+                return false;
+        }
+        wait();
+        return true;
+    }
+
+    void RunHandle::wait() {
+        join();
+        if (_err.length()) {
+            string err = _err;
+            _err.clear();
+            THROW_YASK_EXCEPTION(err);
+        }
+    }
+
+    bool RunHandle::pause_after_step(idx_t step_index) {
+        unique_lock<mutex> lock(_mutex);
+        _pause_req = true;
+        _pause_step = step_index;
+        if (_paused) {
+            if (is_past_pause_step())
+                return true;
+            _paused = false;
+            _cv.notify_all();
+        }
+        _cv.wait(lock, [this]{ return _paused || _done; });
+        return _paused;
+    }
+
+    void RunHandle::resume() {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _pause_req = false;
+            _paused = false;
+        }
+        _cv.notify_all();
+    }
     // Calculate results within a region.  Each region is typically computed
     // in a separate OpenMP 'for' region.  In this function, we loop over
     // the time steps and bundle packs and evaluate a pack in each of
@@ -502,7 +738,6 @@ namespace yask {
                                      const ScanIndices& rank_idxs) {
 
         int ndims = _dims->_stencil_dims.size();
-        auto& step_dim = _dims->_step_dim;
         auto step_posn = Indices::step_posn;
         TRACE_MSG("calc_region: " << rank_idxs.start.makeValStr(ndims) <<
                   " ... (end before) " << rank_idxs.stop.makeValStr(ndims));
@@ -511,15 +746,15 @@ namespace yask {
         ScanIndices region_idxs(*_dims, true, &rank_domain_offsets);
         region_idxs.initFromOuter(rank_idxs);
 
+        // Stage grid slabs when out-of-core.
+        int odim = Dims::get_domain_dim_id(0);
+        ooc_stage(region_idxs.begin[odim], region_idxs.end[odim]);
+
         // Make a copy of the original index span because
         // we will be shifting it for temporal wavefronts.
         Indices start(region_idxs.begin);
         Indices stop(region_idxs.end);
 
-        // Not yet supporting temporal tiling at block level.
-        if (_opts->_block_sizes[step_dim] != 1)
-            THROW_YASK_EXCEPTION("Error: temporal tiling in blocks not yet supported");
-        
         // Steps within a region are based on block sizes.
         region_idxs.step = _opts->_block_sizes;
 
@@ -529,9 +764,13 @@ namespace yask {
         // Step (usually time) loop.
         // When doing WF tiling, this loop will step through
         // several time-steps in each region.
+        // When doing temporal blocking, each iteration
+        // covers several time-steps.
         idx_t begin_t = region_idxs.begin[step_posn];
         idx_t end_t = region_idxs.end[step_posn];
-        idx_t step_t = region_idxs.step[step_posn];
+        const idx_t dir_t = (end_t >= begin_t) ? 1 : -1;
+        idx_t step_t = abs(region_idxs.step[step_posn]) * dir_t;
+        assert(step_t);
         const idx_t num_t = CEIL_DIV(abs(end_t - begin_t), abs(step_t));
         idx_t shift_num = 0;
         for (idx_t index_t = 0; index_t < num_t; index_t++) {
@@ -544,99 +783,605 @@ namespace yask {
 
             // Set indices that will pass through generated code.
             region_idxs.index[step_posn] = index_t;
-            region_idxs.start[step_posn] = start_t;
-            region_idxs.stop[step_posn] = stop_t;
+
+            // Evaluate all the steps in each block together if
+            // possible. Not done with work between the steps in
+            // each span.
+            if (abs(stop_t - start_t) > 1 && !have_span_work() &&
+                calc_region_tb(sel_bp, region_idxs, start, stop,
+                               start_t, stop_t, shift_num))
+                continue;
+
+            // Evaluate one step at a time.
+            for (idx_t t = start_t; t != stop_t; t += dir_t) {
+                region_idxs.start[step_posn] = t;
+                region_idxs.stop[step_posn] = t + dir_t;
             
-            // Stencil bundle packs to evaluate at this time step.
-            for (auto& bp : stPacks) {
+                // Stencil bundle packs to evaluate at this time step.
+                for (auto& bp : stPacks) {
 
-                // Not selected bundle pack?
-                if (sel_bp && sel_bp != bp)
-                    continue;
+                    // Not selected bundle pack?
+                    if (sel_bp && sel_bp != bp)
+                        continue;
                 
-                TRACE_MSG("calc_region: bundle-pack '" << bp->get_name() << "' in step(s) " <<
-                          start_t << " ... (end before) " << stop_t);
-
-                // For wavefront adjustments, see conceptual diagram in
-                // run_solution().  In this function, one of the
-                // parallelogram-shaped regions is being evaluated.  These
-                // shapes may extend beyond actual boundaries. So, at each
-                // time-step, the parallelogram may be trimmed based on the
-                // BB and WF extensions outside of the rank-BB.
-                    
-                // Actual region boundaries must stay within [extended] rank BB.
-                // We have to calculate the posn in the extended rank at each
-                // value of 'shift_num' because it is being shifted spatially.
+                    TRACE_MSG("calc_region: bundle-pack '" << bp->get_name() << "' in step " << t);
+                    EventTrace::Scope pack_scope(bp->get_trace_id());
+
+                    // Only need to loop through the span of the region if it is
+                    // at least partly inside the extended BB. For overlapping
+                    // regions, they may start outside the domain but enter the
+                    // domain as time progresses and their boundaries shift. So,
+                    // we don't want to return if this condition isn't met.
+                    if (get_region_span(region_idxs, start, stop, shift_num)) {
+                        ScanIndices span_idxs(region_idxs);
+
+                        // If the only bundle in this pack has its valid points
+                        // covered by a list of boxes, loop only through the
+                        // blocks in each box instead of the whole region.
+                        vector<ScanIndices> spans;
+                        auto* sb = (bp->size() == 1) ? bp->front() : 0;
+                        if (sb && sb->get_bb_list().size()) {
+                            for (auto& bb : sb->get_bb_list()) {
+                                ScanIndices bb_idxs(region_idxs);
+                                bool bb_ok = true;
+                                for (int i = 0; i < ndims; i++) {
+                                    if (i == step_posn) continue;
+                                    int j = Dims::get_domain_dim_posn(i);
+                                    bb_idxs.begin[i] = max<idx_t>(bb_idxs.begin[i], bb.bb_begin[j]);
+                                    bb_idxs.end[i] = min<idx_t>(bb_idxs.end[i], bb.bb_end[j]);
+                                    if (bb_idxs.end[i] <= bb_idxs.begin[i])
+                                        bb_ok = false;
+                                }
+                                if (bb_ok)
+                                    spans.push_back(bb_idxs);
+                            }
+                        }
+                        else
+                            spans.push_back(region_idxs);
+
+                        for (auto& span : spans) {
+                            region_idxs = span;
+
+                            // Include automatically-generated loop code that
+                            // calls calc_block() for each block in this region.
+                            // Loops through x from begin_rx to end_rx-1;
+                            // similar for y and z.  This code typically
+                            // contains the outer OpenMP loop(s).
+#include "yask_region_loops.hpp"
+                        }
+
+                        // After the last pack, the whole span is done at
+                        // this step, so the sources can be added. With WF
+                        // shifts, the spans of the last pack over all the
+                        // regions still cover each point once.
+                        // When running NUMA parts, this is done after all the parts.
+                        if (!_part_threads && bp == stPacks.back() && have_span_work())
+                            do_span_work(t + dir_t, span_idxs.begin, span_idxs.end);
+                    }
+            
+                    // Mark grids that [may] have been written to by this pack,
+                    // updated at next step (+/- 1).
+                    // Mark grids as dirty even if not actually written by this
+                    // rank. This is needed because neighbors will not know what
+                    // grids are actually dirty, and all ranks must have the same
+                    // information about which grids are possibly dirty.
+                    // Only the halo faces the pack may write are marked.
+                    // When running NUMA parts, this is done after all the parts.
+                    if (!_part_threads)
+                        mark_grids_dirty(bp, t + dir_t, t + 2 * dir_t);
+
+                    // Shift spatial region boundaries for next iteration to
+                    // implement temporal wavefront.
+                    shift_num++;
+
+                } // stencil bundle packs.
+            } // steps in this iteration.
+        } // time.
+    } // calc_region.
+
+    // Keep a rolling window of the out-of-core grids in memory as the
+    // regions sweep across the first domain dim: slabs up to '_ooc_ahead'
+    // regions past the current one are read asynchronously, and those
+    // that the current region and its wave-front shifts no longer reach
+    // are written back asynchronously and dropped at the next call.
+    // Not done while running NUMA parts, which sweep concurrently.
+    void StencilContext::ooc_stage(idx_t begin, idx_t end) {
+        if (_ooc_maps.empty() || _part_threads)
+            return;
+        idx_t lext = max_halos[0] + wf_shifts[0];
+        idx_t rext = max_halos[0];
+
+        // New sweep?
+        if (begin < _ooc_begin) {
+            _ooc_fetched = begin - lext;
+            _ooc_released = begin - lext;
+        }
+        _ooc_begin = begin;
+
+        // Read ahead.
+        idx_t fetch_end = end + rext + (end - begin) * max(_opts->_ooc_ahead, idx_t(0));
+        if (fetch_end > _ooc_fetched) {
+            ooc_advise(_ooc_fetched, fetch_end, true);
+            _ooc_fetched = fetch_end;
+        }
+
+        // Write behind.
+        idx_t release_end = begin - lext;
+        if (release_end > _ooc_released) {
+            ooc_advise(_ooc_released, release_end, false);
+            _ooc_released = release_end;
+        }
+    }
+
+    // Read or write back the slabs from 'first' to 'end' (excluding
+    // 'end') in the first domain dim of all the out-of-core grids.
+    // Each slab of a grid is found from the addresses of the corners of
+    // its allocation in the other dims for each allocated step, so it is
+    // contiguous when the first domain dim is outside the other ones in
+    // the layout.
+    void StencilContext::ooc_advise(idx_t first, idx_t end, bool fetch) {
+        const size_t pg = 4096;
+
+        // Drop what was written behind last time; it is clean by now
+        // unless the device is slower than the calculation.
+        vector<OocRange> ranges;
+        if (!fetch) {
+            for (auto& r : _ooc_pending) {
+                auto& m = _ooc_maps.at(r.map);
+                if (!m.base.expired())
+                    fileDrop(m.fd, r.offset, r.nbytes);
+            }
+            _ooc_pending.clear();
+        }
+
+        int odim = Dims::get_domain_dim_id(0);
+        for (auto gp : gridPtrs) {
+            if (!gp || !gp->is_storage_allocated())
+                continue;
+            int xp = gp->get_dim_id_posn(odim);
+            if (xp < 0)
+                continue;
+            char* base = static_cast<char*>(gp->get_raw_storage_buffer());
+            size_t mi = 0;
+            shared_ptr<char> mbase;
+            for (; mi < _ooc_maps.size(); mi++) {
+                mbase = _ooc_maps[mi].base.lock();
+                if (mbase && base >= mbase.get() &&
+                    base < mbase.get() + _ooc_maps[mi].nbytes)
+                    break;
+            }
+            if (mi == _ooc_maps.size())
+                continue;
+            auto& m = _ooc_maps[mi];
+
+            // Slab in this grid.
+            idx_t f = max(first, gp->_get_first_alloc_index(xp));
+            idx_t l = min(end - 1, gp->_get_last_alloc_index(xp));
+            if (f > l)
+                continue;
+            int nd = gp->get_num_dims();
+            int sp = gp->get_dim_id_posn(Indices::step_posn);
+            idx_t nsteps = (sp >= 0) ? gp->get_alloc_size(sp) : 1;
+            for (idx_t s = 0; s < nsteps; s++) {
+                char* lo = 0;
+                char* hi = 0;
+                Indices pt(nd);
+                for (int c = 0; c < (1 << nd); c++) {
+                    for (int i = 0; i < nd; i++) {
+                        bool is_last = (c >> i) & 1;
+                        if (i == sp)
+                            pt[i] = s;
+                        else if (i == xp)
+                            pt[i] = is_last ? l : f;
+                        else
+                            pt[i] = is_last ? gp->_get_last_alloc_index(i) :
+                                gp->_get_first_alloc_index(i);
+                    }
+                    char* ep = (char*)gp->getElemPtr(pt, s, false);
+                    if (!lo || ep < lo)
+                        lo = ep;
+                    if (!hi || ep > hi)
+                        hi = ep;
+                }
+
+                // Round out to pages within the file.
+                size_t off = ROUND_DOWN(size_t(lo - mbase.get()), pg);
+                size_t off_end = min(ROUND_UP(size_t(hi - mbase.get()) + REAL_BYTES, pg),
+                                     m.nbytes);
+                if (off_end > off)
+                    ranges.push_back({ mi, off, off_end - off });
+            }
+        }
+
+        for (auto& r : ranges) {
+            auto& m = _ooc_maps[r.map];
+            auto mbase = m.base.lock();
+            if (fetch)
+                filePrefetch(m.fd, r.offset, r.nbytes);
+            else {
+                fileWriteBehind(m.fd, mbase.get() + r.offset, r.offset, r.nbytes);
+                _ooc_pending.push_back(r);
+            }
+        }
+        TRACE_MSG("ooc_advise: " << (fetch ? "read ahead " : "wrote behind ") <<
+                  ranges.size() << " range(s) in " << first << " ... (end before) " << end);
+    }
+
+    // Split the span of 'rank_idxs' into '_numa_parts' slabs across the
+    // outer-most domain dim and call 'visitor' for each one from the
+    // master thread of its own team. The region threads are divided
+    // among the teams, so each slab is always calculated by the same
+    // threads. Slab boundaries are cluster multiples.
+    void StencilContext::run_numa_parts(const ScanIndices& rank_idxs,
+                                        const function<void (ScanIndices& part_idxs)>& visitor) {
+        int rthreads = set_region_threads();
+        int nparts = min(_opts->_numa_parts, rthreads);
+        int pthreads = max(rthreads / max(nparts, 1), 1);
+        auto& dname = _dims->_domain_dims.getDimName(0);
+        int posn = _dims->_stencil_dims.lookup_posn(dname);
+        idx_t cpts = _dims->_cluster_pts[dname];
+        idx_t begin = rank_idxs.begin[posn];
+        idx_t end = rank_idxs.end[posn];
+        idx_t len = end - begin;
+
+        // Not enough threads for more than one team.
+        if (nparts < 2) {
+            ScanIndices part_idxs(rank_idxs);
+            visitor(part_idxs);
+            return;
+        }
+
+        // Nested teams are needed even without block threads.
+        omp_set_nested(1);
+        _part_threads = pthreads;
+        _part_level = omp_get_level() + 1;
+
+#pragma omp parallel num_threads(nparts) proc_bind(spread)
+        {
+            int part = omp_get_thread_num();
+            ScanIndices part_idxs(rank_idxs);
+            part_idxs.begin[posn] = min(begin + ROUND_UP(len * part / nparts, cpts), end);
+            part_idxs.end[posn] = (part == nparts - 1) ? end :
+                min(begin + ROUND_UP(len * (part + 1) / nparts, cpts), end);
+            if (part_idxs.begin[posn] < part_idxs.end[posn]) {
+                omp_set_num_threads(pthreads);
+                visitor(part_idxs);
+            }
+        }
+
+        _part_threads = 0;
+        set_region_threads();
+    }
+
+    // Calculate all bundle packs at step 't' over the whole rank.
+    // Each (pack, block) pair is a task. A task becomes ready when the
+    // tasks of the previous pack in all blocks within the dependence
+    // reach are done, so a block of a later pack may start while other
+    // parts of the rank are still in an earlier pack. Newly-ready tasks
+    // are run first to keep the data written by the earlier pack in cache.
+    // There are no neighbor ranks, so no halos are exchanged between packs.
+    void StencilContext::calc_packs_async(idx_t t) {
+        int nsdims = _dims->_stencil_dims.size();
+        auto step_posn = Indices::step_posn;
+        idx_t npacks = stPacks.size();
+
+        // Blocks in the rank and dependence reach in blocks in each dim.
+        // The reach covers the max halos of the grids plus the halos of
+        // any scratch grids calculated in a block.
+        vector<idx_t> nblks(nsdims, 1), reach(nsdims, 0);
+        idx_t nb = 1;
+        for (int i = 0; i < nsdims; i++) {
+            if (i == step_posn) continue;
+            int j = Dims::get_domain_dim_posn(i);
+            idx_t bsize = _opts->_block_sizes[i];
+            idx_t ext = max_halos[j];
+            for (auto* sv : scratchVecs) {
+                auto gp = sv->at(0);
+                int posn = gp->get_dim_id_posn(i);
+                if (posn >= 0)
+                    ext += max(gp->get_left_halo_size(posn),
+                               gp->get_right_halo_size(posn));
+            }
+            nblks[i] = CEIL_DIV(rank_bb.bb_len[j], bsize);
+            reach[i] = CEIL_DIV(ext, bsize);
+            nb *= nblks[i];
+        }
+        if (nb < 1)
+            return;
+
+        // Call 'visitor' with the index of each block within the reach
+        // of block 'b', including 'b' itself.
+        auto visit_nbrs = [&](idx_t b, const function<void (idx_t)>& visitor) {
+            vector<idx_t> pt(nsdims, 0), ofs(nsdims, 0);
+            for (int i = nsdims - 1; i >= 0; i--) {
+                if (i == step_posn) continue;
+                pt[i] = b % nblks[i];
+                b /= nblks[i];
+                ofs[i] = -reach[i];
+            }
+            while (true) {
                 bool ok = true;
-                for (int i = 0; i < ndims; i++) {
+                idx_t nbi = 0;
+                for (int i = 0; ok && i < nsdims; i++) {
                     if (i == step_posn) continue;
-                    auto& dname = _dims->_stencil_dims.getDimName(i);
-                    auto angle = wf_angles[dname];
-
-                    // Begin point.
-                    idx_t dbegin = rank_bb.bb_begin[dname];
-                    idx_t rbegin = max<idx_t>(start[i], ext_bb.bb_begin[dname]);
-                    if (rbegin < dbegin) // in left WF ext?
-                        rbegin = max(rbegin, dbegin - left_wf_exts[dname] + shift_num * angle);
-                    region_idxs.begin[i] = rbegin;
-
-                    // End point.
-                    idx_t dend = rank_bb.bb_end[dname];
-                    idx_t rend = min<idx_t>(stop[i], ext_bb.bb_end[dname]);
-                    if (rend > dend) // in right WF ext?
-                        rend = min(rend, dend + right_wf_exts[dname] - shift_num * angle);
-                    region_idxs.end[i] = rend;
-
-                    // Anything to do?
-                    if (rend <= rbegin)
-                        ok = false;
+                    idx_t ni = pt[i] + ofs[i];
+                    ok = ni >= 0 && ni < nblks[i];
+                    nbi = nbi * nblks[i] + ni;
+                }
+                if (ok)
+                    visitor(nbi);
+
+                // Next offset.
+                int i = nsdims - 1;
+                for (; i >= 0; i--) {
+                    if (i == step_posn) continue;
+                    if (++ofs[i] <= reach[i])
+                        break;
+                    ofs[i] = -reach[i];
+                }
+                if (i < 0)
+                    break;
+            }
+        };
+
+        // Number of unfinished tasks each task in packs after the first
+        // waits for.
+        idx_t ntasks = npacks * nb;
+        vector<atomic<int>> nwaits(ntasks);
+        for (idx_t b = 0; b < nb; b++) {
+            int ndeps = 0;
+            visit_nbrs(b, [&](idx_t) { ndeps++; });
+            for (idx_t p = 1; p < npacks; p++)
+                nwaits[p * nb + b] = ndeps;
+        }
+
+        // Ready tasks, taken from the back.
+        // The first pack is pushed in reverse to start in block order.
+        // Threads with no ready task sleep until one is pushed or all
+        // are done.
+        vector<idx_t> ready;
+        ready.reserve(ntasks);
+        for (idx_t b = nb - 1; b >= 0; b--)
+            ready.push_back(b);
+        mutex ready_lock;
+        condition_variable ready_cv;
+        idx_t ndone = 0;        // guarded by 'ready_lock'.
+
+        // Indices copied for each block.
+        ScanIndices step_idxs(*_dims, true, &rank_domain_offsets);
+        step_idxs.start[step_posn] = t;
+        step_idxs.stop[step_posn] = t + 1;
+
+#pragma omp parallel proc_bind(spread)
+        {
+            while (true) {
+                idx_t task = -1;
+                {
+                    unique_lock<mutex> lock(ready_lock);
+                    ready_cv.wait(lock, [&]() { return ready.size() || ndone == ntasks; });
+                    if (ready.empty())
+                        break;
+                    task = ready.back();
+                    ready.pop_back();
+                }
+                idx_t p = task / nb;
+                idx_t b = task % nb;
+
+                // Indices of this block.
+                ScanIndices block_idxs(step_idxs);
+                idx_t bi = b;
+                for (int i = nsdims - 1; i >= 0; i--) {
+                    if (i == step_posn) continue;
+                    int j = Dims::get_domain_dim_posn(i);
+                    idx_t bsize = _opts->_block_sizes[i];
+                    idx_t first = rank_bb.bb_begin[j] + (bi % nblks[i]) * bsize;
+                    block_idxs.start[i] = first;
+                    block_idxs.stop[i] = min(first + bsize, rank_bb.bb_end[j]);
+                    bi /= nblks[i];
                 }
-                TRACE_MSG("calc_region: region span after trimming: " <<
-                          region_idxs.begin.makeValStr(ndims) <<
-                          " ... (end before) " << region_idxs.end.makeValStr(ndims));
+                block_idxs.begin = block_idxs.start;
+                block_idxs.end = block_idxs.stop;
+                calc_block(stPacks[p], block_idxs);
+
+                // Release tasks of the next pack that waited for this one.
+                if (p + 1 < npacks) {
+                    visit_nbrs(b, [&](idx_t nbi) {
+                            idx_t next = (p + 1) * nb + nbi;
+                            if (--nwaits[next] == 0) {
+                                lock_guard<mutex> lock(ready_lock);
+                                ready.push_back(next);
+                                ready_cv.notify_one();
+                            }
+                        });
+                }
+                {
+                    lock_guard<mutex> lock(ready_lock);
+                    if (++ndone == ntasks)
+                        ready_cv.notify_all();
+                }
+            }
+        }
+
+        // Mark grids that [may] have been written to by the packs;
+        // see calc_region().
+        for (auto& bp : stPacks)
+            mark_grids_dirty(bp, t + 1, t + 2);
+    }
+
+    // Set the begin and end indices of 'idxs' to the span of the region
+    // from 'start' to 'stop' after 'shift_num' wave-front shifts.
+    // Between shifts, we only shift left, so region loops must strictly
+    // increment. They may do so in any order.  TODO: shift only what is
+    // needed by each pack, not the global max.
+    // Return false if the span is empty.
+    bool StencilContext::get_region_span(ScanIndices& idxs,
+                                         const Indices& start,
+                                         const Indices& stop,
+                                         idx_t shift_num) const {
+        int ndims = _dims->_stencil_dims.size();
+        auto step_posn = Indices::step_posn;
+
+        // For wavefront adjustments, see conceptual diagram in
+        // run_solution().  In calc_region(), one of the
+        // parallelogram-shaped regions is being evaluated.  These
+        // shapes may extend beyond actual boundaries. So, at each
+        // time-step, the parallelogram may be trimmed based on the
+        // BB and WF extensions outside of the rank-BB.
                     
-                // Only need to loop through the span of the region if it is
-                // at least partly inside the extended BB. For overlapping
-                // regions, they may start outside the domain but enter the
-                // domain as time progresses and their boundaries shift. So,
-                // we don't want to return if this condition isn't met.
-                if (ok) {
+        // Actual region boundaries must stay within [extended] rank BB.
+        // We have to calculate the posn in the extended rank at each
+        // value of 'shift_num' because it is being shifted spatially.
+        bool ok = true;
+        for (int i = 0; i < ndims; i++) {
+            if (i == step_posn) continue;
+            int j = Dims::get_domain_dim_posn(i);
+            auto angle = wf_angles[j];
+
+            // Begin point.
+            idx_t dbegin = rank_bb.bb_begin[j];
+            idx_t rbegin = max<idx_t>(start[i] - shift_num * angle,
+                                      ext_bb.bb_begin[j]);
+            if (rbegin < dbegin) // in left WF ext?
+                rbegin = max(rbegin, dbegin - left_wf_exts[j] + shift_num * angle);
+
+            // End point.
+            idx_t dend = rank_bb.bb_end[j];
+            idx_t rend = min<idx_t>(stop[i] - shift_num * angle,
+                                    ext_bb.bb_end[j]);
+            if (rend > dend) // in right WF ext?
+                rend = min(rend, dend + right_wf_exts[j] - shift_num * angle);
+
+            // Only part of the rank being evaluated?
+            if (sub_bb) {
+                rbegin = max<idx_t>(rbegin, sub_bb->bb_begin[j]);
+                rend = min<idx_t>(rend, sub_bb->bb_end[j]);
+            }
+            idxs.begin[i] = rbegin;
+            idxs.end[i] = rend;
+
+            // Anything to do?
+            if (rend <= rbegin)
+                ok = false;
+        }
+        TRACE_MSG("get_region_span: region span after trimming: " <<
+                  idxs.begin.makeValStr(ndims) <<
+                  " ... (end before) " << idxs.end.makeValStr(ndims));
+        return ok;
+    }
+
+    // Calculate steps 'start_t' up to 'stop_t' in a region with temporal
+    // blocking, i.e., all the steps and packs are evaluated in one block
+    // before moving to the next one.  Shapes in neighboring blocks are
+    // arranged so that no block needs a value from another block that
+    // is not yet ready (see calc_block_tb()). In 1D, with 'k' shifts:
+    //
+    //  k=2   |  /---------\  |  /---------\  |
+    //  k=1   | /  base 0   \ | /  base 1   \ |  <- phase 0.
+    //  k=0   |/             \|/             \|
+    //        \  /         \  /         \  /
+    //         \/ bridge 0  \/ bridge 1  \/      <- phase 1.
+    //        B0             B1             B2
+    //
+    // In n-D, phase 'p' evaluates the shapes that are bridges in 'p' dims
+    // and bases in the others; the shapes in one phase are independent.
+    // Return false if the blocks are too narrow for the number of steps;
+    // the steps must then be evaluated separately.
+    bool StencilContext::calc_region_tb(BundlePackPtr& sel_bp,
+                                        const ScanIndices& rgn_idxs,
+                                        const Indices& start,
+                                        const Indices& stop,
+                                        idx_t start_t, idx_t stop_t,
+                                        idx_t& shift_num) {
+        int ndims = _dims->_stencil_dims.size();
+        int nddims = _dims->_domain_dims.size();
+        auto step_posn = Indices::step_posn;
+        idx_t dir_t = (stop_t > start_t) ? 1 : -1;
+        idx_t npacks = 0;
+        for (auto& bp : stPacks)
+            if (!sel_bp || sel_bp == bp)
+                npacks++;
+        idx_t nshifts = abs(stop_t - start_t) * npacks;
+
+        // Blocks are laid out on the region span at the first shift
+        // with at least one point in each dim and without alignment, so
+        // only the last block in each dim can be smaller than a full one.
+        // Shapes in neighboring blocks would overlap if the full blocks
+        // were too narrow.
+        ScanIndices region_idxs(rgn_idxs);
+        get_region_span(region_idxs, start, stop, shift_num);
+        int bridge_dims = 0;    // dims with non-zero angles.
+        for (int i = 0, j = 0; i < ndims; i++) {
+            if (i == step_posn) continue;
+            auto angle = wf_angles[j];
+            if (region_idxs.end[i] <= region_idxs.begin[i])
+                region_idxs.end[i] = region_idxs.begin[i] + 1;
+            region_idxs.align[i] = 1;
+            if (angle > 0) {
+                bridge_dims |= 1 << j;
+                auto bsize = region_idxs.step[i];
+                if (region_idxs.end[i] - region_idxs.begin[i] > bsize &&
+                    bsize < 2 * (nshifts - 1) * angle) {
+                    TRACE_MSG("calc_region_tb: block size " << bsize << " in dim " << j <<
+                              " too small for " << nshifts << " shifts");
+                    return false;
+                }
+            }
+            j++;
+        }
+        TRACE_MSG("calc_region_tb: steps " << start_t << " ... (end before) " << stop_t <<
+                  " in blocks over " << region_idxs.begin.makeValStr(ndims) <<
+                  " ... (end before) " << region_idxs.end.makeValStr(ndims));
+        
+        // Save region span at each shift for calc_block_tb().
+        _tb_begins.clear();
+        _tb_ends.clear();
+        bool ok = false;
+        for (idx_t k = 0; k < nshifts; k++) {
+            ScanIndices idxs(rgn_idxs);
+            if (get_region_span(idxs, start, stop, shift_num + k))
+                ok = true;
+            _tb_begins.push_back(idxs.begin);
+            _tb_ends.push_back(idxs.end);
+        }
+        _tb_layout_end = region_idxs.end;
+        _tb_start_t = start_t;
+        _tb_stop_t = stop_t;
+
+        // Loop through phases and the shapes in each.
+        if (ok) {
+            region_idxs.start[step_posn] = start_t;
+            region_idxs.stop[step_posn] = stop_t;
+            for (int phase = 0; phase <= nddims; phase++) {
+                for (int mask = 0; mask < (1 << nddims); mask++) {
+                    if ((mask & ~bridge_dims) != 0)
+                        continue; // bridges are empty w/o angles.
+                    int nbits = 0;
+                    for (int j = 0; j < nddims; j++)
+                        if (mask & (1 << j))
+                            nbits++;
+                    if (nbits != phase)
+                        continue;
+                    _tb_mask = mask;
+                    BundlePackPtr& bp = sel_bp;
 
                     // Include automatically-generated loop code that
                     // calls calc_block() for each block in this region.
-                    // Loops through x from begin_rx to end_rx-1;
-                    // similar for y and z.  This code typically
-                    // contains the outer OpenMP loop(s).
 #include "yask_region_loops.hpp"
                 }
-            
-                // Mark grids that [may] have been written to by this pack,
-                // updated at next step (+/- 1).
-                // Mark grids as dirty even if not actually written by this
-                // rank. This is needed because neighbors will not know what
-                // grids are actually dirty, and all ranks must have the same
-                // information about which grids are possibly dirty.
-                // TODO: make this smarter to save unneeded MPI exchanges.
-                mark_grids_dirty(bp, start_t + step_t, stop_t + step_t);
-
-                // Shift spatial region boundaries for next iteration to
-                // implement temporal wavefront.  Between regions, we only shift
-                // left, so region loops must strictly increment. They may do
-                // so in any order.  TODO: shift only what is needed by
-                // this pack, not the global max.
-                for (int i = 0; i < ndims; i++) {
-                    if (i == step_posn) continue;
-                    auto& dname = _dims->_stencil_dims.getDimName(i);
-                    auto angle = wf_angles[dname];
-
-                    start[i] -= angle;
-                    stop[i] -= angle;
-                }
-                shift_num++;
+            }
+            _tb_mask = -1;
+        }
 
-            } // stencil bundle packs.
-        } // time.
-    } // calc_region.
+        // Mark grids that [may] have been written to by the packs;
+        // see calc_region().
+        for (idx_t t = start_t; t != stop_t; t += dir_t) {
+            for (auto& bp : stPacks)
+                if (!sel_bp || sel_bp == bp)
+                    mark_grids_dirty(bp, t + dir_t, t + 2 * dir_t);
+        }
+        shift_num += nshifts;
+        return true;
+    }
 
     // Calculate results within a block. This function calls
     // 'calc_block' for each bundle in the specified pack.
@@ -646,13 +1391,12 @@ namespace yask {
 
 
         int nsdims = _dims->_stencil_dims.size();
-        auto& step_dim = _dims->_step_dim;
         auto step_posn = Indices::step_posn;
-        auto* bp = sel_bp.get();
-        assert(bp);
-        TRACE_MSG("calc_block for pack '" << bp->get_name() << "': " <<
+        TRACE_MSG("calc_block for pack '" << (sel_bp ? sel_bp->get_name() : "all") << "': " <<
                   region_idxs.start.makeValStr(nsdims) <<
                   " ... (end before) " << region_idxs.stop.makeValStr(nsdims));
+        static const int block_trace_id = EventTrace::get_id("block");
+        EventTrace::Scope block_scope(block_trace_id);
 
         // Init block begin & end from region start & stop indices.
         ScanIndices block_idxs(*_dims, true, 0);
@@ -664,11 +1408,77 @@ namespace yask {
         // Groups in block loops are based on sub-block-group sizes.
         block_idxs.group_size = _opts->_sub_block_group_sizes;
 
+        // Temporal block?
+        if (_tb_mask >= 0) {
+            calc_block_tb(sel_bp, region_idxs, block_idxs);
+            return;
+        }
+        
         // Loop through bundles in this pack.
+        auto* bp = sel_bp.get();
+        assert(bp);
         for (auto* sb : *bp) {
             sb->calc_block(block_idxs);
         }
     }
+
+    // Calculate all the steps and packs of a temporal block in the
+    // shape selected by '_tb_mask'. In each domain dim with a non-zero
+    // angle, the shape after 'k' shifts is either a base that is
+    // narrowed by 'k' * angle on each side of the block or, if the dim
+    // is in '_tb_mask', a bridge that spans 'k' * angle on each side of
+    // the beginning of the block. The last block in each dim is not
+    // narrowed on its ending side. All shapes are trimmed to the region
+    // span at each shift.
+    void StencilContext::calc_block_tb(BundlePackPtr& sel_bp,
+                                       const ScanIndices& region_idxs,
+                                       ScanIndices& block_idxs) {
+        int nsdims = _dims->_stencil_dims.size();
+        auto step_posn = Indices::step_posn;
+        idx_t dir_t = (_tb_stop_t > _tb_start_t) ? 1 : -1;
+        size_t k = 0;
+        for (idx_t t = _tb_start_t; t != _tb_stop_t; t += dir_t) {
+            for (auto& bp : stPacks) {
+                if (sel_bp && sel_bp != bp)
+                    continue;
+                assert(k < _tb_begins.size());
+                auto& rbegin = _tb_begins[k];
+                auto& rend = _tb_ends[k];
+
+                bool ok = true;
+                for (int i = 0, j = 0; i < nsdims; i++) {
+                    idx_t sbegin = t, send = t + dir_t;
+                    if (i != step_posn) {
+                        idx_t ka = idx_t(k) * wf_angles[j];
+                        idx_t bbegin = region_idxs.start[i];
+                        idx_t bend = region_idxs.stop[i];
+                        if (_tb_mask & (1 << j)) {
+                            sbegin = bbegin - ka;
+                            send = bbegin + ka;
+                        } else {
+                            sbegin = bbegin + ka;
+                            send = (bend < _tb_layout_end[i]) ? bend - ka : rend[i];
+                        }
+                        sbegin = max(sbegin, rbegin[i]);
+                        send = min(send, rend[i]);
+                        if (send <= sbegin)
+                            ok = false;
+                        j++;
+                    }
+                    block_idxs.begin[i] = block_idxs.start[i] = sbegin;
+                    block_idxs.end[i] = block_idxs.stop[i] = send;
+                }
+                if (ok) {
+                    TRACE_MSG("calc_block_tb: shape " << _tb_mask << " at shift " << k << ": " <<
+                              block_idxs.begin.makeValStr(nsdims) <<
+                              " ... (end before) " << block_idxs.end.makeValStr(nsdims));
+                    for (auto* sb : *bp)
+                        sb->calc_block(block_idxs);
+                }
+                k++;
+            }
+        }
+    }
     
     // Reset the auto-tuner.
     void StencilContext::AT::clear(bool mark_done, bool verbose) {
@@ -688,17 +1498,26 @@ namespace yask {
         // Apply the best known settings from existing data, if any.
         auto _opts = _context->_opts;
         if (best_rate > 0.) {
-            _opts->_block_sizes = best_block;
-            apply();
+            set_setting(best_setting);
             os << "auto-tuner: applying block-size "  <<
                 best_block.makeDimValStr(" * ") << endl;
+            if (coord >= 0)
+                os << "auto-tuner: applying sub-block-size "  <<
+                    best_setting.sub_block_sizes.makeDimValStr(" * ") <<
+                    ", region-size " << best_setting.region_sizes.makeDimValStr(" * ") <<
+                    ", " << best_setting.block_threads << " thread(s) per block" <<
+                    ", and region-path '" << _opts->_region_path << "'" << endl;
         }
         
         // Reset all vars.
         results.clear();
         n2big = n2small = 0;
         best_block = _opts->_block_sizes;
+        best_setting = get_setting();
         best_rate = 0.;
+        cands.clear();
+        cand_idx = 0;
+        coord = -1;
         center_block = best_block;
         radius = max_radius;
         done = mark_done;
@@ -711,6 +1530,28 @@ namespace yask {
         // Set min blocks to number of region threads.
         min_blks = _context->set_region_threads();
         
+        // Use settings from a previous run if found in the cache.
+        // Only look after the solution is prepared so the key is valid.
+        // When tuning all ranks together, use rank 0's entry everywhere.
+        if (!done && _context->rank_bb.bb_valid) {
+            Setting s = get_setting();
+            bool found = (!is_dist() || _context->_env->my_rank == 0) && read_cache(s);
+            bcast_setting(s, found);
+            if (found) {
+                set_setting(s);
+                best_setting = s;
+                best_block = s.block_sizes;
+                done = true;
+                os << "auto-tuner: using cached block-size " <<
+                    s.block_sizes.makeDimValStr(" * ") <<
+                    ", sub-block-size " << s.sub_block_sizes.makeDimValStr(" * ") <<
+                    ", region-size " << s.region_sizes.makeDimValStr(" * ") <<
+                    ", " << s.block_threads << " thread(s) per block" <<
+                    ", and region-path '" << _opts->_region_path << "' from '" <<
+                    _opts->_at_cache_file << "'" << endl;
+            }
+        }
+
         // Adjust starting block if needed.
         for (auto dim : center_block.getDims()) {
             auto& dname = dim.getName();
@@ -728,9 +1569,11 @@ namespace yask {
     } // clear.
 
     // Evaluate the previous run and take next auto-tuner step.
+    // When tuning all ranks together, every rank sees the time of the
+    // slowest one, so they step through the search in lockstep, and
+    // rank 0's choice is applied everywhere in case the ranks differ.
     void StencilContext::AT::eval(idx_t steps, double etime) {
-        ostream& os = _context->get_ostr();
-        
+
         // Leave if done.
         if (done)
             return;
@@ -739,6 +1582,29 @@ namespace yask {
         if (!nullop)
             return;
 
+        if (!is_dist()) {
+            eval_step(steps, etime);
+            return;
+        }
+        auto _env = _context->_env;
+        etime = maxOverRanks(etime, _env->comm);
+        eval_step(steps, etime);
+
+        Setting s = get_setting();
+        bool is_done = done;
+        bcast_setting(s, is_done);
+        if (s.region_sizes != _context->_opts->_region_sizes ||
+            s.block_sizes != _context->_opts->_block_sizes ||
+            s.sub_block_sizes != _context->_opts->_sub_block_sizes ||
+            s.block_threads != _context->_opts->num_block_threads)
+            set_setting(s);
+        done = is_done;
+    }
+
+    // Take next auto-tuner step based on 'etime' for 'steps'.
+    void StencilContext::AT::eval_step(idx_t steps, double etime) {
+        ostream& os = _context->get_ostr();
+
         // Handy ptrs.
         auto _opts = _context->_opts;
         auto _mpiInfo = _context->_mpiInfo;
@@ -772,16 +1638,41 @@ namespace yask {
         double rate = double(csteps) / ctime;
         os << "auto-tuner: " << csteps << " steps(s) at " << rate <<
             " steps/sec with block-size " <<
-            _opts->_block_sizes.makeDimValStr(" * ") << endl;
+            _opts->_block_sizes.makeDimValStr(" * ");
+        if (coord >= 0)
+            os << ", sub-block-size " << _opts->_sub_block_sizes.makeDimValStr(" * ") <<
+                ", region-size " << _opts->_region_sizes.makeDimValStr(" * ") <<
+                ", " << _opts->num_block_threads << " thread(s) per block" <<
+                ", and region-path '" << _opts->_region_path << "'";
+        os << endl;
         csteps = 0;
         ctime = 0.;
 
         // Save result.
-        results[_opts->_block_sizes] = rate;
         bool is_better = rate > best_rate;
         if (is_better) {
-            best_block = _opts->_block_sizes;
+            best_setting = get_setting();
             best_rate = rate;
+        }
+
+        // Coordinate-descent search of other settings:
+        // try the next candidate, moving to the next coord
+        // when all have been tried.
+        if (coord >= 0) {
+            if (cand_idx >= cands.size() && !next_coord()) {
+                clear(true);
+                write_cache();
+                os << "auto-tuner: done" << endl;
+                return;
+            }
+            set_setting(cands[cand_idx++]);
+            return;
+        }
+
+        // Block-size search.
+        results[_opts->_block_sizes] = rate;
+        if (is_better) {
+            best_block = _opts->_block_sizes;
             better_neigh_found = true;
         }
 
@@ -804,20 +1695,20 @@ namespace yask {
                 // Determine new block size.
                 IdxTuple bsize(center_block);
                 bool ok = true;
-                for (auto odim : ofs.getDims()) {
-                    auto& dname = odim.getName(); // a domain-dim name.
-                    auto& dofs = odim.getVal(); // always [0..2].
+                for (int j = 0; j < ofs.getNumDims(); j++) {
+                    int i = Dims::get_domain_dim_id(j);
+                    auto dofs = ofs[j]; // always [0..2].
 
                     // Min and max sizes of this dim.
-                    auto dmin = _dims->_cluster_pts[dname];
-                    auto dmax = _opts->_region_sizes[dname];
+                    auto dmin = _dims->_cluster_pts[j];
+                    auto dmax = _opts->_region_sizes[i];
                             
                     // Determine distance of GD neighbors.
                     auto step = dmin; // step by cluster size.
                     step = max(step, min_step);
                     step *= radius;
 
-                    auto sz = center_block[dname];
+                    auto sz = center_block[i];
                     switch (dofs) {
                     case 0:
                         sz -= step;
@@ -843,7 +1734,7 @@ namespace yask {
                     sz = ROUND_UP(sz, dmin);
 
                     // Save.
-                    bsize[dname] = sz;
+                    bsize[i] = sz;
 
                 } // domain dims.
                 TRACE_MSG2("auto-tuner: checking block-size "  <<
@@ -897,8 +1788,16 @@ namespace yask {
                     // Done?
                     if (radius < 1) {
 
+                        // Search other settings starting from
+                        // the best one?
+                        if (_opts->_tune_all && next_coord()) {
+                            set_setting(cands[cand_idx++]);
+                            return;
+                        }
+
                         // Reset AT and disable.
                         clear(true);
+                        write_cache();
                         os << "auto-tuner: done" << endl;
                         return;
                     }
@@ -924,7 +1823,6 @@ namespace yask {
 
         // Change block-related sizes to 0 so adjustSettings()
         // will set them to the default.
-        // TODO: tune sub-block sizes also.
         _opts->_sub_block_sizes.setValsSame(0);
         _opts->_sub_block_group_sizes.setValsSame(0);
         _opts->_block_group_sizes.setValsSame(0);
@@ -936,15 +1834,256 @@ namespace yask {
         _context->allocScratchData(nullop->get_ostream());
     }
     
-    // Apply auto-tuning to some of the settings.
-    void StencilContext::run_auto_tuner_now(bool verbose) {
-        if (!rank_bb.bb_valid)
-            THROW_YASK_EXCEPTION("Error: tune_settings() called without calling prepare_solution() first");
-
-        ostream& os = get_ostr();
-        os << "Auto-tuning...\n" << flush;
-        YaskTimer at_timer;
-        at_timer.start();
+    // Get the settings searched by coordinate descent.
+    StencilContext::AT::Setting StencilContext::AT::get_setting() const {
+        auto _opts = _context->_opts;
+        Setting s;
+        s.region_sizes = _opts->_region_sizes;
+        s.block_sizes = _opts->_block_sizes;
+        s.sub_block_sizes = _opts->_sub_block_sizes;
+        s.block_threads = _opts->num_block_threads;
+        s.region_path = _opts->_region_path_idx;
+        return s;
+    }
+
+    // Apply the settings searched by coordinate descent.
+    void StencilContext::AT::set_setting(const Setting& s) {
+        auto _opts = _context->_opts;
+        auto _env = _context->_env;
+        _opts->_region_sizes = s.region_sizes;
+        _opts->_block_sizes = s.block_sizes;
+        _opts->_sub_block_sizes = s.sub_block_sizes;
+        _opts->num_block_threads = s.block_threads;
+        _opts->_region_path = KernelSettings::get_region_paths().at(s.region_path);
+        _opts->_sub_block_group_sizes.setValsSame(0);
+        _opts->_block_group_sizes.setValsSame(0);
+        _opts->adjustSettings(nullop->get_ostream(), _env);
+        _context->allocScratchData(nullop->get_ostream());
+    }
+
+    // Set 'cands' to the untried values of the next setting to search,
+    // each a variation of 'best_setting'. The coords are the number of
+    // threads per block, the sub-block size in each domain dim, when
+    // wave-fronts are used, the region size in each domain dim, and
+    // the path of the region loops.
+    // Return false if there are no more.
+    bool StencilContext::AT::next_coord() {
+        ostream& os = _context->get_ostr();
+        auto _opts = _context->_opts;
+        auto _dims = _context->_dims;
+        auto& step_dim = _dims->_step_dim;
+        int nddims = _dims->_domain_dims.size();
+        auto& base = best_setting;
+        cands.clear();
+        cand_idx = 0;
+
+        // Add a candidate if not the same as the base or the previous one.
+        auto same = [&](const Setting& a, const Setting& b) {
+            return a.block_threads == b.block_threads &&
+                a.region_path == b.region_path &&
+                a.region_sizes == b.region_sizes &&
+                a.sub_block_sizes == b.sub_block_sizes;
+        };
+        auto add_cand = [&](const Setting& s) {
+            if (!same(s, base) && (cands.empty() || !same(s, cands.back())))
+                cands.push_back(s);
+        };
+        
+        while (cands.empty()) {
+            coord++;
+
+            // Threads per block, using default sub-blocks.
+            if (coord == 0) {
+                int mt = max(_opts->max_threads / _opts->thread_divisor, 1);
+                for (int nbt = 1; nbt <= min(mt, max_block_threads); nbt *= 2) {
+                    if (nbt == base.block_threads)
+                        continue;
+                    Setting s = base;
+                    s.block_threads = nbt;
+                    s.sub_block_sizes.setValsSame(0);
+                    cands.push_back(s);
+                }
+                if (cands.size())
+                    os << "auto-tuner: searching threads per block" << endl;
+            }
+
+            // Sub-block sizes from block size down to cluster size.
+            else if (coord <= nddims) {
+                auto& dname = _dims->_domain_dims.getDimName(coord - 1);
+                auto cpts = _dims->_cluster_pts[dname];
+                for (idx_t sz = base.block_sizes[dname]; sz >= cpts; sz /= 2) {
+                    Setting s = base;
+                    s.sub_block_sizes[dname] = ROUND_UP(sz, cpts);
+                    add_cand(s);
+                }
+                if (cands.size())
+                    os << "auto-tuner: searching sub-block size in '" << dname << "'" << endl;
+            }
+
+            // Region sizes from rank size down to block size.
+            else if (coord <= 2 * nddims) {
+                if (base.region_sizes[step_dim] <= 1)
+                    continue;
+                auto& dname = _dims->_domain_dims.getDimName(coord - nddims - 1);
+                auto cpts = _dims->_cluster_pts[dname];
+                for (idx_t sz = _opts->_rank_sizes[dname];
+                     sz >= base.block_sizes[dname]; sz /= 2) {
+                    Setting s = base;
+                    s.region_sizes[dname] = ROUND_UP(sz, cpts);
+                    add_cand(s);
+                }
+                if (cands.size())
+                    os << "auto-tuner: searching region size in '" << dname << "'" << endl;
+            }
+
+            // Region-loop paths.
+            else if (coord == 2 * nddims + 1) {
+                int npaths = KernelSettings::get_region_paths().size();
+                for (int rp = 0; rp < npaths; rp++) {
+                    Setting s = base;
+                    s.region_path = rp;
+                    add_cand(s);
+                }
+                if (cands.size())
+                    os << "auto-tuner: searching region-loop path" << endl;
+            }
+            else
+                return false;
+        }
+        return true;
+    }
+    
+    // Tuning all ranks together?
+    bool StencilContext::AT::is_dist() const {
+        return _context->_opts->_tune_mpi && _context->_env->num_ranks > 1;
+    }
+
+    // Copy 'flag' and the sizes in 's' from rank 0 to all ranks.
+    void StencilContext::AT::bcast_setting(Setting& s, bool& flag) const {
+#ifdef USE_MPI
+        if (!is_dist())
+            return;
+        IdxTuple* tuples[] = { &s.region_sizes, &s.block_sizes, &s.sub_block_sizes };
+        vector<idx_t> buf;
+        buf.push_back(flag);
+        buf.push_back(s.block_threads);
+        buf.push_back(s.region_path);
+        for (auto* t : tuples)
+            for (int i = 0; i < t->getNumDims(); i++)
+                buf.push_back(t->getVal(i));
+        MPI_Bcast(buf.data(), buf.size(), MPI_INTEGER8, 0, _context->_env->comm);
+        size_t j = 0;
+        flag = buf[j++] != 0;
+        s.block_threads = int(buf[j++]);
+        s.region_path = int(buf[j++]);
+        for (auto* t : tuples)
+            for (int i = 0; i < t->getNumDims(); i++)
+                t->setVal(i, buf[j++]);
+#endif
+    }
+
+    // Make the key for the cache file from everything that affects
+    // the best settings but is not searched.
+    string StencilContext::AT::get_cache_key() const {
+        auto _opts = _context->_opts;
+        auto _dims = _context->_dims;
+        auto& step_dim = _dims->_step_dim;
+        ostringstream oss;
+        oss << _context->get_name() << " arch=" << ARCH_NAME <<
+            " rank=" << _opts->_rank_sizes.removeDim(step_dim).makeDimValStr("*") <<
+            " rt=" << _opts->_region_sizes[step_dim] <<
+            " bt=" << _opts->_block_sizes[step_dim] <<
+            " threads=" << max(_opts->max_threads / _opts->thread_divisor, 1) <<
+            " cpu=" << getCpuModel();
+        return oss.str();
+    }
+
+    // Each line in the cache file is the key, a tab, and the region,
+    // block, and sub-block sizes in each stencil dim followed by the
+    // number of threads per block and the region-loop path.
+    bool StencilContext::AT::read_cache(Setting& s) const {
+        auto& fname = _context->_opts->_at_cache_file;
+        if (!fname.length())
+            return false;
+        ifstream ifs(fname);
+        if (!ifs.is_open())
+            return false;
+        string key = get_cache_key();
+        string line;
+        while (getline(ifs, line)) {
+            auto tpos = line.find('\t');
+            if (tpos == string::npos || line.substr(0, tpos) != key)
+                continue;
+            istringstream iss(line.substr(tpos + 1));
+            s = get_setting();
+            for (auto* t : { &s.region_sizes, &s.block_sizes, &s.sub_block_sizes })
+                for (int i = 0; i < t->getNumDims(); i++) {
+                    idx_t v = 0;
+                    iss >> v;
+                    t->setVal(i, v);
+                }
+            iss >> s.block_threads;
+            if (iss.fail() || s.block_threads < 1)
+                continue;
+
+            // The path is optional for files from older versions.
+            string path;
+            if (iss >> path) {
+                auto& paths = KernelSettings::get_region_paths();
+                auto pi = find(paths.begin(), paths.end(), path);
+                if (pi == paths.end())
+                    continue;
+                s.region_path = int(pi - paths.begin());
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Add the current setting to the cache file, replacing any old
+    // one with the same key. Only the msg rank writes the file.
+    void StencilContext::AT::write_cache() const {
+        auto _opts = _context->_opts;
+        auto& fname = _opts->_at_cache_file;
+        if (!fname.length() || _context->_env->my_rank != _opts->msg_rank)
+            return;
+        ostream& os = _context->get_ostr();
+        string key = get_cache_key();
+
+        // Keep the other lines.
+        vector<string> lines;
+        {
+            ifstream ifs(fname);
+            string line;
+            while (getline(ifs, line))
+                if (line.length() && line.substr(0, line.find('\t')) != key)
+                    lines.push_back(line);
+        }
+        auto s = get_setting();
+        lines.push_back(key + "\t" + s.region_sizes.makeValStr(" ") + " " +
+                        s.block_sizes.makeValStr(" ") + " " +
+                        s.sub_block_sizes.makeValStr(" ") + " " +
+                        to_string(s.block_threads) + " " +
+                        KernelSettings::get_region_paths().at(s.region_path));
+
+        ofstream ofs(fname);
+        for (auto& line : lines)
+            ofs << line << endl;
+        if (!ofs)
+            os << "auto-tuner: unable to write '" << fname << "'" << endl;
+        else
+            os << "auto-tuner: saved settings in '" << fname << "'" << endl;
+    }
+    
+    // Apply auto-tuning to some of the settings.
+    void StencilContext::run_auto_tuner_now(bool verbose) {
+        if (!rank_bb.bb_valid)
+            THROW_YASK_EXCEPTION("Error: tune_settings() called without calling prepare_solution() first");
+
+        ostream& os = get_ostr();
+        os << "Auto-tuning...\n" << flush;
+        YaskTimer at_timer;
+        at_timer.start();
 
         // Temporarily disable halo exchange to tune intra-rank.
         enable_halo_exchange = false;
@@ -962,7 +2101,7 @@ namespace yask {
         idx_t step_t = min(region_steps, _at.max_step_t);
         
         // Run time-steps until AT converges.
-        bool done = false;
+        bool done = _at.is_done();
         for (idx_t t = 0; !done; t += step_t) {
 
             // Run step_t time-step(s).
@@ -983,7 +2122,9 @@ namespace yask {
         os << "Auto-tuner done after " << steps_done << " step(s) in " <<
             at_timer.get_elapsed_secs() << " secs.\n";
         os << "best-block-size: " << _opts->_block_sizes.makeDimValStr(" * ") << endl << flush;
-        os << "best-sub-block-size: " << _opts->_sub_block_sizes.makeDimValStr(" * ") << endl << flush;
+        os << "best-sub-block-size: " << _opts->_sub_block_sizes.makeDimValStr(" * ") << endl;
+        os << "best-region-size: " << _opts->_region_sizes.makeDimValStr(" * ") << endl;
+        os << "best-block-threads: " << _opts->num_block_threads << endl << flush;
 
         // Reset stats.
         clear_timers();
@@ -1030,11 +2171,9 @@ namespace yask {
             // i: index for stencil dims, j: index for domain dims.
             for (int i = 0, j = 0; i < nsdims; i++) {
                 if (i != step_posn) {
-                    auto& dim = dims->_stencil_dims.getDim(i);
-                    auto& dname = dim.getName();
 
                     // Is this dim used in this grid?
-                    int posn = gp->get_dim_posn(dname);
+                    int posn = gp->get_dim_id_posn(i);
                     if (posn >= 0) {
 
                         // | ... |        +------+       |
@@ -1080,6 +2219,9 @@ namespace yask {
         // Calc and report perf.
         double rtime = run_time.get_elapsed_secs();
         double mtime = mpi_time.get_elapsed_secs();
+        double otime = overlap_time.get_elapsed_secs();
+        double wtime = halo_wait_time.get_elapsed_secs();
+        double oeff = (otime + wtime > 0.) ? otime / (otime + wtime) : 0.;
         if (rtime > 0.) {
             domain_pts_ps = double(tot_domain_1t * steps_done) / rtime;
             writes_ps= double(tot_numWrites_1t * steps_done) / rtime;
@@ -1087,6 +2229,43 @@ namespace yask {
         }
         else
             domain_pts_ps = writes_ps = flops = 0.;
+
+        // Bundle times are summed over the region threads, so they are
+        // divided by the number of them.
+        int rthreads = max(_opts->max_threads / _opts->thread_divisor, 1);
+        rthreads = max(rthreads / _opts->num_block_threads, 1);
+
+        // Hardware event counts of each bundle, including its scratch
+        // bundles, in pack order and summed over the ranks.
+        const int nev = PerfCounters::perf_num_events;
+        vector<idx_t> bcounts;
+        for (auto& bp : stPacks)
+            for (auto* sb : *bp)
+                for (int ev = 0; ev < nev; ev++) {
+                    uint64_t n = 0;
+                    for (auto* rsb : sb->get_reqd_bundles())
+                        n += rsb->get_perf_count(ev);
+                    if (ev == PerfCounters::perf_dram_lines)
+                        n *= CACHELINE_BYTES;
+                    bcounts.push_back(idx_t(n));
+                }
+#ifdef USE_MPI
+        if (bcounts.size())
+            MPI_Allreduce(MPI_IN_PLACE, bcounts.data(), int(bcounts.size()),
+                          MPI_LONG_LONG, MPI_SUM, _env->comm);
+#endif
+        vector<idx_t> ccounts(nev, 0);
+        for (size_t i = 0; i < bcounts.size(); i++)
+            ccounts[i % nev] += bcounts[i];
+        bool have_counts = ccounts[PerfCounters::perf_cycles] > 0;
+        idx_t dram_bytes = ccounts[PerfCounters::perf_dram_lines];
+        if (have_counts && rtime > 0. && dram_bytes > 0) {
+            mem_bw = double(dram_bytes) / rtime;
+            arith_intensity = double(tot_numFpOps_1t * steps_done) / double(dram_bytes);
+        }
+        else
+            mem_bw = arith_intensity = 0.;
+
         if (steps_done > 0) {
             os <<
                 "num-points-per-step:               " << makeNumStr(tot_domain_1t) << endl <<
@@ -1099,11 +2278,54 @@ namespace yask {
                 "time in halo exch (sec):           " << makeNumStr(mtime);
             float pct = 100. * mtime / rtime;
             os << " (" << pct << "%)" << endl;
+            if (otime > 0.)
+                os <<
+                    "halo-overlap efficiency:           " << (100. * oeff) << "%" << endl;
 #endif
             os <<
                 "throughput (num-writes/sec):       " << makeNumStr(writes_ps) << endl <<
                 "throughput (est-FLOPS):            " << makeNumStr(flops) << endl <<
                 "throughput (num-points/sec):       " << makeNumStr(domain_pts_ps) << endl;
+            if (attainable_pts_ps > 0.)
+                os <<
+                    "attainable (num-points/sec):       " << makeNumStr(attainable_pts_ps) << endl <<
+                    "pct-of-attainable:                 " <<
+                    (100. * domain_pts_ps / attainable_pts_ps) << "%" << endl;
+            if (have_counts) {
+                os <<
+                    "est-mem-bw (bytes/sec):            " << makeNumStr(mem_bw) << endl <<
+                    "est-arith-intensity (FLOPs/byte):  " << arith_intensity << endl <<
+                    "L2-misses-per-point:               " <<
+                    (double(ccounts[PerfCounters::perf_l2_misses]) /
+                     max(double(tot_domain_1t * steps_done), 1.)) << endl <<
+                    "instructions-per-cycle:            " <<
+                    (double(ccounts[PerfCounters::perf_instrs]) /
+                     double(ccounts[PerfCounters::perf_cycles])) << endl;
+
+                // Same per bundle, using the bundle's share of the
+                // compute time and its own FP ops.
+                size_t bi = 0;
+                for (auto& bp : stPacks)
+                    for (auto* sb : *bp) {
+                        double btime = 0., stime = 0.;
+                        sb->get_thread_secs(btime, stime);
+                        btime /= rthreads;
+                        idx_t fpops1 = 0;
+                        for (auto* rsb : sb->get_reqd_bundles())
+                            fpops1 += rsb->get_scalar_fp_ops();
+                        idx_t fpops = sumOverRanks(fpops1 * sb->bb_num_points, _env->comm) *
+                            steps_done;
+                        idx_t bbytes = bcounts[bi + PerfCounters::perf_dram_lines];
+                        os << " bundle '" << bp->get_name() << "/" << sb->get_name() << "': " <<
+                            "est-mem-bw " << makeNumStr(btime > 0. ? bbytes / btime : 0.) <<
+                            "B/sec, est-arith-intensity " <<
+                            (bbytes > 0 ? double(fpops) / double(bbytes) : 0.) << " FLOPs/byte\n";
+                        bi += nev;
+                    }
+            }
+            print_rank_stats(rtime - mtime, mtime,
+                             max(halo_finish_time.get_elapsed_secs() -
+                                 halo_unpack_time.get_elapsed_secs(), 0.));
         }
 
         // Fill in return object.
@@ -1114,6 +2336,51 @@ namespace yask {
         p->nsteps = steps_done;
         p->run_time = rtime;
         p->mpi_time = mtime;
+        p->overlap_eff = oeff;
+
+        // Timer tree.
+        p->add_timer("run", rtime);
+        p->add_timer("run/compute", 0.);
+        double ctime = 0.;
+        size_t bi = 0;
+        if (have_counts)
+            p->counters["run/compute"] = ccounts;
+        for (auto& bp : stPacks) {
+            string pname = "run/compute/" + bp->get_name();
+            p->add_timer(pname, 0.);
+            double ptime = 0.;
+            vector<idx_t> pcounts(nev, 0);
+            for (auto* sb : *bp) {
+                double btime = 0., stime = 0.;
+                sb->get_thread_secs(btime, stime);
+                btime /= rthreads;
+                stime /= rthreads;
+                string bname = pname + "/" + sb->get_name();
+                p->add_timer(bname, btime);
+                if (sb->get_scratch_children().size())
+                    p->add_timer(bname + "/scratch", stime);
+                ptime += btime;
+                vector<idx_t> bc(bcounts.begin() + bi, bcounts.begin() + bi + nev);
+                for (int ev = 0; ev < nev; ev++)
+                    pcounts[ev] += bc[ev];
+                if (have_counts)
+                    p->counters[bname] = bc;
+                bi += nev;
+            }
+            p->timer_secs[pname] = ptime;
+            if (have_counts)
+                p->counters[pname] = pcounts;
+            ctime += ptime;
+        }
+        p->timer_secs["run/compute"] = ctime;
+#ifdef USE_MPI
+        double ftime = halo_finish_time.get_elapsed_secs();
+        double utime = halo_unpack_time.get_elapsed_secs();
+        p->add_timer("run/halo", mtime);
+        p->add_timer("run/halo/pack", halo_pack_time.get_elapsed_secs());
+        p->add_timer("run/halo/wait", max(ftime - utime, 0.));
+        p->add_timer("run/halo/unpack", utime);
+#endif
 
         // Clear counters.
         clear_timers();
@@ -1121,6 +2388,184 @@ namespace yask {
         return p;
     }
     
+    void StencilContext::print_rank_stats(double ctime, double htime, double wtime) {
+#ifdef USE_MPI
+        int nranks = _env->num_ranks;
+        if (nranks < 2)
+            return;
+        ostream& os = get_ostr();
+        auto& mi = *_mpiInfo;
+
+        // Gather the values of all ranks.
+        enum { stat_comp, stat_halo, stat_wait, stat_bytes, stat_msgs, nstats };
+        const char* names[nstats] = { "compute-time (sec):  ",
+                                      "halo-time (sec):     ",
+                                      "halo-wait-time (sec):",
+                                      "halo-bytes-sent:     ",
+                                      "halo-msgs-sent:      " };
+        double mine[nstats] = { ctime, htime, wtime, 0., 0. };
+        for (int ni = 0; ni < mi.neighborhood_size; ni++) {
+            mine[stat_bytes] += mi.send_bytes[ni];
+            mine[stat_msgs] += mi.send_msgs[ni];
+        }
+        vector<double> all(nstats * nranks);
+        MPI_Allgather(mine, nstats, MPI_DOUBLE, all.data(), nstats, MPI_DOUBLE, _env->comm);
+        auto val = [&](int r, int si) { return all[r * nstats + si]; };
+
+        os << "per-rank stats over " << nranks << " ranks:\n";
+        for (int si = 0; si < nstats; si++) {
+            int rmin = 0, rmax = 0;
+            double sum = 0.;
+            for (int r = 0; r < nranks; r++) {
+                sum += val(r, si);
+                if (val(r, si) < val(rmin, si))
+                    rmin = r;
+                if (val(r, si) > val(rmax, si))
+                    rmax = r;
+            }
+            os << " " << names[si] << " min " << makeNumStr(val(rmin, si)) <<
+                " (rank " << rmin << "), avg " << makeNumStr(sum / nranks) <<
+                ", max " << makeNumStr(val(rmax, si)) << " (rank " << rmax << ")\n";
+            if (si == stat_comp && sum > 0.)
+                os << " compute-imbalance (max/avg): " << (val(rmax, si) * nranks / sum) << endl;
+        }
+
+        // Slowest ranks by compute time.
+        const int nslow = min(nranks, 3);
+        vector<int> order(nranks);
+        for (int r = 0; r < nranks; r++)
+            order[r] = r;
+        partial_sort(order.begin(), order.begin() + nslow, order.end(),
+                     [&](int a, int b) { return val(a, stat_comp) > val(b, stat_comp); });
+        os << " slowest ranks by compute-time:";
+        for (int i = 0; i < nslow; i++) {
+            int r = order[i];
+            os << (i ? "," : "") << " rank " << r << " (" << makeNumStr(val(r, stat_comp)) <<
+                " sec compute, " << makeNumStr(val(r, stat_wait)) << " sec halo-wait)";
+        }
+        os << endl;
+
+        // Rank-to-rank matrices of bytes and messages.
+        if (!_opts->_rank_stats_file.length())
+            return;
+        vector<double> row(2 * nranks, 0.);
+        for (int ni = 0; ni < mi.neighborhood_size; ni++) {
+            int nr = mi.my_neighbors[ni];
+            if (ni != mi.my_neighbor_index && nr != MPI_PROC_NULL) {
+                row[nr] += mi.send_bytes[ni];
+                row[nranks + nr] += mi.send_msgs[ni];
+            }
+        }
+        bool is_msg_rank = _env->my_rank == _opts->msg_rank;
+        vector<double> mat(is_msg_rank ? 2 * nranks * nranks : 0);
+        MPI_Gather(row.data(), 2 * nranks, MPI_DOUBLE, mat.data(), 2 * nranks, MPI_DOUBLE,
+                   _opts->msg_rank, _env->comm);
+        if (!is_msg_rank)
+            return;
+        ofstream ofs(_opts->_rank_stats_file);
+        if (!ofs) {
+            os << "Warning: cannot write rank stats to '" << _opts->_rank_stats_file << "'.\n";
+            return;
+        }
+        ofs << "rank,compute_secs,halo_secs,halo_wait_secs,halo_bytes_sent,halo_msgs_sent\n";
+        for (int r = 0; r < nranks; r++) {
+            ofs << r;
+            for (int si = 0; si < nstats; si++)
+                ofs << "," << val(r, si);
+            ofs << "\n";
+        }
+        const char* mnames[2] = { "bytes_sent", "msgs_sent" };
+        for (int k = 0; k < 2; k++) {
+            ofs << "\n" << mnames[k] << "_from\\to";
+            for (int r = 0; r < nranks; r++)
+                ofs << "," << r;
+            ofs << "\n";
+            for (int r = 0; r < nranks; r++) {
+                ofs << r;
+                for (int r2 = 0; r2 < nranks; r2++)
+                    ofs << "," << mat[r * 2 * nranks + k * nranks + r2];
+                ofs << "\n";
+            }
+        }
+        os << "Wrote per-rank stats to '" << _opts->_rank_stats_file << "'.\n";
+#endif
+    }
+
+    void StencilContext::clear_timers() {
+        run_time.clear();
+        mpi_time.clear();
+        overlap_time.clear();
+        halo_wait_time.clear();
+        halo_pack_time.clear();
+        halo_unpack_time.clear();
+        halo_finish_time.clear();
+        steps_done = 0;
+        if (_mpiInfo) {
+            fill(_mpiInfo->send_bytes.begin(), _mpiInfo->send_bytes.end(), 0);
+            fill(_mpiInfo->send_msgs.begin(), _mpiInfo->send_msgs.end(), 0);
+        }
+
+        // Region-thread indices are less than the max threads.
+        for (auto* sb : stBundles)
+            sb->clear_timers(max(_opts->max_threads, 1));
+    }
+
+    double Stats::get_timer_secs(const string& name) {
+        auto i = timer_secs.find(name);
+        if (i == timer_secs.end())
+            THROW_YASK_EXCEPTION("Error: get_timer_secs(): unknown timer '" + name + "'");
+        return i->second;
+    }
+
+    vector<string> Stats::get_counter_names() {
+        vector<string> names;
+        if (counters.size())
+            for (int ev = 0; ev < PerfCounters::perf_num_events; ev++)
+                names.push_back(PerfCounters::get_name(ev));
+        return names;
+    }
+
+    idx_t Stats::get_counter(const string& event,
+                             const string& timer_name) {
+        auto i = counters.find(timer_name);
+        if (i == counters.end())
+            THROW_YASK_EXCEPTION("Error: get_counter(): no counts for timer '" +
+                                 timer_name + "'");
+        for (int ev = 0; ev < PerfCounters::perf_num_events; ev++)
+            if (event == PerfCounters::get_name(ev))
+                return i->second[ev];
+        THROW_YASK_EXCEPTION("Error: get_counter(): unknown event '" + event + "'");
+    }
+
+    // Timers are listed in pre-order, so the children of each node
+    // follow it.
+    string Stats::get_timers_json() {
+        ostringstream oss;
+        function<size_t (size_t)> write_node = [&](size_t i) {
+            auto& name = timer_names[i];
+            oss << "{\"name\": \"" << name.substr(name.rfind('/') + 1) <<
+                "\", \"secs\": " << timer_secs[name];
+            string prefix = name + "/";
+            size_t j = i + 1;
+            bool first = true;
+            while (j < timer_names.size() &&
+                   timer_names[j].compare(0, prefix.length(), prefix) == 0) {
+                oss << (first ? ", \"children\": [" : ", ");
+                first = false;
+                j = write_node(j);
+            }
+            if (!first)
+                oss << "]";
+            oss << "}";
+            return j;
+        };
+        if (timer_names.size())
+            write_node(0);
+        else
+            oss << "{}";
+        return oss.str();
+    }
+
     // Compare grids in contexts.
     // Return number of mis-compares.
     idx_t StencilContext::compareData(const StencilContext& ref) const {
@@ -1140,8 +2585,72 @@ namespace yask {
         return errs;
     }
 
+    // Compare grids in a domain box.
+    idx_t StencilContext::compareData(const StencilContext& ref,
+                                      const IdxTuple& first,
+                                      const IdxTuple& last) const {
+        ostream& os = get_ostr();
+
+        os << "Comparing grid(s) in '" << name << "' to '" << ref.name <<
+            "' from " << first.makeDimValStr() << " to " << last.makeDimValStr() << "..." << endl;
+        if (gridPtrs.size() != ref.gridPtrs.size()) {
+            cerr << "** number of grids not equal." << endl;
+            return 1;
+        }
+        idx_t errs = 0;
+        for (size_t gi = 0; gi < gridPtrs.size(); gi++) {
+            auto gp = gridPtrs[gi];
+            TRACE_MSG("Grid '" << gp->get_name() << "'...");
+
+            // Use the box in domain dims and everything in other dims.
+            int nd = gp->get_num_dims();
+            Indices firstv(nd), lastv(nd);
+            for (int i = 0; i < nd; i++) {
+                auto& dname = gp->get_dim_name(i);
+                if (first.lookup(dname)) {
+                    firstv[i] = first[dname];
+                    lastv[i] = last[dname];
+                } else {
+                    firstv[i] = gp->_get_first_alloc_index(i);
+                    lastv[i] = gp->_get_last_alloc_index(i);
+                }
+            }
+            errs += gp->compare_slice(ref.gridPtrs[gi].get(), firstv, lastv);
+        }
+
+        return errs;
+    }
+
+    // Copy the overlapping parts of all grids to 'dst'.
+    void StencilContext::copyData(StencilContext& dst) const {
+        if (gridPtrs.size() != dst.gridPtrs.size())
+            THROW_YASK_EXCEPTION("Error: copyData(): number of grids not equal");
+        for (size_t gi = 0; gi < gridPtrs.size(); gi++) {
+            auto sp = gridPtrs[gi];
+            auto dp = dst.gridPtrs[gi];
+            if (!sp->is_storage_allocated() || !dp->is_storage_allocated())
+                continue;
+
+            // Intersection of the allocations.
+            int nd = sp->get_num_dims();
+            Indices first(nd), last(nd);
+            idx_t npts = 1;
+            for (int i = 0; i < nd; i++) {
+                first[i] = max(sp->_get_first_alloc_index(i), dp->_get_first_alloc_index(i));
+                last[i] = min(sp->_get_last_alloc_index(i), dp->_get_last_alloc_index(i));
+                npts *= max(last[i] - first[i] + 1, idx_t(0));
+            }
+            if (npts <= 0)
+                continue;
+
+            vector<real_t> buf(npts);
+            sp->get_elements_in_slice(buf.data(), first, last);
+            dp->set_elements_in_slice(buf.data(), first, last);
+        }
+    }
+
     // Exchange dirty halo data for all grids and all steps.
-    void StencilContext::exchange_halos_all() {
+    void StencilContext::exchange_halos_all(bool overlap, const GridPtrs* grids) {
 
 #ifdef USE_MPI
         TRACE_MSG("exchange_halos_all()...");
@@ -1156,277 +2665,536 @@ namespace yask {
             }
         }
         
-        exchange_halos(nullptr, start, stop);
+        exchange_halos(nullptr, start, stop, overlap, grids);
 #endif
     }
     
     // Exchange halo data needed by bundle pack 'sel_bp' at the given time.
     // If sg==null, check all packs.
     // Data is needed for input grids that have not already been updated.
-    // [BIG] TODO: overlap halo exchange with computation.
+    // If 'overlap' is set, the exchange for the last step is left in
+    // progress; it will be completed by the next call to this function
+    // or to complete_halo_exchange().
     void StencilContext::exchange_halos(const BundlePackPtr& sel_bp,
-                                        idx_t start, idx_t stop)
+                                        idx_t start, idx_t stop,
+                                        bool overlap,
+                                        const GridPtrs* grids)
     {
 #ifdef USE_MPI
         if (!enable_halo_exchange || _env->num_ranks < 2)
             return;
 
+        // Finish any exchange started previously.
+        complete_halo_exchange();
+
         mpi_time.start();
         TRACE_MSG("exchange_halos: " << start << " ... (end before) " << stop);
-        auto opts = get_settings();
-        auto& sd = _dims->_step_dim;
+
+        // Get list of grids that may need to be swapped.
+        // Use an ordered map to make sure grids are in
+        // same order on all ranks.
+        GridPtrMap gridsToCheck;
+
+        // Only the given grids.
+        if (grids) {
+            for (auto gp : *grids) {
+                if (!gp->is_scratch() && mpiData.count(gp->get_name()))
+                    gridsToCheck[gp->get_name()] = gp;
+            }
+        }
+
+        // Loop thru all bundle packs.
+        else for (auto& bp : stPacks) {
+
+            // Not selected bundle pack?
+            if (sel_bp && sel_bp != bp)
+                continue;
+            
+            // Loop thru stencil bundles in this pack.
+            for (auto* sg : *bp) {
+
+                // Find the bundles that need to be processed.
+                // This will be any prerequisite scratch-grid
+                // bundles plus this non-scratch bundle.
+                // We need to loop thru the scratch-grid
+                // bundles so we can consider the inputs
+                // to them for exchanges.
+                auto sg_list = sg->get_reqd_bundles();
+
+                // Loop through all the needed bundles.
+                for (auto* csg : sg_list) {
+
+                    TRACE_MSG("exchange_halos: checking " << csg->inputGridPtrs.size() <<
+                              " input grid(s) to bundle '" << csg->get_name() <<
+                              "' that is needed for bundle '" << sg->get_name() << "'");
+
+                    // Loop thru all *input* grids in this bundle.
+                    for (auto gp : csg->inputGridPtrs) {
+
+                        // Don't swap scratch grids.
+                        if (gp->is_scratch())
+                            continue;
+                    
+                        // Only need to swap grids that have any MPI buffers.
+                        auto& gname = gp->get_name();
+                        if (mpiData.count(gname) == 0)
+                            continue;
+
+                        gridsToCheck[gname] = gp;
+                    }
+                } // needed bundles.
+            } // bundles in pack.
+        } // packs.
 
         // Loop through steps.  This loop has to be outside halo-step loop
-        // because we only have one buffer per step. Normally, we only
-        // exchange one step; in that case, it doesn't matter. It would be
-        // more efficient to allow packing and unpacking multiple steps,
-        // esp. with WFs.  TODO: this will need to be addressed if/when
-        // comm/compute overlap is added.
+        // because we only have one buffer per grid per neighbor. Normally,
+        // we only exchange one step. With WFs, the buffers may hold
+        // several steps, and consecutive dirty steps are exchanged
+        // together.
         assert(start != stop);
         idx_t step = (start < stop) ? 1 : -1;
         for (idx_t t = start; t != stop; t += step) {
 
-            // Get list of grids that need to be swapped.
-            // Use an ordered map to make sure grids are in
-            // same order on all ranks.
-            GridPtrMap gridsToSwap;
+            // Find grids whose halos are not up-to-date for this step.
+            HaloSwapMap swaps;
+            for (auto gtci : gridsToCheck) {
+                auto& gname = gtci.first;
+                auto gp = gtci.second;
+                if (!gp->is_dirty(t))
+                    continue;
 
-            // Loop thru all bundle packs.
-            for (auto& bp : stPacks) {
+                // Already being exchanged?
+                if (halo_pending && halo_pending_swaps.count(gname)) {
+                    auto& ps = halo_pending_swaps.at(gname);
+                    if (t >= ps.first_t && t < ps.first_t + ps.num_t)
+                        continue;
+                }
 
-                // Not selected bundle pack?
-                if (sel_bp && sel_bp != bp)
-                    continue;
-            
-                // Loop thru stencil bundles in this pack.
-                for (auto* sg : *bp) {
-
-                    // Find the bundles that need to be processed.
-                    // This will be any prerequisite scratch-grid
-                    // bundles plus this non-scratch bundle.
-                    // We need to loop thru the scratch-grid
-                    // bundles so we can consider the inputs
-                    // to them for exchanges.
-                    auto sg_list = sg->get_reqd_bundles();
-
-                    // Loop through all the needed bundles.
-                    for (auto* csg : sg_list) {
-
-                        TRACE_MSG("exchange_halos: checking " << csg->inputGridPtrs.size() <<
-                                  " input grid(s) to bundle '" << csg->get_name() <<
-                                  "' that is needed for bundle '" << sg->get_name() << "'");
-
-                        // Loop thru all *input* grids in this bundle.
-                        for (auto gp : csg->inputGridPtrs) {
-
-                            // Don't swap scratch grids.
-                            if (gp->is_scratch())
-                                continue;
-                    
-                            // Only need to swap grids whose halos are not up-to-date
-                            // for this step.
-                            if (!gp->is_dirty(t))
-                                continue;
-
-                            // Only need to swap grids that have any MPI buffers.
-                            auto& gname = gp->get_name();
-                            if (mpiData.count(gname) == 0)
-                                continue;
-
-                            // Swap this grid.
-                            gridsToSwap[gname] = gp;
-                        }
-                    } // needed bundles.
-                } // bundles in pack.
-            } // packs.
+                // Add consecutive dirty steps that fit in the buffers.
+                idx_t max_steps = mpiData.at(gname).max_steps;
+                idx_t n = 1;
+                while (n < max_steps) {
+                    idx_t t2 = t + n * step;
+                    if (t2 == stop || !gp->is_dirty(t2))
+                        break;
+                    n++;
+                }
+                HaloSwap& hs = swaps[gname];
+                hs.gp = gp;
+                hs.first_t = (step > 0) ? t : t - n + 1;
+                hs.num_t = n;
+
+                // Skip faces that are clean in all the steps.
+                size_t nfaces = _mpiInfo->neighborhood_size * MPIBufs::nBufDirs;
+                hs.faces.assign(nfaces, false);
+                for (idx_t i = 0; i < n; i++)
+                    for (size_t fi = 0; fi < nfaces; fi++)
+                        if (gp->is_face_dirty(hs.first_t + i, fi))
+                            hs.faces[fi] = true;
+            }
             TRACE_MSG("exchange_halos: need to exchange halos for " <<
-                      gridsToSwap.size() << " grid(s)");
+                      swaps.size() << " grid(s) at step " << t);
+            if (swaps.size() == 0)
+                continue;
 
-            // 1D array to store send request handles.
-            // We use a 1D array so we can call MPI_Waitall().
-            MPI_Request send_reqs[gridsToSwap.size() * _mpiInfo->neighborhood_size];
-            
-            // 2D array for receive request handles.
-            // We use a 2D array to simplify individual indexing.
-            MPI_Request recv_reqs[gridsToSwap.size()][_mpiInfo->neighborhood_size];
-
-            // Sequence of things to do for each grid's neighbors
-            // (isend includes packing).
-            int num_send_reqs = 0;
-            int num_recv_reqs = 0;
-            enum halo_steps { halo_irecv, halo_pack_isend, halo_unpack, halo_nsteps };
-            for (int halo_step = 0; halo_step < halo_nsteps; halo_step++) {
-
-                if (halo_step == halo_irecv)
-                    TRACE_MSG("exchange_halos: requesting data for step " << t << "...");
-                else if (halo_step == halo_pack_isend)
-                    TRACE_MSG("exchange_halos: packing and sending data for step " << t << "...");
-                else if (halo_step == halo_unpack)
-                    TRACE_MSG("exchange_halos: unpacking data for step " << t << "...");
-
-                // Loop thru all grids to swap.
-                // Use 'gi' as a unique MPI index.
-                int gi = -1;
-                for (auto gtsi : gridsToSwap) {
-                    auto& gname = gtsi.first;
-                    auto gp = gtsi.second;
-                    gi++;
-                    MPI_Request* grid_recv_reqs = recv_reqs[gi];
-                    TRACE_MSG(" for grid #" << gi << ", '" << gname << "'...");
-
-                    // Visit all this rank's neighbors.
-                    auto& grid_mpi_data = mpiData.at(gname);
-                    grid_mpi_data.visitNeighbors
-                        ([&](const IdxTuple& offsets, // NeighborOffset.
-                             int neighbor_rank,
-                             int ni, // unique neighbor index.
-                             MPIBufs& bufs) {
-                            auto& sendBuf = bufs.bufs[MPIBufs::bufSend];
-                            auto& recvBuf = bufs.bufs[MPIBufs::bufRecv];
-                            TRACE_MSG("  with rank " << neighbor_rank << " at relative position " <<
-                                      offsets.subElements(1).makeDimValOffsetStr() << "...");
-
-                            // Submit async request to receive data from neighbor.
-                            if (halo_step == halo_irecv) {
-                                auto nbytes = recvBuf.get_bytes();
-                                if (nbytes) {
-                                    void* buf = (void*)recvBuf._elems;
-                                    TRACE_MSG("   requesting " << makeByteStr(nbytes) << "...");
-                                    MPI_Irecv(buf, nbytes, MPI_BYTE,
-                                              neighbor_rank, int(gi), _env->comm, &grid_recv_reqs[ni]);
-                                    num_recv_reqs++;
-                                }
-                                else
-                                    TRACE_MSG("   0B to request");
-                            }
+            // Only one exchange can be in progress because there is only
+            // one set of buffers, so finish one from a previous step.
+            if (halo_pending)
+                finish_halo_exchange();
 
-                            // Pack data into send buffer, then send to neighbor.
-                            else if (halo_step == halo_pack_isend) {
-                                auto nbytes = sendBuf.get_bytes();
-                                if (nbytes) {
-
-                                    // Vec ok?
-                                    // Domain sizes must be ok, and buffer size must be ok
-                                    // as calculated when buffers were created.
-                                    bool send_vec_ok = allow_vec_exchange && sendBuf.vec_copy_ok;
-
-                                    // Get first and last ranges.
-                                    IdxTuple first = sendBuf.begin_pt;
-                                    IdxTuple last = sendBuf.last_pt;
-
-                                    // The code in allocMpiData() pre-calculated the first and
-                                    // last points of each buffer, except in the step dim.
-                                    // So, we need to set that value now.
-                                    // TODO: update this if we expand the buffers to hold
-                                    // more than one step.
-                                    if (gp->is_dim_used(sd)) {
-                                        first.setVal(sd, t);
-                                        last.setVal(sd, t);
-                                    }
-                                    TRACE_MSG("   packing " << sendBuf.num_pts.makeDimValStr(" * ") <<
-                                              " points from " << first.makeDimValStr() <<
-                                              " ... " << last.makeDimValStr() <<
-                                              (send_vec_ok ? " with" : " without") <<
-                                              " vector copy...");
-
-                                    // Copy (pack) data from grid to buffer.
-                                    void* buf = (void*)sendBuf._elems;
-                                    if (send_vec_ok)
-                                        gp->get_vecs_in_slice(buf, first, last);
-                                    else
-                                        gp->get_elements_in_slice(buf, first, last);
-
-                                    // Send packed buffer to neighbor.
-                                    auto nbytes = sendBuf.get_bytes();
-                                    TRACE_MSG("   sending " << makeByteStr(nbytes) << "...");
-                                    MPI_Isend(buf, nbytes, MPI_BYTE,
-                                              neighbor_rank, int(gi), _env->comm,
-                                              &send_reqs[num_send_reqs++]);
-                                }
-                                else
-                                    TRACE_MSG("   0B to send");
+            // Send and receive the halos.
+            start_halo_exchange(swaps);
+            if (!overlap)
+                finish_halo_exchange();
+        } // steps.
+
+        // Start measuring how long the exchange stays in flight.
+        if (halo_pending) {
+            TRACE_MSG("exchange_halos: leaving exchange in progress");
+            overlap_time.start();
+        }
+        mpi_time.stop();
+#endif
+    }
+
+    // Complete an exchange that was left in progress by exchange_halos().
+    void StencilContext::complete_halo_exchange() {
+#ifdef USE_MPI
+        if (!halo_pending)
+            return;
+        overlap_time.stop();
+        mpi_time.start();
+        halo_wait_time.start();
+        finish_halo_exchange();
+        halo_wait_time.stop();
+        mpi_time.stop();
+#endif
+    }
+
+    // Post the receives, then pack and send the halos in 'swaps'.  The
+    // exchange is then pending until finish_halo_exchange() is called.
+    void StencilContext::start_halo_exchange(const HaloSwapMap& swaps) {
+#ifdef USE_MPI
+        assert(!halo_pending);
+        auto& sd = _dims->_step_dim;
+        static const int halo_pack_trace_id = EventTrace::get_id("halo pack");
+
+        // If aggregating, all grids' data for a neighbor are packed into
+        // one buffer, and one message is sent to each neighbor.  With a
+        // neighborhood collective, the aggregated buffers for all
+        // neighbors are exchanged in one call after packing.
+        bool agg = !!aggMpiData;
+        bool nbr = agg && halo_nbr_comm != MPI_COMM_NULL;
+        bool pers = _opts->persistent_halos;
+        vector<size_t> send_ofs(_mpiInfo->neighborhood_size, 0);
+        vector<size_t> recv_bytes(_mpiInfo->neighborhood_size, 0);
+        if (agg) {
+            TRACE_MSG("exchange_halos: requesting aggregated data...");
+            aggMpiData->visitNeighbors
+                ([&](const IdxTuple& offsets, // NeighborOffset.
+                     int neighbor_rank,
+                     int ni, // unique neighbor index.
+                     MPIBufs& bufs) {
+                    size_t nbytes = 0;
+                    for (auto hsi : swaps) {
+                        auto& recvBuf = mpiData.at(hsi.first).bufs[ni].bufs[MPIBufs::bufRecv];
+                        if (recvBuf.get_size() && hsi.second.has_face(ni, MPIBufs::bufRecv))
+                            nbytes += ROUND_UP(recvBuf.get_bytes(hsi.second.num_t), CACHELINE_BYTES);
+                    }
+                    recv_bytes[ni] = nbytes;
+                    if (nbytes && !nbr) {
+                        auto& recvBuf = bufs.bufs[MPIBufs::bufRecv];
+                        TRACE_MSG("  requesting " << makeByteStr(nbytes) <<
+                                  " from rank " << neighbor_rank << "...");
+                        aggMpiData->start_recv((void*)recvBuf._elems,
+                                               pers ? recvBuf.get_bytes() : nbytes,
+                                               neighbor_rank, ni, _env->comm, pers);
+                    }
+                });
+        }
+
+        // Sequence of things to do for each grid's neighbors
+        // (isend includes packing).
+        enum halo_steps { halo_irecv, halo_pack_isend, halo_nsteps };
+        for (int halo_step = 0; halo_step < halo_nsteps; halo_step++) {
+
+            if (halo_step == halo_irecv)
+                TRACE_MSG("exchange_halos: requesting data...");
+            else if (halo_step == halo_pack_isend)
+                TRACE_MSG("exchange_halos: packing and sending data...");
+
+            // Loop thru all grids to swap.
+            // Each grid's MPI tag is set in allocMpiData().
+            for (auto hsi : swaps) {
+                auto& gname = hsi.first;
+                auto& hs = hsi.second;
+                auto gp = hs.gp;
+                TRACE_MSG(" for grid '" << gname << "' at step(s) " <<
+                          hs.first_t << " ... " << (hs.first_t + hs.num_t - 1) << "...");
+
+                // Visit all this rank's neighbors.
+                auto& grid_mpi_data = mpiData.at(gname);
+                grid_mpi_data.visitNeighbors
+                    ([&](const IdxTuple& offsets, // NeighborOffset.
+                         int neighbor_rank,
+                         int ni, // unique neighbor index.
+                         MPIBufs& bufs) {
+                        auto& sendBuf = bufs.bufs[MPIBufs::bufSend];
+                        auto& recvBuf = bufs.bufs[MPIBufs::bufRecv];
+                        TRACE_MSG("  with rank " << neighbor_rank << " at relative position " <<
+                                  offsets.subElements(1).makeDimValOffsetStr() << "...");
+
+                        // Submit async request to receive data from neighbor.
+                        // Already done above if aggregating.
+                        if (halo_step == halo_irecv) {
+                            if (agg)
+                                return; // from lambda.
+                            if (recvBuf.get_size() && hs.has_face(ni, MPIBufs::bufRecv)) {
+                                auto nbytes = recvBuf.get_bytes(hs.num_t);
+                                void* buf = (void*)recvBuf._elems;
+                                TRACE_MSG("   requesting " << makeByteStr(nbytes) << "...");
+                                grid_mpi_data.start_recv(buf, pers ? recvBuf.get_bytes() : nbytes,
+                                                         neighbor_rank, ni, _env->comm, pers);
                             }
+                            else
+                                TRACE_MSG("   0B to request");
+                        }
 
-                            // Wait for data from neighbor, then unpack it.
-                            else if (halo_step == halo_unpack) {
-                                auto nbytes = recvBuf.get_bytes();
-                                if (nbytes) {
-
-                                    // Wait for data from neighbor before unpacking it.
-                                    TRACE_MSG("   waiting for " << makeByteStr(nbytes) << "...");
-                                    MPI_Wait(&grid_recv_reqs[ni], MPI_STATUS_IGNORE);
-
-                                    // Vec ok?
-                                    bool recv_vec_ok = allow_vec_exchange && recvBuf.vec_copy_ok;
-
-                                    // Get first and last ranges.
-                                    IdxTuple first = recvBuf.begin_pt;
-                                    IdxTuple last = recvBuf.last_pt;
-
-                                    // Set step val as above.
-                                    if (gp->is_dim_used(sd)) {
-                                        first.setVal(sd, t);
-                                        last.setVal(sd, t);
-                                    }
-                                    TRACE_MSG("   got data; unpacking " << recvBuf.num_pts.makeDimValStr(" * ") <<
-                                              " points into " << first.makeDimValStr() <<
-                                              " ... " << last.makeDimValStr() <<
-                                              (recv_vec_ok ? " with" : " without") <<
-                                              " vector copy...");
-
-                                    // Copy data from buffer to grid.
-                                    void* buf = (void*)recvBuf._elems;
-                                    idx_t n = 0;
-                                    if (recv_vec_ok)
-                                        n = gp->set_vecs_in_slice(buf, first, last);
-                                    else
-                                        n = gp->set_elements_in_slice(buf, first, last);
-                                    assert(n == recvBuf.get_size());
+                        // Pack data into send buffer, then send to neighbor.
+                        else if (halo_step == halo_pack_isend) {
+                            if (sendBuf.get_size() && hs.has_face(ni, MPIBufs::bufSend)) {
+                                auto nbytes = sendBuf.get_bytes(hs.num_t);
+
+                                // Vec ok?
+                                // Domain sizes must be ok, and buffer size must be ok
+                                // as calculated when buffers were created.
+                                bool send_vec_ok = allow_vec_exchange && sendBuf.vec_copy_ok;
+
+                                // Get first and last ranges.
+                                IdxTuple first = sendBuf.begin_pt;
+                                IdxTuple last = sendBuf.last_pt;
+
+                                // The code in allocMpiData() pre-calculated the first and
+                                // last points of each buffer, except in the step dim.
+                                // So, we need to set that value now.
+                                if (gp->is_dim_used(sd)) {
+                                    first.setVal(sd, hs.first_t);
+                                    last.setVal(sd, hs.first_t + hs.num_t - 1);
                                 }
+                                TRACE_MSG("   packing " << sendBuf.num_pts.makeDimValStr(" * ") <<
+                                          " points from " << first.makeDimValStr() <<
+                                          " ... " << last.makeDimValStr() <<
+                                          (send_vec_ok ? " with" : " without") <<
+                                          " vector copy...");
+
+                                // A buffer in shm may still be read by the
+                                // neighbor from the previous exchange.
+                                if (agg)
+                                    aggMpiData->wait_for_send_buf(ni);
+                                else
+                                    grid_mpi_data.wait_for_send_buf(ni);
+
+                                // Copy (pack) data from grid to buffer.
+                                void* buf = (void*)sendBuf._elems;
+                                if (agg)
+                                    buf = (void*)(((char*)aggMpiData->bufs[ni].bufs[MPIBufs::bufSend]._elems) +
+                                                  send_ofs[ni]);
+                                halo_pack_time.start();
+                                EventTrace::begin(halo_pack_trace_id);
+                                if (send_vec_ok)
+                                    gp->get_vecs_in_slice(buf, first, last);
                                 else
-                                    TRACE_MSG("   0B to wait for");
+                                    gp->get_elements_in_slice(buf, first, last);
+                                EventTrace::end(halo_pack_trace_id);
+                                halo_pack_time.stop();
+
+                                // Send later if aggregating.
+                                if (agg) {
+                                    send_ofs[ni] += ROUND_UP(nbytes, CACHELINE_BYTES);
+                                    return; // from lambda.
+                                }
+
+                                // Send packed buffer to neighbor.
+                                TRACE_MSG("   sending " << makeByteStr(nbytes) << "...");
+                                grid_mpi_data.start_send(buf, nbytes,
+                                                         neighbor_rank, ni, _env->comm, pers);
                             }
-                        }); // visit neighbors.
+                            else
+                                TRACE_MSG("   0B to send");
+                        }
+                    }); // visit neighbors.
+
+            } // grids.
+        } // exchange sequence.
+
+        // Exchange all aggregated buffers at once using absolute
+        // addresses as displacements from MPI_BOTTOM.
+        if (nbr) {
+            TRACE_MSG("exchange_halos: exchanging aggregated data with " <<
+                      halo_nbr_idxs.size() << " neighbor(s)...");
+            for (size_t k = 0; k < halo_nbr_idxs.size(); k++) {
+                int ni = halo_nbr_idxs[k];
+                auto& bufs = aggMpiData->bufs[ni].bufs;
+                halo_nbr_scounts[k] = int(send_ofs[ni]);
+                halo_nbr_rcounts[k] = int(recv_bytes[ni]);
+                MPI_Get_address(bufs[MPIBufs::bufSend]._elems, &halo_nbr_sdispls[k]);
+                MPI_Get_address(bufs[MPIBufs::bufRecv]._elems, &halo_nbr_rdispls[k]);
+            }
+            MPI_Ineighbor_alltoallw(MPI_BOTTOM, halo_nbr_scounts.data(),
+                                    halo_nbr_sdispls.data(), halo_nbr_types.data(),
+                                    MPI_BOTTOM, halo_nbr_rcounts.data(),
+                                    halo_nbr_rdispls.data(), halo_nbr_types.data(),
+                                    halo_nbr_comm, &halo_nbr_req);
+        }
 
-                } // grids.
-            } // exchange sequence.
-            
-            // Mark grids as up-to-date.
-            for (auto gtsi : gridsToSwap) {
-                auto& gname = gtsi.first;
-                auto gp = gtsi.second;
-                if (gp->is_dirty(t)) {
-                    gp->set_dirty(false, t);
+        // Send aggregated buffers.
+        else if (agg) {
+            TRACE_MSG("exchange_halos: sending aggregated data...");
+            aggMpiData->visitNeighbors
+                ([&](const IdxTuple& offsets, // NeighborOffset.
+                     int neighbor_rank,
+                     int ni, // unique neighbor index.
+                     MPIBufs& bufs) {
+                    auto nbytes = send_ofs[ni];
+                    if (nbytes) {
+                        void* buf = (void*)bufs.bufs[MPIBufs::bufSend]._elems;
+                        TRACE_MSG("  sending " << makeByteStr(nbytes) <<
+                                  " to rank " << neighbor_rank << "...");
+                        aggMpiData->start_send(buf, nbytes,
+                                               neighbor_rank, ni, _env->comm, pers);
+                    }
+                });
+        }
+
+        halo_pending = true;
+        halo_pending_swaps = swaps;
+#endif
+    }
+
+    // Wait for the data from the pending exchange, unpack it,
+    // and mark the grids as up-to-date.
+    void StencilContext::finish_halo_exchange() {
+#ifdef USE_MPI
+        assert(halo_pending);
+        auto& sd = _dims->_step_dim;
+        TRACE_MSG("exchange_halos: unpacking data...");
+        halo_finish_time.start();
+        static const int halo_wait_trace_id = EventTrace::get_id("halo wait");
+        static const int halo_unpack_trace_id = EventTrace::get_id("halo unpack");
+
+        // If aggregating, wait for all the aggregated messages.
+        // Unused requests are null, so waiting on them is a no-op.
+        bool agg = !!aggMpiData;
+        vector<size_t> recv_ofs(_mpiInfo->neighborhood_size, 0);
+        if (agg) {
+            TRACE_MSG("exchange_halos: waiting for aggregated data...");
+            EventTrace::Scope wait_scope(halo_wait_trace_id);
+            if (halo_nbr_comm != MPI_COMM_NULL)
+                MPI_Wait(&halo_nbr_req, MPI_STATUS_IGNORE);
+            else {
+                MPI_Waitall(int(aggMpiData->recv_reqs.size()),
+                            aggMpiData->recv_reqs.data(),
+                            MPI_STATUSES_IGNORE);
+                aggMpiData->visitNeighbors
+                    ([&](const IdxTuple& offsets, int neighbor_rank, int ni, MPIBufs& bufs) {
+                        aggMpiData->sync_recv_buf(ni);
+                    });
+            }
+        }
+
+        // Wait for data from each neighbor, then unpack it.
+        int num_recv_reqs = 0;
+        for (auto hsi : halo_pending_swaps) {
+            auto& gname = hsi.first;
+            auto& hs = hsi.second;
+            auto gp = hs.gp;
+            TRACE_MSG(" for grid '" << gname << "'...");
+
+            // Visit all this rank's neighbors.
+            auto& grid_mpi_data = mpiData.at(gname);
+            grid_mpi_data.visitNeighbors
+                ([&](const IdxTuple& offsets, // NeighborOffset.
+                     int neighbor_rank,
+                     int ni, // unique neighbor index.
+                     MPIBufs& bufs) {
+                    auto& recvBuf = bufs.bufs[MPIBufs::bufRecv];
+                    TRACE_MSG("  with rank " << neighbor_rank << " at relative position " <<
+                              offsets.subElements(1).makeDimValOffsetStr() << "...");
+                    if (recvBuf.get_size() && hs.has_face(ni, MPIBufs::bufRecv)) {
+                        auto nbytes = recvBuf.get_bytes(hs.num_t);
+
+                        // Wait for data from neighbor before unpacking it.
+                        if (!agg) {
+                            TRACE_MSG("   waiting for " << makeByteStr(nbytes) << "...");
+                            EventTrace::begin(halo_wait_trace_id);
+                            MPI_Wait(&grid_mpi_data.recv_reqs[ni], MPI_STATUS_IGNORE);
+                            EventTrace::end(halo_wait_trace_id);
+                            grid_mpi_data.sync_recv_buf(ni);
+                            num_recv_reqs++;
+                        }
+
+                        // Vec ok?
+                        bool recv_vec_ok = allow_vec_exchange && recvBuf.vec_copy_ok;
+
+                        // Get first and last ranges.
+                        IdxTuple first = recvBuf.begin_pt;
+                        IdxTuple last = recvBuf.last_pt;
+
+                        // Set step vals as in start_halo_exchange().
+                        if (gp->is_dim_used(sd)) {
+                            first.setVal(sd, hs.first_t);
+                            last.setVal(sd, hs.first_t + hs.num_t - 1);
+                        }
+                        TRACE_MSG("   got data; unpacking " << recvBuf.num_pts.makeDimValStr(" * ") <<
+                                  " points into " << first.makeDimValStr() <<
+                                  " ... " << last.makeDimValStr() <<
+                                  (recv_vec_ok ? " with" : " without") <<
+                                  " vector copy...");
+
+                        // Copy data from buffer to grid.
+                        void* buf = (void*)recvBuf._elems;
+                        if (agg) {
+                            buf = (void*)(((char*)aggMpiData->bufs[ni].bufs[MPIBufs::bufRecv]._elems) +
+                                          recv_ofs[ni]);
+                            recv_ofs[ni] += ROUND_UP(nbytes, CACHELINE_BYTES);
+                        }
+                        idx_t n = 0;
+                        halo_unpack_time.start();
+                        EventTrace::begin(halo_unpack_trace_id);
+                        if (recv_vec_ok)
+                            n = gp->set_vecs_in_slice(buf, first, last);
+                        else
+                            n = gp->set_elements_in_slice(buf, first, last);
+                        EventTrace::end(halo_unpack_trace_id);
+                        halo_unpack_time.stop();
+                        assert(n == recvBuf.get_size(hs.num_t));
+
+                        // Let neighbor reuse its buffer if in shm.
+                        if (!agg)
+                            grid_mpi_data.release_recv_buf(neighbor_rank, ni, _env->comm);
+                    }
+                    else
+                        TRACE_MSG("   0B to wait for");
+                }); // visit neighbors.
+        } // grids.
+        if (agg)
+            aggMpiData->visitNeighbors
+                ([&](const IdxTuple& offsets, int neighbor_rank, int ni, MPIBufs& bufs) {
+                    if (recv_ofs[ni])
+                        aggMpiData->release_recv_buf(neighbor_rank, ni, _env->comm);
+                });
+        TRACE_MSG("exchange_halos: " << num_recv_reqs <<
+                  " MPI receive request(s) completed");
+
+        // Mark grids as up-to-date.
+        for (auto hsi : halo_pending_swaps) {
+            auto& gname = hsi.first;
+            auto& hs = hsi.second;
+            for (idx_t t = hs.first_t; t < hs.first_t + hs.num_t; t++) {
+                if (hs.gp->is_dirty(t)) {
+                    hs.gp->set_dirty(false, t);
                     TRACE_MSG("grid '" << gname <<
                               "' marked as clean at step " << t);
                 }
             }
+        }
 
-            // Wait for all send requests to complete.
-            TRACE_MSG("exchange_halos: " << num_recv_reqs <<
-                      " MPI receive request(s) completed");
-            if (num_send_reqs) {
-                TRACE_MSG("exchange_halos: waiting for " << num_send_reqs <<
-                          " MPI send request(s) to complete...");
-                MPI_Waitall(num_send_reqs, send_reqs, MPI_STATUS_IGNORE);
-                TRACE_MSG(" done waiting for MPI send request(s)");
-            }
-            else
-                TRACE_MSG("exchange_halos: no MPI send requests to wait for");
-        } // steps.
-        
-        mpi_time.stop();
+        // Wait for all send requests to complete.
+        // Unused requests are null, so waiting on them is a no-op.
+        TRACE_MSG("exchange_halos: waiting for MPI send request(s) to complete...");
+        EventTrace::begin(halo_wait_trace_id);
+        for (auto hsi : halo_pending_swaps) {
+            auto& grid_mpi_data = mpiData.at(hsi.first);
+            MPI_Waitall(int(grid_mpi_data.send_reqs.size()),
+                        grid_mpi_data.send_reqs.data(),
+                        MPI_STATUSES_IGNORE);
+            MPI_Waitall(int(grid_mpi_data.shm_ack_reqs.size()),
+                        grid_mpi_data.shm_ack_reqs.data(),
+                        MPI_STATUSES_IGNORE);
+        }
+        if (agg) {
+            MPI_Waitall(int(aggMpiData->send_reqs.size()),
+                        aggMpiData->send_reqs.data(),
+                        MPI_STATUSES_IGNORE);
+            MPI_Waitall(int(aggMpiData->shm_ack_reqs.size()),
+                        aggMpiData->shm_ack_reqs.data(),
+                        MPI_STATUSES_IGNORE);
+        }
+        EventTrace::end(halo_wait_trace_id);
+        TRACE_MSG(" done waiting for MPI send request(s)");
+
+        halo_pending = false;
+        halo_pending_swaps.clear();
+        halo_finish_time.stop();
 #endif
     }
 
     // Mark grids that have been written to by bundle pack 'sel_bp'.
-    // TODO: only mark grids that are written to in their halo-read area.
+    // Only the halo faces that each bundle may write are marked.
     // TODO: add index for misc dim(s).
-    // TODO: track sub-domain of grid that is dirty.
     void StencilContext::mark_grids_dirty(const BundlePackPtr& sel_bp,
                                           idx_t start, idx_t stop) {
         idx_t step = (start < stop) ? 1 : -1;
-        GridPtrSet grids_done;
         
         // Stencil bundle packs.
         for (auto& bp : stPacks) {
@@ -1440,19 +3208,132 @@ namespace yask {
                 
                 // Output grids for this bundle.  NB: don't need to mark
                 // scratch grids as dirty because they are never exchanged.
-                for (auto gp : sb->outputGridPtrs) {
-
-                    // Mark this step as dirty if not already done.
+                for (size_t gi = 0; gi < sb->outputGridPtrs.size(); gi++) {
+                    auto gp = sb->outputGridPtrs[gi];
                     for (idx_t t = start; t != stop; t += step) {
-                        if (grids_done.count(gp) == 0) {
+                        if (gi < sb->outputGridFaces.size())
+                            gp->set_dirty_faces(sb->outputGridFaces[gi], t);
+                        else
                             gp->set_dirty(true, t);
-                            TRACE_MSG("grid '" << gp->get_name() << "' marked as dirty at step " << t);
-                            grids_done.insert(gp);
-                        }
+                        TRACE_MSG("grid '" << gp->get_name() << "' marked as dirty at step " << t <<
+                                  " by bundle '" << sb->get_name() << "'");
                     }
                 }
             }
         }
     }
 
+    void StencilContext::find_source_grids() {
+        _source_grids.clear();
+        if (_timing_run)
+            return;
+        for (auto gp : gridPtrs) {
+            if (gp->has_sources()) {
+                gp->prepare_sources();
+                _source_grids.push_back(gp);
+            }
+        }
+    }
+
+    void StencilContext::do_span_work(idx_t t, const Indices& begin,
+                                      const Indices& end) {
+        for (auto gp : _source_grids) {
+            TRACE_MSG("adding sources to grid '" << gp->get_name() << "' at step " << t);
+            gp->inject_sources(t, begin, end);
+            gp->set_dirty(true, t);
+        }
+
+        if (_step_callbacks.empty())
+            return;
+        int nddims = _dims->_domain_dims.getNumDims();
+        vector<idx_t> first(nddims), last(nddims);
+        for (int i = 0; i < nddims; i++) {
+            int posn = Dims::get_domain_dim_id(i);
+            first[i] = begin[posn];
+            last[i] = end[posn] - 1;
+        }
+        for (auto& cb : _step_callbacks) {
+            if (cb.reach)
+                continue;
+            TRACE_MSG("calling step callback at step " << t);
+            cb.fn(t, first, last);
+            for (auto gp : cb.write_grids)
+                gp->set_dirty(true, t);
+        }
+    }
+
+    void StencilContext::do_step_work(idx_t t) {
+        for (auto& cb : _step_callbacks) {
+            if (!cb.reach)
+                continue;
+            exchange_halos_all(false, &cb.read_grids);
+            complete_halo_exchange();
+            int nddims = _dims->_domain_dims.getNumDims();
+            vector<idx_t> first(nddims), last(nddims);
+            for (int i = 0; i < nddims; i++) {
+                first[i] = rank_bb.bb_begin[i];
+                last[i] = rank_bb.bb_end[i] - 1;
+            }
+            TRACE_MSG("calling step callback with reach " << cb.reach <<
+                      " at step " << t);
+            cb.fn(t, first, last);
+            for (auto gp : cb.write_grids)
+                gp->set_dirty(true, t);
+        }
+    }
+
+    void StencilContext::add_reduction_partial(int idx, idx_t step_index,
+                                               double val) {
+#pragma omp critical (yask_reduction)
+        {
+            auto& r = _reductions.at(idx);
+            auto i = r.partials.find(step_index);
+            if (i == r.partials.end())
+                r.partials[step_index] = val;
+            else if (r.op == YkGridBase::reduce_max_abs)
+                i->second = max(i->second, val);
+            else
+                i->second += val;
+        }
+    }
+
+    // Each step t in [start_t, stop_t) writes step t + step_dir.
+    void StencilContext::finish_reductions(idx_t start_t, idx_t stop_t) {
+        if (!_reductions.size() || _timing_run)
+            return;
+        idx_t step_dir = _dims->_step_dir;
+        idx_t nt = abs(stop_t - start_t);
+
+        // Gather the partials with the same MPI op into one buffer.
+        vector<double> sums, maxes;
+        for (auto& r : _reductions) {
+            auto& buf = (r.op == YkGridBase::reduce_max_abs) ? maxes : sums;
+            for (idx_t i = 0; i < nt; i++) {
+                idx_t t = start_t + (i + 1) * step_dir;
+                auto pi = r.partials.find(t);
+                buf.push_back(pi == r.partials.end() ? 0.0 : pi->second);
+            }
+        }
+
+#ifdef USE_MPI
+        if (sums.size())
+            MPI_Allreduce(MPI_IN_PLACE, sums.data(), int(sums.size()),
+                          MPI_DOUBLE, MPI_SUM, _env->comm);
+        if (maxes.size())
+            MPI_Allreduce(MPI_IN_PLACE, maxes.data(), int(maxes.size()),
+                          MPI_DOUBLE, MPI_MAX, _env->comm);
+#endif
+
+        // Save the results.
+        size_t si = 0, mi = 0;
+        for (auto& r : _reductions) {
+            bool is_max = r.op == YkGridBase::reduce_max_abs;
+            for (idx_t i = 0; i < nt; i++) {
+                idx_t t = start_t + (i + 1) * step_dir;
+                r.results[t] = is_max ? maxes[mi++] : sums[si++];
+                r.partials.erase(t);
+            }
+        }
+    }
+
 } // namespace yask.
@@ -50,6 +50,7 @@ namespace yask {
                        StencilContext& context,
                        bool force_full = false);
     };
+    typedef std::vector<BoundingBox> BBList;
 
     // Stats.
     class Stats : public virtual yk_stats {
@@ -60,13 +61,31 @@ namespace yask {
         idx_t nsteps = 0;
         double run_time = 0.;
         double mpi_time = 0.;
+        double overlap_eff = 0.;
+
+        // Timer tree: names in tree order and secs by name.
+        std::vector<std::string> timer_names;
+        std::map<std::string, double> timer_secs;
+
+        // Hardware event counts by timer name, indexed by
+        // PerfCounters::Event. Empty if not available.
+        std::map<std::string, std::vector<idx_t>> counters;
 
         Stats() {}
         virtual ~Stats() {}
 
         void clear() {
             npts = nwrites = nfpops = nsteps = 0;
-            run_time = mpi_time = 0.;
+            run_time = mpi_time = overlap_eff = 0.;
+            timer_names.clear();
+            timer_secs.clear();
+            counters.clear();
+        }
+
+        // Add a timer after its parent.
+        void add_timer(const std::string& name, double secs) {
+            timer_names.push_back(name);
+            timer_secs[name] = secs;
         }
         
         // APIs.
@@ -90,9 +109,134 @@ namespace yask {
         /// Get the number of seconds elapsed during calls to run_solution().
         virtual double
         get_elapsed_run_secs() { return run_time; }
+
+        /// Get the fraction of overlapped halo-exchange time not spent waiting.
+        virtual double
+        get_halo_overlap_efficiency() { return overlap_eff; }
+
+        virtual std::vector<std::string>
+        get_timer_names() { return timer_names; }
+
+        virtual double
+        get_timer_secs(const std::string& name);
+
+        virtual std::string
+        get_timers_json();
+
+        virtual std::vector<std::string>
+        get_counter_names();
+
+        virtual idx_t
+        get_counter(const std::string& event,
+                    const std::string& timer_name);
         
     };
 
+    // Index of the halo face for neighbor 'ni' and buffer direction
+    // 'bd', as used for per-face dirty flags.
+    inline size_t get_halo_face(int ni, int bd) {
+        return size_t(ni) * MPIBufs::nBufDirs + bd;
+    }
+
+    // A grid whose halos are being exchanged and the steps
+    // being exchanged.
+    struct HaloSwap {
+        YkGridPtr gp;
+        idx_t first_t = 0;      // lowest step index.
+        idx_t num_t = 1;        // number of consecutive steps.
+
+        // Dirty faces in any of the steps, by get_halo_face().
+        // Other faces are skipped. Empty means all faces.
+        std::vector<bool> faces;
+        bool has_face(int ni, int bd) const {
+            return faces.empty() || faces.at(get_halo_face(ni, bd));
+        }
+    };
+    typedef std::map<std::string, HaloSwap> HaloSwapMap; // key: grid name.
+
+    // Grid data copied for a snapshot by write_snapshot()
+    // and written to a file by a background thread.
+    struct SnapshotBuf {
+        std::string fname;
+        std::string header;     // text lines before the data.
+        std::vector<real_t> data;
+        std::string err;        // set if the write failed.
+        std::thread writer;     // writing this buf if joinable.
+    };
+
+    // Function from yk_solution::add_step_callback() and its footprint.
+    struct StepCallback {
+        yk_step_callback fn;
+        GridPtrs read_grids, write_grids;
+        idx_t reach = 0;
+    };
+
+    // Run started by yk_solution::run_solution_async().
+    // The run's thread calls safe_point() after each group of steps;
+    // other functions are called from the thread that started it.
+    class RunHandle : public virtual yk_run_handle {
+    protected:
+        std::thread _thread;
+        std::mutex _mutex;
+        std::condition_variable _cv; // signaled on any state change.
+        idx_t _step_dir;
+        idx_t _last_step;          // last step done.
+        idx_t _pause_step = 0;     // valid if '_pause_req'.
+        bool _pause_req = false;   // pause at '_pause_step'.
+        bool _paused = false;
+        bool _done = false;
+        std::string _err;          // set if the run failed.
+
+        bool is_past_pause_step() const {
+            return (_last_step - _pause_step) * _step_dir >= 0;
+        }
+
+    public:
+        RunHandle(idx_t first_step_index, idx_t step_dir) :
+            _step_dir(step_dir), _last_step(first_step_index - step_dir) { }
+        virtual ~RunHandle() {
+            join();
+        }
+
+        // Start 'fn' on a new thread.
+        void start(std::function<void ()> fn);
+
+        // Called by the run's thread after 'last_step' is done.
+        // Blocks while paused.
+        void safe_point(idx_t last_step);
+
+        // Resume if needed and wait for the thread to exit.
+        void join();
+
+        // Check state without throwing.
+        bool is_done() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _done;
+        }
+        bool is_run_thread() const {
+            return std::this_thread::get_id() == _thread.get_id();
+        }
+
+        // APIs.
+        virtual bool test();
+        virtual void wait();
+        virtual bool pause_after_step(idx_t step_index);
+        virtual void resume();
+        virtual idx_t get_last_step_done() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _last_step;
+        }
+    };
+    typedef std::shared_ptr<RunHandle> RunHandlePtr;
+
+    // Reduction from yc_solution::add_reduction() and its values.
+    struct Reduction {
+        std::string name;
+        int op = 0;             // YkGridBase::ReduceOp.
+        std::map<idx_t, double> partials; // by step, this rank so far.
+        std::map<idx_t, double> results;  // by step, all ranks.
+    };
+
     // Collections of things in a context.
     class StencilBundleBase;
     class BundlePack;
@@ -139,10 +283,17 @@ namespace yask {
         }
 
         // Alloc given bytes on each NUMA node.
+        // Use MPI_Alloc_mem() if 'mpi_mem'.
         virtual void _alloc_data(const std::map <int, size_t>& nbytes,
                                  const std::map <int, size_t>& ngrids,
                                  std::map <int, std::shared_ptr<char>>& _data_buf,
-                                 const std::string& type);
+                                 const std::string& type,
+                                 bool mpi_mem = false,
+                                 bool ooc = false);
+
+        // Alloc from the pool if '-alloc_pool' or 'mpi_mem' is set.
+        virtual std::shared_ptr<char> _alloc_bytes(size_t nbytes, int numa_pref,
+                                                   bool mpi_mem = false);
         
     public:
 
@@ -156,6 +307,66 @@ namespace yask {
         // BB with any needed extensions for wave-fronts.
         // If WFs are not used, this is the same as rank_bb;
         BoundingBox ext_bb;
+
+        // BBs used to overlap halo exchange with computation.
+        // 'mpi_interior' is the part of 'rank_bb' that neither sends
+        // data to nor needs data from any neighbor.
+        // 'mpi_exterior' contains non-overlapping slabs that cover the
+        // rest of 'rank_bb'. Empty if overlapping is not possible.
+        BoundingBox mpi_interior;
+        std::vector<BoundingBox> mpi_exterior;
+
+        // If not null, calc_region() only evaluates points inside this BB.
+        const BoundingBox* sub_bb = 0;
+
+        // Temporal-blocking state set by calc_region_tb() for use
+        // in calc_block_tb().
+        int _tb_mask = -1;      // domain dims of bridge shapes; -1 => no TB.
+        std::vector<Indices> _tb_begins, _tb_ends; // region span at each shift.
+        Indices _tb_layout_end;                     // end of the block layout.
+        idx_t _tb_start_t = 0, _tb_stop_t = 0;      // steps in the temporal block.
+
+        // CPU used by each block thread within each region thread,
+        // found when nested threading is initialized in prepare_solution().
+        std::vector<std::vector<int>> _thread_cpus;
+
+        // Region threads in each team while running NUMA parts; 0 otherwise.
+        int _part_threads = 0;
+        int _part_level = 0;    // OpenMP nesting level of the part teams.
+
+        // Grids with sources from yk_grid::add_source_set(),
+        // found at the start of each run.
+        GridPtrs _source_grids;
+
+        // Functions from add_step_callback().
+        std::vector<StepCallback> _step_callbacks;
+
+        // Whether steps are only being timed, e.g., to balance the ranks.
+        // Sources, step callbacks, and reductions are skipped.
+        bool _timing_run = false;
+
+        // Most recent run from run_solution_async().
+        RunHandlePtr _run_handle;
+
+        // Grid memory backed by files in '-ooc_dir' and the rolling
+        // window over it in the first domain dim; see ooc_stage().
+        struct OocMap {
+            std::weak_ptr<char> base;
+            size_t nbytes;
+            int fd;
+        };
+        struct OocRange {
+            size_t map;
+            size_t offset, nbytes;
+        };
+        std::vector<OocMap> _ooc_maps;
+        std::vector<OocRange> _ooc_pending; // written behind but not yet dropped.
+        idx_t _ooc_begin = idx_max;         // begin of the last region staged.
+        idx_t _ooc_fetched = 0;             // end of slabs read ahead.
+        idx_t _ooc_released = 0;            // end of slabs written behind.
+
+        // Reductions declared by the bundles.
+        std::vector<Reduction> _reductions;
         
         // List of all non-scratch stencil bundles in the order in which
         // they should be evaluated within a step.
@@ -177,6 +388,15 @@ namespace yask {
         // Each vector contains a grid for each thread.
         ScratchVecs scratchVecs;
 
+        // Groups of grids whose vectors are stored interleaved in one
+        // allocation. The generated code relies on this layout.
+        std::vector<GridPtrs> interleaveGroups;
+
+        // Memory for the scratch grids of each region thread.
+        // Kept when the scratch grids are remade and only grown.
+        std::vector<std::shared_ptr<char>> _scratch_arenas;
+        std::vector<size_t> _scratch_arena_sizes;
+
         // Some calculated domain sizes.
         IdxTuple rank_domain_offsets;       // Domain index offsets for this rank.
         IdxTuple overall_domain_sizes;       // Total of rank domains over all ranks.
@@ -198,6 +418,8 @@ namespace yask {
         // 'reads' indicates points actually read by stencil-bundles.
         // 'numFpOps' indicates est. number of FP ops.
         // 'nbytes' indicates number of bytes allocated.
+        // 'memBytes' indicates est. bytes to and from memory without
+        // cache reuse and 'reuseBytes' with reuse in each block.
         // '_1t' suffix indicates work for one time-step.
         // '_dt' suffix indicates work for all time-steps.
         idx_t rank_domain_1t=0, rank_domain_dt=0, tot_domain_1t=0, tot_domain_dt=0;
@@ -205,14 +427,23 @@ namespace yask {
         idx_t rank_reads_1t=0, rank_reads_dt=0, tot_reads_1t=0, tot_reads_dt=0;
         idx_t rank_numFpOps_1t=0, rank_numFpOps_dt=0, tot_numFpOps_1t=0, tot_numFpOps_dt=0;
         idx_t rank_nbytes=0, tot_nbytes=0;
+        idx_t rank_memBytes_1t=0, tot_memBytes_1t=0, rank_reuseBytes_1t=0, tot_reuseBytes_1t=0;
+        double attainable_pts_ps = 0.; // points-per-sec bound from measured memory BW.
 
         // Elapsed-time tracking.
         YaskTimer run_time;     // time in run_solution(), including MPI.
         YaskTimer mpi_time;     // time spent just doing MPI.
+        YaskTimer overlap_time; // time overlapped exchanges were in flight.
+        YaskTimer halo_wait_time; // time spent completing overlapped exchanges.
+        YaskTimer halo_pack_time; // time copying halos to send bufs.
+        YaskTimer halo_unpack_time; // time copying halos from recv bufs.
+        YaskTimer halo_finish_time; // time in finish_halo_exchange().
         idx_t steps_done = 0;   // number of steps that have been run.
         double domain_pts_ps = 0.; // points-per-sec in domain.
         double writes_ps = 0.;     // writes-per-sec.
         double flops = 0.;      // est. FLOPS.
+        double mem_bw = 0.;     // est. DRAM bytes-per-sec.
+        double arith_intensity = 0.; // est. FLOPs per DRAM byte.
         
         // MPI settings.
         // TODO: move to settings or MPI info object.
@@ -231,6 +462,31 @@ namespace yask {
         // Map key: grid name.
         std::map<std::string, MPIData> mpiData;
 
+        // Buffers holding the data for all grids for each neighbor.
+        // Only allocated when aggregating halo messages.
+        std::shared_ptr<MPIData> aggMpiData;
+
+#ifdef USE_MPI
+        // Graph communicator and arguments for exchanging the aggregated
+        // buffers with one neighborhood collective. The arrays are
+        // indexed by position in the graph and must stay valid while the
+        // collective is in progress.
+        MPI_Comm halo_nbr_comm = MPI_COMM_NULL;
+        std::vector<int> halo_nbr_idxs; // neighbor index of each graph neighbor.
+        std::vector<int> halo_nbr_scounts, halo_nbr_rcounts;
+        std::vector<MPI_Aint> halo_nbr_sdispls, halo_nbr_rdispls;
+        std::vector<MPI_Datatype> halo_nbr_types;
+        MPI_Request halo_nbr_req = MPI_REQUEST_NULL;
+
+        // Window holding the send buffers shared with neighbors on this node.
+        MPI_Win halo_shm_win = MPI_WIN_NULL;
+#endif
+
+        // State of a halo exchange that has been started but
+        // not yet completed when overlapping comms.
+        bool halo_pending = false;
+        HaloSwapMap halo_pending_swaps;
+
         // Auto-tuner state.
         class AT {
         protected:
@@ -272,6 +528,46 @@ namespace yask {
             idx_t csteps = 0;
             bool in_warmup = true;
 
+            // Settings searched by coordinate descent after the block
+            // size, i.e., one at a time starting from the best ones so far.
+            struct Setting {
+                IdxTuple region_sizes, block_sizes, sub_block_sizes;
+                int block_threads = 1;
+                int region_path = 0; // index in KernelSettings::get_region_paths().
+            };
+            Setting best_setting;
+            std::vector<Setting> cands; // candidates for current coord.
+            size_t cand_idx = 0;        // next one to try.
+            int coord = -1;             // -1 => searching block sizes.
+            const int max_block_threads = 8;
+
+            // Get and set the searched settings.
+            Setting get_setting() const;
+            void set_setting(const Setting& s);
+
+            // Set 'cands' for the next coord.
+            // Return false if there are no more.
+            bool next_coord();
+
+            // Key identifying the current problem in the cache file.
+            std::string get_cache_key() const;
+
+            // Read the setting for the current key from the cache file.
+            // Return false if not found.
+            bool read_cache(Setting& s) const;
+
+            // Save the current setting in the cache file.
+            void write_cache() const;
+
+            // Tuning all ranks together?
+            bool is_dist() const;
+
+            // Copy 'flag' and 's' from rank 0 to all ranks if is_dist().
+            void bcast_setting(Setting& s, bool& flag) const;
+
+            // Take next auto-tuner step on this rank.
+            void eval_step(idx_t steps, double elapsed_time);
+
         public:
             const idx_t max_step_t = 4;
 
@@ -297,9 +593,23 @@ namespace yask {
                        KernelSettingsPtr settings);
 
         // Destructor.
+        // The bundles and grids of the derived class are already gone
+        // here, so anything that uses them is done in before_destroy().
         virtual ~StencilContext() {
 
-            // Dump stats if get_stats() hasn't been called yet.
+            // Finish any snapshot writes.
+            for (auto& sb : _snap_bufs)
+                if (sb.writer.joinable())
+                    sb.writer.join();
+        }
+
+        // Finish any async run, which may be paused, and dump stats if
+        // get_stats() hasn't been called yet. Called by the deleter of
+        // the solution made in yk_factory::new_solution(), so the run's
+        // thread never outlives the bundles and grids.
+        virtual void before_destroy() {
+            if (_run_handle)
+                _run_handle->join();
             if (steps_done)
                 get_stats();
         }
@@ -315,11 +625,7 @@ namespace yask {
         }
 
         // Reset elapsed times to zero.
-        virtual void clear_timers() {
-            run_time.clear();
-            mpi_time.clear();
-            steps_done = 0;
-        }
+        virtual void clear_timers();
 
         // Access to settings.
         virtual KernelSettingsPtr get_settings() {
@@ -330,6 +636,11 @@ namespace yask {
             _opts = opts;
         }
 
+        // Get the min FD order needed at the stencil-dim indices 'idxs'.
+        idx_t get_min_order(const Indices& idxs) const {
+            return _opts->get_min_order(idxs);
+        }
+
         // Access to dims and MPI info.
         virtual DimsPtr get_dims() {
             return _dims;
@@ -343,21 +654,57 @@ namespace yask {
         virtual void addScratch(GridPtrs& scratch_vec) {
             scratchVecs.push_back(&scratch_vec);
         }
+        virtual void addInterleaveGroup(const GridPtrs& grids) {
+            interleaveGroups.push_back(grids);
+        }
         
+        // Choose the number of ranks in each dim and this rank's index
+        // from the node topology if they are not given.
+        virtual void find_rank_layout();
+
         // Set vars related to this rank's role in global problem.
         // Allocate MPI buffers as needed.
         virtual void setupRank();
 
+        // Set the rank offsets, overall sizes, and neighbor info
+        // from the rank indices and sizes of all ranks.
+        virtual void exchange_rank_info();
+
+        // Size and allocate everything for the current settings.
+        virtual void setup_solution();
+
+        // Time some steps and find the rank-domain sizes at each rank index
+        // that would balance the calculation time across the ranks.
+        // Return whether any size would change.
+        virtual bool balance_ranks(std::map<std::string, std::vector<idx_t>>& splits);
+
+        // Bytes between addresses that can alias in the HW:
+        // 4KiB plus the L1 and L2 set strides.
+        virtual std::vector<idx_t> get_alias_strides() const;
+
+        // Pad grids without storage to avoid aliased strides.
+        virtual void pad_grids(std::ostream& os);
+
+        // Make the layouts of the grids in each interleave group the same.
+        virtual void align_interleaved_grids(std::ostream& os);
+
+        // Set the preferred NUMA node of grids without storage
+        // to the fast node if they fit and are likely to benefit.
+        virtual void place_grids(std::ostream& os);
+
         // Allocate grid memory for any grids that do not
         // already have storage.
         virtual void allocGridData(std::ostream& os);
 
+        // Write zero to the elements of 'grids' using the same threads
+        // that will evaluate each block, so their pages are allocated
+        // close to those threads.
+        virtual void first_touch_grids(GridPtrs& grids);
+
         // Determine sizes of MPI buffers and allocate MPI buffer memory.
         // Dealloc any existing MPI buffers first.
         virtual void allocMpiData(std::ostream& os);
-        virtual void freeMpiData(std::ostream& os) {
-            mpiData.clear();
-        }
+        virtual void freeMpiData(std::ostream& os);
 
         // Alloc scratch-grid memory.
         // Dealloc any existing scratch-grids first.
@@ -365,6 +712,9 @@ namespace yask {
         virtual void freeScratchData(std::ostream& os) {
             makeScratchGrids(0);
         }
+        virtual void grow_scratch_arenas(std::ostream& os,
+                                         const std::vector<size_t>& tbytes,
+                                         const std::vector<int>& tprefs);
 
         // Allocate grids, params, MPI bufs, etc.
         // Calculate rank position in problem.
@@ -382,6 +732,11 @@ namespace yask {
         */
         virtual yk_stats_ptr get_stats();
 
+        // Print the range over the ranks of the compute time, halo times,
+        // and halo traffic, and the slowest ranks. Optionally write the
+        // values of each rank to '_rank_stats_file'.
+        virtual void print_rank_stats(double ctime, double htime, double wtime);
+
         // Dealloc grids, etc.
         virtual void end_solution();
 
@@ -436,6 +791,19 @@ namespace yask {
         // Params should not be written to, so they are not compared.
         // Return number of mis-compares.
         virtual idx_t compareData(const StencilContext& ref) const;
+
+        // Compare grids only in the domain box from 'first' to 'last'
+        // (inclusive) in all steps and misc indices. 'ref' may be a
+        // sub-domain context covering the box.
+        // Return number of mis-compares.
+        virtual idx_t compareData(const StencilContext& ref,
+                                  const IdxTuple& first,
+                                  const IdxTuple& last) const;
+
+        // Copy all elements allocated in both this context and 'dst',
+        // including halos, in all steps and misc indices.
+        // Used to load the initial state of a sub-domain context.
+        virtual void copyData(StencilContext& dst) const;
         
         // Set number of threads w/o using thread-divisor.
         // Return number of threads.
@@ -512,28 +880,155 @@ namespace yask {
             return nt;
         }
 
+        // Index of the calling region thread, unique across the teams
+        // of the NUMA parts. Used to select per-thread scratch grids.
+        // If the region loop is not a parallel region, the part's own
+        // thread is its only region thread.
+        int get_region_thread_idx() const {
+            if (!_part_threads)
+                return omp_get_thread_num();
+            int part = omp_get_ancestor_thread_num(_part_level);
+            int rt = (omp_get_level() > _part_level) ?
+                omp_get_ancestor_thread_num(_part_level + 1) : 0;
+            return part * _part_threads + rt;
+        }
+
+        // Split 'rank_idxs' into slabs across the outer-most domain dim
+        // and call 'visitor' with each slab in its own thread team.
+        virtual void run_numa_parts(const ScanIndices& rank_idxs,
+                                    const std::function<void (ScanIndices& part_idxs)>& visitor);
+
         // Reference stencil calculations.
         virtual void calc_rank_ref();
 
         // Vectorized and blocked stencil calculations.
         virtual void calc_rank_opt();
 
+        // Read ahead and write behind the out-of-core grid slabs
+        // in the first domain dim around a region from 'begin' to
+        // 'end' in that dim.
+        virtual void ooc_stage(idx_t begin, idx_t end);
+        virtual void ooc_advise(idx_t first, idx_t end, bool fetch);
+
         // Calculate results within a region.
         virtual void calc_region(BundlePackPtr& sel_bp,
                                  const ScanIndices& rank_idxs);
 
+        // Calculate all packs at step 't' as a graph of block tasks.
+        virtual void calc_packs_async(idx_t t);
+
+        // Find the grids with sources and prepare them.
+        virtual void find_source_grids();
+
+        // Whether there is work to do in each span after each step.
+        bool have_span_work() const {
+            if (_timing_run)
+                return false;
+            if (_source_grids.size())
+                return true;
+            for (auto& cb : _step_callbacks)
+                if (cb.reach == 0)
+                    return true;
+            return false;
+        }
+
+        // Add the sources at step 't' to the points in [begin, end),
+        // which are in the stencil dims, and call the callbacks with
+        // zero reach for them. Mark the grids written dirty at 't'.
+        virtual void do_span_work(idx_t t, const Indices& begin,
+                                  const Indices& end);
+
+        // Call the callbacks with non-zero reach for step 't' over
+        // the whole rank after exchanging the halos they read.
+        virtual void do_step_work(idx_t t);
+
+        // Combine the partial reductions of the steps written by
+        // the steps from 'start_t' to 'stop_t' across all ranks.
+        virtual void finish_reductions(idx_t start_t, idx_t stop_t);
+
         // Calculate results within a block.
         virtual void calc_block(BundlePackPtr& sel_bp,
                                 const ScanIndices& region_idxs);
 
+        // Set the span of a region after some WF shifts.
+        virtual bool get_region_span(ScanIndices& idxs,
+                                     const Indices& start,
+                                     const Indices& stop,
+                                     idx_t shift_num) const;
+
+        // Calculate several steps in a region with temporal blocking.
+        virtual bool calc_region_tb(BundlePackPtr& sel_bp,
+                                    const ScanIndices& rgn_idxs,
+                                    const Indices& start,
+                                    const Indices& stop,
+                                    idx_t start_t, idx_t stop_t,
+                                    idx_t& shift_num);
+
+        // Calculate all steps of one shape in a temporal block.
+        virtual void calc_block_tb(BundlePackPtr& sel_bp,
+                                   const ScanIndices& region_idxs,
+                                   ScanIndices& block_idxs);
+
         // Exchange all dirty halo data for all stencil bundles
         // and max number of steps for each grid.
-        virtual void exchange_halos_all();
+        // If 'grids' is not null, only those grids are exchanged.
+        virtual void exchange_halos_all(bool overlap = false,
+                                        const GridPtrs* grids = 0);
 
         // Exchange halo data needed by bundle pack 'sel_bp' at the given step(s).
         // If sel_bp==null, check all bundles.
+        // Any exchange left in progress by a previous call is completed first.
+        // If 'overlap', the exchange for the last step needing it is
+        // started but not completed.
+        // If 'grids' is not null, only those grids are checked.
         virtual void exchange_halos(const BundlePackPtr& sel_bp,
-                                    idx_t start, idx_t stop);
+                                    idx_t start, idx_t stop,
+                                    bool overlap = false,
+                                    const GridPtrs* grids = 0);
+
+        // Complete any halo exchange left in progress.
+        virtual void complete_halo_exchange();
+
+    protected:
+        // Post receives, pack and send halos for 'swaps'.
+        virtual void start_halo_exchange(const HaloSwapMap& swaps);
+
+        // Wait for and unpack halos of the pending exchange.
+        virtual void finish_halo_exchange();
+
+        // Set 'mpi_interior' and 'mpi_exterior'.
+        virtual void find_mpi_bbs();
+
+        // Set the halo faces that each bundle may write in
+        // 'outputGridFaces' and start tracking them in the grids.
+        virtual void find_dirty_faces();
+
+        // File of bundle BBs to read instead of finding them.
+        std::string _bb_file;
+
+        // Inputs used when the rank info and the bundle BBs were last
+        // found, so a repeated prepare_solution() can keep them.
+        std::vector<idx_t> _rank_layout_key;
+        std::string _bundle_bb_key;
+
+        // Staging bufs for snapshots and the one to fill next.
+        SnapshotBuf _snap_bufs[2];
+        int _snap_next = 0;
+
+        // Wait for the write of 'sb' to finish and throw any error from it.
+        virtual void wait_for_snapshot(SnapshotBuf& sb);
+
+        // Get the string that identifies the inputs to the bundle BBs.
+        virtual std::string get_bb_key() const;
+
+        // Get the name of the cache file for the bundle BBs.
+        virtual std::string get_bb_cache_file() const;
+
+        // Set the bundle BBs from 'fname'.
+        // Return false if it can't be read or doesn't match.
+        virtual bool read_bb_file(const std::string& fname);
+
+    public:
 
         // Mark grids that have been written to by bundle pack 'sel_bp'.
         // If sel_bp==null, use all bundles.
@@ -574,6 +1069,9 @@ namespace yask {
         virtual int get_element_bytes() const {
             return REAL_BYTES;
         }
+        virtual std::string get_target() const {
+            return ARCH_NAME;
+        }
 
         virtual int get_num_grids() const {
             return int(gridPtrs.size());
@@ -645,6 +1143,8 @@ namespace yask {
         virtual void run_solution(idx_t step_index) {
             run_solution(step_index, step_index);
         }
+        virtual yk_run_handle_ptr run_solution_async(idx_t first_step_index,
+                                                     idx_t last_step_index);
         virtual void share_grid_storage(yk_solution_ptr source);
 
         // APIs that access settings.
@@ -658,8 +1158,50 @@ namespace yask {
         virtual idx_t get_block_size(const std::string& dim) const;
         virtual idx_t get_region_size(const std::string& dim) const;
         virtual idx_t get_num_ranks(const std::string& dim) const;
+        virtual idx_t get_fold_size(const std::string& dim) const;
+        virtual idx_t get_cluster_size(const std::string& dim) const;
         virtual idx_t get_rank_index(const std::string& dim) const;
         virtual std::string apply_command_line_options(const std::string& args);
+        virtual void load_bounding_boxes(const std::string& filename) {
+            _bb_file = filename;
+        }
+        virtual void save_bounding_boxes(const std::string& filename);
+        virtual void set_min_order(const std::vector<idx_t>& first_indices,
+                                   const std::vector<idx_t>& last_indices,
+                                   idx_t order);
+        virtual void clear_min_orders() {
+            _opts->_order_boxes.clear();
+        }
+        virtual void write_snapshot(const std::string& filename,
+                                    idx_t step_index,
+                                    const std::vector<std::string>& grid_names);
+        virtual void wait_for_snapshots() {
+            for (auto& sb : _snap_bufs)
+                wait_for_snapshot(sb);
+        }
+        virtual int add_step_callback(yk_step_callback callback,
+                                      const std::vector<yk_grid_ptr>& read_grids,
+                                      const std::vector<yk_grid_ptr>& write_grids,
+                                      idx_t reach);
+        virtual void clear_step_callbacks() {
+            _step_callbacks.clear();
+        }
+        virtual std::vector<std::string> get_reduction_names() const {
+            std::vector<std::string> names;
+            for (auto& r : _reductions)
+                names.push_back(r.name);
+            return names;
+        }
+        virtual double get_reduction(const std::string& name,
+                                     idx_t step_index) const;
+
+        // Find or add the reduction 'name' and return its index.
+        virtual int add_reduction_def(const std::string& name, int op);
+
+        // Combine 'val' into the partial result of reduction 'idx'
+        // at 'step_index'. Safe to call from several threads.
+        virtual void add_reduction_partial(int idx, idx_t step_index,
+                                           double val);
         virtual bool set_default_numa_preferred(int numa_node) {
 #ifdef USE_NUMA
             _opts->_numa_pref = numa_node;
@@ -27,8 +27,20 @@ IN THE SOFTWARE.
 using namespace std;
 
 // Auto-generated stencil code that extends base types.
+// The bundle calculation code is also defined here unless it is
+// compiled in separate files.
 #define DEFINE_CONTEXT
+#if !defined(NUM_BUNDLE_FILES) || (NUM_BUNDLE_FILES < 1)
+#define DEFINE_BUNDLE_CODE (-1)
+#endif
 #include "yask_stencil_code.hpp"
+#include <dlfcn.h>
+
+// Entry point used by yk_factory::new_jit_solution() to create a
+// factory in a loaded kernel library.
+extern "C" yask::yk_factory* yask_jit_new_factory() {
+    return new yask::yk_factory;
+}
 
 namespace yask {
 
@@ -57,7 +69,13 @@ namespace yask {
 
         // Create problem-specific object defined by stencil compiler.
         // TODO: allow more than one type of solution to be created.
-        auto sp = make_shared<YASK_STENCIL_CONTEXT>(ep, op);
+        // The deleter runs before_destroy() while the derived object
+        // is still whole.
+        shared_ptr<YASK_STENCIL_CONTEXT> sp(new YASK_STENCIL_CONTEXT(ep, op),
+                                            [](YASK_STENCIL_CONTEXT* p) {
+                                                p->before_destroy();
+                                                delete p;
+                                            });
         assert(sp);
 
         // If no source, init settings from default args.
@@ -70,4 +88,313 @@ namespace yask {
         return new_solution(env, nullptr);
     }
 
+    // Load a kernel library and make a factory from it.  It is never
+    // unloaded because its objects may outlive the factory.
+    static unique_ptr<yk_factory> load_factory(const string& lib) {
+        void* handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle)
+            THROW_YASK_EXCEPTION("Error: cannot load stencil library '" + lib + "': " + dlerror());
+        typedef yk_factory* (*factory_fn_t)();
+        auto fn = (factory_fn_t)dlsym(handle, "yask_jit_new_factory");
+        if (!fn)
+            THROW_YASK_EXCEPTION("Error: no factory in stencil library '" + lib + "'");
+        return unique_ptr<yk_factory>(fn());
+    }
+
+    // Quote 's' as one shell word.
+    static string shell_quote(const string& s) {
+        string q = "'";
+        for (char c : s) {
+            if (c == '\'')
+                q += "'\\''";
+            else
+                q += c;
+        }
+        return q + "'";
+    }
+
+    // SHA-1 digest of 's' as hex.
+    // This names cached libraries, so it must not vary between builds.
+    static string sha1_hex(const string& s) {
+        uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+        auto rol = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+
+        // Pad to a multiple of 64 bytes with the length in bits at the end.
+        string m = s;
+        uint64_t nbits = uint64_t(s.length()) * 8;
+        m += char(0x80);
+        while (m.length() % 64 != 56)
+            m += char(0);
+        for (int i = 7; i >= 0; i--)
+            m += char((nbits >> (i * 8)) & 0xff);
+
+        for (size_t ci = 0; ci < m.length(); ci += 64) {
+            uint32_t w[80];
+            for (int i = 0; i < 16; i++)
+                w[i] = (uint32_t(uint8_t(m[ci + i*4])) << 24) |
+                    (uint32_t(uint8_t(m[ci + i*4 + 1])) << 16) |
+                    (uint32_t(uint8_t(m[ci + i*4 + 2])) << 8) |
+                    uint32_t(uint8_t(m[ci + i*4 + 3]));
+            for (int i = 16; i < 80; i++)
+                w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; i++) {
+                uint32_t f, k;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                uint32_t t = rol(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rol(b, 30);
+                b = a;
+                a = t;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+        ostringstream oss;
+        oss << hex << setfill('0');
+        for (int i = 0; i < 5; i++)
+            oss << setw(8) << h[i];
+        return oss.str();
+    }
+
+    // Whether 'fname' holds exactly 'key'.
+    static bool key_matches(const string& fname, const string& key) {
+        ifstream ifs(fname);
+        if (!ifs)
+            return false;
+        stringstream ss;
+        ss << ifs.rdbuf();
+        return ss.str() == key;
+    }
+
+    // Build, load, and use a kernel library for 'code_file'.
+    yk_solution_ptr yk_factory::new_jit_solution(yk_env_ptr env,
+                                                 const string& code_file,
+                                                 const string& cache_dir,
+                                                 const string& make_args) const {
+        ifstream ifs(code_file);
+        if (!ifs)
+            THROW_YASK_EXCEPTION("Error: cannot read stencil code from '" + code_file + "'");
+        stringstream code;
+        code << ifs.rdbuf();
+        char* cpath = realpath(code_file.c_str(), NULL);
+        string code_path(cpath);
+        free(cpath);
+
+        // Name the library by the code and the build settings.
+        // Binding its symbols locally keeps them from resolving to those
+        // of this library, which may be compiled from different code.
+        string src_dir = KERNEL_SRC_DIR;
+        if (access((src_dir + "/Makefile").c_str(), R_OK) != 0)
+            THROW_YASK_EXCEPTION("Error: cannot build stencil libraries because the YASK "
+                                 "kernel source tree is not at '" + src_dir + "', "
+                                 "where this library was built");
+        string args = "-C " + shell_quote(src_dir) + " " KERNEL_MAKE_ARGS
+            " YK_CXX=" + shell_quote(KERNEL_CXX) +
+            " YK_CXXOPT=" + shell_quote(KERNEL_CXXOPT) +
+            " YK_SO_FLAGS=-Wl,-Bsymbolic " + make_args;
+        string key = code.str() + "\n" + args + "\n";
+        string name = "jit_" + sha1_hex(key);
+        string dir = cache_dir;
+        if (!dir.length() && getenv("YASK_JIT_DIR"))
+            dir = getenv("YASK_JIT_DIR");
+        if (!dir.length())
+            dir = string(getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp") + "/yask_jit";
+        if (system(("mkdir -p '" + dir + "'").c_str()) != 0)
+            THROW_YASK_EXCEPTION("Error: cannot make JIT directory '" + dir + "'");
+        char* dpath = realpath(dir.c_str(), NULL);
+        dir = dpath;
+        free(dpath);
+        string lib = dir + "/libyask_kernel." + name + "." ARCH_NAME ".so";
+
+        // Build it on one rank if not already cached. The full key is
+        // saved next to it, so a cached library is only used for the
+        // same code and settings. The result is sent to the other
+        // ranks, so they all throw if it fails.
+        string log = dir + "/" + name + ".log";
+        string key_file = dir + "/" + name + ".key";
+        int built = 1;
+        if (env->get_rank_index() == 0 &&
+            (access(lib.c_str(), R_OK) != 0 || !key_matches(key_file, key))) {
+            remove(key_file.c_str());
+            remove(lib.c_str());
+            string cmd = "rm -rf " + shell_quote(dir + "/" + name) +
+                "; make " + args + " stencil=" + name +
+                " YK_CODE_SRC=" + shell_quote(code_path) +
+                " YK_GEN_DIR=" + shell_quote(dir + "/" + name) +
+                " LIB_DIR=" + shell_quote(dir) + " " + shell_quote(lib) +
+                " > " + shell_quote(log) + " 2>&1";
+            built = system(cmd.c_str()) == 0;
+            if (built) {
+                ofstream ofs(key_file);
+                ofs << key;
+                built = ofs.good();
+            }
+        }
+#ifdef USE_MPI
+        auto ep = dynamic_pointer_cast<KernelEnv>(env);
+        assert(ep);
+        MPI_Bcast(&built, 1, MPI_INT, 0, ep->comm);
+#endif
+        if (!built)
+            THROW_YASK_EXCEPTION("Error: cannot build stencil library '" + lib +
+                                 "'; see '" + log + "' on rank 0");
+        if (!key_matches(key_file, key))
+            THROW_YASK_EXCEPTION("Error: stencil library '" + lib +
+                                 "' was not built from '" + code_file +
+                                 "' with these settings; see '" + key_file + "'");
+
+        auto fac = load_factory(lib);
+        return fac->new_solution(env);
+    }
+
+    // Whether this CPU can run a kernel built with 'arch'.
+    static bool is_arch_supported(const string& arch) {
+        if (arch == ARCH_NAME || arch == "intel64")
+            return true;
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (arch == "knl")
+            return __builtin_cpu_supports("avx512er");
+        if (arch == "skx" || arch == "skl")
+            return __builtin_cpu_supports("avx512bw");
+        if (arch == "hsw" || arch == "bdw")
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        if (arch == "ivb" || arch == "snb")
+            return __builtin_cpu_supports("avx");
+#endif
+        return false;
+    }
+
+    // Copy the settings that are set per dim via the APIs.
+    static void copy_dim_settings(yk_solution_ptr dst, const yk_solution_ptr src) {
+        for (auto& dim : src->get_domain_dim_names()) {
+            dst->set_rank_domain_size(dim, src->get_rank_domain_size(dim));
+            dst->set_num_ranks(dim, src->get_num_ranks(dim));
+            dst->set_min_pad_size(dim, src->get_min_pad_size(dim));
+            dst->set_block_size(dim, src->get_block_size(dim));
+            dst->set_region_size(dim, src->get_region_size(dim));
+        }
+        auto sdim = src->get_step_dim_name();
+        dst->set_region_size(sdim, src->get_region_size(sdim));
+    }
+
+    // Choose among the source solution and the variants built with this
+    // library.
+    yk_solution_ptr yk_factory::new_variant_solution(yk_env_ptr env,
+                                                     const yk_solution_ptr source,
+                                                     int bench_steps) const {
+        auto ep = dynamic_pointer_cast<KernelEnv>(env);
+        assert(ep);
+        auto ssp = dynamic_pointer_cast<StencilContext>(source);
+        if (!ssp)
+            THROW_YASK_EXCEPTION("Error: new_variant_solution() called with a "
+                                 "solution from another library");
+        ostream& os = ssp->get_ostr();
+
+        // Variants from the build as 'arch:tag' strings.
+        vector<string> archs { ARCH_NAME }, libs { "" };
+        istringstream iss(KERNEL_VARIANTS);
+        string var;
+        while (iss >> var) {
+            auto ci = var.find(':');
+            archs.push_back(var.substr(0, ci));
+            libs.push_back(string(KERNEL_LIB_DIR) + "/libyask_kernel." +
+                           var.substr(ci + 1) + ".so");
+        }
+        int nc = int(libs.size());
+
+        // Keep only the ones that all ranks can run.
+        vector<int> ok(nc, 1);
+        for (int ci = 1; ci < nc; ci++)
+            ok[ci] = is_arch_supported(archs[ci]) && access(libs[ci].c_str(), R_OK) == 0;
+#ifdef USE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, ok.data(), nc, MPI_INT, MPI_LAND, ep->comm);
+#endif
+
+        // Make a fresh solution from candidate 'ci'.
+        vector<unique_ptr<yk_factory>> facs(nc);
+        auto new_cand = [&](int ci) {
+            auto sp = ci ? facs[ci]->new_solution(env) : new_solution(env, source);
+            copy_dim_settings(sp, source);
+            return sp;
+        };
+
+        // Score the candidates. Higher is better.
+        vector<double> scores(nc, 0.), ties(nc, 0.);
+        for (int ci = 0; ci < nc; ci++) {
+            if (!ok[ci]) {
+                os << "Kernel variant '" << libs[ci] << "' skipped: not built or '" <<
+                    archs[ci] << "' not supported on all ranks.\n";
+                continue;
+            }
+            if (ci)
+                facs[ci] = load_factory(libs[ci]);
+            auto sp = new_cand(ci);
+
+            // Fraction of the points calculated in whole clusters that are
+            // in the rank domain. Use the lowest over the ranks.
+            double frac = 1.;
+            ties[ci] = 1.;
+            for (auto& dim : sp->get_domain_dim_names()) {
+                idx_t rsize = sp->get_rank_domain_size(dim);
+                idx_t csize = sp->get_cluster_size(dim);
+                frac *= double(rsize) / ROUND_UP(rsize, csize);
+                ties[ci] *= csize;
+            }
+            scores[ci] = frac;
+
+            // Or, time some steps. Use the longest over the ranks.
+            if (bench_steps > 0) {
+                sp->set_debug_output(yask_output_factory().new_null_output());
+                sp->prepare_solution();
+                sp->run_solution(0, bench_steps - 1);
+                scores[ci] = -sp->get_stats()->get_elapsed_run_secs();
+                sp->end_solution();
+            }
+        }
+#ifdef USE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, scores.data(), nc, MPI_DOUBLE, MPI_MIN, ep->comm);
+#endif
+
+        // Pick the best one.
+        int best = 0;
+        for (int ci = 1; ci < nc; ci++) {
+            if (!ok[ci])
+                continue;
+            if (scores[ci] > scores[best] ||
+                (scores[ci] == scores[best] && ties[ci] > ties[best]))
+                best = ci;
+        }
+        for (int ci = 0; ci < nc; ci++) {
+            if (!ok[ci])
+                continue;
+            os << "Kernel variant '" << (ci ? libs[ci] : "built-in") << "' for '" <<
+                archs[ci] << "': " << (bench_steps > 0 ? "run-time " : "useful-fraction ") <<
+                (bench_steps > 0 ? -scores[ci] : scores[ci]) <<
+                (ci == best ? " (chosen)" : "") << endl;
+        }
+        if (!best)
+            return source;
+        auto sp = new_cand(best);
+        sp->set_debug_output(ssp->get_debug_output());
+        return sp;
+    }
+
 } // namespace yask.
@@ -35,10 +35,10 @@ namespace yask {
                                      KernelSettingsPtr* settings,
                                      ostream** ostr) :
         _name(name), _layout_base(&layout_base), _opts(settings), _ostr(ostr) {
+        // The layout is synced by the derived class after it is
+        // constructed because its size accessors are virtual.
         for (auto& dn : dimNames)
             _dims.addDimBack(dn, 1);
-        _sync_layout_with_dims();
-
     }
 
     // Perform default allocation.
@@ -65,7 +65,10 @@ namespace yask {
             os << " on local NUMA node";
 #endif
         os << "...\n" << flush;
-        _base = shared_numa_alloc<char>(sz, numa_pref);
+        if ((*_opts)->_alloc_pool)
+            _base = pool_alloc(sz, numa_pref, (*_opts)->_huge_pages, false);
+        else
+            _base = shared_numa_alloc<char>(sz, numa_pref, (*_opts)->_huge_pages);
         
         // No offset.
         _elems = _base.get();
@@ -88,6 +91,8 @@ namespace yask {
             " (" << makeNumStr(get_num_elems()) << " " <<
             elem_name << " element(s) of " <<
             get_elem_bytes() << " byte(s) each)";
+        if (_interleave > 1)
+            oss << " interleaved with " << (_interleave - 1) << " other grid(s)";
         return oss.str();
     }
     
@@ -121,7 +126,7 @@ namespace yask {
 
 #pragma omp parallel for
                 for (idx_t ai = 0; ai < get_num_elems(); ai++)
-                    ((T*)_elems)[ai] = val;
+                    ((T*)_elems)[ai * _interleave] = val;
             }
         }
 
@@ -133,7 +138,7 @@ namespace yask {
                 auto n = get_num_elems();
 #pragma omp parallel for
                 for (idx_t ai = 0; ai < n; ai++)
-                    ((T*)_elems)[ai] = seed * T(ai % wrap + 1);
+                    ((T*)_elems)[ai * _interleave] = seed * T(ai % wrap + 1);
             }
         }
     
@@ -156,14 +161,39 @@ namespace yask {
             idx_t errs = 0;
 #pragma omp parallel for reduction(+:errs)
             for (idx_t ai = 0; ai < get_num_elems(); ai++) {
-                if (!within_tolerance(((T*)_elems)[ai], ((T*)p->_elems)[ai], ep))
+                if (!within_tolerance(((T*)_elems)[ai * _interleave],
+                                      ((T*)p->_elems)[ai * p->_interleave], ep))
                     errs++;
             }
             return errs;
         }
 
+    // Lookup-table-compressed elements can only be decoded with their
+    // grid's table, so sequences must be set by the grid, and indices
+    // into different tables can't be compared here. Returning the
+    // number of elements from count_diffs() makes the caller compare
+    // decoded values instead.
+#define LUT_GRID_SPECIALIZATIONS(T)                                     \
+    template <>                                                         \
+    void GenericGridTemplate<T>::set_elems_in_seq(T seed) {             \
+        THROW_YASK_EXCEPTION("Error: set_elems_in_seq() is not available for " \
+                             "lookup-table storage in '" + _name + "'"); \
+    }                                                                   \
+    template <>                                                         \
+    idx_t GenericGridTemplate<T>::count_diffs(const GenericGridBase* ref, \
+                                              double epsilon) const {   \
+        return get_num_elems();                                         \
+    }
+    LUT_GRID_SPECIALIZATIONS(real_vec_lut8_t)
+    LUT_GRID_SPECIALIZATIONS(real_vec_lut16_t)
+#undef LUT_GRID_SPECIALIZATIONS
+
     // Explicitly allowed instantiations.
     template class GenericGridTemplate<real_t>;
     template class GenericGridTemplate<real_vec_t>;
+    template class GenericGridTemplate<real_vec_bf16_t>;
+    template class GenericGridTemplate<real_vec_fp16_t>;
+    template class GenericGridTemplate<real_vec_lut8_t>;
+    template class GenericGridTemplate<real_vec_lut16_t>;
     
 } // yask namespace.
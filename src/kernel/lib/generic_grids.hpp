@@ -46,6 +46,10 @@ namespace yask {
 
         void* _elems = 0;          // actual data, which may be offset from _base.
 
+        // Number of grids whose elements are interleaved in the storage.
+        // Element 'i' of this grid is at _elems[i * _interleave].
+        idx_t _interleave = 1;
+
         // Preferred NUMA node.
         const static int _numa_unset = -999;
         int _numa_pref = _numa_unset; // use default from _opts.
@@ -97,6 +101,9 @@ namespace yask {
             return (_numa_pref != _numa_unset) ?
                 _numa_pref : (*_opts)->_numa_pref;
         }
+        virtual bool is_numa_pref_set() const {
+            return _numa_pref != _numa_unset;
+        }
         virtual bool set_numa_pref(int numa_node) {
 #ifdef USE_NUMA
             _numa_pref = numa_node;
@@ -110,6 +117,18 @@ namespace yask {
         // Access dims.
         const IdxTuple& get_dims() const { return _dims; }
 
+        // Access settings.
+        const KernelSettings& get_settings() const {
+            assert(_opts);
+            return **_opts;
+        }
+
+        // Set tile sizes in the layout, if it is tiled.
+        void set_tile_sizes(const Indices& tile_sizes) {
+            _layout_base->set_tile_sizes(tile_sizes);
+            _sync_layout_with_dims();
+        }
+
         // Get the messsage output stream.
         virtual std::ostream& get_ostr() const {
             assert(_ostr);
@@ -117,9 +136,26 @@ namespace yask {
             return **_ostr;
         }
 
-        // Get number of elements.
+        // Get number of elements, including any padding added by the layout.
         virtual idx_t get_num_elems() const {
-            return _dims.product();
+            return _layout_base->get_num_elements();
+        }
+
+        // Get number of elements between consecutive indices in dim 'n'.
+        virtual idx_t get_stride(int n) const {
+            Indices idxs(_dims.size());
+            idxs.setFromConst(0);
+            idx_t ai0 = _layout_base->layout(idxs);
+            idxs[n] = 1;
+            return (_layout_base->layout(idxs) - ai0) * _interleave;
+        }
+
+        // Access number of interleaved grids.
+        // Set after set_storage(), which resets it to 1.
+        idx_t get_interleave() const { return _interleave; }
+        void set_interleave(idx_t n) {
+            assert(n > 0);
+            _interleave = n;
         }
 
         // Get size of one element.
@@ -191,6 +227,7 @@ namespace yask {
         virtual void release_storage() {
             _base.reset();
             _elems = 0;
+            _interleave = 1;
         }
         
         // Set pointer to storage.
@@ -269,6 +306,85 @@ namespace yask {
                                   double epsilon) const;
     };
 
+    // Layout that stores each n-D tile contiguously.
+    // The tiles are ordered by the 'Base' layout, and so are the elements
+    // within each tile. A tile size of 0 means the whole dim. Each size is
+    // effectively padded up to a multiple of its tile size.
+    template <typename Base>
+    class TiledLayout : public Layout {
+    protected:
+        Indices _tile_sizes;    // requested tile sizes; 0 => whole dim.
+        Base _outer;            // layout of tiles.
+        Base _inner;            // layout of elements within a tile.
+        idx_t _tile_elems = 1;  // elements in one tile.
+
+        // Update the tile layouts after a size changes.
+        void _update() {
+            int n = _sizes.getNumDims();
+            Indices ntiles(_sizes), tsizes(_sizes);
+            _tile_elems = 1;
+            for (int i = 0; i < n; i++) {
+                idx_t sz = std::max(_sizes[i], idx_t(1));
+                tsizes[i] = (_tile_sizes[i] > 0) ? std::min(_tile_sizes[i], sz) : sz;
+                ntiles[i] = CEIL_DIV(sz, tsizes[i]);
+                _tile_elems *= tsizes[i];
+            }
+            _outer.set_sizes(ntiles);
+            _inner.set_sizes(tsizes);
+        }
+
+    public:
+        TiledLayout() :
+            Layout(Base().get_num_sizes()),
+            _tile_sizes(idx_t(0), Base().get_num_sizes()) {
+            _update();
+        }
+
+        virtual int get_num_sizes() const final {
+            return _sizes.getNumDims();
+        }
+        virtual void set_sizes(const Indices& sizes) final {
+            _sizes = sizes;
+            _update();
+        }
+        virtual void set_size(int i, idx_t size) final {
+            _sizes[i] = size;
+            _update();
+        }
+        virtual void set_tile_sizes(const Indices& tile_sizes) final {
+            _tile_sizes = tile_sizes;
+            _update();
+        }
+
+        // Whole tiles, so more than the product of the sizes.
+        virtual idx_t get_num_elements() const final {
+            return _outer.get_num_elements() * _tile_elems;
+        }
+
+        // Return 1-D offset from n-D 'j' indices.
+        virtual idx_t layout(const Indices& j) const final {
+            int n = _sizes.getNumDims();
+            Indices tj(n), ij(n);
+            for (int i = 0; i < n; i++) {
+                idx_t ts = _inner.get_size(i);
+                tj[i] = j[i] / ts;
+                ij[i] = j[i] % ts;
+            }
+            return _outer.layout(tj) * _tile_elems + _inner.layout(ij);
+        }
+
+        // Return n indices based on 1-D 'ai' input.
+        virtual Indices unlayout(idx_t ai) const final {
+            int n = _sizes.getNumDims();
+            Indices tj = _outer.unlayout(ai / _tile_elems);
+            Indices ij = _inner.unlayout(ai % _tile_elems);
+            Indices j(_sizes);
+            for (int i = 0; i < n; i++)
+                j[i] = tj[i] * _inner.get_size(i) + ij[i];
+            return j;
+        }
+    };
+
     // A generic n-D grid of elements of type T.
     // This class defines the type and memory layout.
     // The LayoutFn class must provide a 1:1 transform between
@@ -288,6 +404,7 @@ namespace yask {
                     std::ostream** ostr) :
             GenericGridTemplate<T>(name, _layout, dimNames, settings, ostr) {
             assert(int(dimNames.size()) == _layout.get_num_sizes());
+            this->_sync_layout_with_dims();
         }
 
         // Get number of dims.
@@ -318,7 +435,7 @@ namespace yask {
             if (check)
                 assert(ai < this->get_num_elems());
 #endif
-            return ai;
+            return ai * this->_interleave;
         }
 
         // Pointer to given element.
@@ -126,6 +126,8 @@ namespace yask {
         // Same size?
         if (get_num_storage_bytes() != op->get_num_storage_bytes())
             return false;
+        if (get_interleave() != op->get_interleave())
+            return false;
 
         // Same dims?
         if (get_num_dims() != op->get_num_dims())
@@ -148,6 +150,356 @@ namespace yask {
         return true;
     }
 
+    idx_t YkGridBase::get_raw_storage_stride(const string& dim) const {
+        int posn = get_dim_posn(dim, true, "get_raw_storage_stride");
+        if (!is_storage_allocated()) {
+            THROW_YASK_EXCEPTION("Error: call to 'get_raw_storage_stride' with no data allocated for grid '" +
+                                 get_name() + "'");
+        }
+
+        // Elements in a folded dim are not at a const stride.
+        if (_vec_lens[posn] > 1)
+            return 0;
+
+        // Find stride from addrs of first two elements along dim.
+        // The first element is at the beginning of the buffer.
+        Indices pt = _offsets.subElements(_actl_left_pads);
+        if (_has_step_dim)
+            pt[Indices::step_posn] = 0;
+        const real_t* p0 = getElemPtr(pt, get_alloc_step_index(pt), false);
+
+        // Storage isn't real_t elements.
+        if (!p0)
+            return 0;
+
+        // Any stride describes a dim of size one.
+        if (_allocs[posn] <= 1)
+            return 1;
+        pt[posn]++;
+        const real_t* p1 = getElemPtr(pt, get_alloc_step_index(pt), false);
+        return p1 - p0;
+    }
+
+    int YkGridBase::add_sample_set(const vector<idx_t>& indices,
+                                   const vector<double>& weights,
+                                   idx_t points_per_sample) {
+        int nd = get_num_dims();
+        int nid = _has_step_dim ? nd - 1 : nd; // indices per point.
+        idx_t npts = nid ? idx_t(indices.size()) / nid : 0;
+        if (points_per_sample < 1 || npts * nid != idx_t(indices.size()) ||
+            npts % points_per_sample)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: add_sample_set(): " << indices.size() <<
+                                            " index(es) is not a whole number of samples of " <<
+                                            points_per_sample << " point(s) with " << nid <<
+                                            " index(es) each in grid '" << get_name() << "'");
+        if (weights.size() && idx_t(weights.size()) != npts)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: add_sample_set(): " << weights.size() <<
+                                            " weight(s) given for " << npts <<
+                                            " point(s) in grid '" << get_name() << "'");
+
+        SampleSet ss;
+        ss.npps = points_per_sample;
+        for (idx_t p = 0; p < npts; p++) {
+            Indices pt(nd);
+            pt.setFromConst(0);
+            for (int i = 0, j = 0; i < nd; i++)
+                if (!(_has_step_dim && i == Indices::step_posn))
+                    pt[i] = indices[p * nid + j++];
+            ss.pts.push_back(pt);
+            ss.wts.push_back(weights.size() ? real_t(weights[p]) : real_t(1));
+        }
+        _sample_sets.push_back(ss);
+        return int(_sample_sets.size()) - 1;
+    }
+
+    // The offsets are found for each alloc'd step, so they don't
+    // depend on the layout being linear in the step dim.
+    void YkGridBase::find_sample_offsets(SampleSet& ss) {
+        idx_t nsteps = _has_step_dim ? _domains[Indices::step_posn] : 1;
+        const real_t* base = (const real_t*)_ggb->get_storage();
+        ss.key = get_storage_key();
+        ss.ofs.assign(nsteps, vector<idx_t>(ss.pts.size()));
+        for (idx_t t = 0; t < nsteps; t++) {
+            for (size_t p = 0; p < ss.pts.size(); p++) {
+                Indices pt(ss.pts[p]);
+                if (_has_step_dim)
+                    pt[Indices::step_posn] = t;
+                checkIndices(pt, "get_samples", true, false);
+                const real_t* ep = getElemPtr(pt, get_alloc_step_index(pt));
+
+                // Storage isn't real_t elements.
+                if (!ep) {
+                    ss.ofs.clear();
+                    return;
+                }
+                ss.ofs[t][p] = ep - base;
+            }
+        }
+    }
+
+    idx_t YkGridBase::get_samples(void* buffer_ptr,
+                                  int set_index,
+                                  idx_t step_index) {
+        if (!is_storage_allocated()) {
+            THROW_YASK_EXCEPTION("Error: call to 'get_samples' with no data allocated for grid '" +
+                                 get_name() + "'");
+        }
+        if (set_index < 0 || set_index >= int(_sample_sets.size()))
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: get_samples(): no sample set " <<
+                                            set_index << " in grid '" << get_name() << "'");
+        auto& ss = _sample_sets[set_index];
+
+        // (Re)find offsets if the layout changed.
+        if (ss.key != get_storage_key())
+            find_sample_offsets(ss);
+
+        real_t* buf = (real_t*)buffer_ptr;
+        idx_t nsamples = idx_t(ss.pts.size()) / ss.npps;
+        idx_t npps = ss.npps;
+        const real_t* wts = ss.wts.data();
+        idx_t asi = _has_step_dim ? _wrap_step(step_index) : 0;
+
+        // Gather from precomputed offsets.
+        if (ss.ofs.size()) {
+            const real_t* base = (const real_t*)_ggb->get_storage();
+            const idx_t* ofs = ss.ofs[asi].data();
+
+#pragma omp parallel for schedule(static) if (nsamples * npps >= _min_par_slice_pts)
+            for (idx_t s = 0; s < nsamples; s++) {
+                real_t sum = 0;
+                for (idx_t j = s * npps; j < (s + 1) * npps; j++)
+                    sum += wts[j] * base[ofs[j]];
+                buf[s] = sum;
+            }
+        }
+
+        // Read each point if storage isn't real_t elements.
+        else {
+#pragma omp parallel for schedule(static) if (nsamples * npps >= _min_par_slice_pts)
+            for (idx_t s = 0; s < nsamples; s++) {
+                real_t sum = 0;
+                for (idx_t j = s * npps; j < (s + 1) * npps; j++) {
+                    Indices pt(ss.pts[j]);
+                    if (_has_step_dim)
+                        pt[Indices::step_posn] = step_index;
+                    sum += wts[j] * readElem(pt, asi, __LINE__);
+                }
+                buf[s] = sum;
+            }
+        }
+        return nsamples;
+    }
+
+    int YkGridBase::add_source_set(const vector<idx_t>& indices,
+                                   const vector<double>& weights,
+                                   idx_t points_per_source,
+                                   const vector<double>& values,
+                                   idx_t first_step_index) {
+
+        // A grid missing a domain dim would get its sources added once
+        // for each block along that dim.
+        for (auto& dim : _dims->_domain_dims.getDims())
+            if (!is_dim_used(dim.getName()))
+                THROW_YASK_EXCEPTION("Error: add_source_set(): grid '" + get_name() +
+                                     "' does not use domain dimension '" +
+                                     dim.getName() + "'");
+
+        // Use the sample-set code to check and store the points.
+        int si = add_sample_set(indices, weights, points_per_source);
+        SourceSet src;
+        src.ss = _sample_sets[si];
+        _sample_sets.pop_back();
+
+        idx_t nsrcs = idx_t(src.ss.pts.size()) / src.ss.npps;
+        if (nsrcs && values.size() % nsrcs)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: add_source_set(): " << values.size() <<
+                                            " value(s) is not a whole number of steps of " <<
+                                            nsrcs << " source(s) in grid '" << get_name() << "'");
+        src.num_steps = nsrcs ? idx_t(values.size()) / nsrcs : 0;
+        src.first_step = first_step_index;
+        for (auto v : values)
+            src.vals.push_back(real_t(v));
+        for (int i = 0; i < get_num_dims(); i++) {
+            auto& dname = get_dim_name(i);
+            bool is_domain = _dims->_domain_dims.lookup(dname) != 0;
+            src.sposns.push_back(is_domain ? _dims->_stencil_dims.lookup_posn(dname) : -1);
+        }
+        _source_sets.push_back(src);
+        return int(_source_sets.size()) - 1;
+    }
+
+    void YkGridBase::prepare_sources() {
+        if (!is_storage_allocated())
+            THROW_YASK_EXCEPTION("Error: sources added with no data allocated for grid '" +
+                                 get_name() + "'");
+        for (auto& src : _source_sets)
+            if (src.ss.key != get_storage_key())
+                find_sample_offsets(src.ss);
+    }
+
+    void YkGridBase::inject_sources(idx_t step_index,
+                                    const Indices& begin, const Indices& end) {
+        idx_t asi = _has_step_dim ? _wrap_step(step_index) : 0;
+        real_t* base = (real_t*)_ggb->get_storage();
+        int nd = get_num_dims();
+
+        for (auto& src : _source_sets) {
+            idx_t k = step_index - src.first_step;
+            if (k < 0 || k >= src.num_steps)
+                continue;
+            auto& ss = src.ss;
+            idx_t npts = ss.pts.size();
+            idx_t nsrcs = npts / ss.npps;
+            const real_t* vals = src.vals.data() + k * nsrcs;
+            const int* sposns = src.sposns.data();
+
+#pragma omp parallel for schedule(static) if (npts >= _min_par_slice_pts)
+            for (idx_t j = 0; j < npts; j++) {
+                auto& pt = ss.pts[j];
+
+                // Skip points not in [begin, end).
+                bool ok = true;
+                for (int i = 0; i < nd; i++) {
+                    int sp = sposns[i];
+                    if (sp >= 0 && (pt[i] < begin[sp] || pt[i] >= end[sp])) {
+                        ok = false;
+                        break;
+                    }
+                }
+                if (!ok)
+                    continue;
+
+                real_t val = ss.wts[j] * vals[j / ss.npps];
+                if (ss.ofs.size()) {
+#pragma omp atomic update
+                    base[ss.ofs[asi][j]] += val;
+                }
+
+                // Update each point if storage isn't real_t elements.
+                else {
+                    Indices pt2(pt);
+                    if (_has_step_dim)
+                        pt2[Indices::step_posn] = step_index;
+                    addToElem(val, pt2, asi, __LINE__);
+                }
+            }
+        }
+    }
+
+    double YkGridBase::reduce_elems(const Indices& first,
+                                    const Indices& last,
+                                    ReduceOp op,
+                                    const std::function<bool (const Indices& pt)>* keep) const {
+        int nd = get_num_dims();
+        double res = 0.0;
+        if (nd == 0)
+            return res;
+        int ip = get_inner_posn();
+        idx_t n = last[ip] - first[ip] + 1;
+        if (n <= 0)
+            return res;
+        vector<real_t> buf(n);
+
+        // Visit each row along the inner dim.
+        Indices pt(first);
+        for (bool done = false; !done; ) {
+            readElemRow(buf.data(), pt, n, get_alloc_step_index(pt));
+            Indices ept(pt);
+            for (idx_t i = 0; i < n; i++) {
+                if (keep) {
+                    ept[ip] = first[ip] + i;
+                    if (!(*keep)(ept))
+                        continue;
+                }
+                double v = buf[i];
+                if (op == reduce_sum)
+                    res += v;
+                else if (op == reduce_sum_sq)
+                    res += v * v;
+                else
+                    res = max(res, fabs(v));
+            }
+
+            // Next row.
+            done = true;
+            for (int j = nd - 1; j >= 0; j--) {
+                if (j == ip)
+                    continue;
+                if (pt[j] < last[j]) {
+                    pt[j]++;
+                    done = false;
+                    break;
+                }
+                pt[j] = first[j];
+            }
+        }
+        return res;
+    }
+
+    // The key includes the concrete type, which determines the
+    // element type, layout and folding.
+    string YkGridBase::get_storage_key() const {
+        ostringstream oss;
+        oss << "name=" << get_name() <<
+            " type=" << typeid(*this).name() <<
+            " bytes=" << get_num_storage_bytes();
+        for (int i = 0; i < get_num_dims(); i++)
+            oss << " " << get_dim_name(i) << "=" << _domains[i] << ":" <<
+                _actl_left_pads[i] << ":" << _actl_right_pads[i] << ":" <<
+                _allocs[i];
+        return oss.str();
+    }
+
+    void YkGridBase::save_storage(const string& fname) const {
+        if (!is_storage_allocated()) {
+            THROW_YASK_EXCEPTION("Error: call to 'save_storage' with no data allocated for grid '" +
+                                 get_name() + "'");
+        }
+        if (get_interleave() > 1)
+            THROW_YASK_EXCEPTION("Error: save_storage(): storage of grid '" + get_name() +
+                                 "' is interleaved with other grids");
+        ostringstream oss;
+        oss << "yask-grid-storage 1" << endl <<
+            "key " << get_storage_key() << endl;
+        string hdr = oss.str();
+        if (hdr.length() >= _storage_file_hdr_bytes)
+            THROW_YASK_EXCEPTION("Error: save_storage(): layout description too long for grid '" +
+                                 get_name() + "'");
+        hdr.resize(_storage_file_hdr_bytes, '\n');
+
+        ofstream ofs(fname, ios::binary);
+        if (ofs.is_open()) {
+            ofs << hdr;
+            ofs.write((const char*)_ggb->get_storage(), get_num_storage_bytes());
+        }
+        if (!ofs)
+            THROW_YASK_EXCEPTION("Error: cannot write storage of grid '" + get_name() +
+                                 "' to '" + fname + "'");
+        get_ostr() << "Saved storage of grid '" << get_name() << "' to '" <<
+            fname << "'.\n";
+    }
+
+    void YkGridBase::map_storage_file() {
+        auto& fname = _storage_file;
+        ifstream ifs(fname);
+        string line1, line2;
+        getline(ifs, line1);
+        getline(ifs, line2);
+        if (line1 != "yask-grid-storage 1")
+            THROW_YASK_EXCEPTION("Error: '" + fname + "' was not written by save_storage()");
+        if (line2 != "key " + get_storage_key())
+            THROW_YASK_EXCEPTION("Error: storage in '" + fname +
+                                 "' does not match the layout of grid '" + get_name() + "'");
+
+        // Map the whole file and use the part after the header.
+        size_t nbytes = _storage_file_hdr_bytes + get_num_storage_bytes();
+        shared_ptr<char> base(fileMap(fname, nbytes), MmapDeleter(nbytes));
+        _ggb->set_storage(base, _storage_file_hdr_bytes);
+        set_dirty_all(true);
+        get_ostr() << "Mapped storage of grid '" << get_name() << "' from '" <<
+            fname << "'.\n";
+    }
+
     void YkGridBase::share_storage(yk_grid_ptr source) {
         auto sp = dynamic_pointer_cast<YkGridBase>(source);
         assert(sp);
@@ -303,18 +655,12 @@ namespace yask {
         // Find range.
         IdxTuple numElemsTuple = get_slice_range(first_indices, last_indices);
         
-        // Visit points in slice.
-        numElemsTuple.visitAllPointsInParallel
-            ([&](const IdxTuple& ofs, size_t idx) {
-                Indices pt = first_indices.addElements(ofs);
-
-                // TODO: move this outside of loop for const step index.
-                idx_t asi = get_alloc_step_index(pt);
-                
-                real_t val = readElem(pt, asi, __LINE__);
-                ((real_t*)buffer_ptr)[idx] = val;
-                return true;    // keep going.
-            });
+        // Copy rows of slice.
+        real_t* buf = (real_t*)buffer_ptr;
+        _visit_slice_rows(first_indices, last_indices,
+                          [&](const Indices& pt, idx_t idx, idx_t n, idx_t asi) {
+                              readElemRow(buf + idx, pt, n, asi);
+                          });
         return numElemsTuple.product();
     }
     idx_t YkGridBase::set_elements_in_slice_same(double val,
@@ -334,17 +680,12 @@ namespace yask {
         // Find range.
         IdxTuple numElemsTuple = get_slice_range(first, last);
 
-        // Visit points in slice.
-        numElemsTuple.visitAllPointsInParallel([&](const IdxTuple& ofs,
-                                                   size_t idx) {
-                Indices pt = first.addElements(ofs);
-
-                // TODO: move this outside of loop for const step index.
-                idx_t asi = get_alloc_step_index(pt);
-
-                writeElem(real_t(val), pt, asi, __LINE__);
-                return true;    // keep going.
-            });
+        // Set rows of slice.
+        real_t rval = real_t(val);
+        _visit_slice_rows(first, last,
+                          [&](const Indices& pt, idx_t idx, idx_t n, idx_t asi) {
+                              writeElemRow(&rval, 0, pt, n, asi);
+                          });
 
         // Set appropriate dirty flag(s).
         set_dirty_in_slice(first, last);
@@ -362,19 +703,12 @@ namespace yask {
         // Find range.
         IdxTuple numElemsTuple = get_slice_range(first_indices, last_indices);
 
-        // Visit points in slice.
-        numElemsTuple.visitAllPointsInParallel
-            ([&](const IdxTuple& ofs,
-                 size_t idx) {
-                Indices pt = first_indices.addElements(ofs);
-
-                // TODO: move this outside of loop for const step index.
-                idx_t asi = get_alloc_step_index(pt);
-
-                real_t val = ((real_t*)buffer_ptr)[idx];
-                writeElem(val, pt, asi, __LINE__);
-                return true;    // keep going.
-            });
+        // Copy rows of slice.
+        const real_t* buf = (const real_t*)buffer_ptr;
+        _visit_slice_rows(first_indices, last_indices,
+                          [&](const Indices& pt, idx_t idx, idx_t n, idx_t asi) {
+                              writeElemRow(buf + idx, 1, pt, n, asi);
+                          });
 
         // Set appropriate dirty flag(s).
         set_dirty_in_slice(first_indices, last_indices);
@@ -382,5 +716,123 @@ namespace yask {
         return numElemsTuple.product();
     }
 
-} // namespace.
+    idx_t YkGridBase::set_elements_from_profile(const string& dim,
+                                                idx_t first_index,
+                                                const vector<double>& values) {
+        if (!is_storage_allocated())
+            return 0;
+        int dp = get_dim_posn(dim, true, "set_elements_from_profile");
+        if (dim == _dims->_step_dim)
+            THROW_YASK_EXCEPTION("Error: set_elements_from_profile() called with step dimension '" +
+                                 dim + "' for grid '" + get_name() + "'");
+        if (!values.size())
+            THROW_YASK_EXCEPTION("Error: set_elements_from_profile() called with no values for grid '" +
+                                 get_name() + "'");
+        idx_t nv = values.size();
+        return _set_all_elements([&](const Indices& pt) {
+                idx_t k = min(max(pt[dp] - first_index, idx_t(0)), nv - 1);
+                return values[k];
+            });
+    }
+
+    idx_t YkGridBase::set_elements_from_layers(const string& dim,
+                                               const vector<idx_t>& boundaries,
+                                               const vector<double>& values) {
+        if (!is_storage_allocated())
+            return 0;
+        int dp = get_dim_posn(dim, true, "set_elements_from_layers");
+        if (dim == _dims->_step_dim)
+            THROW_YASK_EXCEPTION("Error: set_elements_from_layers() called with step dimension '" +
+                                 dim + "' for grid '" + get_name() + "'");
+        if (values.size() != boundaries.size() + 1)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: set_elements_from_layers() called with " <<
+                                            values.size() << " values and " <<
+                                            boundaries.size() << " boundaries for grid '" <<
+                                            get_name() << "'");
+        for (size_t i = 1; i < boundaries.size(); i++)
+            if (boundaries[i] < boundaries[i - 1])
+                THROW_YASK_EXCEPTION("Error: set_elements_from_layers() called with boundaries"
+                                     " not in increasing order for grid '" + get_name() + "'");
+
+        // Convert to a profile over the allocated range; there is
+        // usually only one layer boundary per few hundred elements.
+        idx_t first = _get_first_alloc_index(dp);
+        idx_t last = _get_last_alloc_index(dp);
+        vector<double> prof;
+        prof.reserve(last - first + 1);
+        size_t k = 0;
+        for (idx_t i = first; i <= last; i++) {
+            while (k < boundaries.size() && boundaries[k] <= i)
+                k++;
+            prof.push_back(values[k]);
+        }
+        return set_elements_from_profile(dim, first, prof);
+    }
+
+    idx_t YkGridBase::set_elements_from_coarse_grid(const vector<double>& values,
+                                                    const vector<idx_t>& coarse_sizes,
+                                                    const vector<idx_t>& spacings,
+                                                    bool linear) {
+        if (!is_storage_allocated())
+            return 0;
+
+        // Positions of the domain dims in this grid.
+        int nd = get_num_dims();
+        vector<int> dposns;
+        for (int i = 0; i < nd; i++)
+            if (_dims->_domain_dims.lookup(get_dim_name(i)))
+                dposns.push_back(i);
+        int ndd = dposns.size();
+        if (int(coarse_sizes.size()) != ndd || int(spacings.size()) != ndd)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: set_elements_from_coarse_grid() called with " <<
+                                            coarse_sizes.size() << " sizes and " <<
+                                            spacings.size() << " spacings for grid '" <<
+                                            get_name() << "' with " << ndd <<
+                                            " domain dimension(s)");
+        idx_t nv = 1;
+        for (int j = 0; j < ndd; j++) {
+            if (coarse_sizes[j] < 1 || spacings[j] < 1)
+                THROW_YASK_EXCEPTION("Error: set_elements_from_coarse_grid() called with"
+                                     " non-positive size or spacing for grid '" +
+                                     get_name() + "'");
+            nv *= coarse_sizes[j];
+        }
+        if (idx_t(values.size()) != nv)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: set_elements_from_coarse_grid() called with " <<
+                                            values.size() << " values instead of " << nv <<
+                                            " for grid '" << get_name() << "'");
+
+        return _set_all_elements([&](const Indices& pt) {
+
+                // Lower coarse point and weight of the upper one in each dim.
+                idx_t i0[MAX_DIMS];
+                double w[MAX_DIMS];
+                for (int j = 0; j < ndd; j++) {
+                    idx_t n = coarse_sizes[j];
+                    double c = double(pt[dposns[j]]) / spacings[j];
+                    c = min(max(c, 0.0), double(n - 1));
+                    if (!linear)
+                        c = floor(c + 0.5);
+                    i0[j] = min(idx_t(c), max(n - 2, idx_t(0)));
+                    w[j] = (n > 1) ? c - i0[j] : 0.0;
+                }
+
+                // Sum over the corners of the coarse cell, skipping
+                // those with zero weight.
+                double val = 0.0;
+                for (int c = 0; c < (1 << ndd); c++) {
+                    double cw = 1.0;
+                    idx_t vi = 0;
+                    for (int j = 0; j < ndd; j++) {
+                        bool upper = (c >> j) & 1;
+                        cw *= upper ? w[j] : 1.0 - w[j];
+                        vi = vi * coarse_sizes[j] + i0[j] + (upper ? 1 : 0);
+                    }
+                    if (cw != 0.0)
+                        val += cw * values[vi];
+                }
+                return val;
+            });
+    }
 
+} // namespace.
@@ -34,6 +34,10 @@ namespace yask {
     const idx_t idx_max = INT64_MAX;
     const idx_t idx_min = INT64_MIN;
 
+#if defined(USE_INTRIN_SVE) && !defined(SVE_BITS)
+#error "SVE_BITS must be set when USE_INTRIN_SVE is defined"
+#endif
+
     // values for 32-bit, single-precision reals.
 #if REAL_BYTES == 4
     typedef float real_t;
@@ -53,6 +57,18 @@ namespace yask {
 #define VEC_ELEMS 16
 #define INAME(op) _mm512_ ## op ## _ps
 #define INAMEI(op) _mm512_ ## op ## _epi32
+#elif defined(USE_INTRIN_SVE)
+    const idx_t vec_elems = SVE_BITS / 32;
+    typedef float imem_t;
+    typedef uidx_t real_mask_t;
+#define VEC_ELEMS (SVE_BITS / 32)
+#define INAME(op) sve_ ## op
+#elif defined(USE_INTRIN_NEON)
+    const idx_t vec_elems = 4;
+    typedef float imem_t;
+    typedef uidx_t real_mask_t;
+#define VEC_ELEMS 4
+#define INAME(op) neon_ ## op
 #endif
 
     // values for 64-bit, double-precision reals.
@@ -74,6 +90,18 @@ namespace yask {
 #define VEC_ELEMS 8
 #define INAME(op) _mm512_ ## op ## _pd
 #define INAMEI(op) _mm512_ ## op ## _epi64
+#elif defined(USE_INTRIN_SVE)
+    const idx_t vec_elems = SVE_BITS / 64;
+    typedef double imem_t;
+    typedef uidx_t real_mask_t;
+#define VEC_ELEMS (SVE_BITS / 64)
+#define INAME(op) sve_ ## op
+#elif defined(USE_INTRIN_NEON)
+    const idx_t vec_elems = 2;
+    typedef double imem_t;
+    typedef uidx_t real_mask_t;
+#define VEC_ELEMS 2
+#define INAME(op) neon_ ## op
 #endif
 
 #else
@@ -81,14 +109,19 @@ namespace yask {
 #endif
 
     // Emulate instrinsics for unsupported VLEN.
-    // Only 256 and 512-bit vectors supported.
+    // Only 256 and 512-bit x86 vectors, SVE vectors of SVE_BITS,
+    // and 128-bit NEON vectors supported.
     // VLEN == 1 also supported as scalar.
 #if VLEN == 1
 #define NO_INTRINSICS
     // note: no warning here because intrinsics aren't wanted in this case.
 
 #elif !defined(INAME)
-#warning "Emulating intrinsics because HW vector length not defined; check setting of USE_INTRIN256 or USE_INTRIN512 in kernel Makefile"
+#warning "Emulating intrinsics because HW vector length not defined; check setting of USE_INTRIN256, USE_INTRIN512, USE_INTRIN_SVE, or USE_INTRIN_NEON in kernel Makefile"
+#define NO_INTRINSICS
+
+#elif defined(USE_INTRIN_SVE) && (!defined(__ARM_FEATURE_SVE_BITS) || __ARM_FEATURE_SVE_BITS != SVE_BITS)
+#warning "Emulating intrinsics because SVE_BITS does not match the compiler's fixed SVE vector length; check -msve-vector-bits"
 #define NO_INTRINSICS
 
 #elif VLEN != VEC_ELEMS
@@ -115,7 +148,9 @@ namespace yask {
 
     // fence needed before loads after streaming stores.
     inline void make_stores_visible() {
-#if defined(USE_STREAMING_STORE)
+#if defined(USE_INTRIN_ARM)
+        __sync_synchronize();
+#else
         _mm_mfence();
 #endif
     }
@@ -127,6 +162,85 @@ namespace yask {
 #define ALWAYS_INLINE __attribute__((always_inline)) inline
 #endif
 
+    // ARM SIMD types and wrappers named so that the INAME() calls
+    // below work the same way as the x86 intrinsics.
+#if defined(USE_INTRIN_SVE) && !defined(NO_INTRINSICS)
+
+    // Fixed-length SVE types, so they can be overlaid in a union.
+    // The predicated ops below still use the vector-length-agnostic
+    // ACLE intrinsics, with all lanes of SVE_BITS active.
+#if REAL_BYTES == 4
+    typedef svfloat32_t sve_real_t __attribute__((arm_sve_vector_bits(SVE_BITS)));
+    typedef svuint32_t sve_ctrl_t __attribute__((arm_sve_vector_bits(SVE_BITS)));
+#define SVE_PTRUE svptrue_b32()
+#define SVE_DUP(v) svdup_n_f32(v)
+#define SVE_DUPC(v) svdup_n_u32(v)
+#define SVE_INDEX svindex_u32(0, 1)
+#else
+    typedef svfloat64_t sve_real_t __attribute__((arm_sve_vector_bits(SVE_BITS)));
+    typedef svuint64_t sve_ctrl_t __attribute__((arm_sve_vector_bits(SVE_BITS)));
+#define SVE_PTRUE svptrue_b64()
+#define SVE_DUP(v) svdup_n_f64(v)
+#define SVE_DUPC(v) svdup_n_u64(v)
+#define SVE_INDEX svindex_u64(0, 1)
+#endif
+
+    // Predicate with lane i active iff bit i of 'k1' is set.
+    ALWAYS_INLINE svbool_t sve_mask_pred(uidx_t k1) {
+        svbool_t pg = SVE_PTRUE;
+        sve_ctrl_t bits = svlsr_x(pg, SVE_DUPC(ctrl_t(k1)), SVE_INDEX);
+        return svcmpne(pg, svand_x(pg, bits, ctrl_t(1)), ctrl_t(0));
+    }
+
+    ALWAYS_INLINE sve_real_t sve_set1(real_t v) { return SVE_DUP(v); }
+    ALWAYS_INLINE sve_real_t sve_setzero() { return SVE_DUP(real_t(0)); }
+    ALWAYS_INLINE sve_real_t sve_add(sve_real_t a, sve_real_t b) { return svadd_x(SVE_PTRUE, a, b); }
+    ALWAYS_INLINE sve_real_t sve_sub(sve_real_t a, sve_real_t b) { return svsub_x(SVE_PTRUE, a, b); }
+    ALWAYS_INLINE sve_real_t sve_mul(sve_real_t a, sve_real_t b) { return svmul_x(SVE_PTRUE, a, b); }
+    ALWAYS_INLINE sve_real_t sve_div(sve_real_t a, sve_real_t b) { return svdiv_x(SVE_PTRUE, a, b); }
+    ALWAYS_INLINE sve_real_t sve_load(const real_t* p) { return svld1(SVE_PTRUE, p); }
+    ALWAYS_INLINE sve_real_t sve_loadu(const real_t* p) { return svld1(SVE_PTRUE, p); }
+    ALWAYS_INLINE void sve_store(real_t* p, sve_real_t v) { svst1(SVE_PTRUE, p, v); }
+    ALWAYS_INLINE void sve_stream(real_t* p, sve_real_t v) { svstnt1(SVE_PTRUE, p, v); }
+    ALWAYS_INLINE void sve_mask_store(real_t* p, uidx_t k1, sve_real_t v) {
+        svst1(sve_mask_pred(k1), p, v);
+    }
+
+#elif defined(USE_INTRIN_NEON) && !defined(NO_INTRINSICS)
+
+#if REAL_BYTES == 4
+    typedef float32x4_t neon_real_t;
+    typedef uint32x4_t neon_ctrl_t;
+#define NEON_NAME(op) op ## _f32
+#define NEON_NAMEC(op) op ## _u32
+#define NEON_LANE_BITS { 1, 2, 4, 8 }
+#else
+    typedef float64x2_t neon_real_t;
+    typedef uint64x2_t neon_ctrl_t;
+#define NEON_NAME(op) op ## _f64
+#define NEON_NAMEC(op) op ## _u64
+#define NEON_LANE_BITS { 1, 2 }
+#endif
+
+    ALWAYS_INLINE neon_real_t neon_set1(real_t v) { return NEON_NAME(vdupq_n)(v); }
+    ALWAYS_INLINE neon_real_t neon_setzero() { return NEON_NAME(vdupq_n)(real_t(0)); }
+    ALWAYS_INLINE neon_real_t neon_add(neon_real_t a, neon_real_t b) { return NEON_NAME(vaddq)(a, b); }
+    ALWAYS_INLINE neon_real_t neon_sub(neon_real_t a, neon_real_t b) { return NEON_NAME(vsubq)(a, b); }
+    ALWAYS_INLINE neon_real_t neon_mul(neon_real_t a, neon_real_t b) { return NEON_NAME(vmulq)(a, b); }
+    ALWAYS_INLINE neon_real_t neon_div(neon_real_t a, neon_real_t b) { return NEON_NAME(vdivq)(a, b); }
+    ALWAYS_INLINE neon_real_t neon_load(const real_t* p) { return NEON_NAME(vld1q)(p); }
+    ALWAYS_INLINE neon_real_t neon_loadu(const real_t* p) { return NEON_NAME(vld1q)(p); }
+    ALWAYS_INLINE void neon_store(real_t* p, neon_real_t v) { NEON_NAME(vst1q)(p, v); }
+    ALWAYS_INLINE void neon_stream(real_t* p, neon_real_t v) { NEON_NAME(vst1q)(p, v); }
+
+    // No masked store in NEON, so blend w/the old values.
+    ALWAYS_INLINE void neon_mask_store(real_t* p, uidx_t k1, neon_real_t v) {
+        const neon_ctrl_t lane_bits = NEON_LANE_BITS;
+        neon_ctrl_t sel = NEON_NAMEC(vtstq)(NEON_NAMEC(vdupq_n)(ctrl_t(k1)), lane_bits);
+        NEON_NAME(vst1q)(p, NEON_NAME(vbslq)(sel, v, NEON_NAME(vld1q)(p)));
+    }
+#endif
+
     // The following union is used to overlay C arrays with vector types.
     // It must be an aggregate type to allow aggregate initialization,
     // so no user-provided ctors, copy operator, virtual member functions, etc.
@@ -150,6 +264,10 @@ namespace yask {
         __m256d mr;
 #elif REAL_BYTES == 8 && defined(USE_INTRIN512)
         __m512d mr;
+#elif defined(USE_INTRIN_SVE)
+        sve_real_t mr;
+#elif defined(USE_INTRIN_NEON)
+        neon_real_t mr;
 #endif
 
         // Integer SIMD-type overlay.
@@ -157,6 +275,10 @@ namespace yask {
         __m256i mi;
 #elif defined(USE_INTRIN512)
         __m512i mi;
+#elif defined(USE_INTRIN_SVE)
+        sve_ctrl_t mi;
+#elif defined(USE_INTRIN_NEON)
+        neon_ctrl_t mi;
 #endif
 
 #endif
@@ -436,6 +558,27 @@ namespace yask {
 #endif
         }
 
+        // masked store that uses a streaming store instead if 'nt' is set
+        // and all elements are written, because there are no masked
+        // streaming stores.
+        ALWAYS_INLINE void storeTo_masked_nt(real_vec_t* __restrict__ to, uidx_t k1,
+                                             bool nt) const {
+#if defined(NO_INTRINSICS) || defined(NO_STORE_INTRINSICS)
+            storeTo_masked(to, k1);
+#else
+            const uidx_t all = (uidx_t(1) << VLEN) - 1;
+            if (nt && (k1 & all) == all) {
+#if defined(ARCH_KNC)
+                INAME(storenrngo)((imem_t*)to, u.mr);
+#else
+                INAME(stream)((imem_t*)to, u.mr);
+#endif
+            }
+            else
+                storeTo_masked(to, k1);
+#endif
+        }
+
         // Output.
         void print_ctrls(std::ostream& os, bool doEnd=true) const {
             for (int j = 0; j < VLEN; j++) {
@@ -517,6 +660,12 @@ namespace yask {
         // For KNC, for 64-bit align, use the 32-bit op w/2x count.
         res.u.mi = _mm512_alignr_epi32(a.u.mi, b.u.mi, count*2);
 
+#elif defined(USE_INTRIN_SVE)
+        res.u.mr = svext(b.u.mr, a.u.mr, count);
+
+#elif defined(USE_INTRIN_NEON)
+        res.u.mr = NEON_NAME(vextq)(b.u.mr, a.u.mr, count);
+
 #else
         res.u.mi = INAMEI(alignr)(a.u.mi, b.u.mi, count);
 #endif
@@ -544,7 +693,7 @@ namespace yask {
         std::cout << " mask: 0x" << std::hex << k1 << std::endl;
 #endif
 
-#if defined(NO_INTRINSICS) || !defined(USE_INTRIN512)
+#if defined(NO_INTRINSICS) || !(defined(USE_INTRIN512) || defined(USE_INTRIN_SVE))
         // must make temp copies in case &res == &a or &b.
         real_vec_t tmpa = a, tmpb = b;
         for (int i = 0; i < VLEN-count; i++)
@@ -553,6 +702,8 @@ namespace yask {
         for (int i = VLEN-count; i < VLEN; i++)
             if ((k1 >> i) & 1)
                 res.u.r[i] = tmpa.u.r[i + count - VLEN];
+#elif defined(USE_INTRIN_SVE)
+        res.u.mr = svsel(sve_mask_pred(k1), svext(b.u.mr, a.u.mr, count), res.u.mr);
 #else
         res.u.mi = INAMEI(mask_alignr)(res.u.mi, real_mask_t(k1), a.u.mi, b.u.mi, count);
 #endif
@@ -574,11 +725,13 @@ namespace yask {
         a.print_reals(std::cout);
 #endif
 
-#if defined(NO_INTRINSICS) || !defined(USE_INTRIN512)
+#if defined(NO_INTRINSICS) || !(defined(USE_INTRIN512) || defined(USE_INTRIN_SVE))
         // must make a temp copy in case &res == &a.
         real_vec_t tmp = a;
         for (int i = 0; i < VLEN; i++)
             res.u.r[i] = tmp.u.r[ctrl.u.ci[i]];
+#elif defined(USE_INTRIN_SVE)
+        res.u.mr = svtbl(a.u.mr, ctrl.u.mi);
 #else
         res.u.mi = INAMEI(permutexvar)(ctrl.u.mi, a.u.mi);
 #endif
@@ -604,13 +757,15 @@ namespace yask {
         res.print_reals(std::cout);
 #endif
 
-#if defined(NO_INTRINSICS) || !defined(USE_INTRIN512)
+#if defined(NO_INTRINSICS) || !(defined(USE_INTRIN512) || defined(USE_INTRIN_SVE))
         // must make a temp copy in case &res == &a.
         real_vec_t tmp = a;
         for (int i = 0; i < VLEN; i++) {
             if ((k1 >> i) & 1)
                 res.u.r[i] = tmp.u.r[ctrl.u.ci[i]];
         }
+#elif defined(USE_INTRIN_SVE)
+        res.u.mr = svsel(sve_mask_pred(k1), svtbl(a.u.mr, ctrl.u.mi), res.u.mr);
 #else
         res.u.mi = INAMEI(mask_permutexvar)(res.u.mi, real_mask_t(k1), ctrl.u.mi, a.u.mi);
 #endif
@@ -662,10 +817,345 @@ namespace yask {
 #endif
     }
 
+    // Reduced-precision storage types.
+    // Values are converted to and from real_t when loaded and stored,
+    // so all arithmetic is done at full precision.
+
+    // bfloat16: the upper 16 bits of an IEEE single.
+    struct bf16_t {
+        ::uint16_t bits;
+
+        ALWAYS_INLINE static bf16_t from_float(float f) {
+            ::uint32_t x;
+            memcpy(&x, &f, sizeof(x));
+            bf16_t h;
+            if ((x & 0x7fffffffu) > 0x7f800000u)
+                h.bits = ::uint16_t((x >> 16) | 0x40); // quiet NaN.
+            else {
+                x += 0x7fffu + ((x >> 16) & 1); // round to nearest even.
+                h.bits = ::uint16_t(x >> 16);
+            }
+            return h;
+        }
+        ALWAYS_INLINE float to_float() const {
+            ::uint32_t x = ::uint32_t(bits) << 16;
+            float f;
+            memcpy(&f, &x, sizeof(f));
+            return f;
+        }
+    };
+
+    // IEEE half precision.
+    struct fp16_t {
+        ::uint16_t bits;
+
+        ALWAYS_INLINE static fp16_t from_float(float f) {
+            fp16_t h;
+#ifdef __F16C__
+            h.bits = _cvtss_sh(f, 0);
+#else
+            ::uint32_t x;
+            memcpy(&x, &f, sizeof(x));
+            ::uint32_t sign = (x >> 16) & 0x8000u;
+            x &= 0x7fffffffu;
+            if (x >= 0x47800000u)      // inf, NaN, or too big.
+                h.bits = (x > 0x7f800000u) ? 0x7e00 : 0x7c00;
+            else if (x < 0x38800000u) { // subnormal or zero.
+                float af;
+                memcpy(&af, &x, sizeof(af));
+                af += 0.5f;
+                memcpy(&x, &af, sizeof(x));
+                h.bits = ::uint16_t(x - 0x3f000000u);
+            }
+            else {
+                ::uint32_t odd = (x >> 13) & 1;
+                x += 0xc8000fffu + odd; // rebias and round to nearest even.
+                h.bits = ::uint16_t(x >> 13);
+            }
+            h.bits |= ::uint16_t(sign);
+#endif
+            return h;
+        }
+        ALWAYS_INLINE float to_float() const {
+#ifdef __F16C__
+            return _cvtsh_ss(bits);
+#else
+            const ::uint32_t shifted_exp = 0x7c00u << 13;
+            ::uint32_t x = (::uint32_t(bits) & 0x7fffu) << 13;
+            ::uint32_t exp = x & shifted_exp;
+            x += (127 - 15) << 23;
+            float f;
+            if (exp == shifted_exp) {  // inf or NaN.
+                x += (128 - 16) << 23;
+                memcpy(&f, &x, sizeof(f));
+            }
+            else if (exp == 0) {       // subnormal or zero.
+                x += 1 << 23;
+                memcpy(&f, &x, sizeof(f));
+                f -= 6.103515625e-05f; // 2^-14.
+            }
+            else
+                memcpy(&f, &x, sizeof(f));
+            ::uint32_t sign = (::uint32_t(bits) & 0x8000u) << 16;
+            memcpy(&x, &f, sizeof(x));
+            x |= sign;
+            memcpy(&f, &x, sizeof(f));
+            return f;
+#endif
+        }
+    };
+
+    // Storage for a folded vector of reduced-precision values.
+    // Converts implicitly to and from real_vec_t, so it can be used
+    // in place of real_vec_t for reading and writing grid vectors.
+    template <typename HT>
+    struct real_vec_lp_t {
+        HT h[VLEN];
+
+        // default ctor does not init data!
+        ALWAYS_INLINE real_vec_lp_t() {}
+
+        // convert from full precision.
+        ALWAYS_INLINE real_vec_lp_t(const real_vec_t& val) {
+            operator=(val);
+        }
+
+        // broadcast scalar.
+        ALWAYS_INLINE real_vec_lp_t(double val) {
+            REAL_VEC_LOOP_UNALIGNED(i) h[i] = HT::from_float(float(val));
+        }
+
+        ALWAYS_INLINE real_vec_lp_t& operator=(const real_vec_t& rhs);
+        ALWAYS_INLINE operator real_vec_t() const;
+
+        // get length.
+        inline int get_num_elems() const {
+            return VLEN;
+        }
+
+        // access one element.
+        ALWAYS_INLINE real_t get_elem(idx_t l) const {
+            assert(l >= 0);
+            assert(l < VLEN);
+            return real_t(h[l].to_float());
+        }
+        ALWAYS_INLINE void set_elem(idx_t l, real_t val) {
+            assert(l >= 0);
+            assert(l < VLEN);
+            h[l] = HT::from_float(float(val));
+        }
+    };
+    typedef real_vec_lp_t<bf16_t> real_vec_bf16_t;
+    typedef real_vec_lp_t<fp16_t> real_vec_fp16_t;
+
+    // Generic conversions.
+    template <typename HT>
+    ALWAYS_INLINE real_vec_lp_t<HT>& real_vec_lp_t<HT>::operator=(const real_vec_t& rhs) {
+        REAL_VEC_LOOP_UNALIGNED(i) h[i] = HT::from_float(float(rhs[i]));
+        return *this;
+    }
+    template <typename HT>
+    ALWAYS_INLINE real_vec_lp_t<HT>::operator real_vec_t() const {
+        real_vec_t res;
+        REAL_VEC_LOOP_UNALIGNED(i) res[i] = real_t(h[i].to_float());
+        return res;
+    }
+
+    // Product at full precision, e.g., for initialization.
+    template <typename HT>
+    ALWAYS_INLINE real_vec_lp_t<HT> operator*(const real_vec_lp_t<HT>& lhs,
+                                              const real_vec_lp_t<HT>& rhs) {
+        return real_vec_t(lhs) * real_vec_t(rhs);
+    }
+
+    // Vector conversions for the common cases.
+#if REAL_BYTES == 4 && !defined(NO_INTRINSICS)
+#if defined(USE_INTRIN512)
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<fp16_t>& real_vec_lp_t<fp16_t>::operator=(const real_vec_t& rhs) {
+        _mm256_storeu_si256((__m256i*)h, _mm512_cvtps_ph(rhs.u.mr, _MM_FROUND_TO_NEAREST_INT));
+        return *this;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<fp16_t>::operator real_vec_t() const {
+        real_vec_t res;
+        res.u.mr = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)h));
+        return res;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<bf16_t>::operator real_vec_t() const {
+        real_vec_t res;
+        res.u.mr = _mm512_castsi512_ps
+            (_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)h)), 16));
+        return res;
+    }
+#elif defined(USE_INTRIN256)
+#ifdef __F16C__
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<fp16_t>& real_vec_lp_t<fp16_t>::operator=(const real_vec_t& rhs) {
+        _mm_storeu_si128((__m128i*)h, _mm256_cvtps_ph(rhs.u.mr, _MM_FROUND_TO_NEAREST_INT));
+        return *this;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<fp16_t>::operator real_vec_t() const {
+        real_vec_t res;
+        res.u.mr = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)h));
+        return res;
+    }
+#endif
+#ifdef __AVX2__
+    template <>
+    ALWAYS_INLINE real_vec_lp_t<bf16_t>::operator real_vec_t() const {
+        real_vec_t res;
+        res.u.mr = _mm256_castsi256_ps
+            (_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)h)), 16));
+        return res;
+    }
+#endif
+#endif
+#endif
+
+    // Lookup-table-compressed storage.
+    // Each element is an index into a table of distinct values kept by
+    // the grid, so the vector can only be decoded with that table.
+    template <typename IT>
+    struct real_vec_lut_t {
+        IT i[VLEN];
+
+        // get length.
+        inline int get_num_elems() const {
+            return VLEN;
+        }
+    };
+    typedef real_vec_lut_t<::uint8_t> real_vec_lut8_t;
+    typedef real_vec_lut_t<::uint16_t> real_vec_lut16_t;
+
+    // Gather the table values for the indices in 'v'.
+    template <typename IT>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut_t<IT>& v) {
+        real_vec_t res;
+        REAL_VEC_LOOP_UNALIGNED(j) res[j] = tbl[v.i[j]];
+        return res;
+    }
+
+    // Vector gathers for the common cases.
+    // The masked forms avoid reading an undefined source vector.
+#if !defined(NO_INTRINSICS)
+#if defined(USE_INTRIN512) && defined(__AVX512F__)
+#if REAL_BYTES == 4
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut8_t& v) {
+        real_vec_t res;
+        __m512i idx = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)v.i));
+        res.u.mr = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), __mmask16(0xffff), idx, tbl, sizeof(real_t));
+        return res;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut16_t& v) {
+        real_vec_t res;
+        __m512i idx = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)v.i));
+        res.u.mr = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), __mmask16(0xffff), idx, tbl, sizeof(real_t));
+        return res;
+    }
+#else
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut8_t& v) {
+        real_vec_t res;
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)v.i));
+        res.u.mr = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xff), idx, tbl, sizeof(real_t));
+        return res;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut16_t& v) {
+        real_vec_t res;
+        __m256i idx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)v.i));
+        res.u.mr = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xff), idx, tbl, sizeof(real_t));
+        return res;
+    }
+#endif
+#elif defined(USE_INTRIN256) && defined(__AVX2__)
+#if REAL_BYTES == 4
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut8_t& v) {
+        real_vec_t res;
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)v.i));
+        res.u.mr = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), tbl, idx,
+                                            _mm256_castsi256_ps(_mm256_set1_epi32(-1)), sizeof(real_t));
+        return res;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut16_t& v) {
+        real_vec_t res;
+        __m256i idx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)v.i));
+        res.u.mr = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), tbl, idx,
+                                            _mm256_castsi256_ps(_mm256_set1_epi32(-1)), sizeof(real_t));
+        return res;
+    }
+#else
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut8_t& v) {
+        real_vec_t res;
+        ::int32_t ibits;
+        memcpy(&ibits, v.i, sizeof(ibits));
+        __m128i idx = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(ibits));
+        res.u.mr = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), tbl, idx,
+                                            _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), sizeof(real_t));
+        return res;
+    }
+    template <>
+    ALWAYS_INLINE real_vec_t lut_gather(const real_t* tbl, const real_vec_lut16_t& v) {
+        real_vec_t res;
+        __m128i idx = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)v.i));
+        res.u.mr = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), tbl, idx,
+                                            _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), sizeof(real_t));
+        return res;
+    }
+#endif
+#endif
+#endif
+
+    // Access one element of a full- or reduced-precision vector.
+    ALWAYS_INLINE real_t get_vec_elem(const real_vec_t& v, idx_t l) {
+        return v[l];
+    }
+    template <typename HT>
+    ALWAYS_INLINE real_t get_vec_elem(const real_vec_lp_t<HT>& v, idx_t l) {
+        return v.get_elem(l);
+    }
+    ALWAYS_INLINE void set_vec_elem(real_vec_t& v, idx_t l, real_t val) {
+        v[l] = val;
+    }
+    template <typename HT>
+    ALWAYS_INLINE void set_vec_elem(real_vec_lp_t<HT>& v, idx_t l, real_t val) {
+        v.set_elem(l, val);
+    }
+
+    // Pointer to one element, or null if the storage is not real_t.
+    ALWAYS_INLINE const real_t* get_vec_elem_ptr(const real_vec_t& v, idx_t l) {
+        return &v[l];
+    }
+    template <typename HT>
+    ALWAYS_INLINE const real_t* get_vec_elem_ptr(const real_vec_lp_t<HT>& v, idx_t l) {
+        return 0;
+    }
+    template <typename IT>
+    ALWAYS_INLINE const real_t* get_vec_elem_ptr(const real_vec_lut_t<IT>& v, idx_t l) {
+        return 0;
+    }
+
+    // Name of the vector storage type for messages.
+    inline const char* get_vec_type_descr(const real_vec_t*) { return "SIMD FP"; }
+    inline const char* get_vec_type_descr(const real_vec_bf16_t*) { return "SIMD BF16"; }
+    inline const char* get_vec_type_descr(const real_vec_fp16_t*) { return "SIMD FP16"; }
+    inline const char* get_vec_type_descr(const real_vec_lut8_t*) { return "SIMD LUT8"; }
+    inline const char* get_vec_type_descr(const real_vec_lut16_t*) { return "SIMD LUT16"; }
+
     // Prefetch wrapper.
     template <int level>
     inline void prefetch(const void* p) {
-#if defined(__INTEL_COMPILER)
+#if defined(USE_INTRIN_ARM)
+        __builtin_prefetch(p, 0, level);
+#elif defined(__INTEL_COMPILER)
         _mm_prefetch((const char*)p, level);
 #else
         _mm_prefetch(p, (enum _mm_hint)level);
@@ -702,6 +1192,11 @@ namespace yask {
         }
         return true;
     }
+    template <typename HT>
+    inline bool within_tolerance(const real_vec_lp_t<HT>& val, const real_vec_lp_t<HT>& ref,
+                                 const real_vec_lp_t<HT>& epsilon) {
+        return within_tolerance(real_vec_t(val), real_vec_t(ref), real_vec_t(epsilon));
+    }
 
 }
 #endif
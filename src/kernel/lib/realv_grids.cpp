@@ -32,15 +32,23 @@ namespace yask {
 
     // Ctor.
     YkGridBase::YkGridBase(GenericGridBase* ggb,
-                           size_t ndims,
+                           const GridDimNames& dimNames,
                            DimsPtr dims) :
     _ggb(ggb), _dims(dims) {
 
         assert(ggb);
         assert(dims.get());
+
+        // Find stencil dims in this grid.
+        // Cannot use '_ggb' yet because it is constructed after this.
+        for (auto& sdim : dims->_stencil_dims.getDims()) {
+            auto i = find(dimNames.begin(), dimNames.end(), sdim.getName());
+            _dim_id_posns.push_back(i == dimNames.end() ? -1 :
+                                    int(i - dimNames.begin()));
+        }
         
         // Init indices.
-        int n = int(ndims);
+        int n = int(dimNames.size());
         _domains.setFromConst(0, n);
         _req_left_pads.setFromConst(0, n);
         _req_right_pads.setFromConst(0, n);
@@ -93,8 +101,36 @@ namespace yask {
     void YkGridBase::set_dirty_all(bool dirty) {
         if (_dirty_steps.size() == 0)
             resize();
-        for (auto i : _dirty_steps)
-            i = dirty;
+        for (size_t i = 0; i < _dirty_steps.size(); i++)
+            set_dirty_using_alloc_index(dirty, i);
+    }
+    void YkGridBase::set_num_dirty_faces(size_t nfaces) {
+        _num_faces = nfaces;
+        _dirty_faces.clear();
+        for (size_t i = 0; i < _dirty_steps.size(); i++)
+            _dirty_faces.push_back(std::vector<bool>(nfaces, _dirty_steps[i]));
+    }
+    bool YkGridBase::is_face_dirty(idx_t step_idx, size_t face) const {
+        if (!is_dirty(step_idx))
+            return false;
+        if (_num_faces == 0)
+            return true;
+        step_idx = _has_step_dim ? _wrap_step(step_idx) : 0;
+        assert(face < _num_faces);
+        return _dirty_faces[step_idx][face];
+    }
+    void YkGridBase::set_dirty_faces(const std::vector<bool>& faces, idx_t step_idx) {
+        if (_num_faces == 0) {
+            set_dirty(true, step_idx);
+            return;
+        }
+        assert(faces.size() == _num_faces);
+        step_idx = _has_step_dim ? _wrap_step(step_idx) : 0;
+        auto& dfaces = _dirty_faces[step_idx];
+        for (size_t i = 0; i < _num_faces; i++)
+            if (faces[i])
+                dfaces[i] = true;
+        _dirty_steps[step_idx] = true;
     }
     
     // Lookup position by dim name.
@@ -210,9 +246,18 @@ namespace yask {
         }
 
         // Attempt to change alloc with existing storage?
+        // If allowed, drop the storage and size as if there were none.
         // TODO: restore the values before the API that called
         // resize() on failure.
         if (p && old_allocs != new_allocs) {
+            if (_release_if_resized) {
+                TRACE_MSG0(get_ostr(), "grid '" << get_name() << "' storage released to resize from " <<
+                           makeIndexString(old_allocs, " * ") <<
+                           " to " << makeIndexString(new_allocs, " * "));
+                release_storage();
+                resize();
+                return;
+            }
             THROW_YASK_EXCEPTION("Error: attempt to change allocation size of grid '" +
                 get_name() + "' from " + 
                 makeIndexString(old_allocs, " * ") + " to " +
@@ -225,6 +270,22 @@ namespace yask {
         _actl_left_pads = new_left_pads;
         _actl_right_pads = new_right_pads;
         size_t new_dirty = 1;      // default if no step dim.
+
+#ifdef USE_TILED_LAYOUT
+        // Set layout tile sizes in vectors. The inner dim is never
+        // tiled so that the generated code can step through it
+        // from one pointer.
+        Indices tile_sizes(idx_t(0), get_num_dims());
+        auto& req_tiles = _ggb->get_settings()._tile_sizes;
+        for (int i = 0; i < get_num_dims(); i++) {
+            auto& dname = get_dim_name(i);
+            auto* p = req_tiles.lookup(dname);
+            if (p && *p > 0 && dname != _dims->_inner_dim && dname != _dims->_step_dim)
+                tile_sizes[i] = CEIL_DIV(*p, _vec_lens[i]);
+        }
+        _ggb->set_tile_sizes(tile_sizes);
+#endif
+
         for (int i = 0; i < get_num_dims(); i++) {
 
             // Calc vec-len values.
@@ -241,8 +302,11 @@ namespace yask {
 
         // Resize dirty flags, too.
         size_t old_dirty = _dirty_steps.size();
-        if (old_dirty != new_dirty)
+        if (old_dirty != new_dirty) {
             _dirty_steps.assign(new_dirty, true); // set all as dirty.
+            if (_num_faces)
+                _dirty_faces.assign(new_dirty, std::vector<bool>(_num_faces, true));
+        }
 
         // Report changes in TRACE mode.
         if (old_allocs != new_allocs || old_dirty != new_dirty) {
@@ -257,6 +321,51 @@ namespace yask {
         }
     }
     
+    // Before allocation, add right padding so that no stride is a
+    // multiple of any of 'set_strides' bytes. A bad stride is fixed by
+    // padding the domain dim with the next-smaller stride one vector at
+    // a time. Returns the number of vectors added.
+    idx_t YkGridBase::pad_for_aliasing(const std::vector<idx_t>& set_strides) {
+        if (get_raw_storage_buffer())
+            return 0;
+        int ndims = get_num_dims();
+
+        // Dims from smallest to largest stride.
+        vector<int> order(ndims);
+        for (int i = 0; i < ndims; i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(),
+                    [&](int a, int b) { return _ggb->get_stride(a) < _ggb->get_stride(b); });
+
+        idx_t nadded = 0;
+        for (int oi = 1; oi < ndims; oi++) {
+            int j = order[oi];
+
+            // Domain dim to pad.
+            int k = -1;
+            for (int ki = oi - 1; ki >= 0 && k < 0; ki--)
+                if (_dims->_domain_dims.lookup(get_dim_name(order[ki])))
+                    k = order[ki];
+            if (k < 0)
+                continue;
+
+            // Limit the search in case of a pathological size.
+            for (int n = 0; n < 16; n++) {
+                idx_t sbytes = _ggb->get_stride(j) * _ggb->get_elem_bytes();
+                bool bad = false;
+                for (auto ss : set_strides)
+                    if (ss > 0 && sbytes > 0 && sbytes % ss == 0)
+                        bad = true;
+                if (!bad)
+                    break;
+                _req_right_pads[k] = _actl_right_pads[k] + _vec_lens[k];
+                resize();
+                nadded++;
+            }
+        }
+        return nadded;
+    }
+
     // Check whether dim is used and of allowed type.
     void YkGridBase::checkDimType(const std::string& dim,
                                   const std::string& fn_name,
@@ -349,6 +458,50 @@ namespace yask {
         return errs;
     }
 
+    // Compare a slice that may be a sub-domain of either grid.
+    idx_t YkGridBase::compare_slice(const YkGridBase* ref,
+                                    const Indices& first_indices,
+                                    const Indices& last_indices,
+                                    real_t epsilon,
+                                    int maxPrint,
+                                    std::ostream& os) const {
+        if (!ref) {
+            os << "** mismatch: no reference grid.\n";
+            return 1;
+        }
+        if (get_dim_names() != ref->get_dim_names()) {
+            os << "** mismatch due to incompatible grids: " <<
+                make_info_string() << " and " << ref->make_info_string() << ".\n";
+            return 1;
+        }
+
+        // Read the slice from both grids.
+        IdxTuple range = get_slice_range(first_indices, last_indices);
+        idx_t n = range.product();
+        vector<real_t> tbuf(n), rbuf(n);
+        get_elements_in_slice(tbuf.data(), first_indices, last_indices);
+        ref->get_elements_in_slice(rbuf.data(), first_indices, last_indices);
+
+        idx_t errs = 0;
+        for (idx_t i = 0; i < n; i++) {
+            if (!within_tolerance(tbuf[i], rbuf[i], epsilon)) {
+                errs++;
+                if (errs < maxPrint) {
+                    IdxTuple opt = range.unlayout(i);
+                    for (int j = 0; j < opt.getNumDims(); j++)
+                        opt[j] += first_indices[j];
+                    os << "** mismatch at " << get_name() <<
+                        "(" << opt.makeDimValStr() << "): " <<
+                        tbuf[i] << " != " << rbuf[i] << std::endl;
+                }
+                else if (errs == maxPrint)
+                    os << "** Additional errors not printed." << std::endl;
+            }
+        }
+        TRACE_MSG0(get_ostr(), "slice compare returned " << errs);
+        return errs;
+    }
+
     // Make sure indices are in range.
     // Side-effect: If fixed_indices is not NULL, set them to in-range if out-of-range.
     bool YkGridBase::checkIndices(const Indices& indices,
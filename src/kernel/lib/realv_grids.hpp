@@ -46,6 +46,10 @@ namespace yask {
         // Problem dimensions. (NOT grid dims.)
         DimsPtr _dims;
 
+        // Posn in this grid of each stencil dim by its ID from Dims,
+        // or -1 if not used.
+        std::vector<int> _dim_id_posns;
+
         // The following indices have values for all dims in the grid.
         // All values are in units of reals, not underlying elements, if different.
         // Should use either _offsets or _local_offsets to adjust an index to
@@ -77,15 +81,68 @@ namespace yask {
         // Otherwise, only bit 0 is used.
         std::vector<bool> _dirty_steps;
 
+        // Halo faces that need to be exchanged. If faces are tracked,
+        // there is one flag per face, i.e., per neighbor and buffer
+        // direction as numbered by the context, for each alloc'd step.
+        // A step is still marked in '_dirty_steps' when it is written,
+        // even if none of its faces are, so all ranks agree on which
+        // steps are exchanged together.
+        size_t _num_faces = 0;
+        std::vector<std::vector<bool>> _dirty_faces;
+
         // Data layout for slice APIs.
         bool _is_col_major = false;
 
         // Whether to resize this grid based on solution parameters.
         bool _fixed_size = false;
 
+        // Whether to release the storage instead of throwing an exception
+        // when a resize needs a different allocation.
+        bool _release_if_resized = false;
+
         // Whether this is a scratch grid;
         bool _is_scratch = false;
 
+        // Points sampled by get_samples().
+        struct SampleSet {
+            std::vector<Indices> pts; // includes the step dim, if any.
+            std::vector<real_t> wts;
+            idx_t npps = 1;     // points per sample.
+
+            // Offset of each point from the storage for each alloc'd step,
+            // valid for storage with layout 'key'.
+            std::vector<std::vector<idx_t>> ofs;
+            std::string key;
+        };
+        std::vector<SampleSet> _sample_sets;
+
+        // Find the offsets of the points in 'ss'.
+        virtual void find_sample_offsets(SampleSet& ss);
+
+        // Points updated by inject_sources().
+        struct SourceSet {
+            SampleSet ss;       // points, weights and offsets.
+            std::vector<real_t> vals; // values for each source at each step.
+            idx_t first_step = 0;
+            idx_t num_steps = 0;
+
+            // Position in the stencil dims of each grid dim or -1.
+            std::vector<int> sposns;
+        };
+        std::vector<SourceSet> _source_sets;
+
+        // File to map as storage instead of allocating it.
+        std::string _storage_file;
+
+        // Bytes before the data in a file from save_storage().
+        static constexpr size_t _storage_file_hdr_bytes = 4096;
+
+        // Describe the storage layout for a file from save_storage().
+        virtual std::string get_storage_key() const;
+
+        // Map '_storage_file' as the storage.
+        virtual void map_storage_file();
+
         // Convenience function to format indices like
         // "x=5, y=3".
         virtual std::string makeIndexString(const Indices& idxs,
@@ -139,7 +196,6 @@ namespace yask {
 
         // Resize or fail if already allocated.
         virtual void resize();
-
         // Set dirty flags in range.
         void set_dirty_in_slice(const Indices& first_indices,
                                 const Indices& last_indices);
@@ -147,21 +203,213 @@ namespace yask {
         // Make tuple needed for slicing.
         IdxTuple get_slice_range(const Indices& first_indices,
                                  const Indices& last_indices) const;
-        
+
+        // Posn of the unit-stride dim in slice buffers.
+        // Zero if there are no dims.
+        int get_inner_posn() const {
+            int nd = get_num_dims();
+            return (_is_col_major || nd == 0) ? 0 : nd - 1;
+        }
+
+        // Min number of points in a slice before splitting it across threads.
+        static constexpr idx_t _min_par_slice_pts = 4096;
+
+        // Call 'row_visitor(pt, idx, n, alloc_step_idx)' for each row of
+        // 'n' points along the unit-stride dim in the slice from 'first'
+        // to 'last', where 'pt' is the first point in the row and 'idx'
+        // is its index in a buffer laid out like the tuple from
+        // get_slice_range(). Large slices are split by rows across
+        // OpenMP threads. If the step dim is the inner one, each row
+        // is a single point so that the step index is const in a row.
+        template <typename RowVisitFn>
+        void _visit_slice_rows(const Indices& first,
+                               const Indices& last,
+                               RowVisitFn row_visitor) const {
+            int nd = first.getNumDims();
+            if (nd == 0) {
+                row_visitor(first, 0, 1, 0);
+                return;
+            }
+            Indices sizes = last.addConst(1).subElements(first);
+            int ip = get_inner_posn();
+            idx_t ni = sizes[ip];
+            idx_t npts = sizes.product();
+            idx_t nrows = (ni > 0) ? npts / ni : 0;
+            bool step_inner = _has_step_dim && ip == Indices::step_posn;
+
+#pragma omp parallel for schedule(static) if (nrows > 1 && npts >= _min_par_slice_pts)
+            for (idx_t r = 0; r < nrows; r++) {
+
+                // Find first point in row from row index.
+                Indices pt(first);
+                idx_t ri = r;
+                if (_is_col_major) {
+                    for (int j = 1; j < nd; j++) {
+                        pt[j] += ri % sizes[j];
+                        ri /= sizes[j];
+                    }
+                } else {
+                    for (int j = nd - 2; j >= 0; j--) {
+                        pt[j] += ri % sizes[j];
+                        ri /= sizes[j];
+                    }
+                }
+
+                // Step index is const along the row unless the step dim
+                // is the inner one.
+                idx_t idx0 = r * ni;
+                if (step_inner) {
+                    idx_t i0 = first[ip];
+                    for (idx_t i = 0; i < ni; i++) {
+                        pt[ip] = i0 + i;
+                        row_visitor(pt, idx0 + i, 1, get_alloc_step_index(pt));
+                    }
+                }
+                else
+                    row_visitor(pt, idx0, ni, get_alloc_step_index(pt));
+            }
+        }
+
+        // Set every allocated element at 'pt' to 'val_fn(pt)'. Rows
+        // along the unit-stride dim are computed into a buffer and
+        // written with writeElemRow(), split across OpenMP threads so
+        // that pages are touched by the threads that will use them.
+        // Marks all steps dirty and returns the number of elements set.
+        template <typename ValFn>
+        idx_t _set_all_elements(ValFn val_fn) {
+            int nd = get_num_dims();
+            Indices first(nd), last(nd);
+            for (int i = 0; i < nd; i++) {
+                first[i] = _get_first_alloc_index(i);
+                last[i] = _get_last_alloc_index(i);
+            }
+            int ip = get_inner_posn();
+            _visit_slice_rows(first, last,
+                              [&](const Indices& first_pt, idx_t idx0,
+                                  idx_t n, idx_t asi) {
+                                  std::vector<real_t> buf(n);
+                                  Indices pt(first_pt);
+                                  for (idx_t i = 0; i < n; i++) {
+                                      if (nd)
+                                          pt[ip] = first_pt[ip] + i;
+                                      buf[i] = real_t(val_fn(pt));
+                                  }
+                                  writeElemRow(buf.data(), 1, first_pt, n, asi);
+                              });
+            set_dirty_all(true);
+            return nd ? last.addConst(1).subElements(first).product() : 1;
+        }
+
+        // Call 'visitor(pt, idx, alloc_step_idx)' for each point in the
+        // slice from 'first' to 'last', where 'idx' is the index of the
+        // point in a buffer laid out like the tuple from get_slice_range().
+        // The slice is processed as rows along the unit-stride dim, and
+        // large slices are split by rows across OpenMP threads. This avoids
+        // the per-point overhead of IdxTuple::visitAllPointsInParallel()
+        // in the halo pack/unpack code.
+        template <typename VisitFn>
+        void _visit_slice(const Indices& first,
+                          const Indices& last,
+                          VisitFn visitor) const {
+            if (first.getNumDims() == 0) {
+                visitor(first, 0, 0);
+                return;
+            }
+            int ip = get_inner_posn();
+            _visit_slice_rows(first, last,
+                              [&](const Indices& first_pt, idx_t idx0,
+                                  idx_t n, idx_t asi) {
+                                  Indices pt(first_pt);
+                                  idx_t i0 = first_pt[ip];
+                                  for (idx_t i = 0; i < n; i++) {
+                                      pt[ip] = i0 + i;
+                                      visitor(pt, idx0 + i, asi);
+                                  }
+                              });
+        }
+
+        // Copy 'n' elements along the unit-stride dim starting at 'pt'
+        // to 'buf' or from 'buf'. For writes, 'buf_stride' may be zero
+        // to write the same value to each element. Indices are relative
+        // to overall problem domain and must be in range.  These
+        // per-element versions are overridden in the concrete classes
+        // to copy each run of elements that are adjacent in memory
+        // with one address calculation.
+        virtual void readElemRow(real_t* buf,
+                                 const Indices& pt,
+                                 idx_t n,
+                                 idx_t alloc_step_idx) const {
+            int ip = get_inner_posn();
+            Indices p(pt);
+            for (idx_t i = 0; i < n; i++) {
+                if (i > 0)
+                    p[ip]++;
+                buf[i] = readElem(p, alloc_step_idx, __LINE__);
+            }
+        }
+        virtual void writeElemRow(const real_t* buf,
+                                  idx_t buf_stride,
+                                  const Indices& pt,
+                                  idx_t n,
+                                  idx_t alloc_step_idx) {
+            int ip = get_inner_posn();
+            Indices p(pt);
+            for (idx_t i = 0; i < n; i++) {
+                if (i > 0)
+                    p[ip]++;
+                writeElem(buf[i * buf_stride], p, alloc_step_idx, __LINE__);
+            }
+        }
+
     public:
         YkGridBase(GenericGridBase* ggb,
-                   size_t ndims,
+                   const GridDimNames& dimNames,
                    DimsPtr dims);
         virtual ~YkGridBase() { }
 
+        // Write 'val' to the elements in the slice without checking
+        // indices or setting dirty flags. Safe to call on disjoint
+        // slices from several threads.
+        void touch_elements_in_slice(double val,
+                                     const Indices& first,
+                                     const Indices& last) {
+            real_t rval = real_t(val);
+            _visit_slice_rows(first, last,
+                              [&](const Indices& pt, idx_t idx, idx_t n, idx_t asi) {
+                                  writeElemRow(&rval, 0, pt, n, asi);
+                              });
+        }
+
+        // Reductions done by reduce_elems().
+        enum ReduceOp { reduce_sum, reduce_sum_sq, reduce_max_abs };
+
+        // Return the reduction 'op' of the elements in the slice.  If
+        // 'keep' is given, only elements for which it returns true are
+        // used. Runs serially, so it may be called from several threads.
+        double reduce_elems(const Indices& first,
+                            const Indices& last,
+                            ReduceOp op,
+                            const std::function<bool (const Indices& pt)>* keep = 0) const;
+
         // Halo-exchange flag accessors.
         virtual bool is_dirty(idx_t step_idx) const;
         virtual void set_dirty(bool dirty, idx_t step_idx);
         virtual void set_dirty_all(bool dirty);
         inline void set_dirty_using_alloc_index(bool dirty, idx_t alloc_idx) {
             _dirty_steps[alloc_idx] = dirty;
+            if (_num_faces)
+                _dirty_faces[alloc_idx].assign(_num_faces, dirty);
         }
 
+        // Per-face halo-exchange flags.
+        // If faces aren't tracked, every face of a dirty step is dirty.
+        virtual void set_num_dirty_faces(size_t nfaces);
+        virtual bool is_face_dirty(idx_t step_idx, size_t face) const;
+
+        // Mark 'step_idx' dirty, but only 'faces' of it; other faces
+        // are unchanged.
+        virtual void set_dirty_faces(const std::vector<bool>& faces, idx_t step_idx);
+
         // Resize flag accessors.
         virtual bool is_fixed_size() const { return _fixed_size; }
         virtual void set_fixed_size(bool is_fixed) {
@@ -169,6 +417,9 @@ namespace yask {
             if (is_fixed)
                 _offsets.setFromConst(0);
         }
+        virtual void set_release_if_resized(bool release) {
+            _release_if_resized = release;
+        }
 
         // Scratch accessors.
         virtual bool is_scratch() const { return _is_scratch; }
@@ -183,6 +434,10 @@ namespace yask {
         virtual bool set_numa_preferred(int numa_node) {
             return _ggb->set_numa_pref(numa_node);
         }
+        virtual bool is_numa_preferred_set() const { return _ggb->is_numa_pref_set(); }
+
+        // Pad to avoid strides that are multiples of 'set_strides' bytes.
+        virtual idx_t pad_for_aliasing(const std::vector<idx_t>& set_strides);
         
         // Lookup position by dim name.
         // Return -1 or die if not found, depending on flag.
@@ -190,6 +445,14 @@ namespace yask {
                                  bool die_on_failure = false,
                                  const std::string& die_msg = "") const;
 
+        // Lookup position by stencil-dim ID from Dims.
+        // Return -1 if not found.
+        int get_dim_id_posn(int dim_id) const {
+            assert(dim_id >= 0);
+            assert(dim_id < int(_dim_id_posns.size()));
+            return _dim_id_posns[dim_id];
+        }
+
         // Get dim name by posn.
         virtual const std::string& get_dim_name(int n) const {
             assert(n >= 0);
@@ -250,6 +513,17 @@ namespace yask {
                               int maxPrint = 20,
                               std::ostream& os = std::cerr) const;
 
+        // Check for equality in the slice from 'first_indices' to
+        // 'last_indices', which must be allocated in both grids.
+        // The grids may have different sizes and offsets.
+        // Return number of mismatches greater than epsilon.
+        virtual idx_t compare_slice(const YkGridBase* ref,
+                                    const Indices& first_indices,
+                                    const Indices& last_indices,
+                                    real_t epsilon = EPSILON,
+                                    int maxPrint = 20,
+                                    std::ostream& os = std::cerr) const;
+
         // Make sure indices are in range.
         // Optionally fix them to be in range and return in 'fixed_indices'.
         // If 'normalize', make rank-relative, divide by vlen and return in 'fixed_indices'.
@@ -283,10 +557,11 @@ namespace yask {
 
         // Write one element.
         // Indices are relative to overall problem domain.
-        inline void writeElem(real_t val,
-                              const Indices& idxs,
-                              idx_t alloc_step_idx,
-                              int line) {
+        // Virtual so that grids without real_t storage can convert.
+        virtual void writeElem(real_t val,
+                               const Indices& idxs,
+                               idx_t alloc_step_idx,
+                               int line) {
             real_t* ep = getElemPtr(idxs, alloc_step_idx);
             *ep = val;
 #ifdef TRACE_MEM
@@ -296,10 +571,10 @@ namespace yask {
 
         // Update one element.
         // Indices are relative to overall problem domain.
-        inline void addToElem(real_t val,
-                              const Indices& idxs,
-                              idx_t alloc_step_idx,
-                              int line) {
+        virtual void addToElem(real_t val,
+                               const Indices& idxs,
+                               idx_t alloc_step_idx,
+                               int line) {
             real_t* ep = getElemPtr(idxs, alloc_step_idx);
 
 #pragma omp atomic update
@@ -513,9 +788,22 @@ namespace yask {
             const Indices last(last_indices);
             return set_elements_in_slice(buffer_ptr, first, last);
         }
+        virtual idx_t set_elements_from_profile(const std::string& dim,
+                                                idx_t first_index,
+                                                const std::vector<double>& values);
+        virtual idx_t set_elements_from_layers(const std::string& dim,
+                                               const std::vector<idx_t>& boundaries,
+                                               const std::vector<double>& values);
+        virtual idx_t set_elements_from_coarse_grid(const std::vector<double>& values,
+                                                    const std::vector<idx_t>& coarse_sizes,
+                                                    const std::vector<idx_t>& spacings,
+                                                    bool linear);
 
         virtual void alloc_storage() {
-            _ggb->default_alloc();
+            if (_storage_file.length())
+                map_storage_file();
+            else
+                _ggb->default_alloc();
         }
         virtual void release_storage() {
             _ggb->release_storage();
@@ -534,9 +822,62 @@ namespace yask {
         virtual void* get_raw_storage_buffer() {
             return _ggb->get_storage();
         }
+        virtual idx_t get_raw_storage_stride(const std::string& dim) const;
+        virtual int get_element_bytes() const {
+            return REAL_BYTES;
+        }
+        virtual int add_sample_set(const std::vector<idx_t>& indices,
+                                   const std::vector<double>& weights,
+                                   idx_t points_per_sample);
+        virtual idx_t get_samples(void* buffer_ptr,
+                                  int set_index,
+                                  idx_t step_index);
+        virtual int add_source_set(const std::vector<idx_t>& indices,
+                                   const std::vector<double>& weights,
+                                   idx_t points_per_source,
+                                   const std::vector<double>& values,
+                                   idx_t first_step_index);
+        virtual void clear_source_sets() {
+            _source_sets.clear();
+        }
+        bool has_sources() const {
+            return _source_sets.size() > 0;
+        }
+
+        // Find the offsets of all the source points for the current
+        // storage if needed. Must be called before inject_sources().
+        virtual void prepare_sources();
+
+        // Add the values of the sources at 'step_index' to the points
+        // in [begin, end), which are in the stencil dims.
+        virtual void inject_sources(idx_t step_index,
+                                    const Indices& begin, const Indices& end);
+        virtual void save_storage(const std::string& filename) const;
+        virtual void set_storage_file(const std::string& filename) {
+            _storage_file = filename;
+            if (_storage_file.length() && is_storage_allocated())
+                map_storage_file();
+        }
+        const std::string& get_storage_file() const {
+            return _storage_file;
+        }
         virtual void set_storage(std::shared_ptr<char> base, size_t offset) {
             _ggb->set_storage(base, offset);
         }
+
+        // Use storage at 'offset' bytes from 'base' that is shared with
+        // 'n' - 1 other grids of the same layout, whose vectors are
+        // interleaved with this one's.
+        virtual void set_interleaved_storage(std::shared_ptr<char> base, size_t offset, idx_t n) {
+            _ggb->set_storage(base, offset);
+            _ggb->set_interleave(n);
+        }
+        idx_t get_interleave() const {
+            return _ggb->get_interleave();
+        }
+        size_t get_storage_elem_bytes() const {
+            return _ggb->get_elem_bytes();
+        }
     };
 
     // YASK grid of real elements.
@@ -560,7 +901,7 @@ namespace yask {
                    const GridDimNames& dimNames,
                    KernelSettingsPtr* settings,
                    std::ostream** ostr) :
-            YkGridBase(&_data, dimNames.size(), dims),
+            YkGridBase(&_data, dimNames, dims),
             _data(name, dimNames, settings, ostr) {
             _has_step_dim = _wrap_step_idx;
             resize();
@@ -649,35 +990,184 @@ namespace yask {
             return e;
         }
 
+        // Copy a row of elements.
+        // The layout is linear, so the elements in the row are at a
+        // const stride, which is found from the addrs of the end points.
+        virtual void readElemRow(real_t* buf,
+                                 const Indices& pt,
+                                 idx_t n,
+                                 idx_t alloc_step_idx) const final {
+            idx_t stride = 0;
+            const real_t* ep = get_row_ptr(pt, n, alloc_step_idx, stride);
+            if (stride == 1)
+                memcpy(buf, ep, n * sizeof(real_t));
+            else
+                for (idx_t i = 0; i < n; i++)
+                    buf[i] = ep[i * stride];
+        }
+        virtual void writeElemRow(const real_t* buf,
+                                  idx_t buf_stride,
+                                  const Indices& pt,
+                                  idx_t n,
+                                  idx_t alloc_step_idx) final {
+            idx_t stride = 0;
+            real_t* ep = const_cast<real_t*>(get_row_ptr(pt, n, alloc_step_idx, stride));
+            if (stride == 1 && buf_stride == 1)
+                memcpy(ep, buf, n * sizeof(real_t));
+            else
+                for (idx_t i = 0; i < n; i++)
+                    ep[i * stride] = buf[i * buf_stride];
+        }
+
+    protected:
+
+        // Get ptr to first elem in row of 'n' elems starting at 'pt' and
+        // set 'stride' to the distance between elems in the row.
+        const real_t* get_row_ptr(const Indices& pt,
+                                  idx_t n,
+                                  idx_t alloc_step_idx,
+                                  idx_t& stride) const {
+            const real_t* ep = YkElemGrid::getElemPtr(pt, alloc_step_idx);
+            if (n > 1) {
+                Indices lpt(pt);
+                lpt[get_inner_posn()] += n - 1;
+                const real_t* lp = YkElemGrid::getElemPtr(lpt, alloc_step_idx);
+                stride = (lp - ep) / (n - 1);
+            }
+            return ep;
+        }
+
     };                          // YkElemGrid.
     
+    // Conversions between the storage type of a folded grid and
+    // real_vec_t. By default, the storage type converts itself.
+    template <typename VecT>
+    class RealVecCodec {
+    public:
+        ALWAYS_INLINE real_vec_t decode(const VecT& v) const {
+            return v;
+        }
+        ALWAYS_INLINE VecT encode(const real_vec_t& v) {
+            return VecT(v);
+        }
+        ALWAYS_INLINE real_t get_elem(const VecT& v, idx_t l) const {
+            return get_vec_elem(v, l);
+        }
+        ALWAYS_INLINE void set_elem(VecT& v, idx_t l, real_t val) {
+            set_vec_elem(v, l, val);
+        }
+
+        // Whether values must be encoded one sequence at a time.
+        static const bool encodes_by_value = false;
+    };
+
+    // Conversions for lookup-table-compressed storage. Each distinct
+    // value is added to the table when first stored, and vectors are
+    // decoded with a gather from the table. The table is allocated at
+    // its maximum size, so decoding never sees it move, and it is shared
+    // with any grid that shares the data.
+    template <typename IT>
+    class RealVecCodec<real_vec_lut_t<IT>> {
+        typedef real_vec_lut_t<IT> VecT;
+        static const size_t _max_vals = size_t(1) << (8 * sizeof(IT));
+
+        struct Table {
+            std::vector<real_t> vals;
+            std::map<ctrl_t, IT> idxs; // value bits -> index in 'vals'.
+            Table() { vals.reserve(_max_vals); }
+        };
+        std::shared_ptr<Table> _tbl = std::make_shared<Table>();
+
+        // Get index of 'val', adding it if not already in the table.
+        IT find_or_add(real_t val) {
+            ctrl_t bits;
+            memcpy(&bits, &val, sizeof(bits));
+            IT idx = 0;
+            bool ok = true;
+#pragma omp critical (yask_lut_table)
+            {
+                auto i = _tbl->idxs.find(bits);
+                if (i != _tbl->idxs.end())
+                    idx = i->second;
+                else if (_tbl->vals.size() < _max_vals) {
+                    idx = IT(_tbl->vals.size());
+                    _tbl->vals.push_back(val);
+                    _tbl->idxs[bits] = idx;
+                }
+                else
+                    ok = false;
+            }
+            if (!ok)
+                FORMAT_AND_THROW_YASK_EXCEPTION("Error: more than " << _max_vals <<
+                                                " distinct values stored in lookup-table grid");
+            return idx;
+        }
+
+    public:
+        ALWAYS_INLINE real_vec_t decode(const VecT& v) const {
+            return lut_gather(_tbl->vals.data(), v);
+        }
+        VecT encode(const real_vec_t& v) {
+            VecT res;
+            REAL_VEC_LOOP_UNALIGNED(j) res.i[j] = find_or_add(v[j]);
+            return res;
+        }
+        ALWAYS_INLINE real_t get_elem(const VecT& v, idx_t l) const {
+            return _tbl->vals.data()[v.i[l]];
+        }
+        void set_elem(VecT& v, idx_t l, real_t val) {
+            v.i[l] = find_or_add(val);
+        }
+
+        // Number of distinct values stored.
+        size_t get_num_vals() const {
+            return _tbl->vals.size();
+        }
+
+        static const bool encodes_by_value = true;
+    };
+
     // YASK grid of real vectors.
     // Used for grids that contain all the folded dims.
+    // 'VecT' is the storage type of each vector: real_vec_t, a
+    // reduced-precision type, or a lookup-table index type. It is
+    // converted to and from real_vec_t by a RealVecCodec<VecT>.
     // If '_wrap_step_idx', then index to step dim will wrap around.
     // The '_templ_vec_lens' arguments must contain a list of vector lengths
     // corresponding to each dim in the grid.
-    template <typename LayoutFn, bool _wrap_step_idx, idx_t... _templ_vec_lens>
-    class YkVecGrid : public YkGridBase {
+    template <typename VecT, typename LayoutFn, bool _wrap_step_idx, idx_t... _templ_vec_lens>
+    class YkVecGridT : public YkGridBase {
 
     protected:
-        typedef GenericGrid<real_vec_t, LayoutFn> _grid_type;
+#ifdef USE_TILED_LAYOUT
+        typedef GenericGrid<VecT, TiledLayout<LayoutFn>> _grid_type;
+#else
+        typedef GenericGrid<VecT, LayoutFn> _grid_type;
+#endif
         _grid_type _data;
+        RealVecCodec<VecT> _codec;
 
         // Positions of grid dims in vector fold dims.
         Indices _vec_fold_posns;
 
         // Share data from source grid.
+        // Any lookup table goes with the data.
         virtual bool share_data(YkGridBase* src, bool die_on_failure) {
-            return _share_data<_grid_type>(src, die_on_failure);
+            if (!_share_data<_grid_type>(src, die_on_failure))
+                return false;
+            auto* sp = dynamic_cast<YkVecGridT*>(src);
+            if (sp)
+                _codec = sp->_codec;
+            return true;
         }
 
     public:
-        YkVecGrid(DimsPtr dims,
+        YkVecGridT(DimsPtr dims,
                   const std::string& name,
                   const GridDimNames& dimNames,
                   KernelSettingsPtr* settings,
                   std::ostream** ostr) :
-            YkGridBase(&_data, dimNames.size(), dims),
+            YkGridBase(&_data, dimNames, dims),
             _data(name, dimNames, settings, ostr),
             _vec_fold_posns(idx_t(0), int(dimNames.size())) {
             _has_step_dim = _wrap_step_idx;
@@ -721,13 +1211,13 @@ namespace yask {
 
         // Make a human-readable description.
         virtual std::string make_info_string() const {
-            return _data.make_info_string("SIMD FP");
+            return _data.make_info_string(get_vec_type_descr((const VecT*)0));
         }
         
         // Init data.
         virtual void set_all_elements_same(double seed) {
             real_vec_t seedv = seed; // bcast.
-            _data.set_elems_same(seedv);
+            _data.set_elems_same(_codec.encode(seedv));
             set_dirty_all(true);
         }
         virtual void set_all_elements_in_seq(double seed) {
@@ -739,14 +1229,32 @@ namespace yask {
             // seed * 1.0, seed * 1.25, seed * 1.5, seed * 1.75.
             for (int i = 0; i < n; i++)
                 seedv[i] = seed * (1.0 + double(i) / n);
-            _data.set_elems_in_seq(seedv);
+            if (_codec.encodes_by_value)
+                set_vecs_in_seq(seedv);
+            else
+                _data.set_elems_in_seq(_codec.encode(seedv));
             set_dirty_all(true);
         }
         
-        // Get a pointer to given element.
-        virtual const real_t* getElemPtr(const Indices& idxs,
-                                         idx_t alloc_step_idx,
-                                         bool checkBounds=true) const final {
+        // Set each vector to 'seedv' times the repeating sequence used by
+        // GenericGridTemplate::set_elems_in_seq(), encoding each one.
+        void set_vecs_in_seq(const real_vec_t& seedv) {
+            VecT* vp = (VecT*)_data.get_storage();
+            if (!vp)
+                return;
+            const idx_t wrap = 71;
+            auto n = _data.get_num_elems();
+            auto il = _data.get_interleave();
+            for (idx_t ai = 0; ai < n; ai++)
+                vp[ai * il] = _codec.encode(seedv * real_vec_t(real_t(ai % wrap + 1)));
+        }
+
+        // Get a pointer to the vector containing the given element
+        // and the element's index in it.
+        const VecT* getVecPtrAndIndex(const Indices& idxs,
+                                      idx_t alloc_step_idx,
+                                      bool checkBounds,
+                                      idx_t& elem_idx) const {
 
 #ifdef TRACE_MEM
             _data.get_ostr() << get_name() << "." << "YkVecGrid::getElemPtr(" <<
@@ -824,11 +1332,26 @@ namespace yask {
 #endif
 
             // Get pointer to vector.
-            const real_vec_t* vp = _data.getPtr(vec_idxs, checkBounds);
+            elem_idx = i;
+            return _data.getPtr(vec_idxs, checkBounds);
+        }
 
-            // Get pointer to element.
-            const real_t* ep = &(*vp)[i];
-            return ep;
+#ifdef USE_TILED_LAYOUT
+        // Elements in a tiled layout are not at a const stride.
+        virtual idx_t get_raw_storage_stride(const std::string& dim) const {
+            get_dim_posn(dim, true, "get_raw_storage_stride");
+            return 0;
+        }
+#endif
+
+        // Get a pointer to given element.
+        // Returns null if the storage is not real_t.
+        virtual const real_t* getElemPtr(const Indices& idxs,
+                                         idx_t alloc_step_idx,
+                                         bool checkBounds=true) const final {
+            idx_t i = 0;
+            const VecT* vp = getVecPtrAndIndex(idxs, alloc_step_idx, checkBounds, i);
+            return get_vec_elem_ptr(*vp, i);
         }
 
         // Non-const version.
@@ -837,8 +1360,8 @@ namespace yask {
                                    bool checkBounds=true) final {
 
             const real_t* p =
-                const_cast<const YkVecGrid*>(this)->getElemPtr(idxs, alloc_step_idx,
-                                                               checkBounds);
+                const_cast<const YkVecGridT*>(this)->getElemPtr(idxs, alloc_step_idx,
+                                                                checkBounds);
             return const_cast<real_t*>(p);
         }
 
@@ -847,19 +1370,145 @@ namespace yask {
         virtual real_t readElem(const Indices& idxs,
                                 idx_t alloc_step_idx,
                                 int line) const final {
-            const real_t* ep = YkVecGrid::getElemPtr(idxs, alloc_step_idx);
-            real_t e = *ep;
+            idx_t i = 0;
+            const VecT* vp = getVecPtrAndIndex(idxs, alloc_step_idx, true, i);
+            real_t e = _codec.get_elem(*vp, i);
 #ifdef TRACE_MEM
             printElem("readElem", idxs, e, line);
 #endif
             return e;
         }
 
+        // Write one element.
+        virtual void writeElem(real_t val,
+                               const Indices& idxs,
+                               idx_t alloc_step_idx,
+                               int line) final {
+            idx_t i = 0;
+            VecT* vp = const_cast<VecT*>(getVecPtrAndIndex(idxs, alloc_step_idx, true, i));
+            _codec.set_elem(*vp, i, val);
+#ifdef TRACE_MEM
+            printElem("writeElem", idxs, val, line);
+#endif
+        }
+
+        // Copy a row of elements.
+        // The row is copied in runs of elems that are in the same vector,
+        // and each run of real_t elems at unit stride is copied with
+        // one memcpy.
+        virtual void readElemRow(real_t* buf,
+                                 const Indices& pt,
+                                 idx_t n,
+                                 idx_t alloc_step_idx) const final {
+            _visit_row_runs(pt, n, alloc_step_idx,
+                            [&](const VecT* vp, idx_t ei, idx_t es, idx_t i, idx_t nr) {
+                                const real_t* ep = get_vec_elem_ptr(*vp, ei);
+                                if (ep && es == 1)
+                                    memcpy(buf + i, ep, nr * sizeof(real_t));
+                                else
+                                    for (idx_t j = 0; j < nr; j++)
+                                        buf[i + j] = _codec.get_elem(*vp, ei + j * es);
+                            });
+        }
+        virtual void writeElemRow(const real_t* buf,
+                                  idx_t buf_stride,
+                                  const Indices& pt,
+                                  idx_t n,
+                                  idx_t alloc_step_idx) final {
+            _visit_row_runs(pt, n, alloc_step_idx,
+                            [&](const VecT* cvp, idx_t ei, idx_t es, idx_t i, idx_t nr) {
+                                VecT* vp = const_cast<VecT*>(cvp);
+                                real_t* ep = const_cast<real_t*>(get_vec_elem_ptr(*vp, ei));
+                                if (ep && es == 1 && buf_stride == 1)
+                                    memcpy(ep, buf + i, nr * sizeof(real_t));
+                                else
+                                    for (idx_t j = 0; j < nr; j++)
+                                        _codec.set_elem(*vp, ei + j * es,
+                                                        buf[(i + j) * buf_stride]);
+                            });
+        }
+
+    protected:
+
+        // Call 'run_visitor(vp, ei, es, i, nr)' for each run of 'nr' elems
+        // in the row of 'n' elems starting at 'pt' that are in the same
+        // vector, where 'vp' points to the vector, 'ei' is the index of the
+        // first elem of the run in it, 'es' is the distance between elems
+        // in the vector, and 'i' is the index of the first elem in the row.
+        // The layout is linear unless tiled, so the vectors after the first
+        // are at a const stride.
+        template <typename RunVisitFn>
+        void _visit_row_runs(const Indices& pt,
+                             idx_t n,
+                             idx_t alloc_step_idx,
+                             RunVisitFn run_visitor) const {
+            int ip = get_inner_posn();
+            idx_t vl = _vec_lens[ip];
+
+            // Distance between elems along the inner dim in a vector.
+            idx_t es = 0;
+            if (vl > 1) {
+                Indices fold_ofs(idx_t(0), NUM_VEC_FOLD_DIMS);
+                idx_t e0 = _dims->getElemIndexInVec(fold_ofs);
+                for (int f = 0; f < NUM_VEC_FOLD_DIMS; f++)
+                    if (_vec_fold_posns[f] == ip)
+                        fold_ofs[f] = 1;
+                es = _dims->getElemIndexInVec(fold_ofs) - e0;
+            }
+
+            // First run, which may start in the middle of a vector.
+            Indices p(pt);
+            idx_t ei = 0;
+            const VecT* vp = getVecPtrAndIndex(p, alloc_step_idx, true, ei);
+            idx_t ofs = idx_t(uidx_t(p[ip] - _offsets[ip] + _actl_left_pads[ip]) % uidx_t(vl));
+            idx_t nr = std::min(n, vl - ofs);
+            run_visitor(vp, ei, es, 0, nr);
+            if (nr >= n)
+                return;
+
+            // Following runs start at the beginning of a vector.
+            p[ip] += nr;
+            const VecT* vp1 = getVecPtrAndIndex(p, alloc_step_idx, true, ei);
+            idx_t vstride = vp1 - vp;
+            vp = vp1;
+            for (idx_t i = nr; i < n; i += nr) {
+                nr = std::min(n - i, vl);
+#ifdef USE_TILED_LAYOUT
+                p[ip] = pt[ip] + i;
+                vp = getVecPtrAndIndex(p, alloc_step_idx, true, ei);
+#endif
+                run_visitor(vp, ei, es, i, nr);
+                vp += vstride;
+            }
+        }
+
+    public:
+
+        // Update one element.
+        // Reduced-precision elements are not updated atomically.
+        virtual void addToElem(real_t val,
+                               const Indices& idxs,
+                               idx_t alloc_step_idx,
+                               int line) final {
+            idx_t i = 0;
+            VecT* vp = const_cast<VecT*>(getVecPtrAndIndex(idxs, alloc_step_idx, true, i));
+            real_t* ep = const_cast<real_t*>(get_vec_elem_ptr(*vp, i));
+            if (ep) {
+#pragma omp atomic update
+                *ep += val;
+            }
+            else
+                _codec.set_elem(*vp, i, _codec.get_elem(*vp, i) + val);
+#ifdef TRACE_MEM
+            printElem("addToElem", idxs, _codec.get_elem(*vp, i), line);
+#endif
+        }
+
         // Get a pointer to given vector.
         // Indices must be normalized and rank-relative.
         // It's important that this function be efficient, since
         // it's indiectly used from the stencil kernel.
-        inline const real_vec_t* getVecPtrNorm(const Indices& vec_idxs,
+        inline const VecT* getVecPtrNorm(const Indices& vec_idxs,
                                                idx_t alloc_step_idx,
                                                bool checkBounds=true) const {
 
@@ -904,14 +1553,19 @@ namespace yask {
         }
 
         // Non-const version.
-        inline real_vec_t* getVecPtrNorm(const Indices& vec_idxs,
-                                         idx_t alloc_step_idx,
-                                         bool checkBounds=true) {
+        inline VecT* getVecPtrNorm(const Indices& vec_idxs,
+                                   idx_t alloc_step_idx,
+                                   bool checkBounds=true) {
+
+            const VecT* p =
+                const_cast<const YkVecGridT*>(this)->getVecPtrNorm(vec_idxs,
+                                                                   alloc_step_idx, checkBounds);
+            return const_cast<VecT*>(p);
+        }
 
-            const real_vec_t* p =
-                const_cast<const YkVecGrid*>(this)->getVecPtrNorm(vec_idxs,
-                                                                  alloc_step_idx, checkBounds);
-            return const_cast<real_vec_t*>(p);
+        // Conversions for vectors read via getVecPtrNorm().
+        inline const RealVecCodec<VecT>& get_codec() const {
+            return _codec;
         }
 
         // Read one vector.
@@ -919,8 +1573,8 @@ namespace yask {
         inline real_vec_t readVecNorm(const Indices& vec_idxs,
                                       idx_t alloc_step_idx,
                                       int line) const {
-            const real_vec_t* vp = getVecPtrNorm(vec_idxs, alloc_step_idx);
-            real_vec_t v = *vp;
+            const VecT* vp = getVecPtrNorm(vec_idxs, alloc_step_idx);
+            real_vec_t v = _codec.decode(read_ptr(vp, line));
 #ifdef TRACE_MEM
             printVecNorm("readVecNorm", vec_idxs, v, line);
 #endif
@@ -933,8 +1587,8 @@ namespace yask {
                                  const Indices& vec_idxs,
                                  idx_t alloc_step_idx,
                                  int line) {
-            real_vec_t* vp = getVecPtrNorm(vec_idxs, alloc_step_idx);
-            *vp = val;
+            VecT* vp = getVecPtrNorm(vec_idxs, alloc_step_idx);
+            *vp = _codec.encode(val);
 #ifdef TRACE_MEM
             printVecNorm("writeVecNorm", vec_idxs, val, line);
 #endif
@@ -953,10 +1607,7 @@ namespace yask {
                 ")" << std::endl;
 #endif
             auto p = getVecPtrNorm(vec_idxs, alloc_step_idx, false);
-            prefetch<level>(p);
-#ifdef MODEL_CACHE
-            cache_model.prefetch(p, level, line);
-#endif
+            prefetch<level>(p, line);
         }
 
         // Vectorized version of set/get_elements_in_slice().
@@ -976,20 +1627,12 @@ namespace yask {
                        makeIndexString(firstv) << " ... " <<
                        makeIndexString(lastv));
 
-            // Visit points in slice.
-            numVecsTuple.visitAllPointsInParallel
-                ([&](const IdxTuple& ofs,
-                     size_t idx) {
-                    Indices pt = firstv.addElements(ofs);
-                    real_vec_t val = ((real_vec_t*)buffer_ptr)[idx];
-
-                    // TODO: move this outside of parallel loop when
-                    // step index is const.
-                    idx_t asi = get_alloc_step_index(pt);
-
-                    writeVecNorm(val, pt, asi, __LINE__);
-                    return true;    // keep going.
-                });
+            // Copy whole vectors from buffer.
+            const real_vec_t* buf = (const real_vec_t*)buffer_ptr;
+            _visit_slice(firstv, lastv,
+                         [&](const Indices& pt, idx_t idx, idx_t asi) {
+                             writeVecNorm(buf[idx], pt, asi, __LINE__);
+                         });
 
             // Set appropriate dirty flag(s).
             set_dirty_in_slice(first_indices, last_indices);
@@ -1019,23 +1662,19 @@ namespace yask {
                        makeIndexString(firstv) << " ... " <<
                        makeIndexString(lastv));
         
-            // Visit points in slice.
-            numVecsTuple.visitAllPointsInParallel
-                ([&](const IdxTuple& ofs,
-                     size_t idx) {
-                    Indices pt = firstv.addElements(ofs);
-
-                    // TODO: move this outside of parallel loop when
-                    // step index is const.
-                    idx_t asi = get_alloc_step_index(pt);
-
-                    real_vec_t val = readVecNorm(pt, asi, __LINE__);
-                    ((real_vec_t*)buffer_ptr)[idx] = val;
-                    return true;    // keep going.
-                });
+            // Copy whole vectors into buffer.
+            real_vec_t* buf = (real_vec_t*)buffer_ptr;
+            _visit_slice(firstv, lastv,
+                         [&](const Indices& pt, idx_t idx, idx_t asi) {
+                             buf[idx] = readVecNorm(pt, asi, __LINE__);
+                         });
             return numVecsTuple.product() * VLEN;
         }
         
-    };                          // YkVecGrid.
+    };                          // YkVecGridT.
+
+    // YASK grid of full-precision real vectors.
+    template <typename LayoutFn, bool _wrap_step_idx, idx_t... _templ_vec_lens>
+    using YkVecGrid = YkVecGridT<real_vec_t, LayoutFn, _wrap_step_idx, _templ_vec_lens...>;
 
 }                               // namespace.
@@ -87,8 +87,15 @@ namespace yask {
         comm = MPI_COMM_WORLD;
         MPI_Comm_rank(comm, &my_rank);
         MPI_Comm_size(comm, &num_ranks);
+
+        // Make a communicator of the ranks on this node.
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank,
+                            MPI_INFO_NULL, &shm_comm);
+        MPI_Comm_rank(shm_comm, &my_shm_rank);
+        MPI_Comm_size(shm_comm, &num_shm_ranks);
 #else
         comm = 0;
+        shm_comm = 0;
 #endif
 
         // Turn off denormals unless the USE_DENORMALS macro is set.
@@ -114,6 +121,11 @@ namespace yask {
             max_threads = omp_get_max_threads();
     }
 
+    // Free memory kept by '-alloc_pool'.
+    idx_t KernelEnv::clear_alloc_pool() {
+        return idx_t(yask::clear_alloc_pool());
+    }
+
     // Apply a function to each neighbor rank.
     // Does NOT visit self.
     void MPIInfo::visitNeighbors(std::function<void
@@ -178,6 +190,97 @@ namespace yask {
         return bufs[i].bufs[bd];
     }
 
+#ifdef USE_MPI
+    // Start receive from neighbor 'ni'.
+    void MPIData::start_recv(void* buf, size_t max_bytes, int rank, int ni,
+                             MPI_Comm comm, bool persistent) {
+        static const int trace_id = EventTrace::get_id("halo irecv");
+        EventTrace::Scope trace_scope(trace_id);
+
+        // Only need to know when the data is ready in shm.
+        if (bufs[ni].bufs[MPIBufs::bufRecv].via_shm) {
+            MPI_Irecv(NULL, 0, MPI_BYTE, rank, tag, comm, &recv_reqs[ni]);
+            return;
+        }
+        if (!persistent) {
+            MPI_Irecv(buf, max_bytes, MPI_BYTE, rank, tag, comm, &recv_reqs[ni]);
+            return;
+        }
+        auto& req = precv_reqs[ni];
+        if (req == MPI_REQUEST_NULL)
+            MPI_Recv_init(buf, max_bytes, MPI_BYTE, rank, tag, comm, &req);
+        MPI_Start(&req);
+        recv_reqs[ni] = req;
+    }
+
+    // Start send to neighbor 'ni'.
+    void MPIData::start_send(void* buf, size_t nbytes, int rank, int ni,
+                             MPI_Comm comm, bool persistent) {
+        static const int trace_id = EventTrace::get_id("halo isend");
+        EventTrace::Scope trace_scope(trace_id);
+        _mpiInfo->send_bytes[ni] += nbytes;
+        _mpiInfo->send_msgs[ni]++;
+
+        // Data is already in shm; flush it, notify the neighbor, and
+        // expect an ack when the neighbor is done with it.
+        if (bufs[ni].bufs[MPIBufs::bufSend].via_shm) {
+            MPI_Win_sync(shm_win);
+            MPI_Isend(NULL, 0, MPI_BYTE, rank, tag, comm, &send_reqs[ni]);
+            MPI_Irecv(NULL, 0, MPI_BYTE, rank, tag + shm_ack_tag_ofs, comm,
+                      &shm_done_reqs[ni]);
+            return;
+        }
+        if (!persistent) {
+            MPI_Isend(buf, nbytes, MPI_BYTE, rank, tag, comm, &send_reqs[ni]);
+            return;
+        }
+        auto& reqs = psend_reqs[ni];
+        if (reqs.count(nbytes) == 0)
+            MPI_Send_init(buf, nbytes, MPI_BYTE, rank, tag, comm, &reqs[nbytes]);
+        auto& req = reqs.at(nbytes);
+        MPI_Start(&req);
+        send_reqs[ni] = req;
+    }
+
+    // Wait for the ack of the previous shm exchange with neighbor 'ni'.
+    void MPIData::wait_for_send_buf(int ni) {
+        if (shm_done_reqs[ni] != MPI_REQUEST_NULL) {
+            MPI_Wait(&shm_done_reqs[ni], MPI_STATUS_IGNORE);
+            MPI_Win_sync(shm_win);
+        }
+    }
+
+    // Sync shm data from neighbor 'ni'.
+    void MPIData::sync_recv_buf(int ni) {
+        if (bufs[ni].bufs[MPIBufs::bufRecv].via_shm)
+            MPI_Win_sync(shm_win);
+    }
+
+    // Send ack to neighbor 'ni' if its data is in shm.
+    void MPIData::release_recv_buf(int rank, int ni, MPI_Comm comm) {
+        if (bufs[ni].bufs[MPIBufs::bufRecv].via_shm)
+            MPI_Isend(NULL, 0, MPI_BYTE, rank, tag + shm_ack_tag_ofs, comm,
+                      &shm_ack_reqs[ni]);
+    }
+
+    // Free persistent requests.
+    // The copies in 'recv_reqs' and 'send_reqs' are reset because they
+    // would otherwise refer to freed requests.
+    void MPIData::free_persistent_reqs() {
+        for (size_t ni = 0; ni < precv_reqs.size(); ni++) {
+            if (precv_reqs[ni] != MPI_REQUEST_NULL) {
+                MPI_Request_free(&precv_reqs[ni]);
+                recv_reqs[ni] = MPI_REQUEST_NULL;
+            }
+            for (auto& i : psend_reqs[ni]) {
+                MPI_Request_free(&i.second);
+                send_reqs[ni] = MPI_REQUEST_NULL;
+            }
+            psend_reqs[ni].clear();
+        }
+    }
+#endif
+
     // Add options to set one domain var to a cmd-line parser.
     void KernelSettings::_add_domain_option(CommandLineParser& parser,
                                             const std::string& prefix,
@@ -222,13 +325,101 @@ namespace yask {
         _add_domain_option(parser, "sb", "Sub-block size", _sub_block_sizes);
         _add_domain_option(parser, "mp", "Minimum grid-padding size (including halo)", _min_pad_sizes);
         _add_domain_option(parser, "ep", "Extra grid-padding size (beyond halo)", _extra_pad_sizes);
+#ifdef USE_TILED_LAYOUT
+        _add_domain_option(parser, "lt", "Grid-layout tile size (0 for no tiling; "
+                           "ignored in the inner dim)", _tile_sizes);
+#endif
 #ifdef USE_MPI
         _add_domain_option(parser, "nr", "Num ranks", _num_ranks);
         _add_domain_option(parser, "ri", "This rank's logical index", _rank_indices);
+        for (auto& i : _rank_splits) {
+            auto& dname = i.first;
+            parser.add_option(new CommandLineParser::IdxListOption
+                              ("rank_sizes_" + dname,
+                               "Rank-domain sizes in '" + dname + "' dimension of the ranks "
+                               "at each rank index in '" + dname + "', one per rank index; "
+                               "overrides '-d" + dname + "', so the ranks can be given "
+                               "uneven shares of the overall domain.",
+                               i.second));
+        }
+        parser.add_option(new CommandLineParser::IntOption
+                          ("balance_steps",
+                           "Before the grids are initialized, run this many steps and "
+                           "set the rank-domain sizes at each rank index in each dimension "
+                           "in inverse proportion to the measured time per point of the "
+                           "ranks at that index, keeping the overall domain size; "
+                           "0 to disable. "
+                           "The new sizes are printed, so they may be given with "
+                           "'-rank_sizes_*' in later runs.",
+                           _balance_steps));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("auto_decomp",
+                           "When the product of the numbers of ranks in each dimension "
+                           "is not the number of MPI ranks, choose the numbers of ranks "
+                           "in the dimensions where it is 1 to minimize the halo data "
+                           "exchanged between nodes, weighted by the grid halo sizes. "
+                           "The ranks on each node are placed in a box that is longest "
+                           "in the dimensions with the largest halos, so most of their "
+                           "exchanges stay within the node.",
+                           _auto_decomp));
         parser.add_option(new CommandLineParser::IntOption
                           ("msg_rank",
                            "Index of MPI rank that will print informational messages.",
                            msg_rank));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("rank_stats_file",
+                           "File to which the message rank writes the compute time, "
+                           "halo-exchange time, halo-wait time, and halo bytes and "
+                           "messages sent by each rank, followed by matrices of the bytes "
+                           "and messages sent from each rank to each other rank, "
+                           "each time the stats are reported. "
+                           "Empty to disable.",
+                           _rank_stats_file));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("overlap_comms",
+                           "Overlap MPI halo exchange with calculation of interior points. "
+                           "Points near the rank boundaries are calculated first, "
+                           "the exchange is started, and then the remaining interior points are "
+                           "calculated while the messages are in flight. "
+                           "Only used when temporal wave-front tiling is not enabled.",
+                           overlap_comms));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("mpi_alloc_mem",
+                           "Allocate MPI buffers with MPI_Alloc_mem(), which may return memory "
+                           "that is already registered with the fabric. "
+                           "With '-alloc_pool', the buffers stay registered across solutions. "
+                           "The NUMA and huge-page settings are not used for these buffers.",
+                           _mpi_alloc_mem));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("multi_step_halos",
+                           "When temporal wave-front tiling is enabled, "
+                           "size the MPI buffers to hold the halos for all the steps in a region "
+                           "and exchange them in one message per grid per neighbor.",
+                           multi_step_halos));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("aggregate_halos",
+                           "Pack the halos of all grids for a given neighbor into one buffer "
+                           "and exchange them in one message per neighbor.",
+                           aggregate_halos));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("persistent_halos",
+                           "Use persistent MPI requests for the halo exchange. "
+                           "The requests are created at the first exchange and "
+                           "restarted at each following one.",
+                           persistent_halos));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("neighbor_halos",
+                           "Use one MPI neighborhood collective on a graph communicator "
+                           "of this rank's neighbors for the halo exchange. "
+                           "Implies '-aggregate_halos'.",
+                           neighbor_halos));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("use_shm",
+                           "Exchange halos with ranks on the same node through "
+                           "MPI shared-memory windows: data are packed directly into memory "
+                           "that the neighbor unpacks from, and only zero-byte "
+                           "notifications are sent. Not used with '-neighbor_halos'.",
+                           use_shm));
 #endif
         parser.add_option(new CommandLineParser::IntOption
                           ("max_threads",
@@ -242,6 +433,46 @@ namespace yask {
                           ("block_threads",
                            "Number of threads to use within each block.",
                            num_block_threads));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("smt_share",
+                           "Run the threads of each block as hyper-threads of one core "
+                           "on neighboring sub-blocks: "
+                           "the default sub-blocks become slabs one cluster thick across "
+                           "the dim outside the inner-most one, so the threads "
+                           "work on adjacent rows at the same time and share the rows "
+                           "they read in the L1 and L2 caches. "
+                           "Run with 'OMP_PLACES=cores' so that each block is bound to one core; "
+                           "the placement found is checked and reported.",
+                           _smt_share));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("numa_parts",
+                           "Split the rank domain into this many slabs across the outer-most "
+                           "domain dim, each calculated by its own team of region threads. "
+                           "The teams are bound with 'proc_bind(spread)', so with one part per "
+                           "NUMA node, e.g., with 'OMP_PLACES=cores', each node calculates "
+                           "only its own slab, and only the slab boundaries are shared "
+                           "across nodes. Use with '-first_touch' to place each slab's memory "
+                           "on its node. "
+                           "Only used without temporal wave-front tiling, '-async_packs', or "
+                           "'-overlap_comms'.",
+                           _numa_parts));
+        string path_names;
+        for (auto& name : get_region_paths())
+            path_names += (path_names.length() ? "', '" : "") + name;
+        parser.add_option(new CommandLineParser::StringOption
+                          ("region_path",
+                           "Path of the region loops through the blocks: one of '" +
+                           path_names + "'. The paths are compiled into the kernel, "
+                           "so they can be selected and auto-tuned without rebuilding.",
+                           _region_path));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("async_packs",
+                           "Evaluate the stencil-bundle packs of each step as a graph of "
+                           "block tasks: a block of a pack is started as soon as the blocks "
+                           "of the previous pack within the stencil halos are done, "
+                           "instead of after the whole previous pack. "
+                           "Only used with one rank and without temporal wave-front tiling.",
+                           _async_packs));
 #ifdef USE_NUMA
         stringstream msg;
         msg << "Preferred NUMA node on which to allocate data for "
@@ -252,7 +483,150 @@ namespace yask {
         parser.add_option(new CommandLineParser::IntOption
                           ("numa_pref", msg.str(),
                            _numa_pref));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("numa_fast_node",
+                           "NUMA node of fast memory, e.g., MCDRAM or HBM. "
+                           "When set along with -numa_fast_mib, grids without their own "
+                           "NUMA preference are ranked by estimated bytes moved per step "
+                           "per byte of storage, and the highest-ranked ones that fit "
+                           "are allocated on this node.",
+                           _numa_fast_node));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("numa_fast_mib",
+                           "Capacity in MiB of the -numa_fast_node memory available to "
+                           "the grids in each rank.",
+                           _numa_fast_mib));
 #endif
+        parser.add_option(new CommandLineParser::IntOption
+                          ("huge_pages",
+                           "Page size for grids and MPI buffers: "
+                           "0 for default pages, "
+                           "1 for transparent huge pages via madvise(), "
+                           "2 for explicit 2MiB huge pages, or "
+                           "3 for explicit 1GiB huge pages. "
+                           "Explicit huge pages fall back to transparent ones if unavailable.",
+                           _huge_pages));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("alloc_pool",
+                           "Keep the memory of grids, MPI buffers, and scratch grids in a "
+                           "process-wide pool when the solution ends, and reuse it for later "
+                           "solutions needing the same sizes, e.g., for many shots run in one "
+                           "process. Reused memory is not cleared.",
+                           _alloc_pool));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("ooc_dir",
+                           "Directory, e.g., on an NVMe drive, for files backing the grids "
+                           "of each rank, for domains larger than memory. "
+                           "Slabs of the grids across the first domain dimension are read "
+                           "ahead of the region being calculated and written back "
+                           "once the regions have passed them. Use region sizes smaller "
+                           "than the rank domain in that dimension, and temporal wave-front "
+                           "tiling (-rt > 1) so that each slab is used for several steps "
+                           "per round trip. Empty to keep the grids in memory.",
+                           _ooc_dir));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("ooc_ahead",
+                           "Number of regions across the first domain dimension to read "
+                           "ahead when -ooc_dir is set.",
+                           _ooc_ahead));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("first_touch",
+                           "Initialize newly-allocated grids in the same region, block, and thread "
+                           "order used to calculate them, so that each memory page is placed "
+                           "on the NUMA node of the thread that computes on it.",
+                           _first_touch));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("nt_stores",
+                           "Use streaming (non-temporal) stores for the grids that a stencil bundle "
+                           "writes without reading them at the same step index, "
+                           "when the bundle writes more than -nt_store_mib in a region. "
+                           "This avoids reading the output into the cache before writing it.",
+                           _nt_stores));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("nt_store_mib",
+                           "Minimum MiB written by a stencil bundle to its write-only grids in a region "
+                           "for streaming stores to be used; 0 for the size of the last-level cache.",
+                           _nt_store_mib));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("measure_mem_bw",
+                           "Measure the memory bandwidth with the STREAM triad when the first solution "
+                           "is prepared, and report the throughput attainable with it given "
+                           "the estimated bytes per point.",
+                           _measure_mem_bw));
+#ifdef MODEL_CACHE
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("cache_model_sample",
+                           "Model the caches using one in this many cache lines, "
+                           "rounded down to a power of 2; 1 to model every line.",
+                           _cache_model_sample));
+#endif
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("alias_pad",
+                           "Before allocating grids, add padding to any grid dimension whose "
+                           "stride is a multiple of 4KiB or of an L1 or L2 set stride, and "
+                           "stagger the grid base addresses across the set stride by the "
+                           "number of grids accessed together in a stencil bundle.",
+                           _alias_pad));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("l1_set_stride",
+                           "Bytes between addresses in the same L1 data-cache set "
+                           "(cache size divided by ways); 0 to read it from sysfs.",
+                           _l1_set_stride));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("l2_set_stride",
+                           "Bytes between addresses in the same L2 cache set "
+                           "(cache size divided by ways); 0 to read it from sysfs.",
+                           _l2_set_stride));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("auto_tune_all",
+                           "After the auto-tuner finds the block size, also search "
+                           "the number of threads per block, the sub-block sizes, and, "
+                           "when temporal wave-front tiling is enabled, the region sizes, "
+                           "one at a time.",
+                           _tune_all));
+        parser.add_option(new CommandLineParser::BoolOption
+                          ("auto_tune_mpi",
+                           "When there are multiple ranks, tune them in lockstep: "
+                           "evaluate each candidate using the elapsed time of the slowest rank "
+                           "and apply the settings chosen on rank 0 to all ranks.",
+                           _tune_mpi));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("auto_tune_cache",
+                           "File in which to save the best settings found by the auto-tuner "
+                           "and from which to reload them in later runs, "
+                           "skipping the search when the stencil, arch, rank-domain sizes, "
+                           "temporal tile sizes, number of threads, and CPU model all match. "
+                           "Empty to disable.",
+                           _at_cache_file));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("bb_cache_dir",
+                           "Directory in which to save the bounding-boxes found for each "
+                           "stencil bundle and from which to reload them in later runs "
+                           "with the same stencil, domain sizes, and rank indices. "
+                           "Empty to disable.",
+                           _bb_cache_dir));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("order_file",
+                           "File of boxes that need a minimum finite-difference order, "
+                           "for stencils that use a lower-order bundle where allowed. "
+                           "Each line contains the order followed by the first and last "
+                           "overall-domain indices of a box in each domain dimension. "
+                           "Where boxes overlap, the last one is used; "
+                           "outside of all boxes, the highest order is used.",
+                           _order_file));
+        parser.add_option(new CommandLineParser::StringOption
+                          ("trace_file",
+                           "File to which to write a timeline of the steps, bundle packs, "
+                           "blocks, and halo-exchange phases of each thread in the Chrome "
+                           "trace-event JSON format, viewable with chrome://tracing or Perfetto. "
+                           "Written when the solution is ended. "
+                           "With more than one rank, '.<rank>' is added to the name. "
+                           "Empty to disable.",
+                           _trace_file));
+        parser.add_option(new CommandLineParser::IdxOption
+                          ("trace_buf_events",
+                           "Max number of the latest events kept per thread for '-trace_file'.",
+                           _trace_buf_events));
     }
     
     // Print usage message.
@@ -307,7 +681,14 @@ namespace yask {
             " Set block sizes to specify a unit of work done by each thread team.\n"
             "  A block size of 0 in a given dimension =>\n"
             "   block size is set to region size in that dimension.\n"
-            "  Temporal tiling in blocks is not yet supported, so effectively, bt = 1.\n"
+            "  Control the time-steps in each temporal block with -bt.\n"
+            "   All the steps in a block are evaluated before moving to the next\n"
+            "   block, using trapezoid-shaped tiles that do not depend on\n"
+            "   each other within each of several phases.\n"
+            "   The region size in the step dimension is increased to -bt if needed.\n"
+            "   The spatial block sizes must be at least 2 * wave-front angle *\n"
+            "   (bt * num-packs - 1) in each dimension with a non-zero angle;\n"
+            "   otherwise, the steps are evaluated separately.\n"
             " Set block-group sizes to control the ordering of blocks within a region.\n"
             "  All blocks that intersect a given block-group are evaluated before blocks\n"
             "   in the next block-group.\n"
@@ -343,13 +724,17 @@ namespace yask {
             "  To 'weak-scale' to a larger overall-problem size, use multiple MPI ranks\n"
             "   and keep the rank-domain sizes constant.\n"
             "  To 'strong-scale' a given overall-problem size, use multiple MPI ranks\n"
-            "   and reduce the size of each rank-domain appropriately.\n" <<
+            "   and reduce the size of each rank-domain appropriately.\n"
+            "  Use '-overlap_comms' to hide halo-exchange latency behind the\n"
+            "   calculation of interior points. The thickness of the exterior\n"
+            "   shell is based on the max halos, rounded up to cluster sizes.\n" <<
 #endif
             appNotes <<
             "Examples:\n" <<
             " " << pgmName << " -d 768 -dt 25\n" <<
             " " << pgmName << " -dx 512 -dy 256 -dz 128\n" <<
-            " " << pgmName << " -d 2048 -dt 20 -r 512 -rt 10  # temporal tiling.\n" <<
+            " " << pgmName << " -d 2048 -dt 20 -r 512 -rt 10  # temporal tiling.\n"
+            " " << pgmName << " -d 2048 -dt 20 -b 128 -bt 4  # temporal blocking.\n" <<
             " " << pgmName << " -d 512 -nrx 2 -nry 1 -nrz 2   # multi-rank.\n";
         for (auto ae : appExamples)
             os << " " << pgmName << " " << ae << endl;
@@ -394,11 +779,90 @@ namespace yask {
         return prod;
     }
 
+    // Names of the region-loop paths from the REGION_LOOP_PATHS macro,
+    // in the order of the cases in the generated region-loop code.
+    const vector<string>& KernelSettings::get_region_paths() {
+        static vector<string> paths;
+        if (paths.empty()) {
+            istringstream iss(REGION_LOOP_PATHS);
+            string name;
+            while (getline(iss, name, ','))
+                paths.push_back(name);
+        }
+        return paths;
+    }
+
+    // Set the rank-domain sizes given for each rank index.
+    // The numbers of ranks must be final, so this is called after
+    // the rank layout is chosen.
+    void KernelSettings::applyRankSplits(KernelEnvPtr env) {
+        for (auto& i : _rank_splits) {
+            auto& dname = i.first;
+            auto& sizes = i.second;
+            if (sizes.empty())
+                continue;
+            if (idx_t(sizes.size()) != _num_ranks[dname])
+                FORMAT_AND_THROW_YASK_EXCEPTION("Error: " << sizes.size() <<
+                                                " rank-domain size(s) given in '" << dname <<
+                                                "' dimension, but there are " << _num_ranks[dname] <<
+                                                " rank(s) in that dimension");
+            auto ri = find_loc ? _num_ranks.unlayout(env->my_rank)[dname] :
+                _rank_indices[dname];
+            _rank_sizes[dname] = sizes.at(ri);
+        }
+    }
+
     // Make sure all user-provided settings are valid and finish setting up some
     // other vars before allocating memory.
     // Called from prepare_solution(), so it doesn't normally need to be called from user code.
     void KernelSettings::adjustSettings(std::ostream& os, KernelEnvPtr env) {
         auto& step_dim = _dims->_step_dim;
+
+        if (_huge_pages < 0 || _huge_pages > 3)
+            THROW_YASK_EXCEPTION("Error: huge_pages must be 0, 1, 2, or 3");
+
+        // Add the boxes from the order file once.
+        if (_order_file.length()) {
+            ifstream ifs(_order_file);
+            if (!ifs.is_open())
+                THROW_YASK_EXCEPTION("Error: cannot open order file '" + _order_file + "'");
+            string line;
+            int nboxes = 0;
+            while (getline(ifs, line)) {
+                if (line.find_first_not_of(" \t") == string::npos || line[0] == '#')
+                    continue;
+                istringstream iss(line);
+                OrderBox ob { _dims->_domain_dims, _dims->_domain_dims, 0 };
+                iss >> ob.order;
+                for (int j = 0; j < ob.first.getNumDims(); j++)
+                    iss >> ob.first[j];
+                for (int j = 0; j < ob.last.getNumDims(); j++)
+                    iss >> ob.last[j];
+                if (iss.fail())
+                    THROW_YASK_EXCEPTION("Error: cannot parse line '" + line +
+                                         "' in order file '" + _order_file + "'");
+                _order_boxes.push_back(ob);
+                nboxes++;
+            }
+            os << "Read " << nboxes << " min-order box(es) from '" << _order_file << "'.\n";
+            _order_file.clear();
+        }
+
+        auto& paths = get_region_paths();
+        auto pi = find(paths.begin(), paths.end(), _region_path);
+        if (pi == paths.end())
+            THROW_YASK_EXCEPTION("Error: region_path '" + _region_path +
+                                 "' is not one of the paths in this kernel");
+        _region_path_idx = int(pi - paths.begin());
+
+        // Temporal blocks are evaluated within regions, so
+        // the region must have at least as many steps.
+        auto bt = _block_sizes[step_dim];
+        if (bt > 1 && _region_sizes[step_dim] < bt) {
+            os << "Note: increasing region size in '" << step_dim <<
+                "' dim to " << bt << " to match block size.\n";
+            _region_sizes[step_dim] = bt;
+        }
     
         // Determine num regions.
         // Also fix up region sizes as needed.
@@ -423,21 +887,28 @@ namespace yask {
                                  _dims->_cluster_pts);
         os << " num-blocks-per-region: " << nb << endl;
         os << " num-blocks-per-rank-domain: " << (nb * nr) << endl;
+        bt = _block_sizes[step_dim];
+        os << " Since the block size in the '" << step_dim <<
+            "' dim is " << bt << ", temporal blocking is ";
+        if (bt <= 1) os << "NOT ";
+        os << "enabled.\n";
 
         // Adjust defaults for sub-blocks to be slab if
         // we are using more than one block thread.
         // Otherwise, findNumSubsets() would set default
         // to entire block.
-        if (num_block_threads > 1) {
-            for (auto& dim : _dims->_domain_dims.getDims()) {
-                auto& dname = dim.getName();
-                if (_sub_block_sizes[dname] == 0)
-                    _sub_block_sizes[dname] = 1; // will be rounded up to min size.
-                
-                // Only want to set 1st dim; others will be set to max.
-                // TODO: make sure we're not setting inner dim.
-                break;
-            }
+        // When sharing a core, use the dim outside the inner-most one
+        // instead, so that the threads of a block work on adjacent rows.
+        auto& ddims = _dims->_domain_dims;
+        int ndd = ddims.getNumDims();
+        if (num_block_threads > 1 && ndd > 0) {
+            int sdim = (_smt_share && ndd > 1) ? ndd - 2 : 0;
+            auto& dname = ddims.getDimName(sdim);
+            if (_sub_block_sizes[dname] == 0)
+                _sub_block_sizes[dname] = 1; // will be rounded up to min size.
+
+            // Only want to set one dim; others will be set to max.
+            // TODO: make sure we're not setting inner dim.
         }
 
         // Determine num sub-blocks.
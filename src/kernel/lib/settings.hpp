@@ -68,8 +68,8 @@ namespace yask {
         Indices(const idx_t src[], int ndims) {
             setFromArray(src, ndims);
         }
-        Indices(idx_t src, int ndims) {
-            setFromConst(src, ndims);
+        Indices(idx_t src, int ndims) : _ndims(ndims) {
+            setFromConst(src);
         }
         
         // Default copy ctor, copy operator should be okay.
@@ -321,6 +321,56 @@ namespace yask {
         }
     };
 
+    // Indices with the number of dims fixed at compile time, e.g.,
+    // NUM_STENCIL_DIMS from the generated code, so that loops over
+    // the dims can be fully unrolled. Has the same layout as Indices,
+    // so it can be passed wherever Indices are expected.
+    template <int N>
+    class FixedIndices : public Indices {
+
+    public:
+        static_assert(N <= +max_idxs, "too many dims for Indices");
+
+        // Ctors.
+        FixedIndices() : Indices(N) { }
+        FixedIndices(const Indices& src) {
+            setFromArray(&src[0], src.getNumDims());
+        }
+        FixedIndices(idx_t src, int ndims) {
+            setFromConst(src, ndims);
+        }
+
+        // Access size.
+        inline int getNumDims() const {
+            return N;
+        }
+
+        // Inits.
+        inline void setFromArray(const idx_t src[], int n = N) {
+            assert(n == N);
+#pragma unroll
+            for (int i = 0; i < N; i++)
+                _idxs[i] = src[i];
+            _ndims = N;
+        }
+        inline void setFromConst(idx_t val, int n = N) {
+            assert(n == N);
+#pragma unroll
+            for (int i = 0; i < N; i++)
+                _idxs[i] = val;
+            _ndims = N;
+        }
+
+        // Copy only the used elements.
+        FixedIndices(const FixedIndices& src) {
+            setFromArray(src._idxs);
+        }
+        inline FixedIndices& operator=(const FixedIndices& src) {
+            setFromArray(src._idxs);
+            return *this;
+        }
+    };
+
     // Define OMP reductions on Indices.
 #pragma omp declare reduction(min_idxs : Indices : \
                               omp_out = omp_out.minElements(omp_in) )   \
@@ -351,10 +401,17 @@ namespace yask {
         MPI_Comm comm=0;        // communicator.
         int num_ranks=1;        // total number of ranks.
         int my_rank=0;          // MPI-assigned index.
+        MPI_Comm shm_comm=0;    // communicator of ranks sharing memory with this one.
+        int num_shm_ranks=1;    // number of ranks in 'shm_comm'.
+        int my_shm_rank=0;      // index in 'shm_comm'.
 
         // OMP vars.
         int max_threads=0;      // initial value from OMP.
 
+        // Memory BW over all ranks in bytes/sec from the first
+        // solution prepared with '-measure_mem_bw'.
+        double stream_bw=0.;
+
         virtual ~KernelEnv() {}
         
         // Init MPI, OMP, etc.
@@ -371,6 +428,7 @@ namespace yask {
         virtual void global_barrier() const {
             MPI_Barrier(comm);
         }
+        virtual idx_t clear_alloc_pool();
     };
     typedef std::shared_ptr<KernelEnv> KernelEnvPtr;
 
@@ -389,6 +447,20 @@ namespace yask {
         IdxTuple _stencil_dims; // step & domain dims.
         IdxTuple _misc_dims;
 
+        // Dim IDs: the posn of each dim in '_stencil_dims', so tuples
+        // made from '_stencil_dims' can be indexed without name lookups.
+        // The step dim is always Indices::step_posn, and domain dim 'j'
+        // in '_domain_dims' or a tuple made from it has ID 'j + 1'.
+        static constexpr int get_domain_dim_id(int j) {
+            return Indices::step_posn + 1 + j;
+        }
+        static constexpr int get_domain_dim_posn(int dim_id) {
+            return dim_id - 1 - Indices::step_posn;
+        }
+        int get_dim_id(const std::string& dim) const {
+            return _stencil_dims.lookup_posn(dim);
+        }
+
         // Dimensions and sizes.
         IdxTuple _fold_pts;     // all domain dims.
         IdxTuple _vec_fold_pts; // just those with >1 pts.
@@ -452,23 +524,25 @@ namespace yask {
     // A group of Indices needed for generated loops.
     // See the help message from gen_loops.pl for the
     // documentation of the indices.
+    // 'IdxsT' is Indices or FixedIndices<NUM_STENCIL_DIMS>.
     // Make sure this stays non-virtual.
-    struct ScanIndices {
+    template <typename IdxsT>
+    struct GenericScanIndices {
         int ndims = 0;
 
         // Values that remain the same for each sub-range.
-        Indices begin, end;     // first and end (beyond last) range of each index.
-        Indices step;           // step value within range.
-        Indices align;          // alignment of steps after first one.
-        Indices align_ofs;      // adjustment for alignment (see below).
-        Indices group_size;     // proximity grouping within range.
+        IdxsT begin, end;       // first and end (beyond last) range of each index.
+        IdxsT step;             // step value within range.
+        IdxsT align;            // alignment of steps after first one.
+        IdxsT align_ofs;        // adjustment for alignment (see below).
+        IdxsT group_size;       // proximity grouping within range.
 
         // Alignment: when possible, each step will be aligned
         // such that ((start - align_ofs) % align) == 0.
         
         // Values that differ for each sub-range.
-        Indices start, stop;    // first and last+1 for this sub-range.
-        Indices index;          // 0-based unique index for each sub-range.
+        IdxsT start, stop;      // first and last+1 for this sub-range.
+        IdxsT index;            // 0-based unique index for each sub-range.
 
         // Example w/3 sub-ranges in overall range:
         // begin                                         end
@@ -479,7 +553,7 @@ namespace yask {
         //                                       start   stop  (index = 2)
         
         // Default init.
-        ScanIndices(const Dims& dims, bool use_vec_align, IdxTuple* ofs) :
+        GenericScanIndices(const Dims& dims, bool use_vec_align, IdxTuple* ofs) :
             ndims(dims._stencil_dims.size()),
             begin(idx_t(0), ndims),
             end(idx_t(0), ndims),
@@ -492,8 +566,9 @@ namespace yask {
             index(idx_t(0), ndims) {
 
             // i: index for stencil dims, j: index for domain dims.
-            for (int i = 0, j = 0; i < ndims; i++) {
+            for (int i = 0; i < ndims; i++) {
                 if (i == Indices::step_posn) continue;
+                int j = Dims::get_domain_dim_posn(i);
 
                 // Set alignment to vector lengths.
                 if (use_vec_align)
@@ -506,11 +581,22 @@ namespace yask {
                 }
             }
         }
+
+        // Default copy ctor, copy operator should be okay.
+
+        // Convert between index types.
+        template <typename T2>
+        explicit GenericScanIndices(const GenericScanIndices<T2>& src) :
+            ndims(src.ndims),
+            begin(src.begin), end(src.end),
+            step(src.step), align(src.align), align_ofs(src.align_ofs),
+            group_size(src.group_size),
+            start(src.start), stop(src.stop), index(src.index) { }
         
         // Init from outer-loop indices.
         // Start..stop from point in outer loop become begin..end
         // for this loop.
-        void initFromOuter(const ScanIndices& outer) {
+        void initFromOuter(const GenericScanIndices& outer) {
 
             // Begin & end set from start & stop of outer loop.
             begin = outer.start;
@@ -526,6 +612,11 @@ namespace yask {
             index = outer.index;
         }
     };
+    typedef GenericScanIndices<Indices> ScanIndices;
+
+    // ScanIndices with the number of stencil dims fixed at compile time.
+    template <int N>
+    using FixedScanIndices = GenericScanIndices<FixedIndices<N>>;
 
     // MPI neighbor info.
     class MPIInfo {
@@ -576,6 +667,16 @@ namespace yask {
         // Whether each neighbor has all its rank-domain
         // sizes as a multiple of the vector length.
         std::vector<bool> has_all_vlen_mults;
+
+        // Rank of each neighbor in the shared-memory communicator.
+        // MPI_PROC_NULL => not on this node.
+        // Vector index is per getNeighborIndex().
+        Neighbors shm_ranks;
+
+        // Halo bytes and messages sent to each neighbor since the
+        // timers were last cleared.
+        // Vector index is per getNeighborIndex().
+        std::vector<idx_t> send_bytes, send_msgs;
         
         // Ctor based on pre-set problem dimensions.
         MPIInfo(DimsPtr dims) : _dims(dims) {
@@ -594,6 +695,9 @@ namespace yask {
             my_neighbors.resize(neighborhood_size, MPI_PROC_NULL);
             man_dists.resize(neighborhood_size, 0);
             has_all_vlen_mults.resize(neighborhood_size, false);
+            shm_ranks.resize(neighborhood_size, MPI_PROC_NULL);
+            send_bytes.resize(neighborhood_size, 0);
+            send_msgs.resize(neighborhood_size, 0);
         }
 
         // Get a 1D index for a neighbor.
@@ -636,6 +740,12 @@ namespace yask {
         // vector length in all dims and buffer is aligned.
         bool vec_copy_ok = false;
 
+        // Whether the neighbor is on the same node and the data is
+        // exchanged through a shared-memory window. A send buffer is then
+        // in this rank's window, and a receive buffer points into the
+        // neighbor's window at its matching send buffer.
+        bool via_shm = false;
+
         // Number of points overall.
         idx_t get_size() const {
             if (num_pts.size() == 0)
@@ -646,6 +756,19 @@ namespace yask {
             return get_size() * sizeof(real_t);
         }
 
+        // Max number of steps that can be held at once.
+        // The step dim of 'num_pts' is set to this value.
+        idx_t max_steps = 1;
+
+        // Number of points and bytes when holding only 'nsteps' steps.
+        idx_t get_size(idx_t nsteps) const {
+            assert(nsteps <= max_steps);
+            return get_size() / max_steps * nsteps;
+        }
+        idx_t get_bytes(idx_t nsteps) const {
+            return get_size(nsteps) * sizeof(real_t);
+        }
+
         // Set pointer to storage.
         // Free old storage.
         // 'base' should provide get_num_bytes() bytes at offset bytes.
@@ -663,6 +786,8 @@ namespace yask {
             begin_pt.clear();
             last_pt.clear();
             num_pts.clear();
+            max_steps = 1;
+            via_shm = false;
             release_storage();
         }
         ~MPIBuf() {
@@ -690,6 +815,59 @@ namespace yask {
         typedef std::vector<MPIBufs> NeighborBufs;
         NeighborBufs bufs;
 
+        // Max number of steps exchanged in one message.
+        idx_t max_steps = 1;
+
+        // MPI tag for messages; same on all ranks.
+        int tag = 0;
+
+#ifdef USE_MPI
+        // Request handles for all possible neighbors.
+        // Kept here instead of on the stack so that an exchange
+        // can remain in progress while computation continues.
+        std::vector<MPI_Request> recv_reqs;
+        std::vector<MPI_Request> send_reqs;
+
+        // Persistent requests for all possible neighbors, created on
+        // first use. A receive is created for the full buffer; a send is
+        // created for each message size used, e.g., for each number of
+        // steps in a multi-step exchange.
+        std::vector<MPI_Request> precv_reqs;
+        std::vector<std::map<size_t, MPI_Request>> psend_reqs;
+
+        // Start a receive of up to 'max_bytes' from or a send of 'nbytes'
+        // to neighbor 'ni' and save the request in 'recv_reqs[ni]' or
+        // 'send_reqs[ni]'. If 'persistent', (re)start a persistent
+        // request instead of making a new one.
+        void start_recv(void* buf, size_t max_bytes, int rank, int ni,
+                        MPI_Comm comm, bool persistent);
+        void start_send(void* buf, size_t nbytes, int rank, int ni,
+                        MPI_Comm comm, bool persistent);
+
+        // Release persistent requests. Must not be active.
+        void free_persistent_reqs();
+
+        // Shared-memory window holding the send buffers that are
+        // 'via_shm'. Instead of the data, a zero-byte message tells the
+        // receiver that a buffer is ready, and another with tag
+        // 'tag + shm_ack_tag_ofs' tells the sender that the receiver
+        // is done reading it.
+        MPI_Win shm_win = MPI_WIN_NULL;
+        static constexpr int shm_ack_tag_ofs = 0x4000;
+        std::vector<MPI_Request> shm_done_reqs; // acks expected by sender.
+        std::vector<MPI_Request> shm_ack_reqs; // acks sent by receiver.
+
+        // Wait until the send buffer to neighbor 'ni' may be written.
+        void wait_for_send_buf(int ni);
+
+        // Make data read from the receive buffer of neighbor 'ni'
+        // visible after its request completed.
+        void sync_recv_buf(int ni);
+
+        // Tell neighbor 'ni' that its data has been read.
+        void release_recv_buf(int rank, int ni, MPI_Comm comm);
+#endif
+
         MPIData(MPIInfoPtr mpiInfo) :
             _mpiInfo(mpiInfo) {
 
@@ -697,6 +875,14 @@ namespace yask {
             auto n = _mpiInfo->neighborhood_size;
             MPIBufs emptyBufs;
             bufs.resize(n, emptyBufs);
+#ifdef USE_MPI
+            recv_reqs.resize(n, MPI_REQUEST_NULL);
+            send_reqs.resize(n, MPI_REQUEST_NULL);
+            precv_reqs.resize(n, MPI_REQUEST_NULL);
+            psend_reqs.resize(n);
+            shm_done_reqs.resize(n, MPI_REQUEST_NULL);
+            shm_ack_reqs.resize(n, MPI_REQUEST_NULL);
+#endif
         }
 
         // Apply a function to each neighbor rank.
@@ -724,6 +910,8 @@ namespace yask {
         DimsPtr _dims;
         
         // Sizes in elements (points).
+        // These all have the stencil dims in order, so they may be
+        // indexed by the IDs from Dims.
         IdxTuple _rank_sizes;     // number of steps and this rank's domain sizes.
         IdxTuple _region_sizes;   // region size (used for wave-front tiling).
         IdxTuple _block_group_sizes; // block-group size (only used for 'grouped' region loops).
@@ -732,25 +920,102 @@ namespace yask {
         IdxTuple _sub_block_sizes;       // sub-block size (used for each nested thread).
         IdxTuple _min_pad_sizes;         // minimum spatial padding.
         IdxTuple _extra_pad_sizes;       // extra spatial padding.
+        IdxTuple _tile_sizes;            // tile size in grid layouts; 0 => none.
 
         // MPI settings.
         IdxTuple _num_ranks;       // number of ranks in each dim.
         IdxTuple _rank_indices;    // my rank index in each dim.
         bool find_loc = true;      // whether my rank index needs to be calculated.
+        bool _auto_decomp = true;  // choose '_num_ranks' from the node topology if needed.
+        std::map<std::string, std::vector<idx_t>> _rank_splits; // domain sizes at each rank index.
+        int _balance_steps = 0;    // steps to time before balancing the rank sizes.
         int msg_rank = 0;          // rank that prints informational messages.
+        std::string _rank_stats_file; // CSV of per-rank and per-neighbor stats; empty => none.
+        bool overlap_comms = false; // overlap halo exchange with interior calculation.
+        bool _mpi_alloc_mem = false; // use MPI_Alloc_mem() for MPI buffers.
+        bool multi_step_halos = false; // exchange all steps in a WF in each message.
+        bool aggregate_halos = false; // exchange all grids in one message per neighbor.
+        bool persistent_halos = false; // use persistent MPI requests for halo exchange.
+        bool neighbor_halos = false; // use neighborhood collectives for halo exchange.
+        bool use_shm = false;      // exchange halos via shared memory on the same node.
+
+        // Global offsets and overall-domain sizes for a single-rank context
+        // that covers only part of the problem, e.g., for sampled
+        // validation. Empty => use the offsets from the rank layout.
+        IdxTuple _sub_domain_offsets;
+        IdxTuple _sub_domain_overall_sizes;
 
         // OpenMP settings.
         int max_threads = 0;      // Initial number of threads to use overall; 0=>OMP default.
         int thread_divisor = 1;   // Reduce number of threads by this amount.
         int num_block_threads = 1; // Number of threads to use for a block.
+        bool _smt_share = false;  // block threads share a core and its L1.
+        int _numa_parts = 1;      // slabs of the rank, each with its own thread team.
+        bool _async_packs = false; // run packs as a graph of block tasks.
+
+        // Path of the region loops through the blocks.
+        std::string _region_path = "default";
+        int _region_path_idx = 0; // index of '_region_path' in get_region_paths().
 
         // Prefetch distances.
         // Prefetching must be enabled via YASK_PREFETCH_L[12] macros.
         int _prefetch_L1_dist = 1;
         int _prefetch_L2_dist = 2;
 
+        // Streaming stores for write-only outputs.
+        bool _nt_stores = false;  // allow them.
+        idx_t _nt_store_mib = 0;  // min output per region; 0 => last-level cache size.
+
+        // Roofline estimates.
+        bool _measure_mem_bw = false; // run STREAM triad in prepare_solution().
+
+#ifdef MODEL_CACHE
+        // Model one in this many cache lines.
+        idx_t _cache_model_sample = 16;
+#endif
+
         // NUMA settings.
         int _numa_pref = NUMA_PREF;
+        int _huge_pages = 0;    // 0: none, 1: THP, 2: 2MiB, 3: 1GiB.
+        bool _alloc_pool = false; // reuse memory across solutions.
+        std::string _ooc_dir;   // dir for out-of-core grid files; empty => in memory.
+        idx_t _ooc_ahead = 2;   // regions to prefetch ahead when out-of-core.
+        int _numa_fast_node = yask_numa_none; // node for bandwidth-bound grids.
+        idx_t _numa_fast_mib = 0; // capacity of '_numa_fast_node' for this rank.
+        bool _first_touch = false; // init grids in block order.
+
+        // Cache-aliasing avoidance.
+        bool _alias_pad = false;  // pad grids and offset their bases.
+        idx_t _l1_set_stride = 0; // L1D size / ways; 0 => read from sysfs.
+        idx_t _l2_set_stride = 0; // L2 size / ways; 0 => read from sysfs.
+
+        // Auto-tune other settings after the block size.
+        bool _tune_all = false;
+
+        // Tune all ranks together using the time of the slowest one.
+        bool _tune_mpi = false;
+
+        // File of cached auto-tuner results; empty => no cache.
+        std::string _at_cache_file;
+
+        // Directory for cached bounding-box analysis; empty => no cache.
+        std::string _bb_cache_dir;
+
+        // Min finite-difference order needed in boxes of the overall
+        // domain, used by stencils with 'min_order()' conditions.
+        // Where boxes overlap, the last one is used.
+        struct OrderBox {
+            IdxTuple first, last; // inclusive; domain dims only.
+            idx_t order;
+        };
+        std::vector<OrderBox> _order_boxes;
+
+        // File of boxes to add to '_order_boxes'; empty => none.
+        std::string _order_file;
+
+        // Timeline of steps, packs, blocks, and halo phases; empty => none.
+        std::string _trace_file;
+        idx_t _trace_buf_events = 1024 * 1024; // events kept per thread.
 
         // Ctor.
         KernelSettings(DimsPtr dims, KernelEnvPtr env) : 
@@ -785,15 +1050,38 @@ namespace yask {
             _extra_pad_sizes = dims->_stencil_dims;
             _extra_pad_sizes.setValsSame(0);
 
+            _tile_sizes = dims->_stencil_dims;
+            _tile_sizes.setValsSame(0);
+
             // Use domain dims only for MPI tuples.
             _num_ranks = dims->_domain_dims;
             _num_ranks.setValsSame(1);
             
             _rank_indices = dims->_domain_dims;
             _rank_indices.setValsSame(0);
+
+            // Empty => use '_rank_sizes'.
+            for (auto& dim : dims->_domain_dims.getDims())
+                _rank_splits[dim.getName()];
         }
         virtual ~KernelSettings() { }
 
+        // Get the min FD order needed at the stencil-dim indices 'idxs'.
+        // Returns 'idx_max' outside of all boxes, so the highest order
+        // is used by default.
+        idx_t get_min_order(const Indices& idxs) const {
+            for (auto bi = _order_boxes.rbegin(); bi != _order_boxes.rend(); bi++) {
+                bool inside = true;
+                for (int j = 0; inside && j < bi->first.getNumDims(); j++) {
+                    idx_t i = idxs[Dims::get_domain_dim_id(j)];
+                    inside = i >= bi->first.getVal(j) && i <= bi->last.getVal(j);
+                }
+                if (inside)
+                    return bi->order;
+            }
+            return idx_max;
+        }
+
     protected:
         // Add options to set one domain var to a cmd-line parser.
         virtual void _add_domain_option(CommandLineParser& parser,
@@ -817,12 +1105,20 @@ namespace yask {
                          const std::string& appNotes,
                          const std::vector<std::string>& appExamples) const;
         
+        // Set '_rank_sizes' from '_rank_splits' for this rank.
+        // Called from prepare_solution() after the rank layout is known.
+        virtual void applyRankSplits(KernelEnvPtr env);
+
         // Make sure all user-provided settings are valid by rounding-up
         // values as needed.
         // Called from prepare_solution(), so it doesn't normally need to be called from user code.
         // Prints informational info to 'os'.
         virtual void adjustSettings(std::ostream& os, KernelEnvPtr env);
 
+        // Names of the region-loop paths compiled into the kernel.
+        // Index 0 is the default path.
+        static const std::vector<std::string>& get_region_paths();
+
         // Determine if this is the first or last rank in given dim.
         virtual bool is_first_rank(const std::string dim) {
             return _rank_indices[dim] == 0;
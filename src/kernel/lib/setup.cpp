@@ -31,6 +31,135 @@ using namespace std;
 
 namespace yask {
 
+    // If the number of ranks is not given for every dim, choose the
+    // numbers of ranks 'nr' in each domain dim and the numbers of nodes
+    // 'nn' across them so that the ranks on each node form a box of
+    // 'nr/nn' ranks. The box and grid of nodes are chosen to minimize the
+    // halo data crossing between nodes per step, which is the sum over
+    // dims of the number of faces between nodes times the rank-face size
+    // times the sum of the grid halos in that dim. Halos between ranks on
+    // the same node are given a small weight, so faces within nodes are
+    // also kept few when there is a choice.
+    void StencilContext::find_rank_layout() {
+#ifdef USE_MPI
+        auto nranks = _env->num_ranks;
+        if (!_opts->_auto_decomp || _opts->_num_ranks.product() == nranks)
+            return;
+        ostream& os = get_ostr();
+        auto& ddims = _dims->_domain_dims;
+        int nddims = ddims.size();
+
+        // Ranks per node. Use a flat layout unless every node has the same number.
+        int nlocal = _env->num_shm_ranks, min_local = nlocal, max_local = nlocal;
+        MPI_Allreduce(MPI_IN_PLACE, &min_local, 1, MPI_INT, MPI_MIN, _env->comm);
+        MPI_Allreduce(MPI_IN_PLACE, &max_local, 1, MPI_INT, MPI_MAX, _env->comm);
+        if (min_local != max_local)
+            nlocal = 1;
+        int nnodes = nranks / nlocal;
+
+        // Sum of halos times size of a rank face in each dim.
+        vector<double> face_wts(nddims, 0.);
+        for (int di = 0; di < nddims; di++) {
+            auto& dname = ddims.getDimName(di);
+            double area = 1.;
+            for (int dj = 0; dj < nddims; dj++)
+                if (dj != di)
+                    area *= _opts->_rank_sizes[ddims.getDimName(dj)];
+            double halos = 0.;
+            for (auto gp : gridPtrs)
+                if (gp && !gp->is_fixed_size() && gp->is_dim_used(dname))
+                    halos += gp->get_left_halo_size(dname) + gp->get_right_halo_size(dname);
+            face_wts[di] = area * halos;
+        }
+
+        // Try every 'nr' with the given values fixed and every 'nn' that
+        // divides it, keeping the first one with the lowest cost.
+        const double local_wt = 0.1;
+        vector<idx_t> nr(nddims), nn(nddims), best_nr, best_nn;
+        double best_cost = -1.;
+        function<void (int, idx_t)> try_nn = [&](int di, idx_t rem) {
+            if (di == nddims) {
+                if (rem != 1)
+                    return;
+                double cost = 0.;
+                for (int dj = 0; dj < nddims; dj++) {
+                    double nfaces = double(nranks) / nr[dj];
+                    cost += nfaces * face_wts[dj] *
+                        ((nn[dj] - 1) + local_wt * (nr[dj] - nn[dj]));
+                }
+                if (best_cost < 0. || cost < best_cost) {
+                    best_cost = cost;
+                    best_nr = nr;
+                    best_nn = nn;
+                }
+                return;
+            }
+            for (idx_t n = 1; n <= nr[di]; n++)
+                if (nr[di] % n == 0 && rem % n == 0) {
+                    nn[di] = n;
+                    try_nn(di + 1, rem / n);
+                }
+        };
+        function<void (int, idx_t)> try_nr = [&](int di, idx_t rem) {
+            if (di == nddims) {
+                if (rem == 1)
+                    try_nn(0, nnodes);
+                return;
+            }
+            auto& dname = ddims.getDimName(di);
+            idx_t given = _opts->_num_ranks[dname];
+
+            // Sizes given for each rank index also fix the number of ranks.
+            auto si = _opts->_rank_splits.find(dname);
+            if (given <= 1 && si != _opts->_rank_splits.end() && si->second.size() > 1)
+                given = idx_t(si->second.size());
+            for (idx_t n = 1; n <= rem; n++)
+                if (rem % n == 0 && (given <= 1 || n == given)) {
+                    nr[di] = n;
+                    try_nr(di + 1, rem / n);
+                }
+        };
+        try_nr(0, nranks);
+        if (best_cost < 0.)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: cannot divide " << nranks <<
+                                            " rank(s) into " <<
+                                            _opts->_num_ranks.makeDimValStr(" * ") <<
+                                            " with the dims of size 1 free");
+
+        // Index of this node: order of the lowest rank on each node.
+        int leader = _env->my_rank;
+        MPI_Allreduce(MPI_IN_PLACE, &leader, 1, MPI_INT, MPI_MIN,
+                      nlocal > 1 ? _env->shm_comm : MPI_COMM_SELF);
+        vector<int> leaders(nranks);
+        MPI_Allgather(&leader, 1, MPI_INT, leaders.data(), 1, MPI_INT, _env->comm);
+        set<int> uleaders(leaders.begin(), leaders.end());
+        int node_idx = distance(uleaders.begin(), uleaders.find(leader));
+        int local_idx = nlocal > 1 ? _env->my_shm_rank : 0;
+
+        // Set sizes and index of this rank in the box of its node.
+        IdxTuple node_sizes(ddims), box_sizes(ddims);
+        for (int di = 0; di < nddims; di++) {
+            auto& dname = ddims.getDimName(di);
+            _opts->_num_ranks[dname] = best_nr[di];
+            node_sizes[dname] = best_nn[di];
+            box_sizes[dname] = best_nr[di] / best_nn[di];
+        }
+        auto node_coords = node_sizes.unlayout(node_idx);
+        auto box_coords = box_sizes.unlayout(local_idx);
+        for (auto& dim : ddims.getDims()) {
+            auto& dname = dim.getName();
+            _opts->_rank_indices[dname] = node_coords[dname] * box_sizes[dname] +
+                box_coords[dname];
+        }
+        _opts->find_loc = false;
+
+        os << "Rank layout chosen for " << nranks << " rank(s) on " << nnodes <<
+            " node(s): " << _opts->_num_ranks.makeDimValStr(" * ") <<
+            " ranks as " << node_sizes.makeDimValStr(" * ") << " nodes of " <<
+            box_sizes.makeDimValStr(" * ") << " ranks each\n";
+#endif
+    }
+
     // Init MPI-related vars and other vars related to my rank's place in
     // the global problem: rank index, offset, etc.  Need to call this even
     // if not using MPI to properly init these vars.  Called from
@@ -39,7 +168,6 @@ namespace yask {
         ostream& os = get_ostr();
         auto& step_dim = _dims->_step_dim;
         auto me = _env->my_rank;
-        int num_neighbors = 0;
 
         // Check ranks.
         idx_t req_ranks = _opts->_num_ranks.product();
@@ -55,9 +183,60 @@ namespace yask {
         if (_opts->find_loc)
             _opts->_rank_indices = _opts->_num_ranks.unlayout(me);
 
-        // A table of rank-coordinates for everyone.
+        // The rank offsets, overall sizes, and neighbors only depend on
+        // the rank layout and sizes, so they are kept when
+        // prepare_solution() is called again and no rank changed them.
+        vector<idx_t> layout_key;
+        for (auto* t : { &_opts->_num_ranks, &_opts->_rank_indices, &_opts->_rank_sizes,
+                    &_opts->_sub_domain_offsets, &_opts->_sub_domain_overall_sizes })
+            for (int i = 0; i < t->getNumDims(); i++)
+                layout_key.push_back(t->getVal(i));
+        int layout_changed = layout_key != _rank_layout_key;
+#ifdef USE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &layout_changed, 1, MPI_INT, MPI_LOR, _env->comm);
+#endif
+        if (layout_changed) {
+            exchange_rank_info();
+            _rank_layout_key = layout_key;
+        }
+        else
+            os << "Rank layout and sizes unchanged; keeping rank offsets and neighbors.\n";
+
+        // Place a sub-domain context at its location in the overall problem.
+        if (_opts->_sub_domain_offsets.getNumDims()) {
+            if (_env->num_ranks > 1)
+                THROW_YASK_EXCEPTION("Error: a sub-domain solution must use a single rank");
+            rank_domain_offsets = _opts->_sub_domain_offsets;
+            overall_domain_sizes = _opts->_sub_domain_overall_sizes;
+        }
+
+        // Set offsets in grids and find WF extensions
+        // based on the grids' halos.
+        update_grid_info();
+
+        // Determine bounding-boxes for all bundles.
+        // This must be done after finding WF extensions.
+        find_bounding_boxes();
+
+    } // setupRank.
+
+    // Find this rank's offset in the overall problem, the overall sizes,
+    // and the neighbors by sharing the rank indices and sizes of all ranks.
+    void StencilContext::exchange_rank_info() {
+        ostream& os = get_ostr();
+        auto me = _env->my_rank;
+        int num_neighbors = 0;
+
+        // A table of rank-coordinates and rank-domain sizes for everyone.
+        // It is on the heap because it grows with the number of ranks.
         auto num_ddims = _opts->_rank_indices.size(); // domain-dims only!
-        idx_t coords[_env->num_ranks][num_ddims];
+        vector<idx_t> rank_info(_env->num_ranks * num_ddims * 2);
+        auto coords = [&](int rn, int di) -> idx_t& {
+            return rank_info[rn * num_ddims * 2 + di];
+        };
+        auto rsizes = [&](int rn, int di) -> idx_t& {
+            return rank_info[rn * num_ddims * 2 + num_ddims + di];
+        };
 
         // Init offsets and total sizes.
         rank_domain_offsets.setValsSame(0);
@@ -65,47 +244,57 @@ namespace yask {
 
         // Init coords for this rank.
         for (int i = 0; i < num_ddims; i++)
-            coords[me][i] = _opts->_rank_indices[i];
-
-        // A table of rank-domain sizes for everyone.
-        idx_t rsizes[_env->num_ranks][num_ddims];
+            coords(me, i) = _opts->_rank_indices[i];
 
         // Init sizes for this rank.
         for (int di = 0; di < num_ddims; di++) {
             auto& dname = _opts->_rank_indices.getDimName(di);
             auto rsz = _opts->_rank_sizes[dname];
-            rsizes[me][di] = rsz;
+            rsizes(me, di) = rsz;
             overall_domain_sizes[dname] = rsz;
         }
 
 #ifdef USE_MPI
-        // Exchange coord and size info between all ranks.
-        for (int rn = 0; rn < _env->num_ranks; rn++) {
-            MPI_Bcast(&coords[rn][0], num_ddims, MPI_INTEGER8,
-                      rn, _env->comm);
-            MPI_Bcast(&rsizes[rn][0], num_ddims, MPI_INTEGER8,
-                      rn, _env->comm);
-        }
-        // Now, the tables are filled in for all ranks.
+        // Exchange coord and size info between all ranks in one
+        // collective instead of a broadcast from each rank.
+        MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                      rank_info.data(), num_ddims * 2, MPI_INTEGER8, _env->comm);
+        // Now, the table is filled in for all ranks.
+
+        // Find the rank of everyone in the shared-memory communicator.
+        // Ranks on other nodes get MPI_UNDEFINED.
+        vector<int> wranks(_env->num_ranks), shm_ranks(_env->num_ranks);
+        for (int rn = 0; rn < _env->num_ranks; rn++)
+            wranks[rn] = rn;
+        MPI_Group wgroup, sgroup;
+        MPI_Comm_group(_env->comm, &wgroup);
+        MPI_Comm_group(_env->shm_comm, &sgroup);
+        MPI_Group_translate_ranks(wgroup, _env->num_ranks, wranks.data(),
+                                  sgroup, shm_ranks.data());
+        MPI_Group_free(&wgroup);
+        MPI_Group_free(&sgroup);
+
+        // Clear neighbor info from any previous layout.
+        fill(_mpiInfo->my_neighbors.begin(), _mpiInfo->my_neighbors.end(), MPI_PROC_NULL);
+        fill(_mpiInfo->man_dists.begin(), _mpiInfo->man_dists.end(), 0);
+        fill(_mpiInfo->has_all_vlen_mults.begin(), _mpiInfo->has_all_vlen_mults.end(), false);
+        fill(_mpiInfo->shm_ranks.begin(), _mpiInfo->shm_ranks.end(), MPI_PROC_NULL);
 
         // Loop over all ranks, including myself.
         for (int rn = 0; rn < _env->num_ranks; rn++) {
 
-            // Coord offset of rn from me: prev => negative, self => 0, next => positive.
-            IdxTuple rcoords(_dims->_domain_dims);
-            IdxTuple rdeltas(_dims->_domain_dims);
-            for (int di = 0; di < num_ddims; di++) {
-                rcoords[di] = coords[rn][di];
-                rdeltas[di] = coords[rn][di] - _opts->_rank_indices[di];
-            }
-        
             // Manhattan distance from rn (sum of abs deltas in all dims).
             // Max distance in any dim.
+            // Number of dims in which rn is not at my rank index.
             int mandist = 0;
             int maxdist = 0;
+            int ndiffs = 0;
             for (int di = 0; di < num_ddims; di++) {
-                mandist += abs(rdeltas[di]);
-                maxdist = max(maxdist, abs(int(rdeltas[di])));
+                int delta = abs(int(coords(rn, di) - coords(me, di)));
+                mandist += delta;
+                maxdist = max(maxdist, delta);
+                if (delta)
+                    ndiffs++;
             }
             
             // Myself.
@@ -121,6 +310,20 @@ namespace yask {
                                                     " and " << rn << " at same coordinates");
             }
 
+            // Nothing more to do if rn is neither in-line with my rank in
+            // any dim nor an immediate neighbor. This is the case for most
+            // ranks in a large job, so skip them before making tuples.
+            if (ndiffs > 1 && maxdist > 1)
+                continue;
+
+            // Coord offset of rn from me: prev => negative, self => 0, next => positive.
+            IdxTuple rcoords(_dims->_domain_dims);
+            IdxTuple rdeltas(_dims->_domain_dims);
+            for (int di = 0; di < num_ddims; di++) {
+                rcoords[di] = coords(rn, di);
+                rdeltas[di] = coords(rn, di) - _opts->_rank_indices[di];
+            }
+
             // Loop through domain dims.
             for (int di = 0; di < num_ddims; di++) {
                 auto& dname = _opts->_rank_indices.getDimName(di);
@@ -141,24 +344,24 @@ namespace yask {
                     // Accumulate total problem size in each dim for ranks that
                     // intersect with this rank, not including myself.
                     if (rn != me)
-                        overall_domain_sizes[dname] += rsizes[rn][di];
+                        overall_domain_sizes[dname] += rsizes(rn, di);
 
                     // Adjust my offset in the global problem by adding all domain
                     // sizes from prev ranks only.
                     if (rdeltas[di] < 0)
-                        rank_domain_offsets[dname] += rsizes[rn][di];
+                        rank_domain_offsets[dname] += rsizes(rn, di);
 
                     // Make sure all the other dims are the same size.
                     // This ensures that all the ranks' domains line up
                     // properly along their edges and at their corners.
                     for (int dj = 0; dj < num_ddims; dj++) {
                         if (di != dj) {
-                            auto mysz = rsizes[me][dj];
-                            auto rnsz = rsizes[rn][dj];
+                            auto mysz = rsizes(me, dj);
+                            auto rnsz = rsizes(rn, dj);
                             if (mysz != rnsz) {
                                 auto& dnamej = _opts->_rank_indices.getDimName(dj);
                                 FORMAT_AND_THROW_YASK_EXCEPTION("Error: rank " << rn << " and " << me <<
-                                                                " are both at rank-index " << coords[me][di] <<
+                                                                " are both at rank-index " << coords(me, di) <<
                                                                 " in the '" << dname <<
                                                                 "' dimension , but their rank-domain sizes are " <<
                                                                 rnsz << " and " << mysz <<
@@ -205,13 +408,17 @@ namespace yask {
                 // Save manhattan dist.
                 _mpiInfo->man_dists.at(rn_ofs) = mandist;
 
+                // Save shm rank if on same node.
+                _mpiInfo->shm_ranks.at(rn_ofs) =
+                    (shm_ranks[rn] == MPI_UNDEFINED) ? MPI_PROC_NULL : shm_ranks[rn];
+
                 // Loop through domain dims.
                 bool vlen_mults = true;
                 for (int di = 0; di < num_ddims; di++) {
                     auto& dname = _opts->_rank_indices.getDimName(di);
 
                     // Does rn have all VLEN-multiple sizes?
-                    auto rnsz = rsizes[rn][di];
+                    auto rnsz = rsizes(rn, di);
                     auto vlen = _dims->_fold_pts[di];
                     if (rnsz % vlen != 0) {
                         TRACE_MSG("cannot use vector halo exchange with rank " << rn <<
@@ -227,16 +434,7 @@ namespace yask {
             
         } // ranks.
 #endif
-
-        // Set offsets in grids and find WF extensions
-        // based on the grids' halos.
-        update_grid_info();
-
-        // Determine bounding-boxes for all bundles.
-        // This must be done after finding WF extensions.
-        find_bounding_boxes();
-
-    } // setupRank.
+    }
 
     // Alloc 'nbytes' on each requested NUMA node.
     // Map keys are preferred NUMA nodes or -1 for local.
@@ -245,8 +443,20 @@ namespace yask {
     void StencilContext::_alloc_data(const map <int, size_t>& nbytes,
                                      const map <int, size_t>& ngrids,
                                      map <int, shared_ptr<char>>& data_buf,
-                                     const std::string& type) {
+                                     const std::string& type,
+                                     bool mpi_mem,
+                                     bool ooc) {
         ostream& os = get_ostr();
+        ooc = ooc && _opts->_ooc_dir.length();
+
+        // Forget files of grids that have been released.
+        if (ooc) {
+            _ooc_pending.clear();
+            _ooc_begin = idx_max;
+            _ooc_maps.erase(remove_if(_ooc_maps.begin(), _ooc_maps.end(),
+                                      [](const OocMap& m) { return m.base.expired(); }),
+                            _ooc_maps.end());
+        }
 
         for (const auto& i : nbytes) {
             int numa_pref = i.first;
@@ -260,14 +470,31 @@ namespace yask {
             // Allocate data.
             os << "Allocating " << makeByteStr(nb) <<
                 " for " << ng << " " << type << "(s)";
+            string fname;
+            if (ooc) {
+                fname = _opts->_ooc_dir + "/yask_" + name + ".r" + to_string(_env->my_rank);
+                if (numa_pref >= 0)
+                    fname += ".n" + to_string(numa_pref);
+                fname += ".grids";
+                os << " in '" << fname << "'";
+            }
+            else if (mpi_mem)
+                os << " using MPI_Alloc_mem()";
 #ifdef USE_NUMA
-            if (numa_pref >= 0)
+            else if (numa_pref >= 0)
                 os << " preferring NUMA node " << numa_pref;
             else
                 os << " using NUMA policy " << numa_pref;
 #endif
             os << "...\n" << flush;
-            auto p = shared_numa_alloc<char>(nb, numa_pref);
+            shared_ptr<char> p;
+            if (ooc) {
+                int fd = -1;
+                p = shared_ptr<char>(fileMapScratch(fname, nb, fd), FileMapDeleter(nb, fd));
+                _ooc_maps.push_back({ p, nb, fd });
+            }
+            else
+                p = _alloc_bytes(nb, numa_pref, mpi_mem);
             TRACE_MSG("Got memory at " << static_cast<void*>(p.get()));
 
             // Save using original key.
@@ -275,6 +502,143 @@ namespace yask {
         }
     }
     
+    // Memory from the pool is returned to it when released instead of
+    // being freed.
+    shared_ptr<char> StencilContext::_alloc_bytes(size_t nbytes, int numa_pref,
+                                                  bool mpi_mem) {
+        if (_opts->_alloc_pool)
+            return pool_alloc(nbytes, numa_pref, _opts->_huge_pages, mpi_mem);
+        if (mpi_mem)
+            return shared_mpi_alloc(nbytes);
+        return shared_numa_alloc<char>(nbytes, numa_pref, _opts->_huge_pages);
+    }
+
+    // Get the strides that may cause aliasing.
+    vector<idx_t> StencilContext::get_alias_strides() const {
+        idx_t l1 = _opts->_l1_set_stride;
+        if (l1 <= 0)
+            l1 = getCacheSetStride(1);
+        idx_t l2 = _opts->_l2_set_stride;
+        if (l2 <= 0)
+            l2 = getCacheSetStride(2);
+        return { 4096, l1, l2 };
+    }
+
+    // Pad each grid that does not yet have storage so that none of its
+    // strides is a multiple of an aliasing stride. Power-of-two sizes
+    // would otherwise map neighboring points in the outer dims to the
+    // same cache sets.
+    void StencilContext::pad_grids(ostream& os) {
+        if (!_opts->_alias_pad)
+            return;
+        auto strides = get_alias_strides();
+        os << "Padding grids to avoid strides that are multiples of " <<
+            makeByteStr(strides[0]) << ", L1 set stride " << makeByteStr(strides[1]) <<
+            ", or L2 set stride " << makeByteStr(strides[2]) << "...\n";
+        for (auto gp : gridPtrs) {
+            if (!gp)
+                continue;
+            idx_t n = gp->pad_for_aliasing(strides);
+            if (n)
+                TRACE_MSG(" grid '" << gp->get_name() << "' padded by " << n << " vector(s)");
+        }
+    }
+
+    // Give the grids in each interleave group without storage the
+    // largest pads of any of them, so they have the same layout.
+    void StencilContext::align_interleaved_grids(ostream& os) {
+        for (auto& grids : interleaveGroups) {
+            bool any_alloc = false;
+            for (auto gp : grids)
+                if (gp->is_storage_allocated())
+                    any_alloc = true;
+            if (any_alloc)
+                continue;
+            auto g0 = grids.front();
+            for (int i = 0; i < g0->get_num_dims(); i++) {
+                auto& dname = g0->get_dim_name(i);
+                if (!_dims->_domain_dims.lookup(dname))
+                    continue;
+                idx_t lp = 0, rp = 0;
+                for (auto gp : grids) {
+                    lp = max(lp, gp->get_left_pad_size(i));
+                    rp = max(rp, gp->get_right_pad_size(i));
+                }
+                for (auto gp : grids) {
+                    gp->set_left_min_pad_size(i, lp);
+                    gp->set_right_min_pad_size(i, rp);
+                }
+            }
+            for (auto gp : grids) {
+                if (!gp->is_storage_layout_identical(g0))
+                    THROW_YASK_EXCEPTION("Error: interleaved grids '" + g0->get_name() +
+                                         "' and '" + gp->get_name() +
+                                         "' do not have the same layout");
+                gp->set_numa_preferred(g0->get_numa_preferred());
+            }
+            TRACE_MSG("align_interleaved_grids: " << grids.size() <<
+                      " grid(s) interleaved with '" << g0->get_name() << "'");
+        }
+    }
+
+    // Choose the NUMA node of each grid that has no explicit preference.
+    // The grids are ranked by the bytes moved per step per byte of
+    // storage, assuming each bundle streams its inputs once and reads
+    // and writes its outputs once per valid point. The densest ones are
+    // put on the fast node until its capacity is used.
+    void StencilContext::place_grids(ostream& os) {
+        int fast_node = _opts->_numa_fast_node;
+        size_t cap = size_t(_opts->_numa_fast_mib) * 1024 * 1024;
+        if (fast_node < 0 || cap == 0)
+            return;
+
+        // Elements moved per step.
+        map<YkGridPtr, double> traffic;
+        for (auto* sb : stBundles) {
+            if (sb->is_scratch())
+                continue;
+            double npts = double(sb->bb_num_points);
+            for (auto gp : sb->inputGridPtrs)
+                traffic[gp] += npts;
+            for (auto gp : sb->outputGridPtrs)
+                traffic[gp] += 2. * npts;
+        }
+
+        struct GridCand {
+            YkGridPtr gp;
+            size_t nbytes;
+            double density;
+        };
+        vector<GridCand> cands;
+        for (auto gp : gridPtrs) {
+            if (!gp || gp->is_storage_allocated() || gp->is_numa_preferred_set())
+                continue;
+            size_t nbytes = gp->get_num_storage_bytes();
+            if (nbytes)
+                cands.push_back({ gp, nbytes,
+                            traffic[gp] * get_element_bytes() / nbytes });
+        }
+        stable_sort(cands.begin(), cands.end(),
+                    [](const GridCand& a, const GridCand& b) {
+                        return a.density > b.density;
+                    });
+
+        os << "\nPlacing grids on NUMA node " << fast_node <<
+            " with capacity " << makeByteStr(cap) << ":\n";
+        size_t used = 0;
+        for (auto& c : cands) {
+            bool fits = c.density > 0. && used + c.nbytes <= cap;
+            if (fits && c.gp->set_numa_preferred(fast_node))
+                used += c.nbytes;
+            else
+                fits = false;
+            os << " grid '" << c.gp->get_name() << "': " << makeByteStr(c.nbytes) <<
+                ", " << c.density << " byte(s) moved per byte per step => " <<
+                (fits ? "fast node" : "default node") << endl;
+        }
+        os << " total on NUMA node " << fast_node << ": " << makeByteStr(used) << endl;
+    }
+
     // Allocate memory for grids that do not already have storage.
     void StencilContext::allocGridData(ostream& os) {
 
@@ -285,6 +649,54 @@ namespace yask {
         // Key is preferred numa node or -1 for local.
         map <int, shared_ptr<char>> _grid_data_buf;
 
+        // Grids given storage here.
+        GridPtrs new_grids;
+
+        // Grids in each interleave group are allocated with the first one.
+        // All or none of them must already have interleaved storage.
+        map<YkGridPtr, const GridPtrs*> group_leaders;
+        set<YkGridPtr> group_members;
+        for (auto& grids : interleaveGroups) {
+            idx_t ng = grids.size();
+            idx_t nalloc = 0;
+            for (auto gp : grids) {
+                if (gp->is_storage_allocated() && gp->get_interleave() == ng)
+                    nalloc++;
+                else if (gp->is_storage_allocated() || gp->get_storage_file().length())
+                    THROW_YASK_EXCEPTION("Error: grid '" + gp->get_name() +
+                                         "' must be stored interleaved with " +
+                                         to_string(ng - 1) + " other grid(s), "
+                                         "so its storage cannot be set separately");
+            }
+            if (nalloc && nalloc < ng)
+                THROW_YASK_EXCEPTION("Error: only " + to_string(nalloc) + " of the " +
+                                     to_string(ng) + " grids interleaved with '" +
+                                     grids.front()->get_name() + "' have storage");
+            if (!nalloc) {
+                group_leaders[grids.front()] = &grids;
+                group_members.insert(grids.begin() + 1, grids.end());
+            }
+        }
+
+        // Offset the grids on each node from each other by a fraction of
+        // the largest aliasing stride, so that the grids used together in
+        // a bundle start in different cache sets.
+        idx_t alias_bytes = 0, alias_step = 0;
+        if (_opts->_alias_pad) {
+            auto strides = get_alias_strides();
+            alias_bytes = *max_element(strides.begin(), strides.end());
+            size_t ntogether = 1;
+            for (auto* sb : stBundles) {
+                set<YkGridPtr> sgrids(sb->inputGridPtrs.begin(), sb->inputGridPtrs.end());
+                sgrids.insert(sb->outputGridPtrs.begin(), sb->outputGridPtrs.end());
+                ntogether = max(ntogether, sgrids.size());
+            }
+            alias_step = max(idx_t(CACHELINE_BYTES),
+                             ROUND_DOWN(alias_bytes / idx_t(ntogether), CACHELINE_BYTES));
+            TRACE_MSG("allocGridData: offsetting up to " << ntogether << " grid(s) by " <<
+                      makeByteStr(alias_step) << " modulo " << makeByteStr(alias_bytes));
+        }
+
         // Pass 0: count required size for each NUMA node, allocate chunk of memory at end.
         // Pass 1: distribute parts of already-allocated memory chunk.
         for (int pass = 0; pass < 2; pass++) {
@@ -300,21 +712,50 @@ namespace yask {
                     continue;
                 auto& gname = gp->get_name();
 
+                // Map grid data from a file.
+                if (pass == 0 && !gp->is_storage_allocated() &&
+                    gp->get_storage_file().length()) {
+                    gp->alloc_storage();
+                    os << gp->make_info_string() << endl;
+                }
+
                 // Grid data.
-                // Don't alloc if already done.
-                if (!gp->is_storage_allocated()) {
+                // Don't alloc if already done or if done with the
+                // first grid in its interleave group.
+                if (!gp->is_storage_allocated() && !group_members.count(gp)) {
                     int numa_pref = gp->get_numa_preferred();
 
+                    // Move to the next staggered base.
+                    if (alias_bytes > 0) {
+                        idx_t tgt = (idx_t(ngrids[numa_pref]) * alias_step) % alias_bytes;
+                        idx_t cur = idx_t(npbytes[numa_pref]) % alias_bytes;
+                        npbytes[numa_pref] += (tgt - cur + alias_bytes) % alias_bytes;
+                    }
+
+                    // Interleaved grids use consecutive vectors.
+                    GridPtrs grids(1, gp);
+                    if (group_leaders.count(gp))
+                        grids = *group_leaders.at(gp);
+                    idx_t ng = grids.size();
+
                     // Set storage if buffer has been allocated in pass 0.
                     if (pass == 1) {
                         auto p = _grid_data_buf[numa_pref];
                         assert(p);
-                        gp->set_storage(p, npbytes[numa_pref]);
-                        os << gp->make_info_string() << endl;
+                        for (idx_t g = 0; g < ng; g++) {
+                            auto& igp = grids[g];
+                            if (ng > 1)
+                                igp->set_interleaved_storage(p, npbytes[numa_pref] +
+                                                             g * gp->get_storage_elem_bytes(), ng);
+                            else
+                                igp->set_storage(p, npbytes[numa_pref]);
+                            os << igp->make_info_string() << endl;
+                            new_grids.push_back(igp);
+                        }
                     }
 
                     // Determine padded size (also offset to next location).
-                    size_t nbytes = gp->get_num_storage_bytes();
+                    size_t nbytes = gp->get_num_storage_bytes() * ng;
                     npbytes[numa_pref] += ROUND_UP(nbytes + _data_buf_pad,
                                                   CACHELINE_BYTES);
                     ngrids[numa_pref]++;
@@ -326,10 +767,91 @@ namespace yask {
 
             // Alloc for each node.
             if (pass == 0)
-                _alloc_data(npbytes, ngrids, _grid_data_buf, "grid");
+                _alloc_data(npbytes, ngrids, _grid_data_buf, "grid", false, true);
 
         } // grid passes.
+
+        if (_opts->_first_touch && new_grids.size()) {
+            os << "Initializing " << new_grids.size() << " grid(s) in block order...\n" << flush;
+            first_touch_grids(new_grids);
+        }
     };
+
+    // Touch the new grids one region at a time, assigning blocks to
+    // threads through the same generated loops that call calc_block().
+    // Blocks on the edges of the rank also cover the halos and pads.
+    void StencilContext::first_touch_grids(GridPtrs& grids) {
+        auto& step_dim = _dims->_step_dim;
+        int nsdims = _dims->_stencil_dims.size();
+        auto step_posn = Indices::step_posn;
+
+        // One step over the rank domain, one region at a time.
+        ScanIndices rank_idxs(*_dims, true, &rank_domain_offsets);
+        for (int i = 0; i < nsdims; i++) {
+            auto& dname = _dims->_stencil_dims.getDimName(i);
+            if (i == step_posn) {
+                rank_idxs.begin[i] = 0;
+                rank_idxs.end[i] = 1;
+                rank_idxs.step[i] = 1;
+            } else {
+                rank_idxs.begin[i] = rank_bb.bb_begin[dname];
+                rank_idxs.end[i] = rank_bb.bb_end[dname];
+                rank_idxs.step[i] = _opts->_region_sizes[dname];
+            }
+        }
+        rank_idxs.start[step_posn] = 0;
+        rank_idxs.stop[step_posn] = 1;
+        set_region_threads();
+
+        // Write zero to the part of each grid in the block.
+        auto calc_block = [&](BundlePackPtr& bp, const ScanIndices& block_idxs) {
+            for (auto gp : grids) {
+                int ngdims = gp->get_num_dims();
+                Indices first(ngdims), last(ngdims);
+                bool ok = true;
+                for (int j = 0; j < ngdims; j++) {
+                    auto& dname = gp->get_dim_name(j);
+                    if (dname == step_dim) {
+                        first[j] = 0;
+                        last[j] = gp->get_alloc_size(dname) - 1;
+                    }
+                    else if (_dims->_domain_dims.lookup(dname)) {
+                        int i = _dims->_stencil_dims.lookup_posn(dname);
+                        first[j] = (block_idxs.start[i] <= rank_bb.bb_begin[dname]) ?
+                            gp->get_first_rank_alloc_index(dname) : block_idxs.start[i];
+                        last[j] = (block_idxs.stop[i] >= rank_bb.bb_end[dname]) ?
+                            gp->get_last_rank_alloc_index(dname) : block_idxs.stop[i] - 1;
+                        if (last[j] < first[j])
+                            ok = false;
+                    }
+                    else {
+                        first[j] = gp->get_first_misc_index(dname);
+                        last[j] = gp->get_last_misc_index(dname);
+                    }
+                }
+                if (ok)
+                    gp->touch_elements_in_slice(0.0, first, last);
+            }
+        };
+
+        // Visit the blocks in each region.
+        auto calc_region = [&](BundlePackPtr& bp, const ScanIndices& rank_idxs) {
+            ScanIndices region_idxs(*_dims, true, &rank_domain_offsets);
+            region_idxs.initFromOuter(rank_idxs);
+            region_idxs.step = _opts->_block_sizes;
+            region_idxs.group_size = _opts->_block_group_sizes;
+#include "yask_region_loops.hpp"
+        };
+
+        BundlePackPtr bp;
+        if (_opts->_numa_parts > 1)
+            run_numa_parts(rank_idxs, [&](ScanIndices& rank_idxs) {
+#include "yask_rank_loops.hpp"
+                });
+        else {
+#include "yask_rank_loops.hpp"
+        }
+    }
     
     // Create MPI buffers and allocate them.
     void StencilContext::allocMpiData(ostream& os) {
@@ -380,6 +902,10 @@ namespace yask {
                 bool vec_ok = allow_vec_exchange &&
                     _mpiInfo->has_all_vlen_mults[_mpiInfo->my_neighbor_index] &&
                     _mpiInfo->has_all_vlen_mults[neigh_idx];
+
+                // Can data be exchanged via a shm window?
+                bool shm_ok = _opts->use_shm && !_opts->neighbor_halos &&
+                    _mpiInfo->shm_ranks[neigh_idx] != MPI_PROC_NULL;
                 
                 // Determine size of MPI buffers between neigh_rank and my
                 // rank for each grid and create those that are needed.  It
@@ -396,6 +922,15 @@ namespace yask {
                     auto& gname = gp->get_name();
                     bool grid_vec_ok = vec_ok;
 
+                    // Number of steps to hold in each buffer.  With WFs,
+                    // up to one step per region step can be dirty, but no
+                    // more than the number of steps allocated.
+                    idx_t max_steps = 1;
+                    if (gp->is_dim_used(step_dim) &&
+                        _opts->is_time_tiling() && _opts->multi_step_halos)
+                        max_steps = min(_opts->_region_sizes[step_dim],
+                                        gp->get_alloc_size(step_dim));
+
                     // Lookup first & last domain indices and calc exchange sizes
                     // for this grid.
                     bool found_delta = false;
@@ -631,15 +1166,15 @@ namespace yask {
                             }
 
                             // step dim?
-                            // Allowing only one step to be exchanged.
-                            // TODO: consider exchanging mutiple steps at once for WFs.
+                            // Allow up to 'max_steps' to be exchanged.
                             else if (dname == step_dim) {
+                                dsize = max_steps;
 
-                                // Use 0..1 as a place-holder range.
+                                // Use 0..max_steps as a place-holder range.
                                 // The actual values will be supplied during
                                 // halo exchange.
                                 copy_begin[dname] = 0;
-                                copy_end[dname] = 1;
+                                copy_end[dname] = max_steps;
                             }
 
                             // misc?
@@ -682,14 +1217,17 @@ namespace yask {
                         auto& gbi = gbp.first; // iterator from pair returned by emplace().
                         auto& gbv = gbi->second; // value from iterator.
                         auto& buf = gbv.getBuf(MPIBufs::BufDir(bd), neigh_offsets);
+                        gbv.max_steps = max_steps;
 
                         // Config buffer for this grid.
                         // (But don't allocate storage yet.)
                         buf.begin_pt = copy_begin;
                         buf.last_pt = copy_last;
                         buf.num_pts = buf_sizes;
+                        buf.max_steps = max_steps;
                         buf.name = bufname;
                         buf.vec_copy_ok = buf_vec_ok;
+                        buf.via_shm = shm_ok;
                         
                         TRACE_MSG("MPI buffer '" << buf.name <<
                                   "' configured for rank at relative offsets " <<
@@ -710,25 +1248,162 @@ namespace yask {
         TRACE_MSG("number of MPI recv buffers on this rank: " << num_exchanges[int(MPIBufs::bufRecv)]);
         TRACE_MSG("number of elements in recv buffers: " << makeNumStr(num_elems[int(MPIBufs::bufRecv)]));
 
+        // Configure aggregated buffers if requested.  Each one holds the
+        // data for all grids for one neighbor, with each grid's segment
+        // starting on a cache-line boundary.  The per-grid buffers are
+        // then used only to describe the segments and get no storage.
+        if ((_opts->aggregate_halos || _opts->neighbor_halos) && mpiData.size()) {
+            aggMpiData = make_shared<MPIData>(_mpiInfo);
+            aggMpiData->visitNeighbors
+                ([&](const IdxTuple& roffsets,
+                     int rank,
+                     int ni,
+                     MPIBufs& bufs) {
+                    for (int bd = 0; bd < MPIBufs::nBufDirs; bd++) {
+                        size_t nbytes = 0;
+                        for (auto& gmd : mpiData) {
+                            auto& gbuf = gmd.second.bufs[ni].bufs[bd];
+                            if (gbuf.get_size())
+                                nbytes += ROUND_UP(gbuf.get_bytes(), CACHELINE_BYTES);
+                        }
+                        if (nbytes == 0)
+                            continue;
+                        auto& buf = bufs.bufs[bd];
+                        ostringstream oss;
+                        if (bd == MPIBufs::bufSend)
+                            oss << "aggregate_send_halo_from_" << me << "_to_" << rank;
+                        else
+                            oss << "aggregate_recv_halo_from_" << rank << "_to_" << me;
+                        buf.name = oss.str();
+                        buf.num_pts.addDimBack("elems", nbytes / sizeof(real_t));
+                        buf.via_shm = _opts->use_shm && !_opts->neighbor_halos &&
+                            _mpiInfo->shm_ranks[ni] != MPI_PROC_NULL;
+                        TRACE_MSG("MPI buffer '" << buf.name << "' configured with " <<
+                                  makeByteStr(nbytes));
+                    }
+                });
+        }
+
+        // Use the position of each grid in the list as its tag so that
+        // messages can be matched by persistent requests regardless of
+        // which grids are exchanged together. Tag 0 is used for
+        // aggregated messages.
+        for (size_t gi = 0; gi < gridPtrs.size(); gi++) {
+            auto gp = gridPtrs[gi];
+            if (gp && mpiData.count(gp->get_name()))
+                mpiData.at(gp->get_name()).tag = int(gi) + 1;
+        }
+
+        // Make a graph communicator connecting this rank to each neighbor
+        // that it exchanges data with. Buffer sizes are symmetric, so
+        // the neighbor lists are the same on both ends. This is
+        // collective, so it is done even if this rank has no buffers.
+        if (_opts->neighbor_halos) {
+            vector<int> nranks;
+            if (aggMpiData)
+                aggMpiData->visitNeighbors
+                    ([&](const IdxTuple& roffsets,
+                         int rank,
+                         int ni,
+                         MPIBufs& bufs) {
+                        if (bufs.bufs[MPIBufs::bufSend].get_size() ||
+                            bufs.bufs[MPIBufs::bufRecv].get_size()) {
+                            halo_nbr_idxs.push_back(ni);
+                            nranks.push_back(rank);
+                        }
+                    });
+            int nn = int(nranks.size());
+            MPI_Dist_graph_create_adjacent(_env->comm,
+                                           nn, nranks.data(), MPI_UNWEIGHTED,
+                                           nn, nranks.data(), MPI_UNWEIGHTED,
+                                           MPI_INFO_NULL, 0, &halo_nbr_comm);
+            halo_nbr_scounts.assign(nn, 0);
+            halo_nbr_rcounts.assign(nn, 0);
+            halo_nbr_sdispls.assign(nn, 0);
+            halo_nbr_rdispls.assign(nn, 0);
+            halo_nbr_types.assign(nn, MPI_BYTE);
+            TRACE_MSG("halo exchange will use a neighborhood collective with " <<
+                      nn << " neighbor(s)");
+        }
+
         // Base ptrs for all alloc'd data.
         // These pointers will be shared by the ones in the grid
         // objects, which will take over ownership when these go
         // out of scope.
         map <int, shared_ptr<char>> _mpi_data_buf;
 
+        // Base of this rank's part of the shm window.
+        // The memory is owned by the window, not by the pointers.
+        shared_ptr<char> shm_base;
+        char* shm_raw = 0; // start of this rank's part before alignment.
+        bool do_shm = _opts->use_shm && !_opts->neighbor_halos &&
+            _env->num_shm_ranks > 1;
+
         // Allocate MPI buffers.
         // Pass 0: count required size, allocate chunk of memory at end.
         // Pass 1: distribute parts of already-allocated memory chunk.
         for (int pass = 0; pass < 2; pass++) {
             TRACE_MSG("allocMpiData pass " << pass << " for " <<
-                      mpiData.size() << " MPI buffer set(s)");
+                      mpiData.size() << " MPI buffer set(s)" <<
+                      (aggMpiData ? " in aggregated buffers" : ""));
         
             // Count bytes needed and number of buffers for each NUMA node.
             map <int, size_t> npbytes, nbufs;
+            size_t shm_nbytes = 0;
+
+            // Visit each buffer that needs storage.
+            auto alloc_buf = [&](MPIBuf& buf, int bd, int numa_pref) {
+                if (buf.get_size() == 0)
+                    return;
+
+                // Send bufs shared with a neighbor on this node are
+                // in the shm window. Recv bufs from such a neighbor
+                // need no storage; they are set after allocation.
+                if (buf.via_shm) {
+                    if (bd == MPIBufs::bufRecv)
+                        return;
+                    if (pass == 1)
+                        buf.set_storage(shm_base, shm_nbytes);
+                    shm_nbytes += ROUND_UP(buf.get_bytes(), CACHELINE_BYTES);
+                    if (pass == 0)
+                        TRACE_MSG("  MPI buf '" << buf.name << "' needs " <<
+                                  makeByteStr(buf.get_bytes()) << " in shm");
+                    return;
+                }
+                                
+                // Set storage if buffer has been allocated in pass 0.
+                if (pass == 1) {
+                    auto p = _mpi_data_buf[numa_pref];
+                    assert(p);
+                    buf.set_storage(p, npbytes[numa_pref]);
+                }
+
+                // Determine padded size (also offset to next location).
+                auto sbytes = buf.get_bytes();
+                npbytes[numa_pref] += ROUND_UP(sbytes + _data_buf_pad,
+                                               CACHELINE_BYTES);
+                nbufs[numa_pref]++;
+                if (pass == 0)
+                    TRACE_MSG("  MPI buf '" << buf.name << "' needs " <<
+                              makeByteStr(sbytes) <<
+                              " on NUMA node " << numa_pref);
+            };
+
+            // Aggregated bufs.
+            if (aggMpiData) {
+                aggMpiData->visitNeighbors
+                    ([&](const IdxTuple& roffsets,
+                         int rank,
+                         int idx,
+                         MPIBufs& bufs) {
+                        for (int bd = 0; bd < MPIBufs::nBufDirs; bd++)
+                            alloc_buf(bufs.bufs[bd], bd, _opts->_numa_pref);
+                    } );
+            }
         
             // Grids.
             for (auto gp : gridPtrs) {
-                if (!gp)
+                if (!gp || aggMpiData)
                     continue;
                 auto& gname = gp->get_name();
                 int numa_pref = gp->get_numa_preferred();
@@ -745,53 +1420,156 @@ namespace yask {
                              MPIBufs& bufs) {
 
                             // Send and recv.
-                            for (int bd = 0; bd < MPIBufs::nBufDirs; bd++) {
-                                auto& buf = grid_mpi_data.getBuf(MPIBufs::BufDir(bd), roffsets);
-                                if (buf.get_size() == 0)
-                                    continue;
-                                
-                                // Set storage if buffer has been allocated in pass 0.
-                                if (pass == 1) {
-                                    auto p = _mpi_data_buf[numa_pref];
-                                    assert(p);
-                                    buf.set_storage(p, npbytes[numa_pref]);
-                                }
-
-                                // Determine padded size (also offset to next location).
-                                auto sbytes = buf.get_bytes();
-                                npbytes[numa_pref] += ROUND_UP(sbytes + _data_buf_pad,
-                                                               CACHELINE_BYTES);
-                                nbufs[numa_pref]++;
-                                if (pass == 0)
-                                    TRACE_MSG("  MPI buf '" << buf.name << "' needs " <<
-                                              makeByteStr(sbytes) <<
-                                              " on NUMA node " << numa_pref);
-                            }
+                            for (int bd = 0; bd < MPIBufs::nBufDirs; bd++)
+                                alloc_buf(bufs.bufs[bd], bd, numa_pref);
                         } );
                 }
             }
 
             // Alloc for each node.
-            if (pass == 0)
-                _alloc_data(npbytes, nbufs, _mpi_data_buf, "MPI buffer");
+            if (pass == 0) {
+                _alloc_data(npbytes, nbufs, _mpi_data_buf, "MPI buffer",
+                            _opts->_mpi_alloc_mem);
+
+                // Alloc shm window. This is collective over the ranks on
+                // this node, so it is done even if no bufs are needed.
+                // Each rank's part is not necessarily aligned, so allocate
+                // an extra cache line and align the base.
+                if (do_shm) {
+                    MPI_Info info;
+                    MPI_Info_create(&info);
+                    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+                    MPI_Win_allocate_shared(shm_nbytes + CACHELINE_BYTES, 1, info,
+                                            _env->shm_comm, &shm_raw, &halo_shm_win);
+                    MPI_Info_free(&info);
+                    MPI_Win_lock_all(MPI_MODE_NOCHECK, halo_shm_win);
+                    char* p = shm_raw;
+                    p += (CACHELINE_BYTES - size_t(p) % CACHELINE_BYTES) % CACHELINE_BYTES;
+                    shm_base = shared_ptr<char>(p, [](char*) { });
+                    os << "Shared-memory MPI buffer window allocated with " <<
+                        makeByteStr(shm_nbytes) << ".\n";
+                }
+            }
 
         } // MPI passes.
+
+        // Point recv bufs at the matching send bufs in the windows of
+        // neighbors on this node. Each rank sends the window offset of
+        // each of its send bufs to the neighbor, indexed by grid
+        // position, with the aggregated buf last.
+        if (do_shm) {
+            size_t ng = gridPtrs.size();
+            for (auto& gmd : mpiData)
+                gmd.second.shm_win = halo_shm_win;
+            if (aggMpiData)
+                aggMpiData->shm_win = halo_shm_win;
+
+            _mpiInfo->visitNeighbors
+                ([&](const IdxTuple& neigh_offsets, int neigh_rank, int ni) {
+                    int srank = _mpiInfo->shm_ranks[ni];
+                    if (neigh_rank == MPI_PROC_NULL || srank == MPI_PROC_NULL)
+                        return; // from lambda fn.
+
+                    // My offsets.
+                    vector<long long> sofs(ng + 1, -1), rofs(ng + 1, -1);
+                    for (size_t gi = 0; gi <= ng; gi++) {
+                        MPIData* md = 0;
+                        if (gi == ng)
+                            md = aggMpiData.get();
+                        else if (gridPtrs[gi] && !aggMpiData &&
+                                 mpiData.count(gridPtrs[gi]->get_name()))
+                            md = &mpiData.at(gridPtrs[gi]->get_name());
+                        if (!md)
+                            continue;
+                        auto& sbuf = md->bufs[ni].bufs[MPIBufs::bufSend];
+                        if (sbuf.via_shm && sbuf.get_size())
+                            sofs[gi] = (char*)sbuf._elems - shm_raw;
+                    }
+
+                    // Swap with neighbor.
+                    MPI_Sendrecv(sofs.data(), int(ng + 1), MPI_LONG_LONG, neigh_rank, 0,
+                                 rofs.data(), int(ng + 1), MPI_LONG_LONG, neigh_rank, 0,
+                                 _env->comm, MPI_STATUS_IGNORE);
+
+                    // Neighbor's part of the window.
+                    MPI_Aint nsize = 0;
+                    int disp_unit = 0;
+                    char* nbase = 0;
+                    MPI_Win_shared_query(halo_shm_win, srank, &nsize, &disp_unit, &nbase);
+
+                    // Set my recv bufs.
+                    for (size_t gi = 0; gi <= ng; gi++) {
+                        MPIData* md = 0;
+                        if (gi == ng)
+                            md = aggMpiData.get();
+                        else if (gridPtrs[gi] && !aggMpiData &&
+                                 mpiData.count(gridPtrs[gi]->get_name()))
+                            md = &mpiData.at(gridPtrs[gi]->get_name());
+                        if (!md)
+                            continue;
+                        auto& rbuf = md->bufs[ni].bufs[MPIBufs::bufRecv];
+                        if (!rbuf.via_shm || !rbuf.get_size())
+                            continue;
+                        if (rofs[gi] < 0)
+                            THROW_YASK_EXCEPTION("Error: no shared-memory send buffer found on rank " +
+                                                 to_string(neigh_rank) + " for '" + rbuf.name + "'");
+                        rbuf._elems = (real_t*)(nbase + rofs[gi]);
+                        TRACE_MSG("MPI buffer '" << rbuf.name << "' mapped to shm of rank " <<
+                                  neigh_rank << " at offset " << rofs[gi]);
+                    }
+                });
+        }
+
+        // Find which halo faces each bundle writes.
+        find_dirty_faces();
+#endif
+    }
+
+    // Release MPI buffers and requests.
+    void StencilContext::freeMpiData(ostream& os) {
+        complete_halo_exchange();
+
+#ifdef USE_MPI
+        for (auto& gmd : mpiData)
+            gmd.second.free_persistent_reqs();
+        if (aggMpiData)
+            aggMpiData->free_persistent_reqs();
+        if (halo_nbr_comm != MPI_COMM_NULL)
+            MPI_Comm_free(&halo_nbr_comm);
+        halo_nbr_idxs.clear();
+
+        // Wait for neighbors to finish reading this rank's shm bufs,
+        // then release the window. Freeing is collective on the node.
+        for (auto& gmd : mpiData)
+            MPI_Waitall(int(gmd.second.shm_done_reqs.size()),
+                        gmd.second.shm_done_reqs.data(), MPI_STATUSES_IGNORE);
+        if (aggMpiData)
+            MPI_Waitall(int(aggMpiData->shm_done_reqs.size()),
+                        aggMpiData->shm_done_reqs.data(), MPI_STATUSES_IGNORE);
+        if (halo_shm_win != MPI_WIN_NULL) {
+            MPI_Win_unlock_all(halo_shm_win);
+            MPI_Win_free(&halo_shm_win);
+        }
 #endif
+        mpiData.clear();
+        aggMpiData.reset();
+
+        // Stop tracking faces of the old buffers.
+        for (auto gp : gridPtrs)
+            if (gp)
+                gp->set_num_dirty_faces(0);
+        for (auto* sg : stBundles)
+            sg->outputGridFaces.clear();
     }
 
     // Allocate memory for scratch grids based on number of threads and
     // block sizes.
     void StencilContext::allocScratchData(ostream& os) {
 
-        // Remove any old scratch data.
+        // Remove any old scratch grids. Their memory is kept in
+        // '_scratch_arenas' for reuse.
         freeScratchData(os);
 
-        // Base ptrs for all alloc'd data.
-        // This pointer will be shared by the ones in the grid
-        // objects, which will take over ownership when it goes
-        // out of scope.
-        map <int, shared_ptr<char>> _scratch_data_buf;
-
         // Make sure the right number of threads are set so we
         // have the right number of scratch grids.
         int rthreads = set_region_threads();
@@ -800,14 +1578,14 @@ namespace yask {
         // Create new scratch grids.
         makeScratchGrids(rthreads);
         
-        // Pass 0: count required size, allocate chunk of memory at end.
-        // Pass 1: distribute parts of already-allocated memory chunk.
+        // Pass 0: count required size for each thread, grow arenas at end.
+        // Pass 1: distribute parts of each thread's arena.
+        vector<size_t> tbytes(rthreads);
+        vector<int> tprefs(rthreads, _opts->_numa_pref);
         for (int pass = 0; pass < 2; pass++) {
             TRACE_MSG("allocScratchData pass " << pass << " for " <<
                       scratchVecs.size() << " set(s) of scratch grids");
-        
-            // Count bytes needed and number of grids for each NUMA node.
-            map <int, size_t> npbytes, ngrids;
+            tbytes.assign(rthreads, 0);
 
             // Loop through each scratch grid vector.
             for (auto* sgv : scratchVecs) {
@@ -820,7 +1598,7 @@ namespace yask {
                 for (auto gp : *sgv) {
                     assert(gp);
                     auto& gname = gp->get_name();
-                    int numa_pref = gp->get_numa_preferred();
+                    tprefs[thr_num] = gp->get_numa_preferred();
             
                     // Loop through each domain dim.
                     for (auto& dim : _dims->_domain_dims.getDims()) {
@@ -841,34 +1619,86 @@ namespace yask {
                         }
                     } // dims.
                 
-                    // Set storage if buffer has been allocated.
+                    // Set storage in this thread's arena.
                     if (pass == 1) {
-                        auto p = _scratch_data_buf[numa_pref];
+                        auto p = _scratch_arenas.at(thr_num);
                         assert(p);
-                        gp->set_storage(p, npbytes[numa_pref]);
+                        gp->set_storage(p, tbytes[thr_num]);
                         TRACE_MSG(gp->make_info_string());
                     }
 
                     // Determine size used (also offset to next location).
                     size_t nbytes = gp->get_num_storage_bytes();
-                    npbytes[numa_pref] += ROUND_UP(nbytes + _data_buf_pad,
-                                                   CACHELINE_BYTES);
-                    ngrids[numa_pref]++;
+                    tbytes[thr_num] += ROUND_UP(nbytes + _data_buf_pad,
+                                                CACHELINE_BYTES);
                     if (pass == 0)
                         TRACE_MSG(" scratch grid '" << gname << "' for thread " <<
                                   thr_num << " needs " << makeByteStr(nbytes) <<
-                                  " on NUMA node " << numa_pref);
+                                  " on NUMA node " << tprefs[thr_num]);
                     thr_num++;
                 } // scratch grids.
             } // scratch-grid vecs.
 
-            // Alloc for each node.
+            // Grow the arenas that are too small for the new grids.
             if (pass == 0)
-                _alloc_data(npbytes, ngrids, _scratch_data_buf, "scratch grid");
+                grow_scratch_arenas(os, tbytes, tprefs);
 
         } // scratch-grid passes.
     }
 
+    // Make sure each thread's scratch arena has at least 'tbytes' bytes.
+    // Arenas only grow, so the auto-tuner and repeated setups reuse them.
+    // Each new arena is allocated and touched by the region thread that
+    // will use it, with the same binding as the region loops, so that its
+    // pages are on the thread's NUMA node.
+    void StencilContext::grow_scratch_arenas(ostream& os,
+                                             const vector<size_t>& tbytes,
+                                             const vector<int>& tprefs) {
+        int rthreads = tbytes.size();
+        _scratch_arenas.resize(max(int(_scratch_arenas.size()), rthreads));
+        _scratch_arena_sizes.resize(_scratch_arenas.size(), 0);
+        size_t nb = 0;
+        int ng = 0;
+        for (int rt = 0; rt < rthreads; rt++)
+            if (tbytes[rt] > _scratch_arena_sizes[rt]) {
+                nb += tbytes[rt];
+                ng++;
+            }
+        if (!ng)
+            return;
+        os << "Allocating " << makeByteStr(nb) <<
+            " for scratch grids of " << ng << " thread(s)...\n" << flush;
+
+        string err;
+#pragma omp parallel proc_bind(spread)
+        {
+            int rt = omp_get_thread_num();
+            if (rt < rthreads && tbytes[rt] > _scratch_arena_sizes[rt]) {
+                try {
+                    _scratch_arenas[rt].reset();
+                    auto p = _alloc_bytes(tbytes[rt], tprefs[rt]);
+                    memset(p.get(), 0, tbytes[rt]);
+                    _scratch_arenas[rt] = p;
+                    _scratch_arena_sizes[rt] = tbytes[rt];
+                    TRACE_MSG("Got " << makeByteStr(tbytes[rt]) << " at " <<
+                              static_cast<void*>(p.get()) << " for thread " << rt);
+                }
+                catch (yask_exception& e) {
+#pragma omp critical
+                    err = e.get_message();
+                }
+            }
+        }
+        if (err.length())
+            THROW_YASK_EXCEPTION(err);
+
+        // In case there were fewer threads than arenas.
+        for (int rt = 0; rt < rthreads; rt++)
+            if (tbytes[rt] > _scratch_arena_sizes[rt])
+                THROW_YASK_EXCEPTION("Internal error: no scratch memory for thread " +
+                                     to_string(rt));
+    }
+
     // Set non-scratch grid sizes and offsets based on settings.
     // Set wave-front settings.
     // This should be called anytime a setting or rank offset is changed.
@@ -879,6 +1709,20 @@ namespace yask {
         // Reset halos to zero.
         max_halos = _dims->_domain_dims;
 
+        // Grids that have storage now. If the new settings change the
+        // allocation of a grid, its storage is released instead of
+        // throwing an exception, so it will be allocated again by
+        // prepare_solution(). Other grids keep their storage and data.
+        set<YkGridBase*> had_storage;
+        for (auto gp : gridPtrs) {
+            assert(gp);
+            if (gp->is_fixed_size())
+                continue;
+            if (gp->is_storage_allocated())
+                had_storage.insert(gp.get());
+            gp->set_release_if_resized(true);
+        }
+
         // Loop through each non-scratch grid.
         for (auto gp : gridPtrs) {
             assert(gp);
@@ -924,7 +1768,9 @@ namespace yask {
             num_wf_shifts = stPacks.size() * wf_steps;
 
             // Don't need to shift first one.
-            num_wf_shifts--;
+            // Packs may not be added yet when called from the ctor.
+            if (num_wf_shifts > 0)
+                num_wf_shifts--;
         }
         for (auto& dim : _dims->_domain_dims.getDims()) {
             auto& dname = dim.getName();
@@ -986,6 +1832,24 @@ namespace yask {
                 }
             }
         }
+
+        // Grids in an interleave group share one allocation, so
+        // they are all allocated again if any one was released.
+        for (auto& igrids : interleaveGroups) {
+            bool released = false;
+            for (auto gp : igrids)
+                if (had_storage.count(gp.get()) && !gp->is_storage_allocated())
+                    released = true;
+            if (released)
+                for (auto gp : igrids)
+                    gp->release_storage();
+        }
+        for (auto gp : gridPtrs) {
+            gp->set_release_if_resized(false);
+            if (had_storage.count(gp.get()) && !gp->is_storage_allocated())
+                get_ostr() << "Storage for grid '" << gp->get_name() <<
+                    "' released because its allocation size changed.\n";
+        }
     }
     
     // Allocate grids and MPI bufs.
@@ -1016,6 +1880,62 @@ namespace yask {
         // reset time keepers.
         clear_timers();
 
+        // Choose the rank layout if needed before using the rank sizes.
+        find_rank_layout();
+
+        // Keep the settings as given in case the rank sizes are balanced
+        // below and the setup is done again.
+        KernelSettings given_opts(*_opts);
+
+        // Grids that already have storage, e.g., from the application.
+        // They would be written while timing steps and could not be
+        // resized, so the rank sizes are not balanced if there are any.
+        idx_t nuser_grids = 0;
+        for (auto gp : gridPtrs)
+            if (gp && (gp->is_storage_allocated() || gp->get_storage_file().length()))
+                nuser_grids++;
+
+        setup_solution();
+
+        // Balance the rank sizes and, if they change, release the
+        // storage allocated above and set up again with the new ones.
+        // The balancing is only done once, so the same sizes are used by
+        // any solution copied from this one.
+        if (_opts->_balance_steps > 0 && _env->num_ranks > 1) {
+            map<string, vector<idx_t>> splits;
+            bool changed = false;
+            if (sumOverRanks(nuser_grids, _env->comm))
+                os << "Note: not balancing rank-domain sizes because some grids "
+                    "already had storage before prepare_solution().\n";
+            else
+                changed = balance_ranks(splits);
+            _opts->_balance_steps = 0;
+            if (changed) {
+                for (auto gp : gridPtrs) {
+                    if (gp)
+                        gp->release_storage();
+                }
+                freeScratchData(os);
+                freeMpiData(os);
+                *_opts = given_opts;
+                for (auto& i : splits)
+                    _opts->_rank_splits[i.first] = i.second;
+                _opts->_balance_steps = 0;
+                os << "\nRepeating setup with balanced rank-domain sizes...\n";
+                setup_solution();
+            }
+        }
+    }
+
+    // Size, allocate, and report everything for the current settings.
+    // Called from prepare_solution() once, or twice if the rank sizes
+    // are balanced.
+    void StencilContext::setup_solution() {
+        ostream& os = get_ostr();
+
+        // Sizes given for each rank index.
+        _opts->applyRankSplits(_env);
+
         // Init auto-tuner to run silently during normal operation.
         _at.clear(false, false);
 
@@ -1042,21 +1962,48 @@ namespace yask {
         // way for top-level OpenMP parallel sections.
         int rthreads = set_region_threads();
 
-        // Run a dummy nested OMP loop to make sure nested threading is
-        // initialized.
+        // Run the region and nested block thread teams once with the
+        // same binding used by the generated region and block loops to
+        // make sure nested threading is initialized, and record the CPU
+        // used by each thread for print_info().
+        _thread_cpus.assign(rthreads, vector<int>());
 #ifdef _OPENMP
-#pragma omp parallel for
-        for (int i = 0; i < rthreads * 100; i++) {
-
-            idx_t dummy = 0;
-            set_block_threads();
-#pragma omp parallel for reduction(+:dummy)
-            for (int j = 0; j < i * 100; j++) {
-                dummy += j;
+#pragma omp parallel proc_bind(spread)
+        {
+            int rt = omp_get_thread_num();
+            int bthreads = set_block_threads();
+            vector<int> cpus(bthreads, -1);
+#pragma omp parallel proc_bind(close)
+            {
+                int bt = omp_get_thread_num();
+                if (bt < bthreads)
+                    cpus[bt] = getCpu();
             }
+            if (rt < rthreads)
+                _thread_cpus[rt] = cpus;
         }
+#else
+        if (rthreads > 0)
+            _thread_cpus[0].push_back(getCpu());
 #endif
 
+        // With SMT sharing, check that each block team is on one core.
+        if (_opts->_smt_share && _opts->num_block_threads > 1) {
+            int nshared = 0;
+            for (auto& cpus : _thread_cpus) {
+                bool same = cpus.size() > 0;
+                for (int cpu : cpus)
+                    if (getCpuCore(cpu) < 0 || getCpuCore(cpu) != getCpuCore(cpus[0]))
+                        same = false;
+                if (same)
+                    nshared++;
+            }
+            os << "SMT sharing: block threads share one core in " << nshared <<
+                " of " << _thread_cpus.size() << " region thread(s).\n";
+            if (nshared < int(_thread_cpus.size()))
+                os << "  Set 'OMP_PLACES=cores' to bind the threads of each block to one core.\n";
+        }
+
         // Some grid stats.
         os << endl;
         os << "Num grids: " << gridPtrs.size() << endl;
@@ -1071,13 +2018,148 @@ namespace yask {
         // will be used.
         // We free the scratch and MPI data first to give grids preference.
         freeScratchData(os);
+        _scratch_arenas.clear();
+        _scratch_arena_sizes.clear();
         freeMpiData(os);
+        pad_grids(os);
+        align_interleaved_grids(os);
+        place_grids(os);
         allocGridData(os);
         allocScratchData(os);
         allocMpiData(os);
 
+        // Measure the memory BW with all threads in all ranks at once,
+        // so ranks on the same node share its BW. The arrays should be
+        // much bigger than the last-level cache, within reason.
+        if (_opts->_measure_mem_bw && _env->stream_bw <= 0.) {
+            const size_t one_mib = 1024 * 1024;
+            size_t nbytes = min(max(4 * getLastCacheSize(), 32 * one_mib), 256 * one_mib);
+            os << "Measuring memory bandwidth with STREAM triad over 3 * " <<
+                makeByteStr(nbytes) << "...\n";
+            _env->global_barrier();
+            set_all_threads();
+            double bw = measureStreamBw(nbytes, 5);
+            set_region_threads();
+            _env->stream_bw = double(sumOverRanks(idx_t(bw), _env->comm));
+        }
+
         print_info();
     }
+
+    // Time '_balance_steps' steps and set 'splits' to the rank-domain sizes
+    // at each rank index in each domain dim with more than one rank.
+    // The size at each index is inversely proportional to the average
+    // time per point of the ranks at that index, so ranks with more work
+    // per point, e.g., from boundary bundles, or on slower nodes get less
+    // of the domain. All ranks find the same sizes from the same times.
+    bool StencilContext::balance_ranks(map<string, vector<idx_t>>& splits) {
+        bool changed = false;
+        splits.clear();
+#ifdef USE_MPI
+        ostream& os = get_ostr();
+        auto nsteps = _opts->_balance_steps;
+        auto nranks = _env->num_ranks;
+        int nddims = _dims->_domain_dims.size();
+        os << "\nBalancing rank-domain sizes using " << nsteps << " step(s)...\n" << flush;
+
+        // Time the steps without halo exchange or auto-tuning, as for the
+        // auto-tuner, so only the calculation in each rank is measured.
+        // Sources, step callbacks, and reductions are skipped, and the
+        // grids are zeroed afterward, so the application sees none of
+        // these steps.
+        initData();
+        _at.clear(true);
+        enable_halo_exchange = false;
+        _timing_run = true;
+        clear_timers();
+        idx_t first_t = 0, last_t = nsteps - 1;
+        if (_dims->_step_dir < 0)
+            swap(first_t, last_t);
+        run_solution(first_t, last_t);
+        double ptime = run_time.get_elapsed_secs() /
+            max(rank_bb.bb_num_points, idx_t(1));
+        _timing_run = false;
+        enable_halo_exchange = true;
+        clear_timers();
+        _at.clear(false, false);
+        for (auto gp : gridPtrs)
+            if (gp)
+                gp->set_all_elements_same(0.0);
+
+        // Share the time per point, rank indices, and sizes of every rank.
+        vector<double> ptimes(nranks);
+        MPI_Allgather(&ptime, 1, MPI_DOUBLE, ptimes.data(), 1, MPI_DOUBLE, _env->comm);
+        vector<idx_t> my_info, info(nranks * nddims * 2);
+        for (int di = 0; di < nddims; di++) {
+            auto& dname = _dims->_domain_dims.getDimName(di);
+            my_info.push_back(_opts->_rank_indices[dname]);
+            my_info.push_back(_opts->_rank_sizes[dname]);
+        }
+        MPI_Allgather(my_info.data(), my_info.size(), MPI_INTEGER8,
+                      info.data(), my_info.size(), MPI_INTEGER8, _env->comm);
+
+        for (int di = 0; di < nddims; di++) {
+            auto& dname = _dims->_domain_dims.getDimName(di);
+            idx_t nr = _opts->_num_ranks[dname];
+            if (nr < 2)
+                continue;
+
+            // Sum the times of the ranks at each index.
+            vector<double> tsum(nr, 0.);
+            vector<int> tnum(nr, 0);
+            vector<idx_t> sizes(nr, 0);
+            for (int rn = 0; rn < nranks; rn++) {
+                auto ri = info[(rn * nddims + di) * 2];
+                tsum.at(ri) += ptimes[rn];
+                tnum.at(ri)++;
+                sizes.at(ri) = info[(rn * nddims + di) * 2 + 1];
+            }
+            idx_t tot = 0;
+            double speed = 0.;
+            bool ok = true;
+            for (idx_t ri = 0; ri < nr; ri++) {
+                tot += sizes[ri];
+                if (tsum[ri] > 0.)
+                    speed += tnum[ri] / tsum[ri];
+                else
+                    ok = false;
+            }
+            if (!ok)
+                continue;
+
+            // New sizes are multiples of the cluster size and at least
+            // the min size required by setupRank(). Any remainder goes
+            // to the largest one.
+            auto cpts = _dims->_cluster_pts[dname];
+            idx_t min_sz = max(ROUND_UP(max_halos[dname] + wf_shifts[dname], cpts), cpts);
+            vector<idx_t> nsizes(nr);
+            idx_t nsum = 0;
+            int big = 0;
+            for (idx_t ri = 0; ri < nr; ri++) {
+                double frac = (tnum[ri] / tsum[ri]) / speed;
+                idx_t sz = ROUND_DOWN(idx_t(tot * frac) + cpts / 2, cpts);
+                nsizes[ri] = max(sz, min_sz);
+                nsum += nsizes[ri];
+                if (nsizes[ri] > nsizes[big])
+                    big = ri;
+            }
+            nsizes[big] += tot - nsum;
+            if (nsizes[big] < min_sz)
+                continue;
+
+            if (nsizes != sizes)
+                changed = true;
+            splits[dname] = nsizes;
+            os << " rank-domain sizes in '" << dname << "':";
+            for (idx_t ri = 0; ri < nr; ri++)
+                os << (ri ? ", " : " ") << sizes[ri] << " => " << nsizes[ri];
+            os << endl;
+        }
+        if (!changed)
+            os << " rank-domain sizes are already balanced.\n";
+#endif
+        return changed;
+    }
     
     void StencilContext::print_info() {
         auto& step_dim = _dims->_step_dim;
@@ -1090,6 +2172,10 @@ namespace yask {
         tot_nbytes = sumOverRanks(rank_nbytes, _env->comm);
         os << "Total overall allocation in " << _env->num_ranks << " rank(s): " <<
             makeByteStr(tot_nbytes) << "\n";
+        if (_opts->_huge_pages)
+            os << "Huge-page memory currently resident in this rank: " <<
+                makeByteStr(getHugePageBytes()) <<
+                " (transparent huge pages are only assigned when first touched)\n";
 
         // Report some stats.
         idx_t dt = _opts->_rank_sizes[step_dim];
@@ -1119,7 +2205,12 @@ namespace yask {
             " minimum-padding:       " << _opts->_min_pad_sizes.makeDimValStr() << endl <<
             " L1-prefetch-distance:  " << PFD_L1 << endl <<
             " L2-prefetch-distance:  " << PFD_L2 << endl <<
-            " max-halos:             " << max_halos.makeDimValStr() << endl;
+            " max-halos:             " << max_halos.makeDimValStr() << endl <<
+            " region-path:           " << _opts->_region_path << endl;
+        if (_opts->_numa_parts > 1)
+            os <<
+                " numa-parts:            " << _opts->_numa_parts << " across '" <<
+                _dims->_domain_dims.getDimName(0) << "'" << endl;
         if (num_wf_shifts > 0) {
             os <<
                 " wave-front-angles:     " << wf_angles.makeDimValStr() << endl <<
@@ -1132,6 +2223,18 @@ namespace yask {
         }
         os << endl;
 
+        // Thread placement found when the thread teams were started.
+        if (_thread_cpus.size()) {
+            os << "Thread affinity (CPU of each block thread in each region thread):\n";
+            for (size_t rt = 0; rt < _thread_cpus.size(); rt++) {
+                os << " region-thread " << rt << ":";
+                for (int cpu : _thread_cpus[rt])
+                    os << " " << cpu;
+                os << endl;
+            }
+            os << endl;
+        }
+
         // Info about eqs, packs and bundles.
         os << "Num stencil equations: " << NUM_STENCIL_EQS << endl;
         os << "Num stencil bundles: " << stBundles.size() << endl;
@@ -1143,6 +2246,13 @@ namespace yask {
         rank_numWrites_1t = 0;
         rank_reads_1t = 0;
         rank_numFpOps_1t = 0;
+        rank_memBytes_1t = 0;
+        rank_reuseBytes_1t = 0;
+
+        // Temporal blocking or wave-front tiling reuses data over its
+        // steps.
+        idx_t reuse_steps = max(max(_opts->_block_sizes[step_dim],
+                                    _opts->_region_sizes[step_dim]), idx_t(1));
 
         for (auto& sp : stPacks) {
             os << "Bundle(s) in pack '" << sp->get_name() << "':\n";
@@ -1168,6 +2278,44 @@ namespace yask {
                 idx_t fpops_domain = fpops1 * sg->bb_num_points;
                 rank_numFpOps_1t += fpops_domain;
 
+                // Est. bytes per point to and from memory. Without cache
+                // reuse, every read and write goes to memory. With reuse
+                // in each block, each non-scratch grid is read once per
+                // block, including its halos, and is written once, plus
+                // a read for ownership unless streaming stores can be
+                // used.
+                idx_t mem_bytes1 = (reads1 + updates1) * REAL_BYTES;
+                set<string> in_names, out_names;
+                double reuse_elems1 = 0.;
+                for (auto* rsg : sg_list) {
+                    for (auto gp : rsg->inputGridPtrs) {
+                        if (gp->is_scratch() || !in_names.insert(gp->get_name()).second)
+                            continue;
+
+                        // Elements read per point in a block.
+                        double elems = 1.;
+                        for (auto& dim : _dims->_domain_dims.getDims()) {
+                            auto& dname = dim.getName();
+                            double blen = max(_opts->_block_sizes[dname], idx_t(1));
+                            if (gp->is_dim_used(dname))
+                                elems *= (blen + reuse_steps *
+                                          (gp->get_left_halo_size(dname) +
+                                           gp->get_right_halo_size(dname))) / blen;
+                            else
+                                elems /= blen;
+                        }
+                        reuse_elems1 += elems;
+                    }
+                    for (auto gp : rsg->outputGridPtrs)
+                        if (!gp->is_scratch() && out_names.insert(gp->get_name()).second)
+                            reuse_elems1 += 2.;
+                    if (_opts->_nt_stores)
+                        reuse_elems1 -= rsg->get_num_nt_store_grids();
+                }
+                double reuse_bytes1 = reuse_elems1 * REAL_BYTES / reuse_steps;
+                rank_memBytes_1t += mem_bytes1 * sg->bb_num_points;
+                rank_reuseBytes_1t += idx_t(reuse_bytes1 * sg->bb_num_points);
+
                 os << " Bundle '" << sg->get_name() << "':\n" <<
                     "  scratch bundles:            " << (sg_list.size() - 1) << endl <<
                     "  sub-domain:                 " << sg->bb_begin.makeDimValStr() <<
@@ -1179,7 +2327,9 @@ namespace yask {
                     "  grid-reads per point:       " << reads1 << endl <<
                     "  grid-reads in sub-domain:   " << makeNumStr(reads_domain) << endl <<
                     "  est FP-ops per point:       " << fpops1 << endl <<
-                    "  est FP-ops in sub-domain:   " << makeNumStr(fpops_domain) << endl;
+                    "  est FP-ops in sub-domain:   " << makeNumStr(fpops_domain) << endl <<
+                    "  est mem-bytes per point:    " << mem_bytes1 << " without cache reuse, " <<
+                    reuse_bytes1 << " with reuse in blocks" << endl;
                 os << "  input-grids:                ";
                 int i = 0;
                 for (auto gp : sg->inputGridPtrs) {
@@ -1213,6 +2363,11 @@ namespace yask {
         rank_domain_dt = rank_domain_1t * dt; // same as _opts->_rank_sizes.product();
         tot_domain_1t = sumOverRanks(rank_domain_1t, _env->comm);
         tot_domain_dt = tot_domain_1t * dt;
+
+        tot_memBytes_1t = sumOverRanks(rank_memBytes_1t, _env->comm);
+        tot_reuseBytes_1t = sumOverRanks(rank_reuseBytes_1t, _env->comm);
+        attainable_pts_ps = (tot_reuseBytes_1t > 0) ?
+            _env->stream_bw * double(tot_domain_1t) / double(tot_reuseBytes_1t) : 0.;
     
         // Print some more stats.
         os << endl <<
@@ -1236,7 +2391,24 @@ namespace yask {
             makeNumStr(rank_numFpOps_1t) << endl <<
             " est-FP-ops in all ranks for one time-step: " <<
             makeNumStr(tot_numFpOps_1t) << endl <<
-            endl;
+            endl <<
+            " est-mem-bytes in all ranks for one time-step without cache reuse: " <<
+            makeByteStr(tot_memBytes_1t) << endl <<
+            " est-mem-bytes in all ranks for one time-step with reuse in blocks: " <<
+            makeByteStr(tot_reuseBytes_1t) << endl;
+        if (tot_domain_1t > 0 && tot_reuseBytes_1t > 0)
+            os <<
+                " est-mem-bytes per point with reuse in blocks: " <<
+                (double(tot_reuseBytes_1t) / tot_domain_1t) << endl <<
+                " est-arith-intensity with reuse in blocks (FLOPs/byte): " <<
+                (double(tot_numFpOps_1t) / tot_reuseBytes_1t) << endl;
+        if (_env->stream_bw > 0.)
+            os <<
+                " measured-mem-bw in all ranks (STREAM triad, bytes/sec): " <<
+                makeNumStr(_env->stream_bw) << endl <<
+                " attainable-throughput (num-points/sec): " <<
+                makeNumStr(attainable_pts_ps) << endl;
+        os << endl;
 
         if (dt > 1) {
             os <<
@@ -1268,6 +2440,9 @@ namespace yask {
             " Num-writes-required is based on sum of grid-updates in sub-domain across stencil-bundle(s).\n"
             " Num-reads-required is based on sum of grid-reads in sub-domain across stencil-bundle(s).\n"
             " Est-FP-ops are based on sum of est-FP-ops in sub-domain across stencil-bundle(s).\n"
+            " Est-mem-bytes with reuse in blocks assume each grid is read once per block with its halos\n"
+            "  and is written once, plus a read for ownership unless streaming stores are allowed.\n"
+            " Attainable-throughput is the measured bandwidth divided by est-mem-bytes with reuse.\n"
             "\n";
 #endif
     }
@@ -1275,11 +2450,30 @@ namespace yask {
     // Dealloc grids, etc.
     void StencilContext::end_solution() {
 
+        // Finish any async run.
+        if (_run_handle)
+            _run_handle->join();
+
+        // Finish any snapshot writes.
+        wait_for_snapshots();
+
+        // Write the timeline.
+        if (_opts->_trace_file.length() && EventTrace::is_enabled()) {
+            EventTrace::disable();
+            string fname = _opts->_trace_file;
+            if (_env->num_ranks > 1)
+                fname += "." + to_string(_env->my_rank);
+            if (EventTrace::write_chrome_json(fname, _env->my_rank))
+                get_ostr() << "Timeline written to '" << fname << "'.\n";
+            else
+                get_ostr() << "Warning: cannot write timeline to '" << fname << "'.\n";
+        }
+
         // Final halo exchange.
         exchange_halos_all();
 
         // Release any MPI data.
-        mpiData.clear();
+        freeMpiData(get_ostr());
 
         // Release grid data.
         for (auto gp : gridPtrs) {
@@ -1287,6 +2481,9 @@ namespace yask {
                 continue;
             gp->release_storage();
         }
+        freeScratchData(get_ostr());
+        _scratch_arenas.clear();
+        _scratch_arena_sizes.clear();
 
 	// Reset threads to original value.
 	set_max_threads();
@@ -1319,10 +2516,483 @@ namespace yask {
         ext_bb.bb_end = rank_bb.bb_end.addElements(right_wf_exts);
         ext_bb.update_bb(os, "extended-rank", *this, true);
 
+        // BBs for comm/compute overlap.
+        find_mpi_bbs();
+
         // Find BB for each bundle. Each will be a subset within
-        // 'ext_bb'.
-        for (auto sg : stBundles)
-            sg->find_bounding_box();
+        // 'ext_bb'. This is skipped if they can be read from a given
+        // file or from the cache or if they were already found for
+        // the same inputs.
+        if (_bb_file.length()) {
+            if (!read_bb_file(_bb_file))
+                THROW_YASK_EXCEPTION("Error: cannot use bounding-boxes from '" +
+                                     _bb_file + "'");
+            _bundle_bb_key.clear();
+            return;
+        }
+        string key = get_bb_key();
+        if (key == _bundle_bb_key) {
+            os << "Bundle bounding-boxes unchanged; not finding them again.\n";
+            return;
+        }
+        string cache_file = get_bb_cache_file();
+        if (!cache_file.length() || !read_bb_file(cache_file)) {
+            for (auto sg : stBundles)
+                sg->find_bounding_box();
+            if (cache_file.length())
+                save_bounding_boxes(cache_file);
+        }
+        _bundle_bb_key = key;
+    }
+
+    // Get the string that identifies the inputs to the bundle BBs.
+    // The BBs depend on the stencil and its code, the overall and rank
+    // domain sizes and positions, the WF extensions, and the min-order boxes.
+    string StencilContext::get_bb_key() const {
+        ostringstream oss;
+        oss << "stencil=" << get_name() <<
+            " code=" << STENCIL_CODE_HASH <<
+            " overall=" << overall_domain_sizes.makeDimValStr(",") <<
+            " rank-index=" << _opts->_rank_indices.makeDimValStr(",") <<
+            " begin=" << ext_bb.bb_begin.makeDimValStr(",") <<
+            " end=" << ext_bb.bb_end.makeDimValStr(",");
+        for (auto& ob : _opts->_order_boxes)
+            oss << " order=" << ob.order << ":" << ob.first.makeValStr(",") <<
+                ":" << ob.last.makeValStr(",");
+        return oss.str();
+    }
+
+    // Get the name of the cache file for the bundle BBs.
+    // Empty if the cache is disabled.
+    string StencilContext::get_bb_cache_file() const {
+        auto& dir = _opts->_bb_cache_dir;
+        if (dir.empty())
+            return "";
+        ostringstream oss;
+        oss << dir << "/" << get_name() << "-" <<
+            hex << hash<string>()(get_bb_key()) << ".bb";
+        return oss.str();
+    }
+
+    // Set the bundle BBs from 'fname'.
+    // Return false if it can't be read or doesn't match.
+    bool StencilContext::read_bb_file(const string& fname) {
+        ostream& os = get_ostr();
+        ifstream ifs(fname);
+        if (!ifs.is_open())
+            return false;
+        int nddims = _dims->_domain_dims.size();
+
+        // Check the key.
+        string line;
+        getline(ifs, line);
+        if (line != "key " + get_bb_key()) {
+            os << "Note: bounding-boxes in '" << fname <<
+                "' are for a different stencil or domain; not using them.\n";
+            return false;
+        }
+
+        // Read into temp vars to avoid using a partial file.
+        vector<BoundingBox> bbs(stBundles.size());
+        vector<BBList> bb_lists(stBundles.size());
+        auto read_bb = [&](BoundingBox& bb) {
+            bb.bb_begin = _dims->_domain_dims;
+            bb.bb_end = _dims->_domain_dims;
+            for (int j = 0; j < nddims; j++)
+                ifs >> bb.bb_begin[j];
+            for (int j = 0; j < nddims; j++)
+                ifs >> bb.bb_end[j];
+        };
+        size_t nbundles = 0;
+        string tag;
+        ifs >> tag >> nbundles;
+        bool ok = tag == "bundles" && nbundles == stBundles.size();
+        for (size_t i = 0; ok && i < nbundles; i++) {
+            string name;
+            size_t nboxes = 0;
+            ifs >> tag >> name >> bbs[i].bb_num_points >> nboxes;
+            ok = tag == "bundle" && name == stBundles[i]->get_name();
+            read_bb(bbs[i]);
+            for (size_t k = 0; ok && k < nboxes; k++) {
+                BoundingBox fbb;
+                read_bb(fbb);
+                fbb.bb_len = fbb.bb_end.subElements(fbb.bb_begin);
+                fbb.bb_size = fbb.bb_num_points = fbb.bb_len.product();
+                fbb.bb_is_full = fbb.bb_valid = true;
+                bb_lists[i].push_back(fbb);
+            }
+            ok = ok && !ifs.fail();
+        }
+        if (!ok) {
+            os << "Note: cannot parse bounding-boxes in '" << fname <<
+                "'; not using them.\n";
+            return false;
+        }
+
+        os << "Using bounding-boxes from '" << fname << "'.\n";
+        for (size_t i = 0; i < nbundles; i++)
+            stBundles[i]->set_bounding_boxes(bbs[i], bb_lists[i]);
+        return true;
+    }
+
+    // Write the bundle BBs to 'fname'.
+    void StencilContext::save_bounding_boxes(const string& fname) {
+        if (!rank_bb.bb_valid)
+            THROW_YASK_EXCEPTION("Error: save_bounding_boxes() called without calling prepare_solution() first");
+        ofstream ofs(fname);
+        if (!ofs.is_open()) {
+            get_ostr() << "Warning: cannot write bounding-boxes to '" << fname << "'.\n";
+            return;
+        }
+        auto write_bb = [&](const BoundingBox& bb) {
+            ofs << bb.bb_begin.makeValStr(" ") << " " <<
+                bb.bb_end.makeValStr(" ") << endl;
+        };
+        ofs << "key " << get_bb_key() << endl;
+        ofs << "bundles " << stBundles.size() << endl;
+        for (auto sg : stBundles) {
+            auto& bbs = sg->get_bb_list();
+            ofs << "bundle " << sg->get_name() << " " <<
+                sg->bb_num_points << " " << bbs.size() << endl;
+            write_bb(*sg);
+            for (auto& bb : bbs)
+                write_bb(bb);
+        }
+    }
+
+    void StencilContext::set_min_order(const vector<idx_t>& first_indices,
+                                       const vector<idx_t>& last_indices,
+                                       idx_t order) {
+        int nddims = _dims->_domain_dims.getNumDims();
+        if (int(first_indices.size()) != nddims || int(last_indices.size()) != nddims)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: set_min_order() called with " <<
+                                            first_indices.size() << " and " <<
+                                            last_indices.size() << " indices instead of " <<
+                                            nddims);
+        KernelSettings::OrderBox ob { _dims->_domain_dims, _dims->_domain_dims, order };
+        for (int j = 0; j < nddims; j++) {
+            ob.first[j] = first_indices[j];
+            ob.last[j] = last_indices[j];
+        }
+        _opts->_order_boxes.push_back(ob);
+    }
+
+    int StencilContext::add_step_callback(yk_step_callback callback,
+                                          const vector<yk_grid_ptr>& read_grids,
+                                          const vector<yk_grid_ptr>& write_grids,
+                                          idx_t reach) {
+        if (!callback)
+            THROW_YASK_EXCEPTION("Error: add_step_callback(): empty function");
+        if (reach < 0)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: add_step_callback(): negative reach " << reach);
+        StepCallback cb;
+        cb.fn = callback;
+        cb.reach = reach;
+        for (int i = 0; i < 2; i++) {
+            for (auto g : i ? write_grids : read_grids) {
+                auto gp = dynamic_pointer_cast<YkGridBase>(g);
+                if (!gp)
+                    THROW_YASK_EXCEPTION("Error: add_step_callback(): null grid pointer");
+                (i ? cb.write_grids : cb.read_grids).push_back(gp);
+            }
+        }
+        _step_callbacks.push_back(cb);
+        return int(_step_callbacks.size()) - 1;
+    }
+
+    // Same name may be used by several bundles, e.g., for
+    // equations with different conditions.
+    int StencilContext::add_reduction_def(const string& name, int op) {
+        for (size_t i = 0; i < _reductions.size(); i++) {
+            if (_reductions[i].name == name) {
+                if (_reductions[i].op != op)
+                    THROW_YASK_EXCEPTION("Error: reduction '" + name +
+                                         "' used with different operations");
+                return int(i);
+            }
+        }
+        Reduction r;
+        r.name = name;
+        r.op = op;
+        _reductions.push_back(r);
+        return int(_reductions.size()) - 1;
+    }
+
+    double StencilContext::get_reduction(const string& name,
+                                         idx_t step_index) const {
+        for (auto& r : _reductions) {
+            if (r.name == name) {
+                auto i = r.results.find(step_index);
+                if (i == r.results.end())
+                    FORMAT_AND_THROW_YASK_EXCEPTION("Error: get_reduction(): reduction '" <<
+                                                    name << "' not computed at step " <<
+                                                    step_index << " by the last run");
+                return i->second;
+            }
+        }
+        THROW_YASK_EXCEPTION("Error: get_reduction(): reduction '" + name +
+                             "' not found");
+    }
+
+    // Copy grids to the next snapshot buf and start a thread to write it.
+    void StencilContext::write_snapshot(const string& fname,
+                                        idx_t step_index,
+                                        const vector<string>& grid_names) {
+        if (!rank_bb.bb_valid)
+            THROW_YASK_EXCEPTION("Error: write_snapshot() called without calling prepare_solution() first");
+        auto& step_dim = _dims->_step_dim;
+
+        // Find grids.
+        GridPtrs gps;
+        if (grid_names.size()) {
+            for (auto& gname : grid_names) {
+                auto gi = gridMap.find(gname);
+                if (gi == gridMap.end())
+                    THROW_YASK_EXCEPTION("Error: write_snapshot(): grid '" + gname +
+                                         "' not found");
+                gps.push_back(gi->second);
+            }
+        }
+        else {
+            for (auto gp : gridPtrs)
+                if (gp->is_dim_used(step_dim))
+                    gps.push_back(gp);
+        }
+
+        // Find the index range of each grid.
+        vector<GridIndices> firsts, lasts;
+        idx_t npts = 0;
+        for (auto gp : gps) {
+            if (!gp->is_storage_allocated())
+                THROW_YASK_EXCEPTION("Error: write_snapshot(): no data allocated for grid '" +
+                                     gp->get_name() + "'");
+            GridIndices first, last;
+            for (auto& dname : gp->get_dim_names()) {
+                if (dname == step_dim) {
+                    first.push_back(step_index);
+                    last.push_back(step_index);
+                }
+                else if (_dims->_domain_dims.lookup(dname)) {
+                    first.push_back(gp->get_first_rank_domain_index(dname));
+                    last.push_back(gp->get_last_rank_domain_index(dname));
+                }
+                else {
+                    first.push_back(gp->get_first_misc_index(dname));
+                    last.push_back(gp->get_last_misc_index(dname));
+                }
+            }
+            idx_t n = 1;
+            for (size_t j = 0; j < first.size(); j++)
+                n *= last[j] - first[j] + 1;
+            npts += n;
+            firsts.push_back(first);
+            lasts.push_back(last);
+        }
+
+        // Wait for the earlier write from this buf.
+        auto& sb = _snap_bufs[_snap_next];
+        wait_for_snapshot(sb);
+        _snap_next = (_snap_next + 1) % 2;
+
+        // Make the header and copy the data.
+        ostringstream oss;
+        oss << "yask-snapshot 1" << endl <<
+            "stencil " << get_name() << endl <<
+            "step " << step_index << endl <<
+            "element-bytes " << sizeof(real_t) << endl <<
+            "grids " << gps.size() << endl;
+        sb.data.resize(npts);
+        idx_t ofs = 0;
+        for (size_t i = 0; i < gps.size(); i++) {
+            auto gp = gps[i];
+            auto n = gp->get_elements_in_slice(sb.data.data() + ofs, firsts[i], lasts[i]);
+            oss << "grid " << gp->get_name() << " " << n;
+            auto dnames = gp->get_dim_names();
+            for (size_t j = 0; j < dnames.size(); j++)
+                oss << " " << dnames[j] << "=" << firsts[i][j] << ":" << lasts[i][j];
+            oss << endl;
+            ofs += n;
+        }
+        oss << "data" << endl;
+        sb.header = oss.str();
+        sb.fname = fname;
+        TRACE_MSG("write_snapshot: " << gps.size() << " grid(s) at step " <<
+                  step_index << " to '" << fname << "'");
+
+        // Write in the background.
+        sb.writer = thread([&sb]() {
+                ofstream ofs(sb.fname, ios::binary);
+                if (ofs.is_open()) {
+                    ofs << sb.header;
+                    ofs.write((const char*)sb.data.data(),
+                              sb.data.size() * sizeof(real_t));
+                }
+                if (!ofs)
+                    sb.err = "Error: cannot write snapshot to '" + sb.fname + "'";
+            });
+    }
+
+    // Wait for the write of 'sb' to finish.
+    void StencilContext::wait_for_snapshot(SnapshotBuf& sb) {
+        if (sb.writer.joinable())
+            sb.writer.join();
+        if (sb.err.length()) {
+            string err = sb.err;
+            sb.err.clear();
+            THROW_YASK_EXCEPTION(err);
+        }
+    }
+
+    // Set the BBs used for overlapping halo exchange with computation.
+    // Exterior slabs are the points within the max halos of each side that
+    // has a neighbor, rounded up to cluster sizes so the interior stays
+    // aligned. Each slab is trimmed in the dims before it to avoid
+    // calculating any point twice, e.g., in 2D:
+    //   +-+-----------+-+
+    //   | |   y-right | |
+    //   | +-----------+ |
+    //   |x|           |x|
+    //   |l| interior  |r|
+    //   | +-----------+ |
+    //   | |   y-left  | |
+    //   +-+-----------+-+
+    void StencilContext::find_mpi_bbs() {
+        mpi_exterior.clear();
+        mpi_interior = rank_bb;
+        if (_env->num_ranks < 2)
+            return;
+
+        // Interior.
+        for (auto& dim : _dims->_domain_dims.getDims()) {
+            auto& dname = dim.getName();
+            auto rbegin = rank_bb.bb_begin[dname];
+            auto rlen = rank_bb.bb_len[dname];
+            auto cpts = _dims->_cluster_pts[dname];
+            auto shell = ROUND_UP(max_halos[dname], cpts);
+            idx_t ibegin = 0, iend = rlen; // rank-relative.
+            if (!_opts->is_first_rank(dname))
+                ibegin = shell;
+            if (!_opts->is_last_rank(dname))
+                iend = round_down_flr(rlen - shell, cpts);
+
+            // No interior?
+            if (iend <= ibegin) {
+                TRACE_MSG("find_mpi_bbs: no interior in '" << dname << "' dim");
+                return;
+            }
+            mpi_interior.bb_begin[dname] = rbegin + ibegin;
+            mpi_interior.bb_end[dname] = rbegin + iend;
+        }
+        mpi_interior.update_bb(get_ostr(), "MPI-interior", *this, true);
+
+        // Exterior slabs.
+        // Dims before the current one are limited to the interior.
+        BoundingBox outer = rank_bb;
+        for (auto& dim : _dims->_domain_dims.getDims()) {
+            auto& dname = dim.getName();
+            for (int side = 0; side < 2; side++) {
+                BoundingBox slab = outer;
+                if (side == 0)
+                    slab.bb_end[dname] = mpi_interior.bb_begin[dname];
+                else
+                    slab.bb_begin[dname] = mpi_interior.bb_end[dname];
+                slab.bb_len = slab.bb_end.subElements(slab.bb_begin);
+                slab.bb_size = slab.bb_num_points = slab.bb_len.product();
+                slab.bb_valid = true;
+                if (slab.bb_size > 0)
+                    mpi_exterior.push_back(slab);
+            }
+            outer.bb_begin[dname] = mpi_interior.bb_begin[dname];
+            outer.bb_end[dname] = mpi_interior.bb_end[dname];
+        }
+        TRACE_MSG("find_mpi_bbs: interior " << mpi_interior.bb_begin.makeDimValStr() <<
+                  " ... (end before) " << mpi_interior.bb_end.makeDimValStr() <<
+                  " with " << mpi_exterior.size() << " exterior slab(s)");
+    }
+
+    // Set the halo faces of its output grids that each bundle may write.
+    // A send face may be written if the bundle BB overlaps the part of
+    // the grid copied to the send buffer. Each recv face is the matching
+    // send face of the neighbor, so they are swapped with each neighbor.
+    // All ranks run the same bundles, so both ends of a face agree on
+    // whether it is dirty.
+    void StencilContext::find_dirty_faces() {
+#ifdef USE_MPI
+        size_t nfaces = _mpiInfo->neighborhood_size * MPIBufs::nBufDirs;
+        int nsend = 0, nfaces_used = 0;
+
+        // Send faces.
+        for (auto* sg : stBundles) {
+            sg->outputGridFaces.clear();
+            for (auto gp : sg->outputGridPtrs) {
+                vector<bool> faces(nfaces, false);
+                auto& gname = gp->get_name();
+                if (mpiData.count(gname))
+                    mpiData.at(gname).visitNeighbors
+                        ([&](const IdxTuple& offsets, int rank, int ni, MPIBufs& bufs) {
+                            auto& sbuf = bufs.bufs[MPIBufs::bufSend];
+                            if (!sbuf.get_size())
+                                return; // from lambda.
+                            nfaces_used++;
+
+                            // An unknown BB may write anywhere.
+                            bool overlap = !sg->bb_valid || sg->bb_num_points > 0;
+                            if (sg->bb_valid) {
+                                for (auto& dim : _dims->_domain_dims.getDims()) {
+                                    auto& dname = dim.getName();
+                                    if (gp->is_dim_used(dname) &&
+                                        (sg->bb_begin[dname] > sbuf.last_pt[dname] ||
+                                         sg->bb_end[dname] <= sbuf.begin_pt[dname]))
+                                        overlap = false;
+                                }
+                            }
+                            if (overlap) {
+                                faces[get_halo_face(ni, MPIBufs::bufSend)] = true;
+                                nsend++;
+                            }
+                        });
+                sg->outputGridFaces.push_back(faces);
+            }
+        }
+        TRACE_MSG("find_dirty_faces: " << nsend << " of " << nfaces_used <<
+                  " bundle send face(s) may be written");
+
+        // Recv faces. The flags for all bundles' output grids are
+        // sent in the same order on all ranks.
+        vector<vector<char>> sflags(_mpiInfo->neighborhood_size);
+        vector<vector<char>> rflags(_mpiInfo->neighborhood_size);
+        vector<MPI_Request> reqs;
+        _mpiInfo->visitNeighbors
+            ([&](const IdxTuple& offsets, int rank, int ni) {
+                if (rank == MPI_PROC_NULL)
+                    return; // from lambda.
+                for (auto* sg : stBundles)
+                    for (auto& faces : sg->outputGridFaces)
+                        sflags[ni].push_back(faces[get_halo_face(ni, MPIBufs::bufSend)]);
+                rflags[ni].resize(sflags[ni].size());
+                reqs.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(rflags[ni].data(), int(rflags[ni].size()), MPI_CHAR,
+                          rank, 0, _env->comm, &reqs.back());
+                reqs.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(sflags[ni].data(), int(sflags[ni].size()), MPI_CHAR,
+                          rank, 0, _env->comm, &reqs.back());
+            });
+        MPI_Waitall(int(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+        _mpiInfo->visitNeighbors
+            ([&](const IdxTuple& offsets, int rank, int ni) {
+                if (rank == MPI_PROC_NULL)
+                    return; // from lambda.
+                size_t i = 0;
+                for (auto* sg : stBundles)
+                    for (auto& faces : sg->outputGridFaces)
+                        faces[get_halo_face(ni, MPIBufs::bufRecv)] = rflags[ni].at(i++) != 0;
+            });
+
+        // Track the faces of the exchanged grids.
+        for (auto gp : gridPtrs)
+            if (gp && mpiData.count(gp->get_name()))
+                gp->set_num_dirty_faces(nfaces);
+#endif
     }
 
     // Set the bounding-box vars for this bundle in this rank.
@@ -1405,6 +3075,211 @@ namespace yask {
         
         // Finalize BB.
         update_bb(os, get_name(), context);
+
+        // Split BB with holes into full boxes.  The BB is first cut into
+        // slabs across the first domain dim, and each slab is split in
+        // parallel. Boxes that were only separated by slab edges are then
+        // joined again.
+        _bb_list.clear();
+        if (!bb_is_full && !is_scratch()) {
+            auto& dname0 = domain_dims.getDimName(0);
+            idx_t len0 = bb_len[dname0];
+            idx_t nslabs = min<idx_t>(len0, omp_get_max_threads());
+            vector<BBList> slab_bbs(nslabs);
+            vector<int> slab_ok(nslabs, 1);
+
+#pragma omp parallel for schedule(dynamic, 1)
+            for (idx_t n = 0; n < nslabs; n++) {
+                BoundingBox slab = *this;
+                slab.bb_begin[dname0] = bb_begin[dname0] + n * len0 / nslabs;
+                slab.bb_end[dname0] = bb_begin[dname0] + (n + 1) * len0 / nslabs;
+                slab.bb_len[dname0] = slab.bb_end[dname0] - slab.bb_begin[dname0];
+                slab.bb_size = slab.bb_len.product();
+                slab_ok[n] = split_bb(slab, slab_bbs[n]);
+            }
+
+            bool ok = true;
+            for (idx_t n = 0; n < nslabs && ok; n++) {
+                if (!slab_ok[n])
+                    ok = false;
+                else
+                    _bb_list.insert(_bb_list.end(),
+                                    slab_bbs[n].begin(), slab_bbs[n].end());
+            }
+            if (ok) {
+                merge_bbs(_bb_list);
+                if (_bb_list.size() > _max_sub_bbs)
+                    ok = false;
+            }
+            
+            if (ok)
+                os << "Note: '" << get_name() << "' domain split into " <<
+                    _bb_list.size() << " full box(es) for vectorized calculations.\n";
+            else {
+                os << "Warning: '" << get_name() << "' domain needs more than " <<
+                    _max_sub_bbs << " full boxes to cover its valid points;"
+                    " slower scalar calculations will be used.\n";
+                _bb_list.clear();
+            }
+        }
+    }
+
+    // Set the bounding-box vars and full boxes from a prior
+    // find_bounding_box().
+    void StencilBundleBase::set_bounding_boxes(const BoundingBox& bb,
+                                               const BBList& bbs) {
+        StencilContext& context = *_generic_context;
+        bb_begin = bb.bb_begin;
+        bb_end = bb.bb_end;
+        bb_num_points = bb.bb_num_points;
+        update_bb(context.get_ostr(), get_name(), context);
+        _bb_list = bbs;
+    }
+
+    // Split 'bb' into tight, full boxes.
+    // Empty slices at the edges of the box are trimmed first. For each dim, the valid points in each slice across the box are
+    // counted. The box is cut wherever the count changes between slices
+    // in the first dim that has such a change. That makes the cuts fall
+    // on the edges of the valid region(s), e.g., a shell around a cube is
+    // split into six slabs. If no count changes, the box is bisected
+    // in its longest dim. Empty boxes are dropped.
+    bool StencilBundleBase::split_bb(const BoundingBox& bb, BBList& bbs) {
+        StencilContext& context = *_generic_context;
+        auto dims = context.get_dims();
+        auto& domain_dims = dims->_domain_dims;
+        int nddims = domain_dims.size();
+        int nsdims = dims->_stencil_dims.size();
+        auto step_posn = Indices::step_posn;
+        if (bb.bb_size == 0)
+            return true;
+
+        // Count valid points in each slice in each dim.
+        vector<vector<idx_t>> slice_npts(nddims);
+        for (int j = 0; j < nddims; j++)
+            slice_npts[j].assign(bb.bb_len[j], 0);
+        idx_t npts = 0;
+        Indices pt(nsdims);
+        pt[step_posn] = 0;
+        bb.bb_len.visitAllPoints([&](const IdxTuple& ofs, size_t idx) {
+                for (int i = 0, j = 0; i < nsdims; i++) {
+                    if (i == step_posn) continue;
+                    pt[i] = bb.bb_begin[j] + ofs[j];
+                    j++;
+                }
+                if (is_in_valid_domain(pt)) {
+                    npts++;
+                    for (int j = 0; j < nddims; j++)
+                        slice_npts[j][ofs[j]]++;
+                }
+                return true;    // keep going.
+            });
+
+        // Empty?
+        if (npts == 0)
+            return true;
+
+        // Trim empty slices from the edges to make the box tight.
+        bool trimmed = false;
+        BoundingBox tbb = bb;
+        for (int j = 0; j < nddims; j++) {
+            auto& sn = slice_npts[j];
+            idx_t lo = 0, hi = bb.bb_len[j];
+            while (sn[lo] == 0) lo++;
+            while (sn[hi - 1] == 0) hi--;
+            if (lo > 0 || hi < bb.bb_len[j]) {
+                tbb.bb_begin[j] = bb.bb_begin[j] + lo;
+                tbb.bb_end[j] = bb.bb_begin[j] + hi;
+                tbb.bb_len[j] = hi - lo;
+                trimmed = true;
+            }
+        }
+        if (trimmed) {
+            tbb.bb_size = tbb.bb_len.product();
+            return split_bb(tbb, bbs);
+        }
+
+        // Full?
+        if (npts == bb.bb_size) {
+            if (bbs.size() >= _max_sub_bbs)
+                return false;
+            BoundingBox fbb = bb;
+            fbb.bb_num_points = bb.bb_size;
+            fbb.bb_is_full = true;
+            bbs.push_back(fbb);
+            return true;
+        }
+
+        // Find cuts in first dim with changes.
+        vector<idx_t> cuts;
+        int cdim = -1;
+        for (int j = 0; j < nddims && cdim < 0; j++) {
+            for (idx_t k = 1; k < bb.bb_len[j]; k++)
+                if (slice_npts[j][k] != slice_npts[j][k - 1])
+                    cuts.push_back(k);
+            if (cuts.size())
+                cdim = j;
+        }
+
+        // Or bisect longest dim.
+        if (cdim < 0) {
+            cdim = 0;
+            for (int j = 1; j < nddims; j++)
+                if (bb.bb_len[j] > bb.bb_len[cdim])
+                    cdim = j;
+            assert(bb.bb_len[cdim] > 1);
+            cuts.push_back(bb.bb_len[cdim] / 2);
+        }
+        cuts.push_back(bb.bb_len[cdim]);
+
+        // Recurse on each part.
+        idx_t prev = 0;
+        for (auto k : cuts) {
+            BoundingBox part = bb;
+            part.bb_begin[cdim] = bb.bb_begin[cdim] + prev;
+            part.bb_end[cdim] = bb.bb_begin[cdim] + k;
+            part.bb_len[cdim] = k - prev;
+            part.bb_size = part.bb_len.product();
+            if (!split_bb(part, bbs))
+                return false;
+            prev = k;
+        }
+        return true;
+    }
+    
+    // Join boxes that have the same extents in all but the first
+    // domain dim and touch in that dim, e.g., ones that were split only
+    // because they crossed the edge of a slab.
+    void StencilBundleBase::merge_bbs(BBList& bbs) {
+        StencilContext& context = *_generic_context;
+        auto dims = context.get_dims();
+        int nddims = dims->_domain_dims.size();
+
+        for (size_t i = 0; i < bbs.size(); i++) {
+            for (size_t k = 0; k < bbs.size(); k++) {
+                auto& bbi = bbs[i];
+                auto& bbk = bbs[k];
+                if (i == k || bbi.bb_end[0] != bbk.bb_begin[0])
+                    continue;
+                bool same = true;
+                for (int j = 1; j < nddims && same; j++)
+                    if (bbi.bb_begin[j] != bbk.bb_begin[j] ||
+                        bbi.bb_end[j] != bbk.bb_end[j])
+                        same = false;
+                if (!same)
+                    continue;
+
+                // Extend 'bbi' to cover 'bbk', drop 'bbk', and
+                // look for another box to join to the new end.
+                bbi.bb_end[0] = bbk.bb_end[0];
+                bbi.bb_len[0] = bbi.bb_end[0] - bbi.bb_begin[0];
+                bbi.bb_size = bbi.bb_len.product();
+                bbi.bb_num_points = bbi.bb_size;
+                bbs.erase(bbs.begin() + k);
+                if (k < i)
+                    i--;
+                k = size_t(-1);
+            }
+        }
     }
     
     // Compute convenience values for a bounding-box.
@@ -1423,11 +3298,10 @@ namespace yask {
         // Solid rectangle?
         bb_is_full = true;
         if (bb_num_points != bb_size) {
-            os << "Warning: '" << name << "' domain has only " <<
+            os << "Note: '" << name << "' domain has only " <<
                 makeNumStr(bb_num_points) <<
                 " valid point(s) inside its bounding-box of " <<
-                makeNumStr(bb_size) <<
-                " point(s); slower scalar calculations will be used.\n";
+                makeNumStr(bb_size) << " point(s).\n";
             bb_is_full = false;
         }
 
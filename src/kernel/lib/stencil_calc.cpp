@@ -36,36 +36,50 @@ namespace yask {
     // first and then the non-scratch stencils in the stencil bundle.
     void StencilBundleBase::calc_block(const ScanIndices& def_block_idxs) {
 
-        auto opts = _generic_context->get_settings();
         auto dims = _generic_context->get_dims();
         int nsdims = dims->_stencil_dims.size();
-        auto& step_dim = dims->_step_dim;
-        auto step_posn = Indices::step_posn;
-        int thread_idx = omp_get_thread_num(); // used to index the scratch grids.
         TRACE_MSG3("calc_block for bundle '" << get_name() << "': " <<
                    def_block_idxs.begin.makeValStr(nsdims) <<
                    " ... (end before) " << def_block_idxs.end.makeValStr(nsdims) <<
-                   " by thread " << thread_idx);
+                   " by thread " << omp_get_thread_num());
         assert(!is_scratch());
 
-        // Trim the default block indices based on the bounding box
-        // for this bundle.
-        // TODO: loop through list of BBs for this bundle.
-        // TODO: replace string-based lookup w/indices.
+        // If the BB has holes, evaluate each full box in it
+        // separately so the vector code can be used.
+        if (!bb_is_full && _bb_list.size()) {
+            for (auto& bb : _bb_list)
+                calc_block_bb(bb, def_block_idxs);
+        }
+        else
+            calc_block_bb(*this, def_block_idxs);
+    }
+
+    // Calculate results within the part of a block inside 'bb'.
+    void StencilBundleBase::calc_block_bb(const BoundingBox& bb,
+                                          const ScanIndices& def_block_idxs) {
+
+        auto opts = _generic_context->get_settings();
+        auto dims = _generic_context->get_dims();
+        int nsdims = dims->_stencil_dims.size();
+        auto& step_dim = dims->_step_dim;
+        auto step_posn = Indices::step_posn;
+        int thread_idx = _generic_context->get_region_thread_idx(); // used to index the scratch grids.
+
+        // Trim the default block indices based on the bounding box.
         ScanIndices bb_idxs(def_block_idxs);
         bool ok = true;
+        assert(bb.bb_begin.getNumDims() == nsdims - 1);
+        assert(bb.bb_end.getNumDims() == nsdims - 1);
         for (int i = 0; i < nsdims; i++) {
             if (i == step_posn) continue;
-            auto& dname = dims->_stencil_dims.getDimName(i);
+            int j = Dims::get_domain_dim_posn(i);
 
             // Begin point.
-            assert(bb_begin.lookup(dname));
-            auto bbegin = max(bb_idxs.begin[i], bb_begin[dname]);
+            auto bbegin = max(bb_idxs.begin[i], bb.bb_begin[j]);
             bb_idxs.begin[i] = bbegin;
 
             // End point.
-            assert(bb_end.lookup(dname));
-            auto bend = min(bb_idxs.end[i], bb_end[dname]);
+            auto bend = min(bb_idxs.end[i], bb.bb_end[j]);
             bb_idxs.end[i] = bend;
 
             // Anything to do?
@@ -113,7 +127,19 @@ namespace yask {
             // Include automatically-generated loop code that calls
             // calc_sub_block() for each sub-block in this block. This
             // code typically contains the nested OpenMP loop(s).
+            YaskCycleTimer sg_time;
+            sg_time.start();
 #include "yask_block_loops.hpp"
+            sg_time.stop();
+
+            // Add to this thread's times.
+            size_t ti = size_t(thread_idx) * _timer_stride;
+            if (ti < _thread_secs.size()) {
+                double secs = sg_time.get_elapsed_secs();
+                _thread_secs[ti] += secs;
+                if (sg != this)
+                    _thread_secs[ti + 1] += secs;
+            }
         }
     }
 
@@ -152,18 +178,43 @@ namespace yask {
     // The index ranges in 'block_idxs' are sub-divided
     // into full vector-clusters, full vectors, and sub-vectors
     // and finally evaluated by the YASK-compiler-generated loops.
+    // The number of stencil dims is set by the generated code, so
+    // the index types and loops over dims in the sub-block are
+    // specialized to it.
     void StencilBundleBase::calc_sub_block(int thread_idx,
                                            const ScanIndices& block_idxs) {
+        calc_sub_block_fixed<NUM_STENCIL_DIMS>(thread_idx, block_idxs);
+    }
+    template <int NSDIMS>
+    void StencilBundleBase::calc_sub_block_fixed(int thread_idx,
+                                                 const ScanIndices& block_idxs) {
         auto* cp = _generic_context;
         auto opts = cp->get_settings();
         auto dims = cp->get_dims();
-        int nddims = dims->_domain_dims.size();
-        int nsdims = dims->_stencil_dims.size();
+        constexpr int nsdims = NSDIMS;
+        assert(dims->_stencil_dims.size() == nsdims);
+
+        // Use fixed-size indices, including in the generated loops
+        // below.
+        typedef FixedIndices<NSDIMS> Indices;
+        typedef FixedScanIndices<NSDIMS> ScanIndices;
         auto& step_dim = dims->_step_dim;
         auto step_posn = Indices::step_posn;
         TRACE_MSG3("calc_sub_block for reqd bundle '" << get_name() << "': " <<
                    block_idxs.start.makeValStr(nsdims) <<
                    " ... (end before) " << block_idxs.stop.makeValStr(nsdims));
+#ifdef USE_PERF_EVENTS
+        PerfCounters::Scope perf_scope(_perf_counts);
+#endif
+#ifdef MODEL_CACHE
+        if (cache_model.isEnabled()) {
+            idx_t npts = 1;
+            for (int i = 0; i < nsdims; i++)
+                if (i != step_posn)
+                    npts *= block_idxs.stop[i] - block_idxs.start[i];
+            cache_model.set_bundle(get_name(), npts);
+        }
+#endif
 
         /*
           Inidices in each domain dim:
@@ -183,7 +234,7 @@ namespace yask {
         // Init sub-block begin & end from block start & stop indices.
         // These indices are in element units and global (NOT rank-relative).
         ScanIndices sub_block_idxs(*dims, true, 0);
-        sub_block_idxs.initFromOuter(block_idxs);
+        sub_block_idxs.initFromOuter(ScanIndices(block_idxs));
 
         // Sub block indices in element units and rank-relative.
         ScanIndices sub_block_eidxs(sub_block_idxs);
@@ -208,7 +259,7 @@ namespace yask {
         
         // Masks for computing partial vectors in each dim.
         // Init to all-ones (no masking).
-        Indices peel_masks(nsdims), rem_masks(nsdims);
+        Indices peel_masks, rem_masks;
         peel_masks.setFromConst(-1);
         rem_masks.setFromConst(-1);
         
@@ -216,24 +267,25 @@ namespace yask {
         bool do_clusters = false; // any clusters to do?
         bool do_vectors = false; // any vectors to do? (assume not)
         bool do_scalars = false; // any scalars to do? (assume not)
-        bool scalar_for_peel_rem = false; // using the scalar code for peel and/or remainder.
 
-        // For scratch grids, always do whole BB. Otherwise,
-        // if BB is not full, do whole block with scalar code.  We should
-        // only get here when using sub-domains w/"holes" in them.  TODO: do
-        // as much vectorization as possible-- this current code is
-        // functionally correct but very poor perf.
+        // Whether points must be checked against the sub-domain.
+        // When the BB is not full, calc_block() normally evaluates
+        // only full boxes within it, so no checks are needed.
+        bool check_domain = !bb_is_full && _bb_list.empty();
+
+        // For scratch grids, always do whole BB. Otherwise, if the BB
+        // is not full and could not be split into full boxes, do whole
+        // block with scalar code.
 #ifdef FORCE_SCALAR
         bool scalar_only = true;
 #else
-        bool scalar_only = !is_scratch() && !bb_is_full;
+        bool scalar_only = !is_scratch() && check_domain;
 #endif
         if (scalar_only) {
 
             do_clusters = false;
             do_vectors = false;
             do_scalars = true;
-            scalar_for_peel_rem = false;
 
             // None of these will be used.
             sub_block_fcidxs.begin.setFromConst(0);
@@ -298,17 +350,6 @@ namespace yask {
                         auto fvend = round_down_flr(eend, vpts);
                         auto vbgn = round_down_flr(ebgn, vpts);
                         auto vend = round_up_flr(eend, vpts);
-                        if (i == _inner_posn) {
-
-                            // Don't do any full and/or partial vectors in
-                            // plane of inner dim.  We'll do these with
-                            // scalars.  This is unusual because vector
-                            // folding is normally done in a plane
-                            // perpendicular to the inner dim for >= 2D
-                            // domains.
-                            fvbgn = vbgn = fcbgn;
-                            fvend = vend = fcend;
-                        }
                         sub_block_fvidxs.begin[i] = fvbgn;
                         sub_block_fvidxs.end[i] = fvend;
                         sub_block_vidxs.begin[i] = vbgn;
@@ -375,16 +416,6 @@ namespace yask {
                             peel_masks[i] = pmask;
                             rem_masks[i] = rmask;
                         }
-
-                        // Anything not covered?
-                        // This will only be needed in inner dim because we
-                        // will do partial vectors in other dims.
-                        // Set 'scalar_for_peel_rem' to indicate we only want to
-                        // do peel and/or rem in scalar loop.
-                        if (i == _inner_posn && (ebgn < vbgn || eend > vend)) {
-                            do_scalars = true;
-                            scalar_for_peel_rem = true;
-                        }
                     }
 
                     // If no peel or rem, just set vec indices to same as
@@ -430,6 +461,10 @@ namespace yask {
                 j++;
             }
 
+#ifdef USE_OFFLOAD
+            // Run all the clusters on the device at once.
+            calc_sub_block_offload(thread_idx, yask::ScanIndices(norm_sub_block_idxs));
+#else
             // Define the function called from the generated loops
             // to simply call the loop-of-clusters functions.
 #define calc_inner_loop(thread_idx, loop_idxs) \
@@ -440,6 +475,7 @@ namespace yask {
             // loops because it does not scan the inner dim.
 #include "yask_sub_block_loops.hpp"
 #undef calc_inner_loop
+#endif
         }
         
         // Full and partial peel/remainder vectors.
@@ -481,6 +517,31 @@ namespace yask {
             normalize_indices(sub_block_fvidxs.end, norm_sub_block_fvidxs.end);
             norm_sub_block_fvidxs.align.setFromConst(1); // one vector.
 
+            // Bounds in the inner dim where the mask or the cluster
+            // coverage can change. Between two adjacent ones, all vectors
+            // in a loop are treated the same way.
+            // They are kept sorted and unique in 'ibounds[0 .. nibounds-1]'.
+            idx_t ibgn = norm_sub_block_idxs.begin[_inner_posn];
+            idx_t iend = norm_sub_block_idxs.end[_inner_posn];
+            idx_t ibounds[6] = { ibgn };
+            int nibounds = 1;
+            for (idx_t ib : { norm_sub_block_fvidxs.begin[_inner_posn],
+                        norm_sub_block_fcidxs.begin[_inner_posn],
+                        norm_sub_block_fcidxs.end[_inner_posn],
+                        norm_sub_block_fvidxs.end[_inner_posn], iend }) {
+                if (ib <= ibgn || ib > iend)
+                    continue;
+                int k = nibounds;
+                while (ibounds[k - 1] > ib)
+                    k--;
+                if (ibounds[k - 1] == ib)
+                    continue;
+                for (int m = nibounds; m > k; m--)
+                    ibounds[m] = ibounds[m - 1];
+                ibounds[k] = ib;
+                nibounds++;
+            }
+
             // Define the function called from the generated loops to
             // determine whether a loop of vectors is within the peel
             // range (before the cluster) and/or remainder
@@ -488,6 +549,10 @@ namespace yask {
             // loop-of-vectors function w/appropriate mask.
             // See the mask diagrams above that show how the
             // masks are ANDed together.
+            // In the inner dim, the loop is split at 'ibounds', so
+            // partial vectors there are also done with masks. The
+            // inner-dim start of 'loop_idxs' is set in place for each
+            // piece; it is not used by the generated loops.
             // Since step is always 1, we ignore loop_idxs.stop.
 #define calc_inner_loop(thread_idx, loop_idxs) \
             bool ok = false;                                            \
@@ -504,7 +569,21 @@ namespace yask {
                             mask &= rem_masks[i];                       \
                 }                                                       \
             }                                                           \
-            if (ok) calc_loop_of_vectors(thread_idx, loop_idxs, mask);
+            for (int k = 0; k + 1 < nibounds; k++) {                    \
+                idx_t ib = ibounds[k];                                  \
+                bool iok = ok ||                                        \
+                    ib < norm_sub_block_fcidxs.begin[_inner_posn] ||    \
+                    ib >= norm_sub_block_fcidxs.end[_inner_posn];       \
+                if (!iok) continue;                                     \
+                idx_t imask = mask;                                     \
+                if (ib < norm_sub_block_fvidxs.begin[_inner_posn])      \
+                    imask &= peel_masks[_inner_posn];                   \
+                if (ib >= norm_sub_block_fvidxs.end[_inner_posn])       \
+                    imask &= rem_masks[_inner_posn];                    \
+                loop_idxs.start[_inner_posn] = ib;                      \
+                calc_loop_of_vectors(thread_idx, loop_idxs.start,       \
+                                     ibounds[k + 1], imask);            \
+            }
 
             // Include automatically-generated loop code that calls
             // calc_inner_loop(). This is different from the higher-level
@@ -513,7 +592,7 @@ namespace yask {
 #undef calc_inner_loop
         }
         
-        // Use scalar code for anything not done above.
+        // Use scalar code for the whole sub-block when vectors can't be used.
         if (do_scalars) {
 
             // Use the 'misc' loops. Indices for these loops will be scalar and
@@ -526,9 +605,8 @@ namespace yask {
 
 #ifdef TRACE
             string msg = "calc_sub_block:  using scalar code for ";
-            msg += scalar_for_peel_rem ? "peel/remainder of" : "entire";
-            msg += " sub-block ";
-            msg += bb_is_full ? "without" : "with";
+            msg += "entire sub-block ";
+            msg += check_domain ? "with" : "without";
             msg += " sub-domain checking for ";
             TRACE_MSG3(msg << 
                        misc_idxs.begin.makeValStr(nsdims) <<
@@ -543,19 +621,7 @@ namespace yask {
             // Since step is always 1, we ignore misc_idxs.stop.
 #define misc_fn(pt_idxs)  do {                                          \
                 TRACE_MSG3("calc_sub_block:   at pt " << pt_idxs.start.makeValStr(nsdims)); \
-                bool ok = true;                                         \
-                if (scalar_for_peel_rem) {                              \
-                    ok = false;                                         \
-                    for (int i = 0, j = 0; i < nsdims; i++) {           \
-                        if (i == step_posn) continue;                   \
-                        auto rofs = cp->rank_domain_offsets[j];         \
-                        if (pt_idxs.start[i] < rofs + sub_block_vidxs.begin[i] || \
-                            pt_idxs.start[i] >= rofs + sub_block_vidxs.end[i]) { \
-                            ok = true; break; }                         \
-                        j++;                                            \
-                    }                                                   \
-                }                                                       \
-                if (ok && (bb_is_full || is_in_valid_domain(pt_idxs.start))) { \
+                if (!check_domain || is_in_valid_domain(pt_idxs.start)) { \
                     calc_scalar(thread_idx, pt_idxs.start);             \
                 }                                                       \
             } while(0)
@@ -568,16 +634,94 @@ namespace yask {
         }
 
         // Make sure streaming stores are visible for later loads.
-        make_stores_visible();
+#ifndef USE_STREAMING_STORE
+        if (_use_nt_stores)
+#endif
+            make_stores_visible();
+
+        // Reduce the values just written while they are in cache.
+        if (_reductions.size() && !_generic_context->_timing_run)
+            reduce_sub_block(yask::ScanIndices(sub_block_idxs), check_domain);
 
     } // calc_sub_block.
 
+    void StencilBundleBase::add_reduction(const string& name,
+                                          const string& op,
+                                          YkGridPtr gp,
+                                          const Indices& ofs) {
+        auto* cp = _generic_context;
+        auto dims = cp->get_dims();
+        BundleReduction br;
+        if (op == "sum")
+            br.op = YkGridBase::reduce_sum;
+        else if (op == "sum_sq")
+            br.op = YkGridBase::reduce_sum_sq;
+        else if (op == "max_abs")
+            br.op = YkGridBase::reduce_max_abs;
+        else
+            THROW_YASK_EXCEPTION("Error: unknown reduction operation '" + op +
+                                 "' for '" + name + "'");
+        br.idx = cp->add_reduction_def(name, br.op);
+        br.gp = gp;
+        br.ofs = ofs;
+        for (int i = 0; i < gp->get_num_dims(); i++)
+            br.sposns.push_back(dims->_stencil_dims.lookup_posn(gp->get_dim_name(i)));
+        _reductions.push_back(br);
+    }
+
+    // The sub-block is clipped to the rank domain, so points in the
+    // extensions evaluated for wave-fronts are not counted twice.
+    void StencilBundleBase::reduce_sub_block(const ScanIndices& sub_block_idxs,
+                                             bool check_domain) {
+        auto* cp = _generic_context;
+        auto step_posn = Indices::step_posn;
+        idx_t t = sub_block_idxs.start[step_posn];
+
+        for (auto& br : _reductions) {
+            auto& gp = br.gp;
+            int nd = gp->get_num_dims();
+            Indices first(br.ofs), last(br.ofs);
+            idx_t wt = t;
+            bool ok = true;
+            for (int i = 0; i < nd; i++) {
+                int sp = br.sposns[i];
+                if (sp == step_posn)
+                    first[i] = last[i] = wt = t + br.ofs[i];
+                else if (sp >= 0) {
+                    int j = Dims::get_domain_dim_posn(sp);
+                    first[i] = max(sub_block_idxs.begin[sp], cp->rank_bb.bb_begin[j]);
+                    last[i] = min(sub_block_idxs.end[sp], cp->rank_bb.bb_end[j]) - 1;
+                    if (last[i] < first[i])
+                        ok = false;
+                }
+            }
+            if (!ok)
+                continue;
+
+            // Only points in the sub-domain were written.
+            std::function<bool (const Indices& pt)> keep =
+                [&](const Indices& pt) {
+                    Indices idxs(sub_block_idxs.start);
+                    for (int i = 0; i < nd; i++) {
+                        int sp = br.sposns[i];
+                        if (sp >= 0 && sp != step_posn)
+                            idxs[sp] = pt[i];
+                    }
+                    return is_in_valid_domain(idxs);
+                };
+            double v = gp->reduce_elems(first, last, YkGridBase::ReduceOp(br.op),
+                                        check_domain ? &keep : 0);
+            cp->add_reduction_partial(br.idx, wt, v);
+        }
+    }
+
     // Calculate a series of cluster results within an inner loop.
     // The 'loop_idxs' must specify a range only in the inner dim.
     // Indices must be rank-relative.
     // Indices must be normalized, i.e., already divided by VLEN_*.
+    template <typename IdxsT>
     void StencilBundleBase::calc_loop_of_clusters(int thread_idx,
-                                                 const ScanIndices& loop_idxs) {
+                                                 const GenericScanIndices<IdxsT>& loop_idxs) {
         auto* cp = _generic_context;
         auto dims = cp->get_dims();
         int nsdims = dims->_stencil_dims.size();
@@ -612,8 +756,9 @@ namespace yask {
     // The 'loop_idxs' must specify a range only in the inner dim.
     // Indices must be rank-relative.
     // Indices must be normalized, i.e., already divided by VLEN_*.
+    template <typename IdxsT>
     void StencilBundleBase::calc_loop_of_vectors(int thread_idx,
-                                                const ScanIndices& loop_idxs,
+                                                const GenericScanIndices<IdxsT>& loop_idxs,
                                                 idx_t write_mask) {
         auto* cp = _generic_context;
         auto dims = cp->get_dims();
@@ -674,11 +819,9 @@ namespace yask {
             // i: index for stencil dims, j: index for domain dims.
             for (int i = 0, j = 0; i < nsdims; i++) {
                 if (i == step_posn) continue;
-                auto& dim = dims->_stencil_dims.getDim(i);
-                auto& dname = dim.getName();
                 
                 // Is this dim used in this grid?
-                int posn = gp->get_dim_posn(dname);
+                int posn = gp->get_dim_id_posn(i);
                 if (posn >= 0) {
 
                     // Make sure grid domain covers block.
@@ -53,6 +53,56 @@ namespace yask {
         // Whether this updates scratch grid(s);
         bool _is_scratch = false;
 
+        // Number of output grids that are written w/streaming stores
+        // when '_use_nt_stores' is set.
+        int _num_nt_store_grids = 0;
+        bool _use_nt_stores = false;
+
+        // Full boxes covering all the valid points when the BB is not
+        // full, so that vector code can be used in each one. Empty if
+        // the BB is full or if too many boxes would be needed; the
+        // whole BB is then evaluated with scalar code.
+        BBList _bb_list;
+        static constexpr size_t _max_sub_bbs = 1024;
+
+        // Reductions over the values written by this bundle.
+        struct BundleReduction {
+            int idx = 0;        // index into the context's reductions.
+            int op = 0;         // YkGridBase::ReduceOp.
+            YkGridPtr gp;       // grid written.
+            Indices ofs;        // step offset and misc indices of the LHS.
+            std::vector<int> sposns; // posn in stencil dims of each grid dim or -1.
+        };
+        std::vector<BundleReduction> _reductions;
+
+        // Seconds in calc_block_bb() by each region thread at
+        // [thread * _timer_stride] and the part of it in the scratch
+        // bundles at the next entry. Strided to keep threads on
+        // separate cache lines.
+        static constexpr int _timer_stride = CACHELINE_BYTES / sizeof(double);
+        std::vector<double> _thread_secs;
+
+        // Hardware event counts in calc_sub_block() summed over all
+        // threads. Only updated if built with 'perf_events=1'.
+        std::atomic<uint64_t> _perf_counts[PerfCounters::perf_num_events] {};
+
+        // Reduce the values written in a sub-block into the context's
+        // partial results.
+        void reduce_sub_block(const ScanIndices& sub_block_idxs,
+                              bool check_domain);
+
+        // Split 'bb' into tight, full boxes and append them to 'bbs'.
+        // Return false if more than '_max_sub_bbs' would be needed.
+        bool split_bb(const BoundingBox& bb, BBList& bbs);
+
+        // Join neighboring boxes in 'bbs' that only differ in the
+        // first domain dim and touch in it.
+        void merge_bbs(BBList& bbs);
+
+        // Calculate results within the part of a block inside 'bb'.
+        void calc_block_bb(const BoundingBox& bb,
+                           const ScanIndices& def_block_idxs);
+
         // Normalize the indices, i.e., divide by vector len in each dim.
         // Ranks offsets must already be subtracted.
         // Each dim in 'orig' must be a multiple of corresponding vec len.
@@ -63,6 +113,11 @@ namespace yask {
         // Grids that are written to by these stencils.
         GridPtrs outputGridPtrs;
 
+        // Halo faces of each grid in 'outputGridPtrs' that these
+        // stencils may write, as used by YkGridBase::set_dirty_faces().
+        // Set by StencilContext::find_dirty_faces(); empty if unknown.
+        std::vector<std::vector<bool>> outputGridFaces;
+
         // Grids that are read by these stencils (not necessarify
         // read-only, i.e., a grid can be input and output).
         GridPtrs inputGridPtrs;
@@ -111,11 +166,48 @@ namespace yask {
         virtual bool is_scratch() const { return _is_scratch; }
         virtual void set_scratch(bool is_scratch) { _is_scratch = is_scratch; }
         
+        // Streaming-store accessors.
+        virtual int get_num_nt_store_grids() const { return _num_nt_store_grids; }
+        virtual bool is_using_nt_stores() const { return _use_nt_stores; }
+        virtual void set_using_nt_stores(bool use_nt) {
+            _use_nt_stores = use_nt && _num_nt_store_grids > 0;
+        }
+
         // Add dependency.
         virtual void add_dep(StencilBundleBase* eg) {
             _depends_on.insert(eg);
         }
 
+        // Add a reduction 'op' named 'name' over the values written to
+        // 'gp'. 'ofs' holds the LHS step offset and misc indices for
+        // each dim of 'gp'; domain entries are ignored.
+        virtual void add_reduction(const std::string& name,
+                                   const std::string& op,
+                                   YkGridPtr gp,
+                                   const Indices& ofs);
+
+        // Reset the times for up to 'nthreads' region threads.
+        virtual void clear_timers(int nthreads) {
+            _thread_secs.assign(size_t(nthreads) * _timer_stride, 0.);
+            for (auto& c : _perf_counts)
+                c = 0;
+        }
+
+        // Get the times summed over the region threads.
+        virtual void get_thread_secs(double& total_secs,
+                                     double& scratch_secs) const {
+            total_secs = scratch_secs = 0.;
+            for (size_t i = 0; i < _thread_secs.size(); i += _timer_stride) {
+                total_secs += _thread_secs[i];
+                scratch_secs += _thread_secs[i + 1];
+            }
+        }
+
+        // Get the hardware event counts.
+        virtual uint64_t get_perf_count(int ev) const {
+            return _perf_counts[ev];
+        }
+
         // Get dependencies.
         virtual const StencilBundleSet& get_deps() const {
             return _depends_on;
@@ -147,6 +239,17 @@ namespace yask {
         // Set the bounding-box vars for this bundle in this rank.
         virtual void find_bounding_box();
 
+        // Set the bounding-box vars and full boxes from a prior
+        // find_bounding_box().
+        virtual void set_bounding_boxes(const BoundingBox& bb,
+                                        const BBList& bbs);
+
+        // Get the full boxes covering the valid points.
+        // Empty if the BB is full or if scalar code is used.
+        virtual const BBList& get_bb_list() const {
+            return _bb_list;
+        }
+
         // Determine whether indices are in [sub-]domain.
         virtual bool
         is_in_valid_domain(const Indices& idxs) =0;
@@ -163,6 +266,10 @@ namespace yask {
         virtual void
         calc_sub_block(int thread_idx, const ScanIndices& block_idxs);
 
+        // Implementation of calc_sub_block() w/'NSDIMS' stencil dims.
+        template <int NSDIMS> void
+        calc_sub_block_fixed(int thread_idx, const ScanIndices& block_idxs);
+
         // Calculate a series of cluster results within an inner loop.
         // All indices start at 'start_idxs'. Inner loop iterates to
         // 'stop_inner' by 'step_inner'.
@@ -177,9 +284,18 @@ namespace yask {
         // The 'loop_idxs' must specify a range only in the inner dim.
         // Indices must be rank-relative.
         // Indices must be normalized, i.e., already divided by VLEN_*.
-        virtual void
+        template <typename IdxsT> void
         calc_loop_of_clusters(int thread_idx,
-                              const ScanIndices& loop_idxs);
+                              const GenericScanIndices<IdxsT>& loop_idxs);
+
+#ifdef USE_OFFLOAD
+        // Calculate all the cluster results in a sub-block on the
+        // offload device. Defined by the 'omp-target' stencil compiler
+        // format. Indices must be rank-relative and normalized.
+        virtual void
+        calc_sub_block_offload(int thread_idx,
+                               const ScanIndices& norm_idxs) =0;
+#endif
 
         // Calculate a series of vector results within an inner loop.
         // All indices start at 'start_idxs'. Inner loop iterates to
@@ -198,9 +314,9 @@ namespace yask {
         // Indices must be rank-relative.
         // Indices must be normalized, i.e., already divided by VLEN_*.
         // Each vector write is masked by 'write_mask'.
-        virtual void
+        template <typename IdxsT> void
         calc_loop_of_vectors(int thread_idx,
-                             const ScanIndices& loop_idxs,
+                             const GenericScanIndices<IdxsT>& loop_idxs,
                              idx_t write_mask);
 
     };                          // StencilBundleBase.
@@ -211,6 +327,7 @@ namespace yask {
 
     protected:
         std::string _name;
+        int _trace_id = -1;
         
     public:
         BundlePack(const std::string& name) :
@@ -220,6 +337,13 @@ namespace yask {
         const std::string& get_name() {
             return _name;
         }
+
+        // Id of this pack's events in an EventTrace.
+        int get_trace_id() {
+            if (_trace_id < 0)
+                _trace_id = EventTrace::get_id("pack " + _name);
+            return _trace_id;
+        }
         
     }; // BundlePack.
 
@@ -25,10 +25,10 @@ IN THE SOFTWARE.
 
 #include "yask.hpp"
 
-// Set MODEL_CACHE to 1 or 2 to model that cache level
-// and create a global cache object here.
+// Set MODEL_CACHE to model the data caches
+// and create a global cache-model object here.
 #ifdef MODEL_CACHE
-Cache cache_model(MODEL_CACHE);
+yask::CacheModel cache_model;
 #endif
 
 using namespace std;
@@ -58,6 +58,37 @@ namespace yask {
         return static_cast<char*>(p);
     }
 
+#if defined(USE_NUMA) && !defined(USE_NUMA_POLICY_LIB)
+
+    // Apply the NUMA policy for 'numa_pref' to an mmap'd range.
+    static void bindNuma(void* p, size_t nbytes, int numa_pref) {
+        if (numa_pref >= 0) {
+
+            // Prefer given node.
+            unsigned long nodemask = 0x1UL << numa_pref;
+            mbind(p, nbytes, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0);
+        }
+        else if (numa_pref == yask_numa_interleave) {
+
+            // Use all nodes.
+            unsigned long nodemask = (unsigned long)-1;
+            mbind(p, nbytes, MPOL_INTERLEAVE, &nodemask, sizeof(nodemask) * 8, 0);
+        }
+
+        else{
+
+            // Use local node.
+            // MPOL_LOCAL was defined in Linux 3.8, so use
+            // MPOL_DEFAULT as backup on old systems.
+#ifdef MPOL_LOCAL
+            mbind(p, nbytes, MPOL_LOCAL, 0, 0, 0);
+#else
+            mbind(p, nbytes, MPOL_DEFAULT, 0, 0, 0);
+#endif
+        }
+    }
+#endif
+
     // NUMA allocation.
     // 'numa_pref' >= 0: preferred NUMA node.
     // 'numa_pref' < 0: use defined policy.
@@ -99,32 +130,8 @@ namespace yask {
             p = mmap(0, nbytes, mmprot, mmflags, -1, 0);
 
             // If successful, apply the desired binding.
-            if (p && p != MAP_FAILED) {
-                if (numa_pref >= 0) {
-
-                    // Prefer given node.
-                    unsigned long nodemask = 0x1UL << numa_pref;
-                    mbind(p, nbytes, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0);
-                }
-                else if (numa_pref == yask_numa_interleave) {
-
-                    // Use all nodes.
-                    unsigned long nodemask = (unsigned long)-1;
-                    mbind(p, nbytes, MPOL_INTERLEAVE, &nodemask, sizeof(nodemask) * 8, 0);
-                }
-
-                else{
-
-                    // Use local node.
-                    // MPOL_LOCAL was defined in Linux 3.8, so use
-                    // MPOL_DEFAULT as backup on old systems.
-#ifdef MPOL_LOCAL
-                    mbind(p, nbytes, MPOL_LOCAL, 0, 0, 0);
-#else
-                    mbind(p, nbytes, MPOL_DEFAULT, 0, 0, 0);
-#endif
-                }
-            }
+            if (p && p != MAP_FAILED)
+                bindNuma(p, nbytes, numa_pref);
             else
                 THROW_YASK_EXCEPTION("Error: anonymous mmap of " + makeByteStr(nbytes) +
                                      " failed");
@@ -141,6 +148,438 @@ namespace yask {
         return static_cast<char*>(p);
     }
 
+    // Huge-page allocation.
+    // 'huge_pages' == 1: transparent huge pages.
+    // 'huge_pages' == 2 or 3: explicit 2MiB or 1GiB pages, falling back
+    // to transparent huge pages if none are available.
+    // 'nbytes' is updated to the size of the mapping.
+    char* hugeAlloc(std::size_t& nbytes, int numa_pref, int huge_pages) {
+        const size_t thp_bytes = YASK_HUGE_ALIGNMENT;
+        int mmprot = PROT_READ | PROT_WRITE;
+        int mmflags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        if (huge_pages >= 2) {
+            int shift = (huge_pages == 3) ? 30 : 21;
+            size_t hbytes = ROUND_UP(nbytes, size_t(1) << shift);
+            int hflags = MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+            hflags |= shift << MAP_HUGE_SHIFT;
+#endif
+            p = mmap(0, hbytes, mmprot, mmflags | hflags, -1, 0);
+            if (p != MAP_FAILED)
+                nbytes = hbytes;
+        }
+#endif
+
+        // Transparent huge pages: map extra so the start can be aligned
+        // to a huge page, then unmap the unaligned ends.
+        if (p == MAP_FAILED) {
+            size_t tbytes = ROUND_UP(nbytes, thp_bytes);
+            p = mmap(0, tbytes + thp_bytes, mmprot, mmflags, -1, 0);
+            if (p == MAP_FAILED)
+                THROW_YASK_EXCEPTION("Error: anonymous mmap of " + makeByteStr(nbytes) +
+                                     " failed");
+            char* cp = static_cast<char*>(p);
+            size_t head = (thp_bytes - size_t(cp) % thp_bytes) % thp_bytes;
+            if (head)
+                munmap(cp, head);
+            if (thp_bytes - head)
+                munmap(cp + head + tbytes, thp_bytes - head);
+            p = cp + head;
+            nbytes = tbytes;
+#ifdef MADV_HUGEPAGE
+            madvise(p, nbytes, MADV_HUGEPAGE);
+#endif
+        }
+
+        // Apply NUMA policy.
+#ifdef USE_NUMA
+        if (numa_pref != yask_numa_none) {
+#ifdef USE_NUMA_POLICY_LIB
+            if (numa_available() != -1) {
+                if (numa_pref >= 0 && numa_pref <= numa_max_node())
+                    numa_tonode_memory(p, nbytes, numa_pref);
+                else if (numa_pref == yask_numa_interleave)
+                    numa_interleave_memory(p, nbytes, numa_all_nodes_ptr);
+                else
+                    numa_setlocal_memory(p, nbytes);
+            }
+#else
+            if (get_mempolicy(NULL, NULL, 0, 0, 0) == 0)
+                bindNuma(p, nbytes, numa_pref);
+#endif
+        }
+#endif
+        return static_cast<char*>(p);
+    }
+
+    // Private R/W map of the first 'nbytes' of file 'fname'.
+    // Changes to the mapped memory are not written to the file.
+    char* fileMap(const std::string& fname, std::size_t nbytes) {
+        int fd = open(fname.c_str(), O_RDONLY);
+        if (fd < 0)
+            THROW_YASK_EXCEPTION("Error: cannot open '" + fname + "'");
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < nbytes) {
+            close(fd);
+            THROW_YASK_EXCEPTION("Error: '" + fname + "' is smaller than " +
+                                 makeByteStr(nbytes));
+        }
+        void* p = mmap(0, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+            THROW_YASK_EXCEPTION("Error: cannot mmap " + makeByteStr(nbytes) +
+                                 " of '" + fname + "'");
+        return static_cast<char*>(p);
+    }
+
+    // Shared R/W map of a new 'nbytes' file 'fname'.
+    char* fileMapScratch(const std::string& fname, std::size_t nbytes, int& fd) {
+        fd = open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+            THROW_YASK_EXCEPTION("Error: cannot create '" + fname + "'");
+        unlink(fname.c_str());
+        if (ftruncate(fd, off_t(nbytes)) != 0) {
+            close(fd);
+            THROW_YASK_EXCEPTION("Error: cannot extend '" + fname + "' to " +
+                                 makeByteStr(nbytes));
+        }
+        void* p = mmap(0, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            THROW_YASK_EXCEPTION("Error: cannot mmap " + makeByteStr(nbytes) +
+                                 " of '" + fname + "'");
+        }
+        return static_cast<char*>(p);
+    }
+
+    // These are only hints, so errors are ignored.
+    void filePrefetch(int fd, std::size_t offset, std::size_t nbytes) {
+        posix_fadvise(fd, off_t(offset), off_t(nbytes), POSIX_FADV_WILLNEED);
+    }
+    void fileWriteBehind(int fd, char* p, std::size_t offset, std::size_t nbytes) {
+        madvise(p, nbytes, MADV_DONTNEED);
+        sync_file_range(fd, off_t(offset), off_t(nbytes), SYNC_FILE_RANGE_WRITE);
+    }
+    void fileDrop(int fd, std::size_t offset, std::size_t nbytes) {
+        posix_fadvise(fd, off_t(offset), off_t(nbytes), POSIX_FADV_DONTNEED);
+    }
+
+    // Sum the huge-page sizes in /proc/self/smaps.
+    size_t getHugePageBytes() {
+        ifstream ifs("/proc/self/smaps");
+        size_t nbytes = 0;
+        string line;
+        while (getline(ifs, line)) {
+            if (line.compare(0, 14, "AnonHugePages:") == 0 ||
+                line.compare(0, 16, "Private_Hugetlb:") == 0 ||
+                line.compare(0, 15, "Shared_Hugetlb:") == 0) {
+                istringstream iss(line.substr(line.find(':') + 1));
+                size_t kb = 0;
+                iss >> kb;
+                nbytes += kb * 1024;
+            }
+        }
+        return nbytes;
+    }
+
+    // MPI_Alloc_mem() may only align to 16 bytes.
+    shared_ptr<char> shared_mpi_alloc(size_t sz) {
+#ifdef USE_MPI
+        char* p = 0;
+        if (MPI_Alloc_mem(MPI_Aint(sz + CACHELINE_BYTES), MPI_INFO_NULL, &p) != MPI_SUCCESS || !p)
+            THROW_YASK_EXCEPTION("Error: MPI_Alloc_mem() failed for " +
+                                 makeByteStr(sz));
+        char* ap = p + (CACHELINE_BYTES - size_t(p) % CACHELINE_BYTES) % CACHELINE_BYTES;
+        return shared_ptr<char>(ap, [p](char*) {
+                int done = 0;
+                MPI_Finalized(&done);
+                if (!done)
+                    MPI_Free_mem(p);
+            });
+#else
+        THROW_YASK_EXCEPTION("Error: MPI_Alloc_mem() requested without MPI");
+#endif
+    }
+
+    namespace {
+        struct PoolKey {
+            size_t nbytes;
+            int numa_pref;
+            int huge_pages;
+            bool mpi_mem;
+
+            bool operator<(const PoolKey& rhs) const {
+                return std::tie(nbytes, numa_pref, huge_pages, mpi_mem) <
+                    std::tie(rhs.nbytes, rhs.numa_pref, rhs.huge_pages, rhs.mpi_mem);
+            }
+        };
+        struct AllocPool {
+            std::mutex mtx;
+            multimap<PoolKey, shared_ptr<char>> bufs;
+        };
+
+        // Never deleted, so memory may be released into it at exit.
+        AllocPool& get_alloc_pool() {
+            static AllocPool* pool = new AllocPool;
+            return *pool;
+        }
+    }
+
+    shared_ptr<char> pool_alloc(size_t sz, int numa_pref,
+                                int huge_pages, bool mpi_mem) {
+        PoolKey key { sz, numa_pref, huge_pages, mpi_mem };
+        auto& pool = get_alloc_pool();
+        shared_ptr<char> base;
+        {
+            lock_guard<mutex> lock(pool.mtx);
+            auto i = pool.bufs.find(key);
+            if (i != pool.bufs.end()) {
+                base = i->second;
+                pool.bufs.erase(i);
+            }
+        }
+
+        // Nothing to reuse.
+        if (!base) {
+            if (mpi_mem)
+                base = shared_mpi_alloc(sz);
+            else
+                base = shared_numa_alloc<char>(sz, numa_pref, huge_pages);
+        }
+
+        // Return 'base' to the pool when the last copy is released.
+        return shared_ptr<char>(base.get(),
+                                [key, base](char*) {
+                                    auto& pool = get_alloc_pool();
+                                    lock_guard<mutex> lock(pool.mtx);
+                                    pool.bufs.emplace(key, base);
+                                });
+    }
+
+    size_t clear_alloc_pool() {
+        auto& pool = get_alloc_pool();
+        multimap<PoolKey, shared_ptr<char>> bufs;
+        {
+            lock_guard<mutex> lock(pool.mtx);
+            bufs.swap(pool.bufs);
+        }
+        size_t nb = 0;
+        for (auto& i : bufs)
+            nb += i.first.nbytes;
+        return nb;
+    }
+
+    // The TSC is only usable if it is invariant, i.e., runs at a
+    // constant rate in all power states. See CPUID leaf 0x80000007.
+    static bool tsc_is_invariant() {
+#ifdef USE_TSC_TIMER
+        unsigned int a, b, c, d;
+        if (__get_cpuid(0x80000000, &a, &b, &c, &d) && a >= 0x80000007 &&
+            __get_cpuid(0x80000007, &a, &b, &c, &d))
+            return (d & (1 << 8)) != 0;
+#endif
+        return false;
+    }
+    const bool YaskCycleTimer::_use_tsc = tsc_is_invariant();
+
+    // Count ticks over a few msecs of CLOCK_MONOTONIC.
+    double YaskCycleTimer::get_secs_per_tick() {
+        static const double spt = [] {
+            if (!_use_tsc)
+                return 1e-9;
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            uint64_t c0 = get_ticks();
+            double secs = 0.;
+            do {
+                clock_gettime(CLOCK_MONOTONIC, &t1);
+                secs = double(t1.tv_sec - t0.tv_sec) + double(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+            } while (secs < 0.005);
+            uint64_t c1 = get_ticks();
+            return (c1 > c0) ? secs / double(c1 - c0) : 1e-9;
+        }();
+        return spt;
+    }
+
+    const char* PerfCounters::get_name(int ev) {
+        static const char* names[perf_num_events] =
+            { "cycles", "instructions", "l2_misses", "dram_bytes" };
+        assert(ev >= 0 && ev < perf_num_events);
+        return names[ev];
+    }
+
+#ifdef USE_PERF_EVENTS
+    // The counters of one thread. The first open event leads the
+    // group, so all of them are read with one call.
+    struct PerfGroup {
+        int fd = -1;
+        int nopen = 0;
+        int evs[PerfCounters::perf_num_events];
+
+        PerfGroup() {
+            static const uint64_t configs[PerfCounters::perf_num_events] =
+                { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                  PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES };
+            for (int i = 0; i < PerfCounters::perf_num_events; i++) {
+                struct perf_event_attr pea;
+                memset(&pea, 0, sizeof(pea));
+                pea.size = sizeof(pea);
+                pea.type = PERF_TYPE_HARDWARE;
+                pea.config = configs[i];
+                pea.exclude_kernel = 1;
+                pea.exclude_hv = 1;
+                pea.read_format = PERF_FORMAT_GROUP;
+                int efd = int(syscall(__NR_perf_event_open, &pea, 0, -1, fd, 0));
+                if (efd < 0)
+                    continue;
+                if (fd < 0)
+                    fd = efd;
+                evs[nopen++] = i;
+            }
+        }
+    };
+#endif
+
+    bool PerfCounters::read(uint64_t vals[perf_num_events]) {
+#ifdef USE_PERF_EVENTS
+        thread_local PerfGroup pg;
+        if (pg.fd < 0)
+            return false;
+
+        // Layout for PERF_FORMAT_GROUP: number of events, then counts.
+        uint64_t buf[perf_num_events + 1];
+        ssize_t nb = ::read(pg.fd, buf, sizeof(buf));
+        if (nb < ssize_t(sizeof(uint64_t) * (pg.nopen + 1)))
+            return false;
+        for (int i = 0; i < perf_num_events; i++)
+            vals[i] = 0;
+        for (int i = 0; i < pg.nopen; i++)
+            vals[pg.evs[i]] = buf[i + 1];
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool EventTrace::_enabled = false;
+    size_t EventTrace::_buf_events = 0;
+
+    // Names and buffers shared by all threads.
+    // The buffers are only added to or cleared under the lock.
+    struct EventTraceData {
+        std::mutex lock;
+        std::vector<std::string> names;
+        std::map<std::string, int> ids;
+        struct ThreadBuf {
+            std::vector<EventTrace::Event> events;
+            uint64_t num_events = 0;
+            std::string thread_name;
+        };
+        std::vector<std::unique_ptr<ThreadBuf>> bufs;
+    };
+    static EventTraceData& trace_data() {
+        static EventTraceData td;
+        return td;
+    }
+
+    void EventTrace::enable(size_t buf_events) {
+        auto& td = trace_data();
+        std::lock_guard<std::mutex> lk(td.lock);
+        _buf_events = std::max(buf_events, size_t(2));
+        for (auto& b : td.bufs) {
+            b->events.assign(_buf_events, Event());
+            b->num_events = 0;
+        }
+        _enabled = true;
+    }
+
+    int EventTrace::get_id(const std::string& name) {
+        auto& td = trace_data();
+        std::lock_guard<std::mutex> lk(td.lock);
+        auto i = td.ids.find(name);
+        if (i != td.ids.end())
+            return i->second;
+        int id = int(td.names.size());
+        td.names.push_back(name);
+        td.ids[name] = id;
+        return id;
+    }
+
+    std::vector<EventTrace::Event>& EventTrace::get_buf(uint64_t*& num_events) {
+        thread_local EventTraceData::ThreadBuf* tb = 0;
+        if (!tb) {
+            auto& td = trace_data();
+            std::lock_guard<std::mutex> lk(td.lock);
+            td.bufs.emplace_back(new EventTraceData::ThreadBuf);
+            tb = td.bufs.back().get();
+            tb->events.assign(_buf_events, Event());
+
+            // Name by the OpenMP thread number at each nesting level.
+            tb->thread_name = "thread";
+            for (int l = 1; l <= omp_get_level(); l++)
+                tb->thread_name += (l == 1 ? " " : ".") + to_string(omp_get_ancestor_thread_num(l));
+            if (omp_get_level() == 0)
+                tb->thread_name += " 0";
+        }
+        num_events = &tb->num_events;
+        return tb->events;
+    }
+
+    bool EventTrace::write_chrome_json(const std::string& fname, int pid) {
+        auto& td = trace_data();
+        std::lock_guard<std::mutex> lk(td.lock);
+        ofstream ofs(fname);
+        if (!ofs)
+            return false;
+
+        // Times are in usec from the earliest event.
+        uint64_t t0 = UINT64_MAX;
+        for (auto& b : td.bufs) {
+            size_t n = b->events.size();
+            if (b->num_events)
+                t0 = std::min(t0, b->events[b->num_events > n ? b->num_events % n : 0].ticks);
+        }
+        double usecs_per_tick = YaskCycleTimer::get_secs_per_tick() * 1e6;
+
+        ofs << "{\"traceEvents\": [\n";
+        bool first = true;
+        for (size_t ti = 0; ti < td.bufs.size(); ti++) {
+            auto& b = *td.bufs[ti];
+            if (!b.num_events)
+                continue;
+            ofs << (first ? "" : ",\n") <<
+                "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid <<
+                ", \"tid\": " << ti << ", \"args\": {\"name\": \"" << b.thread_name << "\"}}";
+            first = false;
+
+            // Oldest first, from the ring position if it wrapped.
+            size_t n = b.events.size();
+            uint64_t ne = std::min<uint64_t>(b.num_events, n);
+            uint64_t start = b.num_events > n ? b.num_events % n : 0;
+            for (uint64_t i = 0; i < ne; i++) {
+                auto& e = b.events[(start + i) % n];
+                ofs << ",\n{\"name\": \"" << td.names[e.id] << "\", \"ph\": \"" << e.phase <<
+                    "\", \"pid\": " << pid << ", \"tid\": " << ti <<
+                    ", \"ts\": " << fixed << setprecision(3) <<
+                    (double(e.ticks - t0) * usecs_per_tick) << defaultfloat << "}";
+            }
+        }
+        ofs << "\n]}\n";
+        return bool(ofs);
+    }
+
+    // CPU the calling thread is running on, or -1 if unknown.
+    int getCpu() {
+#if defined(WIN32)
+        return -1;
+#else
+        return sched_getcpu();
+#endif
+    }
+
     // Return num with SI multiplier and "iB" suffix,
     // e.g., 412KiB.
     string makeByteStr(size_t nbytes)
@@ -187,6 +626,153 @@ namespace yask {
         return os.str();
     }
 
+    // Return the CPU model name from /proc/cpuinfo or "unknown".
+    string getCpuModel()
+    {
+        ifstream ifs("/proc/cpuinfo");
+        string line;
+        while (getline(ifs, line)) {
+            if (line.compare(0, 10, "model name") == 0) {
+                auto pos = line.find_first_not_of(" \t", line.find(':') + 1);
+                if (pos != string::npos)
+                    return line.substr(pos);
+            }
+        }
+        return "unknown";
+    }
+
+    // Read the size and ways of the data cache at 'level' from sysfs.
+    // Return false if not found.
+    bool getCacheGeom(int level, size_t& nbytes, size_t& nways)
+    {
+        for (int i = 0; ; i++) {
+            string dir = "/sys/devices/system/cpu/cpu0/cache/index" + to_string(i) + "/";
+            ifstream lfs(dir + "level");
+            if (!lfs)
+                break;
+            int lvl = 0;
+            string type, size;
+            size_t ways = 0;
+            lfs >> lvl;
+            ifstream(dir + "type") >> type;
+            ifstream(dir + "size") >> size;
+            ifstream(dir + "ways_of_associativity") >> ways;
+            if (lvl != level || type == "Instruction" || size.empty() || !ways)
+                continue;
+            nbytes = atol(size.c_str());
+            if (size.back() == 'K')
+                nbytes *= 1024;
+            else if (size.back() == 'M')
+                nbytes *= 1024 * 1024;
+            nways = ways;
+            return true;
+        }
+        return false;
+    }
+
+    // Read the data-cache geometry from sysfs.
+    size_t getCacheSetStride(int level)
+    {
+        size_t nbytes = 0, nways = 0;
+        if (getCacheGeom(level, nbytes, nways))
+            return nbytes / nways;
+        return 0;
+    }
+
+    // Size of the last-level data cache from sysfs.
+    size_t getLastCacheSize()
+    {
+        for (int level = 4; level > 0; level--) {
+            size_t nbytes = 0, nways = 0;
+            if (getCacheGeom(level, nbytes, nways))
+                return nbytes;
+        }
+        return 0;
+    }
+
+    double measureStreamBw(size_t nbytes, int nreps)
+    {
+        size_t n = nbytes / sizeof(double);
+        if (!n)
+            return 0.;
+
+        // Touch the arrays with the threads that use them.
+        unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+        double* ap = a.get();
+        double* bp = b.get();
+        double* cp = c.get();
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            ap[i] = 0.;
+            bp[i] = 1.;
+            cp[i] = 2.;
+        }
+
+        double best = 0.;
+        const double scalar = 3.;
+        for (int r = 0; r < nreps; r++) {
+            YaskTimer timer;
+            timer.start();
+#pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < n; i++)
+                ap[i] = bp[i] + scalar * cp[i];
+            timer.stop();
+            double secs = timer.get_elapsed_secs();
+            if (secs > 0.)
+                best = max(best, 3. * double(n * sizeof(double)) / secs);
+        }
+        return best;
+    }
+
+    // Read the core and package of 'cpu' from sysfs.
+    int getCpuCore(int cpu)
+    {
+        if (cpu < 0)
+            return -1;
+        string dir = "/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/";
+        int core = -1, pkg = 0;
+        ifstream(dir + "core_id") >> core;
+        ifstream(dir + "physical_package_id") >> pkg;
+        if (core < 0)
+            return -1;
+        return pkg * 0x10000 + core;
+    }
+
+    // Convert the distance to coordinates using Skilling's method
+    // ("Programming the Hilbert curve," AIP Conf. Proc. 707, 2004):
+    // the bits of 'h' are dealt to the coords starting with the MSB
+    // of coords[0], and the resulting Gray code is then undone.
+    void getHilbertCoords(idx_t h, int nbits, int ndims, idx_t* coords)
+    {
+        for (int i = 0; i < ndims; i++)
+            coords[i] = 0;
+        for (int k = 0; k < nbits * ndims; k++)
+            coords[ndims - 1 - k % ndims] |= ((h >> k) & 1) << (k / ndims);
+        if (nbits < 1)
+            return;
+
+        // Gray decode.
+        idx_t t = coords[ndims - 1] >> 1;
+        for (int i = ndims - 1; i > 0; i--)
+            coords[i] ^= coords[i - 1];
+        coords[0] ^= t;
+
+        // Undo the excess work.
+        idx_t n = idx_t(1) << nbits;
+        for (idx_t q = 2; q != n; q <<= 1) {
+            idx_t p = q - 1;
+            for (int i = ndims - 1; i >= 0; i--) {
+                if (coords[i] & q)
+                    coords[0] ^= p;
+                else {
+                    t = (coords[0] ^ coords[i]) & p;
+                    coords[0] ^= t;
+                    coords[i] ^= t;
+                }
+            }
+        }
+    }
+
     // Round up val to a multiple of mult.
     // Print a message if rounding is done and do_print is set.
     idx_t roundUp(ostream& os, idx_t val, idx_t mult,
@@ -212,6 +798,15 @@ namespace yask {
         return sum_val;
     }
 
+    // Find max of rank_vals over all ranks.
+    double maxOverRanks(double rank_val, MPI_Comm comm) {
+        double max_val = rank_val;
+#ifdef USE_MPI
+        MPI_Allreduce(&rank_val, &max_val, 1, MPI_DOUBLE, MPI_MAX, comm);
+#endif
+        return max_val;
+    }
+
     // Make sure rank_val is same over all ranks.
     void assertEqualityOverRanks(idx_t rank_val,
                                  MPI_Comm comm,
@@ -364,6 +959,27 @@ namespace yask {
             _val << "." << endl;
     }
     
+    // Check for a string option.
+    bool CommandLineParser::StringOption::check_arg(std::vector<std::string>& args,
+                                                    int& argi) {
+        if (_check_arg(args, argi, _name)) {
+            if (size_t(argi) >= args.size()) {
+                THROW_YASK_EXCEPTION("Error: no argument for option '" + args[argi - 1] + "'");
+            }
+            _val = args[argi++];
+            return true;
+        }
+        return false;
+    }
+
+    // Print help on a string option.
+    void CommandLineParser::StringOption::print_help(ostream& os,
+                                                     int width) const {
+        _print_help(os, _name + " <string>", width);
+        os << _help_leader << _current_value_str <<
+            "'" << _val << "'." << endl;
+    }
+    
     // Print help on an multi-idx_t option.
     void CommandLineParser::MultiIdxOption::print_help(ostream& os,
                                                   int width) const {
@@ -389,6 +1005,44 @@ namespace yask {
         return false;
     }
 
+    // Print help on an idx_t-list option.
+    void CommandLineParser::IdxListOption::print_help(ostream& os,
+                                                      int width) const {
+        _print_help(os, _name + " <integer>,<integer>,...", width);
+        os << _help_leader << _current_value_str;
+        for (size_t i = 0; i < _vals.size(); i++) {
+            if (i > 0)
+                os << ", ";
+            os << _vals[i];
+        }
+        if (_vals.empty())
+            os << "none";
+        os << "." << endl;
+    }
+    
+    // Check for an idx_t-list option.
+    bool CommandLineParser::IdxListOption::check_arg(std::vector<std::string>& args,
+                                                     int& argi) {
+        if (_check_arg(args, argi, _name)) {
+            if (size_t(argi) >= args.size()) {
+                THROW_YASK_EXCEPTION("Error: no argument for option '" + args[argi - 1] + "'");
+            }
+
+            // Parse each comma-separated value as if it followed the option.
+            _vals.clear();
+            istringstream iss(args[argi]);
+            string val;
+            while (getline(iss, val, ',')) {
+                vector<string> vargs = { args[argi - 1], val };
+                int vi = 1;
+                _vals.push_back(_idx_val(vargs, vi));
+            }
+            argi++;
+            return true;
+        }
+        return false;
+    }
+
     // Print help on all options.
     void CommandLineParser::print_help(ostream& os) const {
         for (auto oi : _opts) {
@@ -25,6 +25,11 @@ IN THE SOFTWARE.
 
 #pragma once
 
+// For huge-page allocation and file mapping.
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
 #ifdef USE_NUMA
 
 // Use numa policy library?
@@ -82,9 +87,33 @@ namespace yask {
     // Return num with SI multiplier, e.g., 4.23M.
     extern std::string makeNumStr(double num);
 
+    // Return the CPU model name or "unknown".
+    extern std::string getCpuModel();
+
+    // Set the size in bytes and the ways of the data cache at 'level'.
+    // Return false if unknown.
+    extern bool getCacheGeom(int level, size_t& nbytes, size_t& nways);
+
+    // Return the bytes between addresses that map to the same set in
+    // the data cache at 'level', i.e., its size divided by its ways,
+    // or zero if unknown.
+    extern size_t getCacheSetStride(int level);
+
+    // Return the size in bytes of the last-level data cache,
+    // or zero if unknown.
+    extern size_t getLastCacheSize();
+
+    // Run the STREAM triad over three arrays of 'nbytes' each with the
+    // current number of OpenMP threads. Return the best rate of 'nreps'
+    // runs in bytes/sec, counting 3 * 'nbytes' per run like STREAM.
+    extern double measureStreamBw(size_t nbytes, int nreps);
+
     // Find sum of rank_vals over all ranks.
     extern idx_t sumOverRanks(idx_t rank_val, MPI_Comm comm);
 
+    // Find max of rank_vals over all ranks.
+    extern double maxOverRanks(double rank_val, MPI_Comm comm);
+
     // Make sure rank_val is same over all ranks.
     extern void assertEqualityOverRanks(idx_t rank_val, MPI_Comm comm,
                                         const std::string& descr);
@@ -136,13 +165,106 @@ namespace yask {
         }
     };
 
+    // Helpers for shared and huge-page malloc and free.
+    // Use like this:
+    // shared_ptr<char> p(hugeAlloc(nbytes, numa_pref, huge_pages), MmapDeleter(nbytes));
+    // 'nbytes' is updated to the mapped size.
+    extern char* hugeAlloc(std::size_t& nbytes, int numa_pref, int huge_pages);
+    struct MmapDeleter {
+        std::size_t _nbytes;
+        MmapDeleter(std::size_t nbytes): _nbytes(nbytes) {}
+        void operator()(char* p) {
+            if (p) {
+                munmap(p, _nbytes);
+                p = NULL;
+            }
+        }
+    };
+
+    // Allocate memory with MPI_Alloc_mem(), which may return memory
+    // registered with the fabric, aligned to a cache line.
+    // The memory is not freed after MPI_Finalize().
+    extern std::shared_ptr<char> shared_mpi_alloc(size_t sz);
+
+    // Helper for mapping a file as private memory.
+    // Use like this:
+    // shared_ptr<char> p(fileMap(fname, nbytes), MmapDeleter(nbytes));
+    extern char* fileMap(const std::string& fname, std::size_t nbytes);
+
+    // Helpers for staging memory through a scratch file.
+    // Use like this:
+    // int fd;
+    // shared_ptr<char> p(fileMapScratch(fname, nbytes, fd), FileMapDeleter(nbytes, fd));
+    // The file is removed when created, so its space is freed when unmapped.
+    // Pages of the map are written to the file when evicted.
+    extern char* fileMapScratch(const std::string& fname, std::size_t nbytes, int& fd);
+    struct FileMapDeleter {
+        std::size_t _nbytes;
+        int _fd;
+        FileMapDeleter(std::size_t nbytes, int fd): _nbytes(nbytes), _fd(fd) {}
+        void operator()(char* p) {
+            if (p) {
+                munmap(p, _nbytes);
+                p = NULL;
+            }
+            if (_fd >= 0) {
+                close(_fd);
+                _fd = -1;
+            }
+        }
+    };
+
+    // Start reading 'nbytes' at 'offset' in file 'fd' into the page cache.
+    extern void filePrefetch(int fd, std::size_t offset, std::size_t nbytes);
+
+    // Start writing the 'nbytes' at 'offset' in file 'fd', mapped at 'p',
+    // back to the file and unmap them from the process. The pages stay
+    // in the page cache until fileDrop() or eviction.
+    extern void fileWriteBehind(int fd, char* p, std::size_t offset, std::size_t nbytes);
+
+    // Drop clean pages of the 'nbytes' at 'offset' in file 'fd' from the page cache.
+    extern void fileDrop(int fd, std::size_t offset, std::size_t nbytes);
+
+    // Huge-page bytes resident in this process.
+    extern size_t getHugePageBytes();
+
+    // CPU the calling thread is running on, or -1 if unknown.
+    extern int getCpu();
+
+    // Return an ID of the physical core containing 'cpu' that is
+    // unique across packages, or -1 if unknown.
+    extern int getCpuCore(int cpu);
+
+    // Set 'coords[0..ndims-1]' to the point at distance 'h' along the
+    // Hilbert curve through a cube with 2^'nbits' points on a side.
+    // Used by loop code generated with the 'hilbert' modifier.
+    extern void getHilbertCoords(idx_t h, int nbits, int ndims, idx_t* coords);
+
     // Allocate NUMA memory from preferred node.
+    // Use huge pages if 'huge_pages' > 0.
     template<typename T>
-    std::shared_ptr<T> shared_numa_alloc(size_t sz, int numa_pref) {
+    std::shared_ptr<T> shared_numa_alloc(size_t sz, int numa_pref, int huge_pages = 0) {
+        if (huge_pages > 0) {
+            size_t nbytes = sz;
+            auto* p = hugeAlloc(nbytes, numa_pref, huge_pages);
+            return std::shared_ptr<T>(p, MmapDeleter(nbytes));
+        }
         auto _base = std::shared_ptr<T>(numaAlloc(sz, numa_pref), NumaDeleter(sz));
         return _base;
     }
 
+    // Allocate from a process-wide pool of released memory, keyed by
+    // size, NUMA preference, huge-page setting, and 'mpi_mem', which
+    // selects MPI_Alloc_mem(). When the last copy of the returned
+    // pointer is released, the memory goes back to the pool instead of
+    // being freed, so later solutions with the same sizes avoid the
+    // mmap and page-fault costs. Reused memory is not cleared.
+    extern std::shared_ptr<char> pool_alloc(size_t sz, int numa_pref,
+                                            int huge_pages, bool mpi_mem);
+
+    // Free all memory in the pool and return the number of bytes freed.
+    extern size_t clear_alloc_pool();
+
     // A class for maintaining elapsed time.
     class YaskTimer {
 
@@ -168,12 +290,12 @@ namespace yask {
         // pairs before calling get_elapsed_secs(), which
         // will return the cumulative time over all timed regions.
         virtual void start() {
-            clock_gettime(CLOCK_REALTIME, &_begin);
+            clock_gettime(CLOCK_MONOTONIC, &_begin);
         }
 
         // End a timed region.
         virtual void stop() {
-            clock_gettime(CLOCK_REALTIME, &_end);
+            clock_gettime(CLOCK_MONOTONIC, &_end);
 
             // Elapsed time is just end - begin times.
             _elapsed.tv_sec += _end.tv_sec - _begin.tv_sec;
@@ -189,7 +311,242 @@ namespace yask {
             return double(_elapsed.tv_sec) + double(_elapsed.tv_nsec) * 1e-9;
         }
     };
-    
+
+    // A lower-overhead timer for hot paths, e.g., in block loops.  It
+    // reads the time-stamp counter if the CPU has an invariant one and
+    // CLOCK_MONOTONIC otherwise. Ticks are converted to seconds with a
+    // rate calibrated against CLOCK_MONOTONIC the first time it is
+    // needed. Used like YaskTimer, but the methods are not virtual.
+    class YaskCycleTimer {
+        uint64_t _begin = 0, _elapsed = 0;
+
+        // Whether get_ticks() reads the TSC.
+        static const bool _use_tsc;
+
+    public:
+
+        // Current tick count.
+        static inline uint64_t get_ticks() {
+#ifdef USE_TSC_TIMER
+            if (_use_tsc) {
+                unsigned int aux;
+                return __rdtscp(&aux);
+            }
+#endif
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+        }
+
+        // Seconds per tick.
+        static double get_secs_per_tick();
+
+        void clear() {
+            _begin = _elapsed = 0;
+        }
+        void start() {
+            _begin = get_ticks();
+        }
+        void stop() {
+            _elapsed += get_ticks() - _begin;
+        }
+        uint64_t get_elapsed_ticks() const {
+            return _elapsed;
+        }
+        double get_elapsed_secs() const {
+            return double(_elapsed) * get_secs_per_tick();
+        }
+    };
+
+    // Hardware event counts for the calling thread from Linux
+    // perf_event_open(2). Each thread opens its own group of counters
+    // the first time it reads them. Only user-mode events are counted.
+    // Enabled by building with 'perf_events=1'; otherwise, or if the
+    // kernel does not provide the events, read() returns false.
+    class PerfCounters {
+    public:
+        enum Event {
+            perf_cycles,
+            perf_instrs,
+            perf_l2_misses,     // LLC references, i.e., L2 misses.
+            perf_dram_lines,    // LLC misses, i.e., lines from memory.
+            perf_num_events
+        };
+
+        // Name of an event in yk_stats. Memory lines are reported
+        // as bytes.
+        static const char* get_name(int ev);
+
+        // Read the current counts into 'vals'.
+        // Counts of events that could not be opened are zero.
+        static bool read(uint64_t vals[perf_num_events]);
+
+        // Adds the counts during its lifetime to 'sums'.
+        class Scope {
+            std::atomic<uint64_t>* _sums;
+            uint64_t _begin[perf_num_events];
+            bool _ok;
+
+        public:
+            Scope(std::atomic<uint64_t>* sums) :
+                _sums(sums) {
+                _ok = read(_begin);
+            }
+            ~Scope() {
+                uint64_t end[perf_num_events];
+                if (_ok && read(end))
+                    for (int i = 0; i < perf_num_events; i++)
+                        _sums[i].fetch_add(end[i] - _begin[i],
+                                           std::memory_order_relaxed);
+            }
+        };
+    };
+
+    // Recorder of begin and end events with time stamps for a timeline
+    // of a run. Each thread writes to its own ring buffer without locks,
+    // so only the latest events of a thread are kept if its buffer
+    // fills. Names are registered once with get_id(), so recording an
+    // event stores only its time, id, and phase. Nothing is recorded
+    // unless enabled.
+    class EventTrace {
+    public:
+        struct Event {
+            uint64_t ticks;     // from YaskCycleTimer::get_ticks().
+            int id;             // from get_id().
+            char phase;         // 'B' for begin or 'E' for end.
+        };
+
+    protected:
+        static bool _enabled;
+        static size_t _buf_events;
+
+        // Buffer of the calling thread, created on its first event.
+        static std::vector<Event>& get_buf(uint64_t*& num_events);
+
+    public:
+
+        // Start recording with 'buf_events' events per thread.
+        // Discards any events from a previous recording.
+        static void enable(size_t buf_events);
+        static void disable() { _enabled = false; }
+        static bool is_enabled() { return _enabled; }
+
+        // Return the id for 'name', adding it if new.
+        // Ids are kept for the life of the process.
+        static int get_id(const std::string& name);
+
+        static inline void record(int id, char phase) {
+            if (!_enabled || id < 0)
+                return;
+            uint64_t* np;
+            auto& buf = get_buf(np);
+            auto& e = buf[*np % buf.size()];
+            e.ticks = YaskCycleTimer::get_ticks();
+            e.id = id;
+            e.phase = phase;
+            (*np)++;
+        }
+        static inline void begin(int id) { record(id, 'B'); }
+        static inline void end(int id) { record(id, 'E'); }
+
+        // Write the events of all threads to 'fname' in the Chrome
+        // trace-event JSON format with 'pid' as the process id.
+        // Return false if the file cannot be written.
+        static bool write_chrome_json(const std::string& fname, int pid);
+
+        // Records a begin event now and an end event when destroyed.
+        class Scope {
+            int _id;
+
+        public:
+            Scope(int id) : _id(id) { begin(_id); }
+            ~Scope() { end(_id); }
+        };
+    };
+
+    // A work-stealing scheduler for the iterations [0, n) of a loop.
+    // Each thread starts with its own contiguous chunk of iterations and
+    // takes them from the front, so the generated path order (grouped,
+    // serpentine, etc.) is kept within a chunk. When its chunk is empty,
+    // a thread steals the back half of the nearest thread's chunk that
+    // still has work, so neighboring threads stay on neighboring blocks.
+    // Used by loop code generated with the 'steal' modifier.
+    class StealScheduler {
+
+        // Remaining iterations owned by one thread.
+        struct alignas(CACHELINE_BYTES) Chunk {
+            std::atomic_flag _lock = ATOMIC_FLAG_INIT;
+            idx_t _begin = 0, _end = 0;
+
+            void lock() {
+                while (_lock.test_and_set(std::memory_order_acquire))
+                    ;
+            }
+            void unlock() {
+                _lock.clear(std::memory_order_release);
+            }
+        };
+        std::vector<Chunk> _chunks;
+        int _nthreads;
+
+    public:
+        StealScheduler(idx_t niters, int nthreads) :
+            _chunks(std::max(nthreads, 1)),
+            _nthreads(std::max(nthreads, 1)) {
+            for (int i = 0; i < _nthreads; i++) {
+                _chunks[i]._begin = niters * i / _nthreads;
+                _chunks[i]._end = niters * (i + 1) / _nthreads;
+            }
+        }
+
+        // Set 'idx' to the next iteration for thread 'thr'.
+        // Returns false when no iterations remain anywhere.
+        bool next(int thr, idx_t& idx) {
+            thr %= _nthreads;
+
+            // Own chunk first.
+            auto& mine = _chunks[thr];
+            mine.lock();
+            if (mine._begin < mine._end) {
+                idx = mine._begin++;
+                mine.unlock();
+                return true;
+            }
+            mine.unlock();
+
+            // Steal from threads at increasing distance.
+            for (int d = 1; d < _nthreads; d++) {
+                for (int s = 0; s < 2; s++) {
+                    int vic = s ? thr + d : thr - d;
+                    if (vic < 0 || vic >= _nthreads)
+                        continue;
+                    auto& other = _chunks[vic];
+                    other.lock();
+                    idx_t nleft = other._end - other._begin;
+                    if (nleft <= 0) {
+                        other.unlock();
+                        continue;
+                    }
+
+                    // Take back half, or the last iteration.
+                    idx_t sbegin = other._end - (nleft + 1) / 2;
+                    idx_t send = other._end;
+                    other._end = sbegin;
+                    other.unlock();
+
+                    // Run first stolen iteration now and keep the rest.
+                    idx = sbegin;
+                    mine.lock();
+                    mine._begin = sbegin + 1;
+                    mine._end = send;
+                    mine.unlock();
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
     // A class to parse command-line args.
     class CommandLineParser {
 
@@ -290,6 +647,21 @@ namespace yask {
             virtual bool check_arg(std::vector<std::string>& args, int& argi);
         };
 
+        // An allowed string option.
+        class StringOption : public OptionBase {
+            std::string& _val;
+            
+        public:
+            StringOption(const std::string& name,
+                         const std::string& help_msg,
+                         std::string& val) :
+                OptionBase(name, help_msg), _val(val) { }
+
+            virtual void print_help(std::ostream& os,
+                                    int width) const;
+            virtual bool check_arg(std::vector<std::string>& args, int& argi);
+        };
+
         // An allowed idx_t option that sets multiple vars.
         class MultiIdxOption : public OptionBase {
             std::vector<idx_t*> _vals;
@@ -307,6 +679,23 @@ namespace yask {
             virtual bool check_arg(std::vector<std::string>& args, int& argi);
         };
 
+        // An allowed option that sets a list of idx_t vars.
+        class IdxListOption : public OptionBase {
+            std::vector<idx_t>& _vals;
+            
+        public:
+            IdxListOption(const std::string& name,
+                          const std::string& help_msg,
+                          std::vector<idx_t>& vals) :
+                OptionBase(name, help_msg), _vals(vals) {
+                _current_value_str = "Current values = ";
+            }
+
+            virtual void print_help(std::ostream& os,
+                                    int width) const;
+            virtual bool check_arg(std::vector<std::string>& args, int& argi);
+        };
+
     protected:
         std::map<std::string, OptionBase*> _opts;
         int _width;
@@ -52,6 +52,8 @@ typedef std::uint64_t uidx_t;
 // Standard C and C++ headers.
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
@@ -61,6 +63,7 @@ typedef std::uint64_t uidx_t;
 #include <limits.h>
 #include <malloc.h>
 #include <map>
+#include <mutex>
 #include <math.h>
 #include <set>
 #include <sstream>
@@ -70,14 +73,55 @@ typedef std::uint64_t uidx_t;
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <time.h>
+#include <tuple>
+#include <typeinfo>
 #include <vector>
 
 #ifndef WIN32
+#include <sched.h>
 #include <unistd.h>
 #include <stdint.h>
+#if defined(USE_INTRIN_SVE)
+#include <arm_sve.h>
+#elif defined(USE_INTRIN_NEON)
+#include <arm_neon.h>
+#else
 #include <immintrin.h>
 #endif
+#endif
+
+// Any ARM SIMD target.
+#if defined(USE_INTRIN_SVE) || defined(USE_INTRIN_NEON)
+#define USE_INTRIN_ARM
+#endif
+
+// Time-stamp counter for YaskCycleTimer.
+#if defined(__x86_64__) && !defined(NO_TSC_TIMER)
+#define USE_TSC_TIMER
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// OpenMP target offload of the sub-blocks.
+// The device accesses the grids and the stencil objects through the
+// host addresses, so the same yk_solution API and data are used.
+// This requires unified shared memory. Older g++ versions cannot
+// declare that, so 'YASK_OFFLOAD_IF' keeps the target regions on the
+// host with them.
+#if defined(USE_OFFLOAD) && (defined(__clang__) || !defined(__GNUC__) || __GNUC__ >= 13)
+#pragma omp requires unified_shared_memory
+#define YASK_OFFLOAD_IF
+#else
+#define YASK_OFFLOAD_IF if(target: 0)
+#endif
+
+// Hardware event counters for PerfCounters.
+#ifdef USE_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
 // Simple macros and stubs.
 
@@ -123,6 +167,8 @@ inline int omp_get_num_procs() { return 1; }
 inline int omp_get_num_threads() { return 1; }
 inline int omp_get_max_threads() { return 1; }
 inline int omp_get_thread_num() { return 0; }
+inline int omp_get_ancestor_thread_num(int level) { return 0; }
+inline int omp_get_level() { return 0; }
 inline void omp_set_num_threads(int n) { }
 inline void omp_set_nested(int n) { }
 #endif
@@ -198,8 +244,14 @@ inline void omp_set_nested(int n) { }
 #define INT3 asm volatile("int $3")
 
 // L1 and L2 hints
+// (On ARM, these are the locality args to __builtin_prefetch().)
+#ifdef USE_INTRIN_ARM
+#define L1_HINT 3
+#define L2_HINT 2
+#else
 #define L1_HINT _MM_HINT_T0
 #define L2_HINT _MM_HINT_T1
+#endif
 
 ////// Default prefetch distances.
 // These are only used if and when prefetch code is generated by
@@ -216,19 +268,63 @@ inline void omp_set_nested(int n) { }
  #define PFD_L2 0
 #endif
 
-// Set MODEL_CACHE to 1 or 2 to model L1 or L2.
+// Name of the target arch.
+#ifndef ARCH_NAME
+ #define ARCH_NAME "unknown"
+#endif
+
+// Kernel variants built with this library as 'arch:tag' strings
+// separated by spaces, and the dir of their libraries.
+#ifndef KERNEL_VARIANTS
+ #define KERNEL_VARIANTS ""
+#endif
+#ifndef KERNEL_LIB_DIR
+ #define KERNEL_LIB_DIR "."
+#endif
+
+// Checksum of the generated stencil code.
+#ifndef STENCIL_CODE_HASH
+ #define STENCIL_CODE_HASH ""
+#endif
+
+// Comma-separated names of the generated region-loop paths.
+#ifndef REGION_LOOP_PATHS
+ #define REGION_LOOP_PATHS "default"
+#endif
+
+// Set MODEL_CACHE to model the data caches.
 #ifdef MODEL_CACHE
 #include "cache_model.hpp"
-extern yask::Cache cache_model;
- #if MODEL_CACHE==L1
-  #warning Modeling L1 cache
- #elif MODEL_CACHE==L2
-  #warning Modeling L2 cache
- #else
-  #warning Modeling UNKNOWN cache
- #endif
+extern yask::CacheModel cache_model;
 #endif
 
+namespace yask {
+
+    // Prefetch, read, and write wrappers used by generated code.
+    // They also update the cache model if enabled.
+    template <int level>
+    ALWAYS_INLINE void prefetch(const void* p, int line) {
+        prefetch<level>(p);
+#ifdef MODEL_CACHE
+        cache_model.prefetch(p, level == L1_HINT ? 1 : 2, line);
+#endif
+    }
+    template <typename T>
+    ALWAYS_INLINE const T& read_ptr(const T* p, int line) {
+#ifdef MODEL_CACHE
+        cache_model.read(p, line);
+#endif
+        return *p;
+    }
+    template <typename T>
+    ALWAYS_INLINE T* write_ptr(T* p, bool nt, int line) {
+#ifdef MODEL_CACHE
+        cache_model.write(p, nt, line);
+#endif
+        return p;
+    }
+}
+
 #include "tuple.hpp"
 #include "settings.hpp"
 #include "generic_grids.hpp"
@@ -239,6 +335,9 @@ extern yask::Cache cache_model;
 #define FIRST_INDEX(dim) (0)
 #define LAST_INDEX(dim) (_context->overall_domain_sizes[#dim] - 1)
 
+// Min FD order at the indices of a sub-domain condition.
+#define MIN_ORDER(idxs) (_context->get_min_order(idxs))
+
 // Base types for stencil context, etc.
 #include "context.hpp"
 #include "stencil_calc.hpp"
@@ -44,6 +44,7 @@ IN THE SOFTWARE.
 %shared_ptr(yask::yk_solution)
 %shared_ptr(yask::yk_grid)
 %shared_ptr(yask::yk_stats)
+%shared_ptr(yask::yk_run_handle)
 
 // Mutable buffer to access raw data.
 %pybuffer_mutable_string(void* buffer_ptr)
@@ -56,6 +57,7 @@ IN THE SOFTWARE.
 // All vector types used in API.
 %template(vector_idx) std::vector<long int>;
 %template(vector_str) std::vector<std::string>;
+%template(vector_dbl) std::vector<double>;
 %template(vector_grid_ptr) std::vector<std::shared_ptr<yask::yk_grid>>;
 
 %exception {
@@ -67,7 +69,63 @@ IN THE SOFTWARE.
   }
 }
 
+// C++ function objects are not wrapped.
+%ignore yask::yk_step_callback;
+%ignore yask::yk_solution::add_step_callback;
+
 %include "yask_common_api.hpp"
 %include "yask_kernel_api.hpp"
 %include "yk_solution_api.hpp"
 %include "yk_grid_api.hpp"
+
+// NumPy support for grids.
+// NumPy is imported only when these are used.
+%extend yask::yk_grid {
+%pythoncode %{
+
+    @property
+    def __array_interface__(self):
+        """Describe the raw storage as a strided array for NumPy.
+
+        Allows a zero-copy view of the whole allocation via
+        'numpy.asarray(grid)' when get_raw_storage_stride() is non-zero in
+        every dim. Axes follow get_dim_names(), and index zero in each axis
+        is the first allocated index in that dim."""
+        if not self.is_storage_allocated():
+            raise AttributeError("storage not allocated for grid '" + self.get_name() + "'")
+        shape = []
+        strides = []
+        nbytes = self.get_element_bytes()
+        for dname in self.get_dim_names():
+            stride = self.get_raw_storage_stride(dname)
+            if stride == 0:
+                raise AttributeError("storage for grid '" + self.get_name() +
+                                     "' is not strided in dim '" + dname +
+                                     "'; use get_ndarray() to copy it")
+            shape.append(self.get_alloc_size(dname))
+            strides.append(stride * nbytes)
+        return { 'version': 3,
+                 'shape': tuple(shape),
+                 'strides': tuple(strides),
+                 'typestr': '<f' + str(nbytes),
+                 'data': (int(self.get_raw_storage_buffer()), False) }
+
+    def get_ndarray(self, first_indices, last_indices):
+        """Copy the elements from 'first_indices' to 'last_indices' into a
+        new C-ordered NumPy array with one axis per grid dim."""
+        import numpy
+        shape = [last - first + 1 for first, last in zip(first_indices, last_indices)]
+        dtype = numpy.float32 if self.get_element_bytes() == 4 else numpy.float64
+        ndarray = numpy.empty(shape, dtype, 'C')
+        self.get_elements_in_slice(ndarray.data, first_indices, last_indices)
+        return ndarray
+
+    def set_ndarray(self, ndarray, first_indices, last_indices):
+        """Copy the elements of a NumPy array into the grid from
+        'first_indices' to 'last_indices'."""
+        import numpy
+        dtype = numpy.float32 if self.get_element_bytes() == 4 else numpy.float64
+        ndarray = numpy.ascontiguousarray(ndarray, dtype)
+        return self.set_elements_in_slice(ndarray.data, first_indices, last_indices)
+%}
+};
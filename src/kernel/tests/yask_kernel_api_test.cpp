@@ -30,6 +30,7 @@ IN THE SOFTWARE.
 #include <iostream>
 #include <vector>
 #include <set>
+#include <cstdlib>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -37,7 +38,11 @@ IN THE SOFTWARE.
 using namespace std;
 using namespace yask;
 
-int main() {
+// If a file of stencil code from yc_solution::format() is given,
+// a solution is also built from it at run time.
+// If YK_API_TEST_VARIANTS is set to 1, a kernel variant built with
+// the library must be chosen for the settings of the test.
+int main(int argc, char** argv) {
 
     // The factory from which all other kernel objects are made.
     yk_factory kfac;
@@ -221,7 +226,89 @@ int main() {
         os << "Running the solution for 10 more steps...\n";
         soln->run_solution(1, 10);
 
+        // Prepare again after changing settings. Grids keep their
+        // storage unless their allocation sizes change.
+        auto grid0 = soln->get_grids().front();
+        auto raw0 = grid0->get_raw_storage_buffer();
+        for (auto dim_name : soln->get_domain_dim_names())
+            soln->set_block_size(dim_name, 16);
+        os << "Preparing the solution again with new block sizes...\n";
+        soln->prepare_solution();
+        assert(grid0->get_raw_storage_buffer() == raw0);
+        soln->run_solution(11, 12);
+        for (auto dim_name : soln->get_domain_dim_names())
+            soln->set_rank_domain_size(dim_name, 64);
+        os << "Preparing the solution again with new rank-domain sizes...\n";
+        soln->prepare_solution();
+        assert(grid0->is_storage_allocated());
+        soln->run_solution(13, 14);
+
+        // Run in the background and read a grid at a safe point.
+        os << "Running the solution asynchronously for 4 more steps...\n";
+        auto run = soln->run_solution_async(15, 18);
+        if (run->pause_after_step(16)) {
+            idx_t last_t = run->get_last_step_done();
+            os << "  paused after step " << last_t << ".\n";
+            assert(last_t >= 16);
+            vector<idx_t> idxs;
+            for (auto dname : grid0->get_dim_names()) {
+                if (dname == soln->get_step_dim_name())
+                    idxs.push_back(last_t);
+                else if (domain_dim_set.count(dname))
+                    idxs.push_back(grid0->get_first_rank_domain_index(dname));
+                else
+                    idxs.push_back(grid0->get_first_misc_index(dname));
+            }
+            os << "  first element == " << grid0->get_element(idxs) << ".\n";
+            run->resume();
+        }
+        run->wait();
+        assert(run->test());
+        assert(run->get_last_step_done() == 18);
+
+        // Choose a kernel variant for the current settings.
+        {
+            auto src = kfac.new_solution(env, soln);
+            auto vsoln = kfac.new_variant_solution(env, src);
+            os << "Chose kernel for '" << vsoln->get_target() << "' with cluster size";
+            for (auto dname : vsoln->get_domain_dim_names())
+                os << " " << dname << "=" << vsoln->get_cluster_size(dname);
+            os << ".\n";
+            auto expect = getenv("YK_API_TEST_VARIANTS");
+            if (expect && atoi(expect))
+                assert(vsoln != src);
+            vsoln->prepare_solution();
+            vsoln->run_solution(0, 1);
+            vsoln->end_solution();
+        }
+
+        // Drop a solution while its asynchronous run is paused.
+        // The run is resumed and finished before the solution is destroyed.
+        {
+            os << "Dropping a solution during an asynchronous run...\n";
+            auto soln2 = kfac.new_solution(env, soln);
+            soln2->prepare_solution();
+            auto run2 = soln2->run_solution_async(0, 3);
+            run2->pause_after_step(1);
+            soln2.reset();
+            assert(run2->test());
+            assert(run2->get_last_step_done() == 3);
+        }
+
         soln->end_solution();
+
+        // Make a solution from the code at run time.
+        if (argc > 1) {
+            os << "Building a solution from '" << argv[1] << "'...\n";
+            auto jsoln = kfac.new_jit_solution(env, argv[1]);
+            assert(jsoln->get_name() == name);
+            for (auto dim_name : jsoln->get_domain_dim_names())
+                jsoln->set_rank_domain_size(dim_name, 32);
+            jsoln->set_num_ranks(ddim1, env->get_num_ranks());
+            jsoln->prepare_solution();
+            jsoln->run_solution(0, 1);
+            jsoln->end_solution();
+        }
     
         os << "End of YASK kernel API test.\n";
         return 0;
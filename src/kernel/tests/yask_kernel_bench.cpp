@@ -0,0 +1,296 @@
+/*****************************************************************************
+
+YASK: Yet Another Stencil Kernel
+Copyright (c) 2014-2018, Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+*****************************************************************************/
+
+// Microbenchmarks for pieces of the YASK kernel in isolation.
+// Each one is repeated until it runs for at least '-min_secs', and the
+// results are written to stdout in the JSON format of Google Benchmark,
+// so they can be compared across versions with its tools.
+// This must be compiled with a kernel lib containing at least one grid
+// with all the domain dims.
+
+#include "yask.hpp"
+using namespace std;
+using namespace yask;
+
+// Auto-generated stencil code that extends base types.
+#define DEFINE_CONTEXT
+#include "yask_stencil_code.hpp"
+
+// Keep the compiler from removing the computation of 'val'.
+template <typename T>
+inline void keep(const T& val) {
+    asm volatile("" : : "g"(&val) : "memory");
+}
+
+// Runs the benchmarks and collects the results.
+class Bench {
+    double _min_secs;
+    string _filter;
+    vector<string> _results;
+
+public:
+    Bench(double min_secs, const string& filter) :
+        _min_secs(min_secs), _filter(filter) { }
+
+    // Time 'fn', which processes 'items' items per call.
+    void run(const string& name, idx_t items,
+             const function<void ()>& fn) {
+        if (_filter.length() && name.find(_filter) == string::npos)
+            return;
+
+        // Double the iterations until the min time is reached, then
+        // scale them up to it.
+        fn();
+        idx_t niters = 1;
+        double secs = 0.;
+        while (true) {
+            YaskTimer timer;
+            timer.start();
+            for (idx_t i = 0; i < niters; i++)
+                fn();
+            timer.stop();
+            secs = timer.get_elapsed_secs();
+            if (secs >= _min_secs)
+                break;
+            idx_t next = niters * 2;
+            if (secs > 0.)
+                next = max(next, idx_t(niters * _min_secs * 1.2 / secs));
+            niters = next;
+        }
+        double ns = secs * 1e9 / niters;
+        ostringstream oss;
+        oss << "    {\n"
+            "      \"name\": \"" << name << "\",\n"
+            "      \"iterations\": " << niters << ",\n"
+            "      \"real_time\": " << ns << ",\n"
+            "      \"cpu_time\": " << ns << ",\n"
+            "      \"time_unit\": \"ns\",\n"
+            "      \"items_per_second\": " << (double(items) * niters / secs) << "\n"
+            "    }";
+        _results.push_back(oss.str());
+        cerr << name << ": " << ns << " ns" << endl;
+    }
+
+    // Write all results.
+    void print(ostream& os, int nthreads) const {
+        time_t now = time(0);
+        char date[64];
+        strftime(date, sizeof(date), "%FT%T", localtime(&now));
+        os << "{\n"
+            "  \"context\": {\n"
+            "    \"date\": \"" << date << "\",\n"
+            "    \"stencil\": \"" YASK_STENCIL_NAME "\",\n"
+            "    \"arch\": \"" ARCH_NAME "\",\n"
+            "    \"real_bytes\": " << REAL_BYTES << ",\n"
+            "    \"vlen\": " << VLEN << ",\n"
+            "    \"num_threads\": " << nthreads << "\n"
+            "  },\n"
+            "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < _results.size(); i++)
+            os << _results[i] << (i + 1 < _results.size() ? ",\n" : "\n");
+        os << "  ]\n}\n";
+    }
+};
+
+int main(int argc, char** argv) {
+    double min_secs = 0.2;
+    string filter;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-min_secs" && i + 1 < argc)
+            min_secs = atof(argv[++i]);
+        else if (arg == "-filter" && i + 1 < argc)
+            filter = argv[++i];
+        else {
+            cerr << "usage: " << argv[0] << " [-min_secs <secs>] [-filter <substring>]\n";
+            return 1;
+        }
+    }
+    Bench bench(min_secs, filter);
+
+    try {
+
+        // Bootstrap factory from kernel API.
+        yk_factory kfac;
+        yask_output_factory ofac;
+        auto kenv = kfac.new_env();
+        auto ksoln = kfac.new_solution(kenv);
+        auto context = dynamic_pointer_cast<StencilContext>(ksoln);
+        assert(context.get());
+        ksoln->set_debug_output(ofac.new_null_output());
+
+        // A small domain; the pieces are timed, not the whole solution.
+        for (auto dname : ksoln->get_domain_dim_names())
+            ksoln->set_rank_domain_size(dname, 64);
+        ksoln->prepare_solution();
+        auto ddims = ksoln->get_domain_dim_names();
+        int nddims = ddims.size();
+        idx_t npts = 1;
+        for (auto& dname : ddims)
+            npts *= ksoln->get_rank_domain_size(dname);
+
+        // Vector loads and the shifts used by the generated code to
+        // make unaligned vectors from aligned ones.
+        {
+            const int nvecs = 1024;
+            shared_ptr<char> vp(alignedAlloc(sizeof(real_vec_t) * (nvecs + 1)), AlignedDeleter());
+            real_vec_t* vecs = (real_vec_t*)vp.get();
+            for (int i = 0; i <= nvecs; i++)
+                vecs[i] = real_vec_t(1.0);
+            bench.run("real_vec_t/loadUnalignedFrom", nvecs, [&]() {
+                    real_vec_t sum(0.0), v;
+                    for (int i = 0; i < nvecs; i++) {
+                        v.loadUnalignedFrom((const real_vec_t*)((const real_t*)&vecs[i] + VLEN / 2));
+                        sum = sum + v;
+                    }
+                    keep(sum);
+                });
+#if VLEN > 1
+            bench.run("real_vec_t/real_vec_align<1>", nvecs, [&]() {
+                    real_vec_t sum(0.0), v;
+                    for (int i = 0; i < nvecs; i++) {
+                        real_vec_align<1>(v, vecs[i + 1], vecs[i]);
+                        sum = sum + v;
+                    }
+                    keep(sum);
+                });
+#endif
+        }
+
+        // A grid with all the domain dims.
+        YkGridPtr gp;
+        for (auto g : context->gridPtrs) {
+            bool all = g && !g->is_scratch();
+            for (auto& dname : ddims)
+                all = all && g->is_dim_used(dname);
+            if (all) {
+                gp = g;
+                break;
+            }
+        }
+        if (!gp)
+            THROW_YASK_EXCEPTION("Error: no grid with all the domain dims");
+        int ngdims = gp->get_num_dims();
+        Indices first(ngdims), last(ngdims);
+        for (int i = 0; i < ngdims; i++)
+            first[i] = last[i] = gp->_get_first_alloc_index(i);
+        for (auto& dname : ddims) {
+            int posn = gp->get_dim_posn(dname);
+            first[posn] = gp->get_first_rank_domain_index(posn);
+            last[posn] = gp->get_last_rank_domain_index(posn);
+        }
+        shared_ptr<char> bp(alignedAlloc(sizeof(real_t) * gp->get_num_storage_elements()),
+                            AlignedDeleter());
+        real_t* buf = (real_t*)bp.get();
+
+        // Halo pack and unpack of a face in each domain dim, with the
+        // width rounded up to whole vectors like the vector exchanges.
+        for (auto& dname : ddims) {
+            int posn = gp->get_dim_posn(dname);
+            Indices ffirst(first), flast(last);
+            idx_t width = ROUND_UP(max(gp->get_left_halo_size(posn), idx_t(1)),
+                                   gp->_get_vec_len(posn));
+            flast[posn] = ffirst[posn] + width - 1;
+            idx_t nelems = flast.subElements(ffirst).addConst(1).product();
+            bench.run("halo/pack/" + dname, nelems, [&]() {
+                    keep(gp->get_vecs_in_slice(buf, ffirst, flast));
+                });
+            bench.run("halo/unpack/" + dname, nelems, [&]() {
+                    keep(gp->set_vecs_in_slice(buf, ffirst, flast));
+                });
+        }
+
+        // Element copies of the whole rank domain.
+        bench.run("grid/get_elements_in_slice", npts, [&]() {
+                keep(gp->get_elements_in_slice(buf, first, last));
+            });
+
+        // Layout index math for each point of the rank domain.
+        {
+            idx_t alloc_step = gp->get_alloc_step_index(first);
+            Indices pt(first);
+            bench.run("grid/getElemPtr", npts, [&]() {
+                    const real_t* p = 0;
+                    int inner = ngdims - 1;
+                    pt = first;
+                    while (true) {
+                        p = gp->getElemPtr(pt, alloc_step, false);
+                        keep(p);
+                        int i = inner;
+                        while (i >= 0 && pt[i] >= last[i]) {
+                            pt[i] = first[i];
+                            i--;
+                        }
+                        if (i < 0)
+                            break;
+                        pt[i]++;
+                    }
+                });
+        }
+
+        // Bounding boxes of each bundle.
+        bench.run("bundle/find_bounding_box", npts * context->stBundles.size(), [&]() {
+                for (auto* sb : context->stBundles)
+                    sb->find_bounding_box();
+            });
+
+        // Index tuples.
+        {
+            Indices a(first), b(last);
+            bench.run("Indices/addElements", 1, [&]() {
+                    keep(a.addElements(b));
+                });
+            bench.run("Indices/product", 1, [&]() {
+                    keep(b.product());
+                });
+            IdxTuple ta, tb;
+            for (auto& dname : ddims) {
+                ta.addDimBack(dname, 3);
+                tb.addDimBack(dname, ksoln->get_rank_domain_size(dname));
+            }
+            auto& dlast = ddims.at(nddims - 1);
+            bench.run("IdxTuple/addElements", 1, [&]() {
+                    keep(ta.addElements(tb));
+                });
+            bench.run("IdxTuple/getVal(name)", 1, [&]() {
+                    keep(tb.getVal(dlast));
+                });
+            bench.run("IdxTuple/layout", 1, [&]() {
+                    keep(tb.layout(ta));
+                });
+            bench.run("IdxTuple/unlayout", 1, [&]() {
+                    keep(tb.unlayout(npts / 3));
+                });
+        }
+
+        bench.print(cout, omp_get_max_threads());
+        ksoln->end_solution();
+    }
+    catch (yask_exception& e) {
+        cerr << "YASK kernel benchmark: " << e.get_message() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -26,6 +26,7 @@ IN THE SOFTWARE.
 // This code implements the YASK stand-alone performance-measurement tool.
 
 #include "yask.hpp"
+#include <random>
 using namespace std;
 using namespace yask;
 
@@ -43,8 +44,13 @@ struct AppSettings : public KernelSettings {
     int step_alloc = 0;         // if >0, override number of steps to alloc.
     int num_trials = 3;         // number of trials.
     bool validate = false;      // whether to do validation run.
+    int validate_samples = 0;   // if >0, validate only this many random boxes.
+    int validate_box = 8;       // size of each sampled box in each domain dim.
+    int validate_seed = 1;      // seed for choosing sampled boxes.
     int pre_trial_sleep_time = 1; // sec to sleep before each trial.
     int debug_sleep = 0;          // sec to sleep for debug attach.
+    int peak_mem_bw = 0;          // if >0, peak memory BW in GB/s for roofline.
+    int peak_gflops = 0;          // if >0, peak GFLOPS for roofline.
 
     AppSettings(DimsPtr dims, KernelEnvPtr env) :
         KernelSettings(dims, env) { }
@@ -137,10 +143,37 @@ struct AppSettings : public KernelSettings {
                           ("debug_sleep",
                            "Number of seconds to sleep for debug attach.",
                            debug_sleep));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("peak_mem_bw",
+                           "Peak memory bandwidth of the machine in GB/s. "
+                           "If >0 and both peaks are set, the percentage of the roofline "
+                           "achieved is reported when hardware counts are available.",
+                           peak_mem_bw));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("peak_gflops",
+                           "Peak floating-point throughput of the machine in GFLOPS. "
+                           "See '-peak_mem_bw'.",
+                           peak_gflops));
         parser.add_option(new CommandLineParser::BoolOption
                           ("validate",
                            "Run validation iteration(s) after performance trial(s).",
                            validate));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("validate_samples",
+                           "If >0, validate only this many randomly-placed boxes in each rank "
+                           "instead of the whole domain. "
+                           "The reference for each box is computed from its dependency cone over "
+                           "all the steps, so this is suitable for large problems. "
+                           "Enables '-validate'.",
+                           validate_samples));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("validate_box",
+                           "Size of each box used by '-validate_samples' in each domain dimension.",
+                           validate_box));
+        parser.add_option(new CommandLineParser::IntOption
+                          ("validate_seed",
+                           "Random seed for placing the boxes used by '-validate_samples'.",
+                           validate_seed));
         parser.add_option(new ValOption(*this));
         
         // Tokenize default args.
@@ -150,11 +183,14 @@ struct AppSettings : public KernelSettings {
         // Parse cmd-line options, which sets values.
         // Any remaining strings will be left in args.
         parser.parse_args(argc, argv, args);
+        if (validate_samples > 0)
+            validate = true;
 
         if (help) {
             string appNotes =
                 "Validation is very slow and uses 2x memory,\n"
-                " so run with very small sizes and number of time-steps.\n"
+                " so run with very small sizes and number of time-steps\n"
+                " or use '-validate_samples' to check only parts of the domain.\n"
                 " If validation fails, it may be due to rounding error;\n"
                 "  try building with 8-byte reals.\n";
             vector<string> appExamples;
@@ -222,6 +258,109 @@ void alloc_steps(yk_solution_ptr soln, const AppSettings& opts) {
     }
 }
 
+// A box checked by sampled validation and the sub-domain solution
+// that computes its reference values.
+struct SampleBox {
+    IdxTuple first, last;       // global domain indices, inclusive.
+    yk_solution_ptr soln;
+};
+
+// Make a reference solution for each of 'opts.validate_samples' random
+// boxes in this rank. Each solution covers a box plus its dependency
+// cone over all the steps, runs on this rank only, and is loaded with
+// the current data from 'context', which must be in its initial state.
+vector<SampleBox> make_sample_boxes(yk_factory& kfac,
+                                    KernelEnvPtr ep,
+                                    yk_solution_ptr ksoln,
+                                    const AppSettings& opts) {
+    auto context = dynamic_pointer_cast<StencilContext>(ksoln);
+    assert(context.get());
+    ostream& os = context->get_ostr();
+    auto& step_dim = opts._dims->_step_dim;
+    idx_t dt = opts._rank_sizes[step_dim];
+    idx_t npacks = context->stPacks.size();
+
+    // Single-rank env for the sub-domain solutions.
+    auto sub_env = make_shared<KernelEnv>(*ep);
+#ifdef USE_MPI
+    sub_env->comm = MPI_COMM_SELF;
+    sub_env->shm_comm = MPI_COMM_SELF;
+#endif
+    sub_env->num_ranks = sub_env->num_shm_ranks = 1;
+    sub_env->my_rank = sub_env->my_shm_rank = 0;
+
+    // Find where the boxes may be placed. A cone may only cross a rank
+    // boundary at the edge of the overall domain because the initial
+    // data is not available from other ranks.
+    auto& bb = context->rank_bb;
+    auto& overall = context->overall_domain_sizes;
+    IdxTuple reach(opts._dims->_domain_dims), bsize(reach), lo(reach), hi(reach);
+    for (auto dim : opts._dims->_domain_dims.getDims()) {
+        auto& dname = dim.getName();
+        reach[dname] = dt * npacks * context->max_halos[dname];
+        lo[dname] = bb.bb_begin[dname] + ((bb.bb_begin[dname] > 0) ? reach[dname] : 0);
+        hi[dname] = bb.bb_end[dname] - ((bb.bb_end[dname] < overall[dname]) ? reach[dname] : 0);
+        bsize[dname] = min(idx_t(opts.validate_box), hi[dname] - lo[dname]);
+        if (bsize[dname] < 1)
+            FORMAT_AND_THROW_YASK_EXCEPTION("Error: rank domain is too small in '" << dname <<
+                                            "' for sampled validation with a dependency reach of " <<
+                                            reach[dname] << "; use '-validate' instead");
+    }
+    os << "Sampling " << opts.validate_samples << " box(es) of size " <<
+        bsize.makeDimValStr(" * ") << " with a dependency reach of " <<
+        reach.makeDimValStr() << "...\n" << flush;
+
+    mt19937 rng(opts.validate_seed + ep->my_rank);
+    vector<SampleBox> boxes;
+    for (int i = 0; i < opts.validate_samples; i++) {
+        SampleBox box;
+        box.first = lo;
+        box.last = lo;
+        IdxTuple cone_first(lo), cone_size(lo);
+        for (auto dim : opts._dims->_domain_dims.getDims()) {
+            auto& dname = dim.getName();
+            uniform_int_distribution<idx_t> dist(lo[dname], hi[dname] - bsize[dname]);
+            box.first[dname] = dist(rng);
+            box.last[dname] = box.first[dname] + bsize[dname] - 1;
+            cone_first[dname] = max(box.first[dname] - reach[dname], idx_t(0));
+            idx_t cone_end = min(box.last[dname] + 1 + reach[dname], overall[dname]);
+            cone_size[dname] = cone_end - cone_first[dname];
+        }
+
+        // Make a solution over the cone at its global location.
+        box.soln = kfac.new_solution(sub_env, ksoln);
+        auto ref_context = dynamic_pointer_cast<StencilContext>(box.soln);
+        assert(ref_context.get());
+        auto ref_opts = ref_context->get_settings();
+        ref_context->name += "-sample-" + to_string(i);
+        ref_context->allow_vec_exchange = false;
+        ref_context->set_debug_output(yask_output_factory().new_null_output());
+        for (auto dim : opts._dims->_domain_dims.getDims()) {
+            auto& dname = dim.getName();
+            ref_opts->_rank_sizes[dname] = cone_size[dname];
+            ref_opts->_num_ranks[dname] = 1;
+            ref_opts->_rank_indices[dname] = 0;
+        }
+        ref_opts->_sub_domain_offsets = cone_first;
+        ref_opts->_sub_domain_overall_sizes = overall;
+        ref_opts->_rank_splits.clear();
+        ref_opts->_balance_steps = 0;
+        ref_opts->_numa_parts = 1;
+        ref_opts->_measure_mem_bw = false;
+        ref_opts->_at_cache_file.clear();
+        ref_opts->_bb_cache_dir.clear();
+        ref_opts->_rank_stats_file.clear();
+        ref_opts->_trace_file.clear();
+        alloc_steps(box.soln, opts);
+        box.soln->prepare_solution();
+
+        // Load the initial state.
+        context->copyData(*ref_context);
+        boxes.push_back(box);
+    }
+    return boxes;
+}
+
 // Parse command-line args, run kernel, run validation if requested.
 int main(int argc, char** argv)
 {
@@ -301,10 +440,22 @@ int main(int argc, char** argv)
 
         // variables for measuring performance.
         double best_elapsed_time=0., best_apps=0., best_dpps=0., best_flops=0.;
+        double best_mem_bw=0., best_ai=0.;
 
         /////// Performance run(s).
         auto& step_dim = opts->_dims->_step_dim;
         idx_t dt = opts->_rank_sizes[step_dim];
+
+        // Capture the initial state of the sampled boxes. Every trial
+        // starts from the same state, so it is saved only once.
+        vector<SampleBox> sample_boxes;
+        if (opts->validate_samples > 0) {
+            os << endl << divLine <<
+                "Setup for sampled validation...\n";
+            context->initDiff();
+            sample_boxes = make_sample_boxes(kfac, ep, ksoln, *opts);
+        }
+
         os << endl << divLine <<
             "Running " << opts->num_trials << " performance trial(s) of " <<
             dt << " step(s) each...\n" << flush;
@@ -345,6 +496,8 @@ int main(int argc, char** argv)
                 best_apps = context->writes_ps;
                 best_flops = context->flops;
                 best_elapsed_time = stats->get_elapsed_run_secs();
+                best_mem_bw = context->mem_bw;
+                best_ai = context->arith_intensity;
             }
         }
         
@@ -352,7 +505,26 @@ int main(int argc, char** argv)
             "best-elapsed-time (sec):           " << makeNumStr(best_elapsed_time) << endl <<
             "best-throughput (num-writes/sec):  " << makeNumStr(best_apps) << endl <<
             "best-throughput (est-FLOPS):       " << makeNumStr(best_flops) << endl <<
-            "best-throughput (num-points/sec):  " << makeNumStr(best_dpps) << endl <<
+            "best-throughput (num-points/sec):  " << makeNumStr(best_dpps) << endl;
+        if (context->attainable_pts_ps > 0.)
+            os <<
+                "best-pct-of-attainable:            " <<
+                (100. * best_dpps / context->attainable_pts_ps) << "%" << endl;
+        if (best_mem_bw > 0.) {
+            os <<
+                "best-est-mem-bw (bytes/sec):       " << makeNumStr(best_mem_bw) << endl <<
+                "best-est-arith-int (FLOPs/byte):   " << best_ai << endl;
+
+            // Roofline is limited by either memory BW or FP throughput.
+            if (opts->peak_mem_bw > 0 && opts->peak_gflops > 0) {
+                double roof = min(best_ai * opts->peak_mem_bw, double(opts->peak_gflops)) * 1e9;
+                os << "best-pct-of-roofline:              " <<
+                    (100. * best_flops / roof) << "%" <<
+                    ((best_ai * opts->peak_mem_bw < opts->peak_gflops) ?
+                     " (memory-bound)" : " (compute-bound)") << endl;
+            }
+        }
+        os <<
             divLine <<
             "Notes:\n"
             " Num-writes/sec and FLOPS are metrics based on certain\n"
@@ -364,7 +536,31 @@ int main(int argc, char** argv)
 
         /////// Validation run.
         bool ok = true;
-        if (opts->validate) {
+        if (opts->validate_samples > 0) {
+            os << endl << divLine <<
+                "Running " << dt << " step(s) for sampled validation...\n" << flush;
+            idx_t errs = 0;
+            for (auto& box : sample_boxes) {
+                auto ref_context = dynamic_pointer_cast<StencilContext>(box.soln);
+                ref_context->calc_rank_ref();
+                errs += context->compareData(*ref_context, box.first, box.last);
+
+                // Reference stats are not needed.
+                ref_context->clear_timers();
+                box.soln->end_solution();
+            }
+            auto ri = kenv->get_rank_index();
+            if( errs == 0 ) {
+                os << "TEST PASSED on rank " << ri << " in " <<
+                    sample_boxes.size() << " sampled box(es).\n" << flush;
+            } else {
+                cerr << "TEST FAILED on rank " << ri << ": >= " << errs << " mismatch(es).\n" << flush;
+                if (REAL_BYTES < 8)
+                    cerr << "This is not uncommon for low-precision FP; try with 8-byte reals." << endl;
+                ok = false;
+            }
+        }
+        else if (opts->validate) {
             kenv->global_barrier();
             os << endl << divLine <<
                 "Setup for validation...\n";
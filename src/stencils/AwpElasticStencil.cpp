@@ -113,8 +113,8 @@ protected:
     
 public:
 
-    AwpElasticStencil(StencilList& stencils) :
-        StencilBase("awp_elastic", stencils) { }
+    AwpElasticStencil(StencilList& stencils, string suffix="") :
+        StencilBase("awp_elastic" + suffix, stencils) { }
 
     // Adjustment for sponge layer.
     void adjust_for_sponge(GridValue& val) {
@@ -456,6 +456,21 @@ public:
 
 REGISTER_STENCIL(AwpElasticStencil);
 
+// Store the read-only Lame' coefficients as indices into lookup tables.
+// Layered earth models have few distinct values, so each element needs
+// only two bytes instead of a full real.
+class AwpElasticLutStencil : public AwpElasticStencil {
+public:
+    AwpElasticLutStencil(StencilList& stencils) :
+        AwpElasticStencil(stencils, "_lut") {
+        lambda.set_storage_precision("lut16");
+        rho.set_storage_precision("lut16");
+        mu.set_storage_precision("lut16");
+    }
+};
+
+REGISTER_STENCIL(AwpElasticLutStencil);
+
 #undef DO_SURFACE
 #undef FULL_SPONGE_GRID
 #undef USE_SCRATCH_GRIDS
@@ -27,6 +27,7 @@ IN THE SOFTWARE.
 // space (where n = 2 * radius) and 2nd-order accurate in time.
 
 #include "Soln.hpp"
+#include "fd_coeff.hpp"
 
 class Iso3dfdStencil : public StencilRadiusBase {
 
@@ -138,3 +139,86 @@ public:
 };
 
 REGISTER_STENCIL(Iso3dfdSpongeStencil);
+
+// Store the read-only velocity model in bfloat16 to halve its memory
+// traffic. Calculations are still done at full precision.
+class Iso3dfdBf16Stencil : public Iso3dfdStencil {
+public:
+    Iso3dfdBf16Stencil(StencilList& stencils, int radius=8) :
+        Iso3dfdStencil(stencils, "_bf16", radius) {
+        vel.set_storage_precision("bf16");
+    }
+    virtual ~Iso3dfdBf16Stencil() { }
+};
+
+REGISTER_STENCIL(Iso3dfdBf16Stencil);
+
+// Use a lower-order stencil where the run-time order map allows it, e.g.,
+// near absorbing boundaries or in low-velocity zones. An equation is made
+// for each radius r = radius, radius/2, ..., 1 with central coefficients
+// from fd_coeff(). Each one is valid where the min order at a point is
+// more than that of the next-lower radius and no more than 2*r, so the
+// full radius is used where no lower order is allowed.
+class Iso3dfdVarStencil : public StencilRadiusBase {
+
+protected:
+
+    // Indices & dimensions.
+    MAKE_STEP_INDEX(t);           // step in time dim.
+    MAKE_DOMAIN_INDEX(x);         // spatial dim.
+    MAKE_DOMAIN_INDEX(y);         // spatial dim.
+    MAKE_DOMAIN_INDEX(z);         // spatial dim.
+
+    // Grids.
+    MAKE_GRID(pressure, t, x, y, z); // time-varying 3D pressure grid.
+    MAKE_GRID(vel, x, y, z);         // constant 3D vel grid.
+
+public:
+
+    // The coefficients are for unit grid spacing, so the 'vel' grid
+    // should contain (v * dt / h)^2.
+    Iso3dfdVarStencil(StencilList& stencils, int radius=8) :
+        StencilRadiusBase("iso3dfd_var", stencils, radius) { }
+    virtual ~Iso3dfdVarStencil() { }
+
+    // Define RHS expression for pressure at t+1 using radius 'r'.
+    virtual GridValue get_next_p(int r) {
+
+        // Coefficients of the 2nd derivative at the center point.
+        vector<float> pts, coeffs(2 * r + 1);
+        for (int i = -r; i <= r; i++)
+            pts.push_back(i);
+        fd_coeff(coeffs.data(), 0.f, 2, pts.data(), pts.size());
+
+        // Laplacian: the center coefficient is used for each axis.
+        GridValue lap = pressure(t, x, y, z) * (3.0 * coeffs[r]);
+        for (int i = 1; i <= r; i++)
+            lap += (pressure(t, x-i, y, z) + pressure(t, x+i, y, z) +
+                    pressure(t, x, y-i, z) + pressure(t, x, y+i, z) +
+                    pressure(t, x, y, z-i) + pressure(t, x, y, z+i)) * coeffs[r + i];
+
+        return (2.0 * pressure(t, x, y, z))
+            - pressure(t-1, x, y, z)
+            + (lap * vel(x, y, z));
+    }
+
+    virtual void define() {
+
+        // Radii from lowest to highest.
+        vector<int> radii;
+        for (int r = _radius; r > 0; r /= 2)
+            radii.insert(radii.begin(), r);
+
+        int lower = 0;
+        for (size_t i = 0; i < radii.size(); i++) {
+            int r = radii[i];
+            Condition in_order = min_order() > constNum(2 * lower);
+            if (i + 1 < radii.size())
+                in_order = in_order && min_order() <= constNum(2 * r);
+            pressure(t+1, x, y, z) EQUALS get_next_p(r) IF in_order;
+            lower = r;
+        }
+    }
+};
+
+REGISTER_STENCIL(Iso3dfdVarStencil);
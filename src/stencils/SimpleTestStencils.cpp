@@ -368,6 +368,50 @@ public:
 
 REGISTER_STENCIL(TestSubdomainStencil1);
 
+// Test a sub-domain with a hole: a shell around the domain
+// like an absorbing boundary layer.
+class TestSubdomainStencil2 : public StencilRadiusBase {
+
+protected:
+
+    // Indices & dimensions.
+    MAKE_STEP_INDEX(t);           // step in time dim.
+    MAKE_DOMAIN_INDEX(x);         // spatial dim.
+    MAKE_DOMAIN_INDEX(y);         // spatial dim.
+    MAKE_DOMAIN_INDEX(z);         // spatial dim.
+
+    // Vars.
+    MAKE_GRID(data, t, x, y, z); // time-varying grid.
+
+    // Width of shell.
+    const int _width = 5;
+
+public:
+
+    TestSubdomainStencil2(StencilList& stencils, int radius=2) :
+        StencilRadiusBase("test_subdomain2", stencils, radius) { }
+
+    virtual void define() {
+
+        GridValue u = data(t, x, y, z);
+        for (int r = 1; r <= _radius; r++)
+            u += data(t, x-r, y, z) + data(t, x+r, y, z) +
+                data(t, x, y-r, z) + data(t, x, y+r, z) +
+                data(t, x, y, z-r) + data(t, x, y, z+r);
+
+        Condition at_shell =
+            (x < first_index(x) + _width || x > last_index(x) - _width) ||
+            (y < first_index(y) + _width || y > last_index(y) - _width) ||
+            (z < first_index(z) + _width || z > last_index(z) - _width);
+
+        // Damped update in shell; normal update inside.
+        data(t+1, x, y, z) EQUALS u / (_radius * 6 + 2) IF at_shell;
+        data(t+1, x, y, z) EQUALS u / (_radius * 6 + 1) IF !at_shell;
+    }
+};
+
+REGISTER_STENCIL(TestSubdomainStencil2);
+
 // A stencil that has grids, but no stencil equation.
 class TestEmptyStencil1 : public StencilBase {
 